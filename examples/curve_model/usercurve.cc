@@ -37,6 +37,7 @@
 #include <Goptical/Shape/Disk>
 
 #include <Goptical/Curve/Rotational>
+#include <Goptical/Curve/RotationalDual>
 
 #include <Goptical/Trace/Tracer>
 #include <Goptical/Trace/Sequence>
@@ -73,6 +74,23 @@ private:
   }
                                                                   /* anchor mycurve1 */
 
+  double _a;
+};
+                                                                  /* anchor mycurve3 */
+class MyCatenaryCurveDual : public Curve::RotationalDual<MyCatenaryCurveDual>
+{
+public:
+  MyCatenaryCurveDual(double a)
+    : _a(a)
+  {
+  }
+
+  template <typename T> T sagitta_t(const T &r) const
+  {
+    return _a * cosh(r / _a) - _a;
+  }
+
+private:
   double _a;
 };
                                                                   /* anchor end */
@@ -48,11 +48,16 @@ namespace _Goptical {
        intersection between a given 3d ray and the curve is also
        provided.
 
+       Batch versions of intersection and normal functions are
+       available to process arrays of rays at once. Curves with
+       closed form solutions reimplement them with vectorized code.
+
        @xsee {tuto_usercurve}
     */
     class Base : public ref_base<Base>
     {
     public:
+      inline Base();
       virtual inline ~Base();
 
       /** Get curve sagitta at specified point */
@@ -65,8 +70,103 @@ namespace _Goptical {
           false if no intersection occurred */
       virtual bool intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const;
 
+      /** Get intersection point between curve and 3d ray when only
+          curve points at distance less than @tt max_radius from
+          curve axis are of interest. This may be used by curves to
+          bracket the intersection search. Default implementation
+          calls @ref intersect. */
+      virtual bool intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                                     double max_radius) const;
+
       /** Get normal to curve surface at specified point */
       virtual void normal(Math::Vector3 &normal, const Math::Vector3 &point) const;
+
+      /** Get minimal and maximal sagitta over a rectangular
+          area. Default implementation samples sagitta and gradient
+          on a grid and adds a margin based on the largest gradient
+          found, the result is an estimate which may miss narrow
+          features. */
+      virtual void sagitta_range(const Math::VectorPair2 &area,
+                                 double &min, double &max) const;
+
+      /** Get conservative minimal and maximal z of points which may
+          be returned by @ref intersect for rays crossing a
+          rectangular area. This may differ from sagitta range
+          when other solutions of the curve equation are
+          considered. Return true if the range is guaranteed to
+          enclose all such points and false if it is only an
+          estimate. Default implementation uses @ref sagitta_range
+          and returns false. */
+      virtual bool intersect_range(const Math::VectorPair2 &area,
+                                   double &min, double &max) const;
+
+      /** Compute lazily evaluated internal state so that further
+          const calls do not modify the curve object. Default
+          implementation does nothing. @see Sys::System::freeze */
+      virtual void prepare() const;
+
+      /** Get intersection points between curve and a batch of 3d
+          rays. Rays and points are given as separate x, y and z
+          coordinates arrays. The @tt hit array is set to false for
+          rays which do not intersect the curve. When @tt max_radius
+          is positive, intersections are searched as with @ref
+          intersect_bounded. Default implementation calls @ref
+          intersect or @ref intersect_bounded for each ray. */
+      virtual void intersect_batch(double * const point[3], bool *hit,
+                                   const double * const origin[3],
+                                   const double * const direction[3],
+                                   unsigned int count, double max_radius) const;
+
+      /** Get normals to curve surface at a batch of points given as
+          separate x, y and z coordinates arrays. Default
+          implementation calls @ref normal for each point. */
+      virtual void normal_batch(double * const normal[3],
+                                const double * const point[3],
+                                unsigned int count) const;
+
+      /** Enable use of the last intersection point found on this
+          curve by the current thread as starting point of iterative
+          intersection methods. Neighbouring rays usually hit
+          neighbouring points, this saves iterations when rays are
+          traced in order. Default is disabled.
+
+          Intersection points then depend on rays order and number
+          of threads within the convergence tolerance, trace results
+          are not guaranteed to be identical for any thread count. */
+      inline void set_intersect_hint(bool enabled);
+
+      /** @internal Select hints used by next intersections on the
+          current thread. Surfaces pass their own address so that a
+          curve shared by several surfaces keeps a hint per surface. */
+      static void set_intersect_hint_key(const void *key);
+
+    protected:
+      /** Get last intersection point found on this curve by the
+          current thread for current hint key along with curve normal
+          near this point. Return false if no hint is available. */
+      bool load_intersect_hint(Math::VectorPair3 &point) const;
+
+      /** Record converged intersection point and normal found on
+          this curve for the current thread and hint key when hint is
+          enabled. */
+      void save_intersect_hint(const Math::VectorPair3 &point) const;
+
+      /** Call @ref intersect, or @ref intersect_bounded when @tt
+          max_radius is positive, for rays in range [first, count) of
+          a batch */
+      void intersect_batch_scalar(double * const point[3], bool *hit,
+                                  const double * const origin[3],
+                                  const double * const direction[3],
+                                  unsigned int first, unsigned int count,
+                                  double max_radius) const;
+
+      /** Call @ref normal for points in range [first, count) of a batch */
+      void normal_batch_scalar(double * const normal[3],
+                               const double * const point[3],
+                               unsigned int first, unsigned int count) const;
+
+    private:
+      bool _intersect_hint;
     };
 
   }
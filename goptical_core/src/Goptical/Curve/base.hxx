@@ -30,10 +30,20 @@ namespace _Goptical {
 
   namespace Curve {
 
+    Base::Base()
+      : _intersect_hint(false)
+    {
+    }
+
     Base::~Base()
     {
     }
 
+    void Base::set_intersect_hint(bool enabled)
+    {
+      _intersect_hint = enabled;
+    }
+
   }
 }
 
@@ -0,0 +1,76 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_CURVE_BASE_DUAL_HH_
+#define GOPTICAL_CURVE_BASE_DUAL_HH_
+
+#include "Goptical/common.hh"
+
+#include "Goptical/Math/dual.hh"
+#include "Goptical/Math/vector.hh"
+#include "base.hh"
+
+namespace _Goptical {
+
+  namespace Curve {
+
+    /**
+       @short Curve with automatic differentiation
+       @header Goptical/Curve/BaseDual
+       @module {Core}
+
+       This class template can be used as base class for curves
+       which do not provide a closed form gradient. The @tt X derived
+       class must implement the sagitta as a template function:
+
+       @code
+       template <typename T> T sagitta_t(const T &x, const T &y) const;
+       @end code
+
+       This function is evaluated on @tt double to get sagitta and
+       on 2 variables @ref Math::Dual numbers to get exact x and y
+       derivatives in a single pass, instead of the numerical
+       differentiation performed by @ref Base::derivative.
+
+       @see RotationalDual
+     */
+    template <class X>
+    class BaseDual : public Base
+    {
+    public:
+      /** @override */
+      double sagitta(const Math::Vector2 & xy) const;
+      /** @override */
+      void derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const;
+
+    protected:
+      inline BaseDual();
+    };
+
+  }
+}
+
+#endif
+
@@ -0,0 +1,62 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_CURVE_BASE_DUAL_HXX_
+#define GOPTICAL_CURVE_BASE_DUAL_HXX_
+
+#include "Goptical/Math/dual.hxx"
+#include "Goptical/Math/vector.hxx"
+#include "base.hxx"
+
+namespace _Goptical {
+
+  namespace Curve {
+
+    template <class X>
+    BaseDual<X>::BaseDual()
+      : Base()
+    {
+    }
+
+    template <class X>
+    double BaseDual<X>::sagitta(const Math::Vector2 & xy) const
+    {
+      return static_cast<const X *>(this)->sagitta_t(xy.x(), xy.y());
+    }
+
+    template <class X>
+    void BaseDual<X>::derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const
+    {
+      Math::Dual<2> z = static_cast<const X *>(this)->sagitta_t(Math::Dual<2>(xy.x(), 0),
+                                                                Math::Dual<2>(xy.y(), 1));
+
+      dxdy = Math::Vector2(z.deriv(0), z.deriv(1));
+    }
+
+  }
+}
+
+#endif
+
@@ -74,6 +74,13 @@ namespace _Goptical {
       double fit(const Rotational &curve, double radius, unsigned int count);
 
       bool intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const;
+      void intersect_batch(double * const point[3], bool *hit,
+                           const double * const origin[3],
+                           const double * const direction[3],
+                           unsigned int count, double max_radius) const;
+      void normal_batch(double * const normal[3],
+                        const double * const point[3],
+                        unsigned int count) const;
       double sagitta(double r) const;
       double derivative(double r) const;
 
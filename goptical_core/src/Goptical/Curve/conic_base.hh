@@ -69,9 +69,23 @@ namespace _Goptical {
       double fit_roc(const Rotational &c, double radius, unsigned int count);
 
       virtual bool intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const = 0;
+
+      /** @override Use closed form @ref intersect, radius bound is not needed */
+      bool intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                             double max_radius) const;
       virtual double sagitta(double r) const = 0;
       virtual double derivative(double r) const = 0;
 
+      /** @override Conic sagitta is monotonic along radius */
+      void sagitta_range(const Math::VectorPair2 &area,
+                         double &min, double &max) const;
+
+      /** @override Include other branch of the conic section which
+          may be selected depending on ray direction. Range is
+          exact. */
+      bool intersect_range(const Math::VectorPair2 &area,
+                           double &min, double &max) const;
+
     protected:
       inline ConicBase(double roc, double sc);
 
@@ -51,9 +51,22 @@ namespace _Goptical {
       Flat();
 
       bool intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const;
+      bool intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                             double max_radius) const;
       void normal(Math::Vector3 &normal, const Math::Vector3 &point) const;
+      void intersect_batch(double * const point[3], bool *hit,
+                           const double * const origin[3],
+                           const double * const direction[3],
+                           unsigned int count, double max_radius) const;
+      void normal_batch(double * const normal[3],
+                        const double * const point[3],
+                        unsigned int count) const;
 
       double sagitta(double r) const;
+      void sagitta_range(const Math::VectorPair2 &area,
+                         double &min, double &max) const;
+      bool intersect_range(const Math::VectorPair2 &area,
+                           double &min, double &max) const;
       double derivative(double r) const;
     };
 
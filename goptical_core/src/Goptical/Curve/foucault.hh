@@ -142,6 +142,9 @@ namespace _Goptical {
       double sagitta(double r) const;
       double derivative(double r) const;
 
+      /** @override Reduce foucault readings */
+      void prepare() const;
+
     private:
 
       void update();
@@ -73,6 +73,9 @@ namespace _Goptical {
       double sagitta(const Math::Vector2 & xy) const;
       void derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const;
 
+      /** @override */
+      void prepare() const;
+
     protected:
       Data::Grid _data;
     };
@@ -65,6 +65,35 @@ namespace _Goptical {
       inline double sagitta(const Math::Vector2 & xy) const;
       void derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const;
 
+      /** Intersection solver statistics */
+      struct intersect_stats_s
+      {
+        /** Number of solver steps */
+        unsigned int iterations;
+        /** Number of steps where newton step was replaced by bisection */
+        unsigned int bisections;
+        /** Root bracket was found by subdividing the ray segment */
+        bool scanned;
+      };
+
+      /** @override Reduce curve intersection to a 1d root search
+          along the ray segment which lies in the @tt max_radius
+          cylinder. Root is bracketed from segment ends and found
+          with a safeguarded newton/bisection method. Falls back to
+          @ref intersect when radius is not bounded or when sagitta
+          is not defined over the segment. */
+      bool intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                             double max_radius) const;
+
+      /** Same as @ref intersect_bounded, solver statistics for
+          this call are stored in @tt stats. */
+      bool intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                             double max_radius, intersect_stats_s &stats) const;
+
+      /** @override Sample sagitta along radius range of the area */
+      void sagitta_range(const Math::VectorPair2 &area,
+                         double &min, double &max) const;
+
       // FIXME sample points
       /** Get number of available sample points. Samples points may be
           used by curve fitting algorithms and are choosen to avoid
@@ -73,6 +102,12 @@ namespace _Goptical {
       /** Get a sample point on curve. (0,0) is not included. */
       virtual void get_sample(unsigned int index, double &r, double &z) const;
 
+    protected:
+      /** Get minimal and maximal distance from curve origin (0, 0)
+          of points in a rectangular area */
+      static void radius_range(const Math::VectorPair2 &area,
+                               double &rmin, double &rmax);
+
     private:
       static double gsl_func_sagitta(double x, void *params);
       gsl_function gsl_func;
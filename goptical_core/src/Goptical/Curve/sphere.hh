@@ -50,6 +50,13 @@ namespace _Goptical {
 
       bool intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const;
       void normal(Math::Vector3 &normal, const Math::Vector3 &point) const;
+      void intersect_batch(double * const point[3], bool *hit,
+                           const double * const origin[3],
+                           const double * const direction[3],
+                           unsigned int count, double max_radius) const;
+      void normal_batch(double * const normal[3],
+                        const double * const point[3],
+                        unsigned int count) const;
 
       double sagitta(double r) const;
       double derivative(double r) const;
@@ -72,6 +72,9 @@ namespace _Goptical {
       inline double sagitta(double r) const;
       inline double derivative(double r) const;
 
+      /** @override */
+      void prepare() const;
+
     protected:
       Data::DiscreteSet _data;
     };
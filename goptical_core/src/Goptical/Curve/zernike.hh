@@ -26,9 +26,12 @@
 #ifndef GOPTICAL_CURVE_ZERNIKE_HH_
 #define GOPTICAL_CURVE_ZERNIKE_HH_
 
+#include <vector>
+
 #include "Goptical/common.hh"
 
 #include "Goptical/Trace/distribution.hh"
+#include "Goptical/Math/vector.hh"
 #include "base.hh"
 
 namespace _Goptical {
@@ -49,7 +52,11 @@ namespace _Goptical {
        coefficients of an other curve.
 
        This implementation uses Zernike polynomials set as described
-       in ISO standard 10110-5.
+       in ISO standard 10110-5. Terms are indexed in fringe order
+       and the number of terms is not limited: radial polynomials
+       are evaluated using three terms recurrences so that all
+       enabled terms are computed in a single pass over the
+       orders, along with the gradient.
 
        Based on Zernikes pages by James C Wyant and Michael Koch.
        @url http://www.optics.arizona.edu/jcwyant/Zernikes/ZernikePolynomials.htm
@@ -60,7 +67,7 @@ namespace _Goptical {
       static const Trace::Distribution default_dist;
 
     public:
-      /** Number of implemented zernike polynomials */
+      /** Default number of zernike terms */
       static const unsigned int term_count = 36;
 
       /** Create a Zernike curve defined over the given circle radius. 
@@ -73,7 +80,8 @@ namespace _Goptical {
           and initialize coefficients from table.
           @param radius Zernike circle radius
           @param coefs Table of Zernike coefficients starting with z0 (piston)
-          @param coefs_count Number of coefficients available in the table
+          @param coefs_count Number of coefficients available in the
+          table, number of terms is extended as needed
           @param unit_scale Sagitta scale factor used to change units globally
       */
       Zernike(double radius, double coefs[], unsigned int coefs_count, double unit_scale = 1.0);
@@ -83,6 +91,12 @@ namespace _Goptical {
       /** Get Zernike circle radius */
       inline double get_radius() const;
 
+      /** Set number of zernike terms, new terms have a null
+          coefficient and are disabled. */
+      void set_term_count(unsigned int count);
+      /** Get number of zernike terms */
+      inline unsigned int get_term_count() const;
+
       /** Set coefficient associated with zernike term n and enable
           term according to current threshold. See
           set_coefficients_threshold() */
@@ -112,26 +126,89 @@ namespace _Goptical {
           curve. RMS difference is returned. The specified
           distribution is used to choose sampling points on
           curve. Terms state is adjusted according to current
-          threshold */
+          threshold.
+
+          The column pivoted QR factorization of the least squares
+          problem is kept and reused by further fits with the same
+          distribution, terms count and coefficients scale, so that
+          these fits only cost curve sampling and a triangular
+          solve. Terms which can not be told apart on the sample
+          points, like sine terms with a meridional distribution,
+          are set to zero. */
       double fit(const Base &c, const Trace::Distribution & d = default_dist);
 
+      /** Set number of threads used to sample the fitted curve, 0
+          means one thread per processor, default is 1. The fitted
+          curve must support concurrent const calls once @ref
+          Base::prepare has been called. */
+      inline void set_fit_thread_count(unsigned int count);
+
       double sagitta(const Math::Vector2 & xy) const;
       void derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const;
 
+      /** Get curve sagitta and gradient at specified point in a
+          single pass over enabled terms */
+      void sagitta_derivative(const Math::Vector2 & xy, double &sag,
+                              Math::Vector2 & dxdy) const;
+
+      /** Get curve sagitta and gradient at a batch of points given
+          as separate x and y coordinates arrays. */
+      void sagitta_derivative_batch(double *sag, double * const dxdy[2],
+                                    const double * const xy[2],
+                                    unsigned int count) const;
+
+      void normal_batch(double * const normal[3],
+                        const double * const point[3],
+                        unsigned int count) const;
+
+      /** @override Terms are bounded by 1 over the unit circle, the
+          range is bounded by the sum of enabled coefficients. */
+      bool intersect_range(const Math::VectorPair2 &area,
+                           double &min, double &max) const;
+
       /** Evaluate zernike polynomial n */
       static double zernike_poly(unsigned int n, const Math::Vector2 & xy);
       /** Evaluate x and y derivatives of zernike polynomial n */
       static void zernike_poly_d(unsigned int n, const Math::Vector2 & xy, Math::Vector2 & dxdy);
+
+      /** Get radial order and azimuthal frequency of zernike term
+          n. Azimuthal frequency is negative for sine terms. */
+      static void get_term_orders(unsigned int n, unsigned int &radial, int &azimuthal);
+
     private:
 
+      /** Recurrence coefficients and weights of cosine and sine
+          terms for a given radial order and azimuthal frequency */
+      struct term_s
+      {
+        double a, b, c;
+        double cos_coeff, sin_coeff;
+      };
+
+      class fit_job;
+
       void update_threshold_state();
+      void update_terms();
+      void update_fit(const Trace::Distribution &d);
+      void eval(double x, double y, double &sag, double *dxdy) const;
 
       double _scale;
       double _threshold;
       double _radius;
-      double _coeff[term_count];
-      unsigned int _enabled_count;
-      unsigned char _enabled_list[term_count];
+      std::vector<double> _coeff;
+      std::vector<bool> _enabled;
+      std::vector<term_s> _terms;
+      std::vector<unsigned int> _m_count;
+
+      unsigned int _fit_threads;
+      Trace::Distribution _fit_dist;
+      unsigned int _fit_terms;
+      double _fit_scale;
+      std::vector<Math::Vector2> _fit_points;
+      std::vector<double> _fit_qr;   // factorized design matrix, row major
+      std::vector<double> _fit_tau;
+      std::vector<size_t> _fit_perm; // terms pivoting order
+      unsigned int _fit_rank;        // independent terms count
     };
 
   }
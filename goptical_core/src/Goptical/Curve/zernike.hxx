@@ -44,16 +44,21 @@ namespace _Goptical {
       return _radius;
     }
 
+    unsigned int Zernike::get_term_count() const
+    {
+      return _coeff.size();
+    }
+
     void Zernike::set_coefficient(unsigned int n, double c)
     {
-      assert(n < term_count);
+      assert(n < _coeff.size());
       _coeff[n] = c;
       set_term_state(n, fabs(c) >= _threshold);
     }
 
     double Zernike::get_coefficient(unsigned int n) const
     {
-      assert(n < term_count);
+      assert(n < _coeff.size());
       return _coeff[n];
     }
 
@@ -68,6 +73,11 @@ namespace _Goptical {
       _scale = s;
     }
 
+    void Zernike::set_fit_thread_count(unsigned int count)
+    {
+      _fit_threads = count;
+    }
+
   }
 }
 
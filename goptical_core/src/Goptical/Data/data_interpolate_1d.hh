@@ -58,6 +58,10 @@ namespace _Goptical {
 
       void set_interpolation(Interpolation i);
 
+    protected:
+      /** @override */
+      void update_tables() const;
+
     private:
       /** quadratic and cubic polynomial coefficients */
       struct poly_s
@@ -32,12 +32,18 @@ namespace _Goptical {
     template <class X>
     double Interpolate1d<X>::interpolate(double x) const
     {
+      if (!X::is_prepared())
+        X::prepare_tables();
+
       return (this->*_interpolate)(0, x);
     }
 
     template <class X>
     double Interpolate1d<X>::interpolate(double x, unsigned int d) const
     {
+      if (!X::is_prepared())
+        X::prepare_tables();
+
       return (this->*_interpolate)(d, x);
     }
 
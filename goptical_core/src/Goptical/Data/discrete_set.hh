@@ -62,6 +62,12 @@ namespace _Goptical {
       /** Clear all data */
       void clear();
 
+      /** Enable use of a per thread hint when looking up the data
+          interval of a value. The last interval found by each thread
+          is checked first, this speeds up monotone and repeated
+          queries on the same data set. Default is disabled. */
+      inline void set_interval_hint(bool enabled);
+
       /** Get stored derivative value at index x */
       inline double get_d_value(unsigned int x) const;
       /** Get modifiable reference to stored derivative value at index x */
@@ -86,12 +92,31 @@ namespace _Goptical {
       /** find nearest value index */
       unsigned int get_nearest(double x) const;
 
+      /** build uniform buckets lookup index over x range, used by
+          @ref get_interval once built. Index is discarded when
+          data is added. */
+      void update_index() const;
+
       virtual void invalidate() = 0;
 
       inline double get_x_interval(unsigned int x) const;
       inline double get_x_interval(unsigned int x1, unsigned int x2) const;
 
       std::vector<struct entry_s>       _data;
+
+    private:
+      /** get lookup index bucket of value in x range */
+      inline unsigned int get_bucket(double x) const;
+
+      /** binary search of interval in given index range */
+      inline unsigned int search_interval(double x, unsigned int first,
+                                          unsigned int last) const;
+
+      // first interval index of each bucket, and end index
+      mutable std::vector<unsigned int> _index;
+      mutable double                    _index_origin;
+      mutable double                    _index_scale;
+      bool                              _hint;
     };
 
     /** 
@@ -40,6 +40,11 @@ namespace _Goptical {
       _data.reserve(n);
     }
 
+    void DiscreteSetBase::set_interval_hint(bool enabled)
+    {
+      _hint = enabled;
+    }
+
     unsigned int DiscreteSetBase::get_count() const
     {
       return _data.size();
@@ -133,6 +133,10 @@ namespace _Goptical {
       Math::range_t get_x_range(unsigned int dimension) const;
       void set_interpolation(Interpolation i);
 
+    protected:
+      /** @override */
+      void update_tables() const;
+
     private:
 
       struct poly_t
@@ -127,6 +127,10 @@ namespace _Goptical {
     double Grid::interpolate(const Math::Vector2 & v) const
     {      
       unsigned int x[2];
+
+      if (!is_prepared())
+        prepare_tables();
+
       (this->*_lookup)(x, v);
 
       return (this->*_interpolate_y)(x, v);
@@ -136,6 +140,10 @@ namespace _Goptical {
     {
       Math::Vector2 res;
       unsigned int x[2];
+
+      if (!is_prepared())
+        prepare_tables();
+
       (this->*_lookup)(x, v);
 
       (this->*_interpolate_d)(x, res, v);
@@ -180,7 +188,7 @@ namespace _Goptical {
 
     void Grid::invalidate()
     {
-      _lookup = _update;
+      invalidate_tables();
     }
 
   }
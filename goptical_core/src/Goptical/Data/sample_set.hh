@@ -94,6 +94,9 @@ namespace _Goptical {
       /** find nearest value index */
       unsigned int get_nearest(double x) const;
 
+      /** samples are evenly spaced, no lookup index is needed */
+      inline void update_index() const;
+
       virtual void invalidate() = 0;
 
       inline double get_x_interval(unsigned int x) const;
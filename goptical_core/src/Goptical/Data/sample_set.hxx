@@ -84,6 +84,10 @@ namespace _Goptical {
       return _origin;
     }
 
+    void SampleSetBase::update_index() const
+    {
+    }
+
     double SampleSetBase::get_x_interval(unsigned int x) const
     {
       return _step;
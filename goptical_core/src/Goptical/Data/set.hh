@@ -92,6 +92,13 @@ namespace _Goptical {
       /** Select interpolation method */
       virtual void set_interpolation(Interpolation i) = 0;
 
+      /** Compute interpolation tables which are otherwise built on
+          first interpolation. Further queries do not modify the data
+          set and can be performed concurrently from several threads
+          until data or interpolation method are changed. Does
+          nothing if the data set is empty. */
+      void prepare() const;
+
       /** Get current interpolation method */
       inline Interpolation get_interpolation();
 
@@ -102,8 +109,35 @@ namespace _Goptical {
     protected:
       Set();
 
+      /** Check if interpolation tables are up to date */
+      inline bool is_prepared() const;
+
+      /** Build interpolation tables once. Concurrent callers wait
+          for the first one to complete. */
+      void prepare_tables() const;
+
+      /** Mark interpolation tables as outdated */
+      inline void invalidate_tables();
+
+      /** Compute interpolation tables and select interpolation
+          functions. Called by @ref prepare_tables, must throw if data
+          set doesn't contain enough data. Default implementation
+          does nothing. */
+      virtual void update_tables() const;
+
       unsigned int      _version;
       Interpolation     _interpolation;
+
+    private:
+      /** interpolation tables state */
+      enum tables_state_e
+        {
+          TablesDirty,
+          TablesBuilding,
+          TablesReady,
+        };
+
+      mutable int       _tables_state;
     };
 
   }
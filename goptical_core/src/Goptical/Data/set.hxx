@@ -40,6 +40,16 @@ namespace _Goptical {
       return _interpolation;
     }
 
+    bool Set::is_prepared() const
+    {
+      return __atomic_load_n(&_tables_state, __ATOMIC_ACQUIRE) == TablesReady;
+    }
+
+    void Set::invalidate_tables()
+    {
+      _tables_state = TablesDirty;
+    }
+
   }
 }
 
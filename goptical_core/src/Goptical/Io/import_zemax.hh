@@ -60,6 +60,14 @@ namespace _Goptical {
       /** Set glass catalogs default path */
       inline void set_catalog_path(const std::string &path);
 
+      /** Set directory used to store binary glass catalog cache
+          files. Imported ascii catalogs are written to this
+          directory in a memory mappable format and later imports of
+          the same unchanged file use the cache instead of parsing
+          the file again. Cache is disabled if path is empty
+          (default). */
+      inline void set_catalog_cache_path(const std::string &path);
+
       /** Import Zemax ascii glass catalog, guess filename from default path and name */
       ref<Material::Catalog> import_catalog(const std::string &name);
 
@@ -67,10 +75,21 @@ namespace _Goptical {
           name from file name */
       ref<Material::Catalog> import_catalog_file(const std::string &path);
 
-      /** Import Zemax ascii glass catalog file (@tt .agf) */
+      /** Import Zemax ascii glass catalog file (@tt .agf).
+
+          Imported catalogs are kept in a process wide registry
+          shared by all importers: a file is parsed once and the same
+          catalog object is returned on later imports unless the file
+          has been modified. Material objects are created on first
+          lookup and shared by all users of the catalog. */
       ref<Material::Catalog> import_catalog(const std::string &path,
                                             const std::string &name);
 
+      /** Drop catalogs from process wide registry. Catalogs still
+          referenced are not destroyed but will not be returned by
+          later imports. */
+      static void clear_shared_catalogs();
+
       /** Get already imported catalog */
       ref<Material::Catalog> get_catalog(const std::string &name);
 
@@ -88,6 +107,7 @@ namespace _Goptical {
 
       cat_map_t         _cat_list;
       std::string       _cat_path;
+      std::string       _cache_path;
     };
 
   }
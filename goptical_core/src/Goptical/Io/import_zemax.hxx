@@ -34,6 +34,11 @@ namespace _Goptical {
       _cat_path = path;
     }
 
+    void ImportZemax::set_catalog_cache_path(const std::string &path)
+    {
+      _cache_path = path;
+    }
+
   }
 
 }
@@ -74,6 +74,8 @@ namespace _Goptical {
       /** @override */
       double get_refractive_index(double wavelen) const;
       /** @override */
+      double get_thermal_refractive_index(double wavelen, double temperature) const;
+      /** @override */
       double get_extinction_coef(double wavelen) const;
 
       GOPTICAL_ACCESSORS(double, pressure, "relative air pressure in @em Pa @see std_pressure")
@@ -74,6 +74,13 @@ namespace _Goptical {
       /** Get material relative refractive index in given medium at specified wavelen in @em nm. */
       inline double get_refractive_index(double wavelen, const Base &env) const;
 
+      /** Get material absolute refractive index at specified wavelen
+          in @em nm as if material temperature was set to given value
+          in celcius. Material is not modified. Default
+          implementation throws an @ref Error, materials without
+          temperature model can not be traced at other temperatures. */
+      virtual double get_thermal_refractive_index(double wavelen, double temperature) const;
+
       /** Get extinction coefficient. Subclasses _must_ provide this
           function or the get_internal_transmittance() function. */
       virtual double get_extinction_coef(double wavelen) const;
@@ -84,6 +91,16 @@ namespace _Goptical {
       /** Get transmittance at normal incidence */
       virtual double get_normal_transmittance(const Base *from, double wavelen) const;
 
+      /** Get reflectance at normal incidence as if both materials
+          temperature was set to given value in celcius. */
+      virtual double get_thermal_normal_reflectance(const Base *from, double wavelen,
+                                                    double temperature) const;
+
+      /** Get transmittance at normal incidence as if both materials
+          temperature was set to given value in celcius. */
+      virtual double get_thermal_normal_transmittance(const Base *from, double wavelen,
+                                                      double temperature) const;
+
       /** Set material temperature in celcius */
       void set_temperature(double temp);
       /** Get material temperature in celcius */
@@ -92,6 +109,12 @@ namespace _Goptical {
       /** Get material color and alpha */
       virtual Io::Rgb get_color() const;
 
+      /** Compute data set interpolation tables and other lazily
+          evaluated internal state so that further const calls do not
+          modify the material object. Default implementation does
+          nothing. @see Sys::System::freeze */
+      virtual void prepare() const;
+
     protected:
       double            _temperature; // celcius
     };
@@ -28,6 +28,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <pthread.h>
 
 #include "Goptical/common.hh"
 
@@ -42,6 +44,10 @@ namespace _Goptical {
        @header Goptical/Material/Catalog
        @module {Core}
        @main
+
+       Catalog lookup functions may be called concurrently from
+       multiple threads. Derived classes may instantiate materials
+       lazily on first lookup, see @ref create_material.
      */
     class Catalog : public ref_base<Catalog>
     {
@@ -49,13 +55,16 @@ namespace _Goptical {
       /** Create a catalog with given name */
       Catalog(const std::string & name = "");
 
+      virtual ~Catalog();
+
       /** Get catalog name */
       inline const std::string & get_name() const;
       /** Set catalog name */
       inline void set_name(const std::string & name);
 
-      /** Get material with given name */
-      inline const Base & get_material(const std::string &material_name);
+      /** Get material with given name. The returned reference keeps
+          the material alive if it is removed from catalog. */
+      const_ref<Base> get_material(const std::string &material_name);
 
       /** Add a material to catalog. material object will be deleted
           on catalog destruction if owner is set. */
@@ -64,12 +73,30 @@ namespace _Goptical {
       /** Remove a material from catalog */
       void del_material(const std::string &material_name);
 
+      /** Get sorted names of all materials in catalog, including
+          materials not instantiated yet */
+      void get_material_names(std::vector<std::string> &names) const;
+
+    protected:
+      /** Create material with given name when not found in
+          catalog. Created material is kept in catalog. Default
+          implementation returns an invalid reference. Materials
+          removed from catalog may be created again on next lookup. */
+      virtual const_ref<Base> create_material(const std::string &material_name) const;
+
+      /** Append names of materials which can be created by @ref
+          create_material. Default implementation does nothing. */
+      virtual void get_lazy_material_names(std::vector<std::string> &names) const;
+
     private:
+      Catalog(const Catalog &);
+      Catalog & operator=(const Catalog &);
 
       typedef std::map<std::string, const_ref<Base> > catalog_map_t;
 
       std::string _name;
       catalog_map_t _list;
+      mutable pthread_mutex_t _lock;
     };
 
   }
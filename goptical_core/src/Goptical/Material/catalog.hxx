@@ -42,16 +42,6 @@ namespace _Goptical {
       _name = name;
     }
 
-    inline const Base & Catalog::get_material(const std::string &material_name)
-    {
-      catalog_map_t::iterator i = _list.find(material_name);
-
-      if (i == _list.end())
-        throw Error("No such material in catalog");
-
-      return *i->second;
-    }
-
   }
 
 }
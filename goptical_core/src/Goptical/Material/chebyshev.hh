@@ -0,0 +1,140 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_MATERIAL_CHEBYSHEV_HH_
+#define GOPTICAL_MATERIAL_CHEBYSHEV_HH_
+
+#include <vector>
+
+#include "Goptical/common.hh"
+
+#include "Goptical/Material/base.hh"
+
+namespace _Goptical {
+
+  namespace Material {
+
+    /**
+       @short Compiled Chebyshev approximant of dielectric material
+       @header Goptical/Material/Chebyshev
+       @module {Core}
+
+       This class approximates the absolute refractive index of a
+       @ref Dielectric material with piecewise Chebyshev polynomials
+       over the material wavelen validity range. Evaluating the
+       polynomial is much faster than evaluating the dispersion
+       formula, measurement medium index and temperature model of
+       the original material. It is suitable for spectral ray tracing
+       with continuous wavelens.
+
+       The wavelen range is split in the smallest number of equal
+       segments for which a polynomial of degree at most 16 fits
+       the refractive index with an error below the requested
+       maximum. Error is checked on a grid 8 times denser than the
+       fit nodes.
+
+       The original material model is used for wavelens outside the
+       fitted range and when the material temperature differs from
+       the temperature at fit time. The @ref update function must be
+       called when other material parameters are changed. All other
+       properties are taken from the original material.
+     */
+    class Chebyshev : public Base
+    {
+    public:
+      /** Fit refractive index of given material with the specified
+          maximum error. An @ref Error is thrown if the requested
+          accuracy can not be reached. */
+      Chebyshev(const const_ref<Dielectric> &m, double max_error = 1e-8);
+
+      /** Fit refractive index again using current parameters of
+          original material */
+      void update();
+
+      /** Get original material */
+      inline const Dielectric & get_material() const;
+
+      /** Get number of polynomial segments */
+      inline unsigned int get_segment_count() const;
+
+      /** Get degree of polynomials */
+      inline unsigned int get_degree() const;
+
+      /** Get maximum error found when checking fit */
+      inline double get_fit_error() const;
+
+      /** @override */
+      bool is_opaque() const;
+
+      /** @override */
+      bool is_reflecting() const;
+
+      /** @override */
+      double get_internal_transmittance(double wavelen, double thickness) const;
+
+      /** @override */
+      double get_refractive_index(double wavelen) const;
+
+      /** @override */
+      double get_thermal_refractive_index(double wavelen, double temperature) const;
+
+      /** @override */
+      double get_extinction_coef(double wavelen) const;
+
+      /** @override */
+      double get_temperature() const;
+
+      /** @override */
+      Io::Rgb get_color() const;
+
+      /** @override */
+      void prepare() const;
+
+    private:
+      /** fit polynomials with given segments count and degree,
+          return maximum error on check grid */
+      double fit(unsigned int segments, unsigned int degree);
+
+      /** evaluate fitted polynomials */
+      inline double eval(double wavelen) const;
+
+      const_ref<Dielectric>     _m;
+      double                    _max_error;
+      double                    _fit_error;
+      double                    _fit_temperature;
+      double                    _low;
+      double                    _high;
+      double                    _scale; // segments per nm
+      unsigned int              _segments;
+      unsigned int              _degree;
+      std::vector<double>       _coefs; // [segment][degree + 1]
+    };
+
+  }
+
+}
+
+#endif
+
@@ -0,0 +1,83 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_MATERIAL_CHEBYSHEV_HXX_
+#define GOPTICAL_MATERIAL_CHEBYSHEV_HXX_
+
+#include <algorithm>
+
+#include "Goptical/Material/base.hxx"
+#include "Goptical/Material/dielectric.hh"
+
+namespace _Goptical {
+
+  namespace Material {
+
+    const Dielectric & Chebyshev::get_material() const
+    {
+      return *_m;
+    }
+
+    unsigned int Chebyshev::get_segment_count() const
+    {
+      return _segments;
+    }
+
+    unsigned int Chebyshev::get_degree() const
+    {
+      return _degree;
+    }
+
+    double Chebyshev::get_fit_error() const
+    {
+      return _fit_error;
+    }
+
+    double Chebyshev::eval(double wavelen) const
+    {
+      double t = (wavelen - _low) * _scale;
+      unsigned int s = std::min((unsigned int)t, _segments - 1);
+      double x = 2.0 * (t - s) - 1.0;
+      const double *c = &_coefs[s * (_degree + 1)];
+
+      // Clenshaw recurrence
+      double b1 = 0.0, b2 = 0.0;
+
+      for (unsigned int j = _degree; j > 0; j--)
+        {
+          double b = 2.0 * x * b1 - b2 + c[j];
+          b2 = b1;
+          b1 = b;
+        }
+
+      return x * b1 - b2 + c[0];
+    }
+
+  }
+
+}
+
+#endif
+
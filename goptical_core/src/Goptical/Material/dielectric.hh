@@ -128,6 +128,12 @@ namespace _Goptical {
       /** Set wavelen validity range in @em nm */
       inline void set_wavelen_range(double low, double high);
 
+      /** Get low bound of wavelen validity range in @em nm */
+      inline double get_low_wavelen() const;
+
+      /** Get high bound of wavelen validity range in @em nm */
+      inline double get_high_wavelen() const;
+
       /** Get material relative refractive index in measurment medium
           at specified wavelen in @em nm. */
       virtual double get_measurement_index(double wavelen) const = 0;
@@ -142,12 +148,16 @@ namespace _Goptical {
       double get_internal_transmittance(double wavelen) const;
       /** @override */
       double get_refractive_index(double wavelen) const;
+      /** @override */
+      double get_thermal_refractive_index(double wavelen, double temperature) const;
+      /** @override */
+      void prepare() const;
 
     private:
 
       /** Get temperature coeffiecient of refractive index using
           absloute reference refractive index */
-      double get_schott_temp(double wavelen, double ref_index) const;
+      double get_schott_temp(double wavelen, double ref_index, double temperature) const;
 
       /** normalized 1mm thickness transmittance data */
       Data::DiscreteSet _transmittance; 
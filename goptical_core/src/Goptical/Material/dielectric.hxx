@@ -80,6 +80,16 @@ namespace _Goptical {
       _high_wavelen = high;
     }
 
+    double Dielectric::get_low_wavelen() const
+    {
+      return _low_wavelen;
+    }
+
+    double Dielectric::get_high_wavelen() const
+    {
+      return _high_wavelen;
+    }
+
   }
 }
 
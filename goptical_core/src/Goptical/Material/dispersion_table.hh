@@ -65,6 +65,8 @@ namespace _Goptical {
 
       /** @override */
       double get_measurement_index(double wavelen) const;
+      /** @override */
+      void prepare() const;
     private:
 
       Data::DiscreteSet _refractive_index;
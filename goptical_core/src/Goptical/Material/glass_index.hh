@@ -0,0 +1,177 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_MATERIAL_GLASS_INDEX_HH_
+#define GOPTICAL_MATERIAL_GLASS_INDEX_HH_
+
+#include <string>
+#include <vector>
+
+#include "Goptical/common.hh"
+
+namespace _Goptical {
+
+  namespace Material {
+
+    /**
+       @short Nearest neighbour search index for glass substitution
+       @header Goptical/Material/GlassIndex
+       @module {Core}
+       @main
+
+       This class stores precomputed @em nd, @em vd, partial
+       dispersion deviation and cost attributes of dielectric
+       materials in a k-d tree. It provides fast k-nearest and range
+       queries, suitable for glass substitution during optimization.
+
+       Partial dispersion deviation is the difference between the
+       @em g, @em F partial dispersion of the glass and the Schott
+       normal line @em {0.6438 - 0.001682 vd}.
+
+       Nearest queries use an euclidean distance in attribute space
+       where each attribute is scaled by a weight. Default weights
+       are 100 for @em nd and partial dispersion deviation, 1 for
+       @em vd and 0 for cost.
+
+       The tree is built on first query after materials or weights
+       have been changed. @ref build must be called explicitly
+       before querying from multiple threads.
+     */
+    class GlassIndex
+    {
+    public:
+      /** Indexed glass attributes */
+      enum Attribute
+        {
+          Nd,
+          Vd,
+          DPgF,
+          Cost,
+        };
+
+      /** Number of indexed attributes */
+      static const unsigned int attribute_count = 4;
+
+      /** Indexed glass entry */
+      struct Entry
+      {
+        std::string             catalog;
+        std::string             name;
+        const_ref<Dielectric>   material;
+        double                  attr[attribute_count];
+      };
+
+      /** Create an empty index */
+      GlassIndex();
+
+      /** Create an index holding all dielectric materials of catalog */
+      GlassIndex(Catalog &catalog, double cost = 0.);
+
+      /** Add all dielectric materials of catalog with given cost */
+      void add_catalog(Catalog &catalog, double cost = 0.);
+
+      /** Add a material, attributes are computed from material model */
+      void add_material(const std::string &name,
+                        const const_ref<Dielectric> &material,
+                        double cost = 0.);
+
+      /** Add an entry with given attributes */
+      void add_entry(const std::string &catalog, const std::string &name,
+                     const const_ref<Dielectric> &material,
+                     double nd, double vd, double dpgf, double cost);
+
+      /** Remove all entries */
+      void clear();
+
+      /** Set cost attribute of entry */
+      void set_cost(unsigned int index, double cost);
+
+      /** Set weight of an attribute for distance computation */
+      void set_weight(enum Attribute a, double weight);
+
+      /** Get weight of an attribute */
+      inline double get_weight(enum Attribute a) const;
+
+      /** Get number of entries */
+      inline unsigned int get_entry_count() const;
+
+      /** Get entry */
+      inline const Entry & get_entry(unsigned int index) const;
+
+      /** Get weighted distance between entry and attribute values */
+      double get_distance(unsigned int index,
+                          const double attr[attribute_count]) const;
+
+      /** Build search tree */
+      void build();
+
+      /** Find up to @tt k entries nearest to given attribute values.
+          Indexes of entries are appended to @tt result in increasing
+          distance order. */
+      void find_nearest(std::vector<unsigned int> &result, unsigned int k,
+                        const double attr[attribute_count]) const;
+
+      /** Find @tt k entries nearest to given @em nd, @em vd and
+          partial dispersion deviation. Cost target is 0. */
+      void find_nearest(std::vector<unsigned int> &result, unsigned int k,
+                        double nd, double vd, double dpgf = 0.) const;
+
+      /** Find all entries with attributes in given bounds. Indexes of
+          entries are appended to @tt result in ascending order. */
+      void find_range(std::vector<unsigned int> &result,
+                      const double low[attribute_count],
+                      const double high[attribute_count]) const;
+
+    private:
+      struct node_s
+      {
+        unsigned int    _entry;
+        unsigned int    _axis;
+        double          _attr[attribute_count];
+      };
+
+      struct nearest_s;
+      struct axis_less_s;
+
+      void build_tree(unsigned int first, unsigned int last);
+      void search_nearest(nearest_s &s, unsigned int first, unsigned int last) const;
+      void search_range(std::vector<unsigned int> &result,
+                        const double low[attribute_count],
+                        const double high[attribute_count],
+                        unsigned int first, unsigned int last) const;
+      inline void update() const;
+
+      std::vector<Entry>        _entries;
+      std::vector<node_s>       _nodes;         // implicit balanced tree
+      double                    _weight[attribute_count];
+      bool                      _dirty;
+    };
+
+  }
+
+}
+
+#endif
+
@@ -58,6 +58,9 @@ namespace _Goptical {
       double get_refractive_index(double wavelen) const;
       double get_extinction_coef(double wavelen) const;
 
+      /** @override */
+      void prepare() const;
+
       /** Get refractive index dataset object */
       inline Data::DiscreteSet & get_refractive_index_dataset();
       /** Get extinction dataset object */
@@ -60,6 +60,9 @@ namespace _Goptical {
       /** @override */
       double get_refractive_index(double wavelen) const;
 
+      /** @override */
+      double get_thermal_refractive_index(double wavelen, double temperature) const;
+
       /** @override */
       double get_extinction_coef(double wavelen) const;
 
@@ -69,12 +72,23 @@ namespace _Goptical {
       /** @override */
       double get_normal_transmittance(const Base *from, double wavelen) const;
 
+      /** @override */
+      double get_thermal_normal_reflectance(const Base *from, double wavelen,
+                                            double temperature) const;
+
+      /** @override */
+      double get_thermal_normal_transmittance(const Base *from, double wavelen,
+                                              double temperature) const;
+
       /** @override */
       double get_temperature() const;
 
       /** @override */
       Io::Rgb get_color() const;
 
+      /** @override */
+      void prepare() const;
+
     private:
       const_ref<Base> _m;
     };
@@ -0,0 +1,151 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_MATH_DUAL_HH_
+#define GOPTICAL_MATH_DUAL_HH_
+
+#include <ostream>
+
+#include "Goptical/common.hh"
+
+namespace _Goptical {
+
+  namespace Math {
+
+    /**
+       @short Dual number class for automatic differentiation
+       @header Goptical/Math/Dual
+       @module {Core}
+
+       This class stores a value along with its first partial
+       derivatives with respect to @tt N variables. Arithmetic
+       operators and usual math functions propagate derivatives
+       using the chain rule, so that a function written as a
+       template evaluated on dual numbers yields exact derivatives
+       in a single pass.
+
+       Comparison operators only consider the value, branches taken
+       in the evaluated function are those taken on plain doubles.
+
+       @see Curve::RotationalDual
+       @see Curve::BaseDual
+     */
+    template <int N> struct Dual
+    {
+      /** Create an uninitialized dual number */
+      inline Dual();
+
+      /** Create a constant dual number, all derivatives are zero */
+      inline Dual(double value);
+
+      /** Create a dual number for the variable of index @tt var,
+          its derivative with respect to this variable is one */
+      inline Dual(double value, unsigned int var);
+
+      /** Get value */
+      inline double value() const;
+
+      /** Get partial derivative with respect to variable @tt var */
+      inline double deriv(unsigned int var = 0) const;
+
+      /** Get modifiable reference to value */
+      inline double & value();
+
+      /** Get modifiable reference to partial derivative with
+          respect to variable @tt var */
+      inline double & deriv(unsigned int var = 0);
+
+      inline Dual & operator+=(const Dual &d);
+      inline Dual & operator-=(const Dual &d);
+      inline Dual & operator*=(const Dual &d);
+      inline Dual & operator/=(const Dual &d);
+
+      inline Dual & operator+=(double s);
+      inline Dual & operator-=(double s);
+      inline Dual & operator*=(double s);
+      inline Dual & operator/=(double s);
+
+      inline Dual operator-() const;
+
+      inline Dual operator+(const Dual &d) const;
+      inline Dual operator-(const Dual &d) const;
+      inline Dual operator*(const Dual &d) const;
+      inline Dual operator/(const Dual &d) const;
+
+      inline Dual operator+(double s) const;
+      inline Dual operator-(double s) const;
+      inline Dual operator*(double s) const;
+      inline Dual operator/(double s) const;
+
+      inline bool operator<(const Dual &d) const;
+      inline bool operator>(const Dual &d) const;
+      inline bool operator<=(const Dual &d) const;
+      inline bool operator>=(const Dual &d) const;
+      inline bool operator==(const Dual &d) const;
+      inline bool operator!=(const Dual &d) const;
+
+      /** @internal Get dual number with value @tt f and
+          derivatives scaled by @tt df, used to apply chain rule */
+      inline Dual chain(double f, double df) const;
+
+    private:
+      double _v;
+      double _d[N];
+    };
+
+    template <int N> inline Dual<N> operator+(double s, const Dual<N> &d);
+    template <int N> inline Dual<N> operator-(double s, const Dual<N> &d);
+    template <int N> inline Dual<N> operator*(double s, const Dual<N> &d);
+    template <int N> inline Dual<N> operator/(double s, const Dual<N> &d);
+
+    template <int N> inline bool operator<(double s, const Dual<N> &d);
+    template <int N> inline bool operator>(double s, const Dual<N> &d);
+    template <int N> inline bool operator<=(double s, const Dual<N> &d);
+    template <int N> inline bool operator>=(double s, const Dual<N> &d);
+
+    /** @multiple Compute math function and its derivatives */
+    template <int N> inline Dual<N> sqrt(const Dual<N> &d);
+    template <int N> inline Dual<N> exp(const Dual<N> &d);
+    template <int N> inline Dual<N> log(const Dual<N> &d);
+    template <int N> inline Dual<N> sin(const Dual<N> &d);
+    template <int N> inline Dual<N> cos(const Dual<N> &d);
+    template <int N> inline Dual<N> tan(const Dual<N> &d);
+    template <int N> inline Dual<N> asin(const Dual<N> &d);
+    template <int N> inline Dual<N> acos(const Dual<N> &d);
+    template <int N> inline Dual<N> atan(const Dual<N> &d);
+    template <int N> inline Dual<N> sinh(const Dual<N> &d);
+    template <int N> inline Dual<N> cosh(const Dual<N> &d);
+    template <int N> inline Dual<N> tanh(const Dual<N> &d);
+    template <int N> inline Dual<N> fabs(const Dual<N> &d);
+    template <int N> inline Dual<N> pow(const Dual<N> &d, double e);
+    template <int N> inline Dual<N> square(const Dual<N> &d);
+
+    template <int N> std::ostream & operator<<(std::ostream &o, const Dual<N> &d);
+
+  }
+}
+
+#endif
+
@@ -0,0 +1,446 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_MATH_DUAL_HXX_
+#define GOPTICAL_MATH_DUAL_HXX_
+
+#include <cmath>
+#include <cassert>
+
+namespace _Goptical {
+
+  namespace Math {
+
+    template <int N>
+    Dual<N>::Dual()
+    {
+    }
+
+    template <int N>
+    Dual<N>::Dual(double value)
+      : _v(value)
+    {
+      for (int i = 0; i < N; i++)
+        _d[i] = 0.0;
+    }
+
+    template <int N>
+    Dual<N>::Dual(double value, unsigned int var)
+      : _v(value)
+    {
+      assert(var < (unsigned int)N);
+
+      for (int i = 0; i < N; i++)
+        _d[i] = 0.0;
+      _d[var] = 1.0;
+    }
+
+    template <int N>
+    double Dual<N>::value() const
+    {
+      return _v;
+    }
+
+    template <int N>
+    double Dual<N>::deriv(unsigned int var) const
+    {
+      assert(var < (unsigned int)N);
+      return _d[var];
+    }
+
+    template <int N>
+    double & Dual<N>::value()
+    {
+      return _v;
+    }
+
+    template <int N>
+    double & Dual<N>::deriv(unsigned int var)
+    {
+      assert(var < (unsigned int)N);
+      return _d[var];
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::chain(double f, double df) const
+    {
+      Dual<N> r;
+
+      r._v = f;
+      for (int i = 0; i < N; i++)
+        r._d[i] = _d[i] * df;
+
+      return r;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator+=(const Dual &d)
+    {
+      _v += d._v;
+      for (int i = 0; i < N; i++)
+        _d[i] += d._d[i];
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator-=(const Dual &d)
+    {
+      _v -= d._v;
+      for (int i = 0; i < N; i++)
+        _d[i] -= d._d[i];
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator*=(const Dual &d)
+    {
+      for (int i = 0; i < N; i++)
+        _d[i] = _d[i] * d._v + _v * d._d[i];
+      _v *= d._v;
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator/=(const Dual &d)
+    {
+      const double inv = 1.0 / d._v;
+
+      _v *= inv;
+      for (int i = 0; i < N; i++)
+        _d[i] = (_d[i] - _v * d._d[i]) * inv;
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator+=(double s)
+    {
+      _v += s;
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator-=(double s)
+    {
+      _v -= s;
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator*=(double s)
+    {
+      _v *= s;
+      for (int i = 0; i < N; i++)
+        _d[i] *= s;
+      return *this;
+    }
+
+    template <int N>
+    Dual<N> & Dual<N>::operator/=(double s)
+    {
+      return *this *= 1.0 / s;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator-() const
+    {
+      return chain(-_v, -1.0);
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator+(const Dual &d) const
+    {
+      Dual<N> r(*this);
+      return r += d;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator-(const Dual &d) const
+    {
+      Dual<N> r(*this);
+      return r -= d;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator*(const Dual &d) const
+    {
+      Dual<N> r(*this);
+      return r *= d;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator/(const Dual &d) const
+    {
+      Dual<N> r(*this);
+      return r /= d;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator+(double s) const
+    {
+      Dual<N> r(*this);
+      return r += s;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator-(double s) const
+    {
+      Dual<N> r(*this);
+      return r -= s;
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator*(double s) const
+    {
+      return chain(_v * s, s);
+    }
+
+    template <int N>
+    Dual<N> Dual<N>::operator/(double s) const
+    {
+      return *this * (1.0 / s);
+    }
+
+    template <int N>
+    bool Dual<N>::operator<(const Dual &d) const
+    {
+      return _v < d._v;
+    }
+
+    template <int N>
+    bool Dual<N>::operator>(const Dual &d) const
+    {
+      return _v > d._v;
+    }
+
+    template <int N>
+    bool Dual<N>::operator<=(const Dual &d) const
+    {
+      return _v <= d._v;
+    }
+
+    template <int N>
+    bool Dual<N>::operator>=(const Dual &d) const
+    {
+      return _v >= d._v;
+    }
+
+    template <int N>
+    bool Dual<N>::operator==(const Dual &d) const
+    {
+      return _v == d._v;
+    }
+
+    template <int N>
+    bool Dual<N>::operator!=(const Dual &d) const
+    {
+      return _v != d._v;
+    }
+
+    template <int N>
+    Dual<N> operator+(double s, const Dual<N> &d)
+    {
+      return d + s;
+    }
+
+    template <int N>
+    Dual<N> operator-(double s, const Dual<N> &d)
+    {
+      return d.chain(s - d.value(), -1.0);
+    }
+
+    template <int N>
+    Dual<N> operator*(double s, const Dual<N> &d)
+    {
+      return d * s;
+    }
+
+    template <int N>
+    Dual<N> operator/(double s, const Dual<N> &d)
+    {
+      const double inv = 1.0 / d.value();
+
+      return d.chain(s * inv, -s * inv * inv);
+    }
+
+    template <int N>
+    bool operator<(double s, const Dual<N> &d)
+    {
+      return s < d.value();
+    }
+
+    template <int N>
+    bool operator>(double s, const Dual<N> &d)
+    {
+      return s > d.value();
+    }
+
+    template <int N>
+    bool operator<=(double s, const Dual<N> &d)
+    {
+      return s <= d.value();
+    }
+
+    template <int N>
+    bool operator>=(double s, const Dual<N> &d)
+    {
+      return s >= d.value();
+    }
+
+    // keep double overloads visible to unqualified calls in Math namespace
+    using std::sqrt;
+    using std::exp;
+    using std::log;
+    using std::sin;
+    using std::cos;
+    using std::tan;
+    using std::asin;
+    using std::acos;
+    using std::atan;
+    using std::sinh;
+    using std::cosh;
+    using std::tanh;
+    using std::fabs;
+    using std::pow;
+
+    template <int N>
+    Dual<N> sqrt(const Dual<N> &d)
+    {
+      const double r = std::sqrt(d.value());
+
+      return d.chain(r, 0.5 / r);
+    }
+
+    template <int N>
+    Dual<N> exp(const Dual<N> &d)
+    {
+      const double e = std::exp(d.value());
+
+      return d.chain(e, e);
+    }
+
+    template <int N>
+    Dual<N> log(const Dual<N> &d)
+    {
+      return d.chain(std::log(d.value()), 1.0 / d.value());
+    }
+
+    template <int N>
+    Dual<N> sin(const Dual<N> &d)
+    {
+      return d.chain(std::sin(d.value()), std::cos(d.value()));
+    }
+
+    template <int N>
+    Dual<N> cos(const Dual<N> &d)
+    {
+      return d.chain(std::cos(d.value()), -std::sin(d.value()));
+    }
+
+    template <int N>
+    Dual<N> tan(const Dual<N> &d)
+    {
+      const double t = std::tan(d.value());
+
+      return d.chain(t, 1.0 + t * t);
+    }
+
+    template <int N>
+    Dual<N> asin(const Dual<N> &d)
+    {
+      return d.chain(std::asin(d.value()),
+                     1.0 / std::sqrt(1.0 - d.value() * d.value()));
+    }
+
+    template <int N>
+    Dual<N> acos(const Dual<N> &d)
+    {
+      return d.chain(std::acos(d.value()),
+                     -1.0 / std::sqrt(1.0 - d.value() * d.value()));
+    }
+
+    template <int N>
+    Dual<N> atan(const Dual<N> &d)
+    {
+      return d.chain(std::atan(d.value()),
+                     1.0 / (1.0 + d.value() * d.value()));
+    }
+
+    template <int N>
+    Dual<N> sinh(const Dual<N> &d)
+    {
+      return d.chain(std::sinh(d.value()), std::cosh(d.value()));
+    }
+
+    template <int N>
+    Dual<N> cosh(const Dual<N> &d)
+    {
+      return d.chain(std::cosh(d.value()), std::sinh(d.value()));
+    }
+
+    template <int N>
+    Dual<N> tanh(const Dual<N> &d)
+    {
+      const double t = std::tanh(d.value());
+
+      return d.chain(t, 1.0 - t * t);
+    }
+
+    template <int N>
+    Dual<N> fabs(const Dual<N> &d)
+    {
+      return d.value() < 0.0 ? -d : d;
+    }
+
+    template <int N>
+    Dual<N> pow(const Dual<N> &d, double e)
+    {
+      const double p = std::pow(d.value(), e - 1.0);
+
+      return d.chain(p * d.value(), e * p);
+    }
+
+    template <int N>
+    Dual<N> square(const Dual<N> &d)
+    {
+      return d.chain(d.value() * d.value(), 2.0 * d.value());
+    }
+
+    template <int N>
+    std::ostream & operator<<(std::ostream &o, const Dual<N> &d)
+    {
+      o << "[" << d.value();
+
+      for (int i = 0; i < N; i++)
+        o << ", " << d.deriv(i);
+
+      o << "]";
+      return o;
+    }
+
+  }
+}
+
+#endif
+
@@ -76,6 +76,11 @@ namespace _Goptical {
       /** Get shape bounding box */
       virtual Math::VectorPair2 get_bounding_box() const = 0;
 
+      /** Compute lazily evaluated internal state so that further
+          const calls do not modify the shape object. Default
+          implementation does nothing. @see Sys::System::freeze */
+      virtual void prepare() const;
+
       /** Get number of contours polygones. This function returns
           value is greater than 1 if shape has hole(s). @see get_contour */
       virtual unsigned int get_contour_count() const = 0;
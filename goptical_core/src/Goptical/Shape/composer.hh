@@ -76,6 +76,8 @@ namespace _Goptical {
       void get_contour(unsigned int contour, const Math::Vector2::put_delegate_t  &f, double resolution) const;
       /** @override */
       void get_triangles(const Math::Triangle<2>::put_delegate_t  &f, double resolution) const;
+      /** @override */
+      void prepare() const;
 
       /** Add a new shape to shape composer.
           
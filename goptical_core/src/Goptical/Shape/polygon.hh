@@ -73,6 +73,8 @@ namespace _Goptical {
       /** @override */
       Math::VectorPair2 get_bounding_box() const;
       /** @override */
+      void prepare() const;
+      /** @override */
       bool inside(const Math::Vector2 &point) const;
       /** @override */
       inline unsigned int get_contour_count() const;
@@ -168,12 +168,27 @@ namespace _Goptical {
       /** Set enable state */ /* FIXME virtual, recursive for groups */
       inline void set_enable_state(bool enabled);
 
+      /** Compute lazily evaluated state of element and attached
+          objects so that ray tracing does not modify them. Default
+          implementation does nothing. @see System::freeze */
+      virtual void prepare() const;
+
       /** Batch process a list of light rays interacting with element.
           This function is only used in sequential ray trace mode. */
       template <Trace::IntensityMode m>
       inline void process_rays(Trace::Result &result,
                                Trace::rays_queue_t *input) const;
 
+      /** Batch process rays in range [first, last) of a packet
+          interacting with element. Interception data is stored in
+          input packet and generated rays are appended to output
+          packet. This function is only used in sequential packet ray
+          trace mode. */
+      template <Trace::IntensityMode m>
+      inline void process_packet(const Trace::Params &params, Trace::RayPacket &input,
+                                 unsigned int first, unsigned int last,
+                                 Trace::RayPacket &output) const;
+
       /** Draw element 2d layout using the given renderer in given
           element coordinates. */
       virtual void draw_2d_e(Io::Renderer &r, const Element *ref) const;
@@ -207,6 +222,27 @@ protected:
       virtual void process_rays_polarized(Trace::Result &result,
                                           Trace::rays_queue_t *input) const;
 
+      /** This function process incoming rays packet. It must be
+          reimplemented in subclasses if the element can interact with
+          light in simple packet raytrace mode. */
+      virtual void process_packet_simple(const Trace::Params &params, Trace::RayPacket &input,
+                                         unsigned int first, unsigned int last,
+                                         Trace::RayPacket &output) const;
+
+      /** This function process incoming rays packet. It must be
+          reimplemented in subclasses if the element can interact with
+          light in intensity packet raytrace mode. */
+      virtual void process_packet_intensity(const Trace::Params &params, Trace::RayPacket &input,
+                                            unsigned int first, unsigned int last,
+                                            Trace::RayPacket &output) const;
+
+      /** This function process incoming rays packet. It must be
+          reimplemented in subclasses if the element can interact with
+          light in polarized packet raytrace mode. */
+      virtual void process_packet_polarized(const Trace::Params &params, Trace::RayPacket &input,
+                                            unsigned int first, unsigned int last,
+                                            Trace::RayPacket &output) const;
+
       /** This function is called from the @ref System class when the
           element is added to a system */
       virtual void system_register(System &s);
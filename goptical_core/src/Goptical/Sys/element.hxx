@@ -109,6 +109,27 @@ namespace _Goptical {
         }
     }
 
+    template <Trace::IntensityMode m>
+    inline void Element::process_packet(const Trace::Params &params, Trace::RayPacket &input,
+                                        unsigned int first, unsigned int last,
+                                        Trace::RayPacket &output) const
+    {
+      switch (m)
+        {
+        case Trace::SimpleTrace:
+          process_packet_simple(params, input, first, last, output);
+          break;
+
+        case Trace::IntensityTrace:
+          process_packet_intensity(params, input, first, last, output);
+          break;
+
+        case Trace::PolarizedTrace:
+          process_packet_polarized(params, input, first, last, output);
+          break;
+        }
+    }
+
     std::ostream & operator<<(std::ostream &o, const Element &e)
     {
       e.print(o);
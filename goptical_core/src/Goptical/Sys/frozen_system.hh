@@ -0,0 +1,79 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#ifndef GOPTICAL_FROZEN_SYSTEM_HH_
+#define GOPTICAL_FROZEN_SYSTEM_HH_
+
+#include "Goptical/common.hh"
+
+namespace _Goptical {
+
+  namespace Sys {
+
+    /**
+       @short Read only view of a prepared optical system
+       @header Goptical/Sys/FrozenSystem
+       @module {Core}
+
+       This class is returned by @ref System::freeze. Transforms
+       used by ray tracing, data set interpolation tables and other
+       lazily computed states of the system and its elements have
+       been computed so that ray tracing does not modify any shared
+       object. Any number of @ref Trace::Tracer objects built from
+       the same frozen system may trace concurrently without locking
+       when they use the propagation mode and sequence given to
+       freeze; tracing with other parameters throws an @ref Error.
+
+       The system must not be modified while tracers use the frozen
+       view; tracing throws an @ref Error if the system version
+       changed since it was frozen. Changes to curves and shapes
+       of attached surfaces do not update the system version and
+       require a new call to @ref System::freeze.
+    */
+    class FrozenSystem
+    {
+      friend class System;
+
+    public:
+      /** Get frozen system */
+      inline const System & get_system() const;
+
+      /** Test if system has not been modified since freeze */
+      inline bool is_valid() const;
+
+      /** Throw an @ref Error if system has been modified since freeze */
+      inline void check() const;
+
+    private:
+      explicit inline FrozenSystem(const System &system);
+
+      const_ref<System>         _system;
+      unsigned int              _version;
+    };
+
+  }
+}
+
+#endif
+
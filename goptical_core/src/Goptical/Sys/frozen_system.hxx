@@ -0,0 +1,61 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#ifndef GOPTICAL_FROZEN_SYSTEM_HXX_
+#define GOPTICAL_FROZEN_SYSTEM_HXX_
+
+#include "Goptical/error.hh"
+#include "Goptical/Sys/system.hxx"
+
+namespace _Goptical {
+
+  namespace Sys {
+
+    FrozenSystem::FrozenSystem(const System &system)
+      : _system(system),
+        _version(system.get_version())
+    {
+    }
+
+    const System & FrozenSystem::get_system() const
+    {
+      return *_system;
+    }
+
+    bool FrozenSystem::is_valid() const
+    {
+      return _system->get_version() == _version;
+    }
+
+    void FrozenSystem::check() const
+    {
+      if (!is_valid())
+        throw Error("system has been modified since freeze");
+    }
+
+  }
+}
+
+#endif
+
@@ -61,6 +61,16 @@ namespace _Goptical {
                                const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const;
       void trace_ray_polarized(Trace::Result &result, Trace::Ray &incident,
                                const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const;
+
+      void trace_packet_simple(Trace::RayPacket &input, unsigned int index,
+                               const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                               Trace::RayPacket &output) const;
+      void trace_packet_intensity(Trace::RayPacket &input, unsigned int index,
+                                  const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                  Trace::RayPacket &output) const;
+      void trace_packet_polarized(Trace::RayPacket &input, unsigned int index,
+                                  const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                  Trace::RayPacket &output) const;
     };
 
   }
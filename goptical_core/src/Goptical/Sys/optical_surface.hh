@@ -96,14 +96,35 @@ namespace _Goptical {
       /** Get surface natural color from material properties. */
       Io::Rgb get_color(const Io::Renderer &r) const;
 
+      /** @override Prepare curve, shape and materials */
+      void prepare() const;
+
     private:
 
+      /** Trace interaction of a ray with surface and store generated
+          rays in output. Shared by rays and rays packets */
+      template <Trace::IntensityMode m, class Output>
+      inline void trace_interaction(Output &output, const Material::Base *material,
+                                    double wl, double intensity,
+                                    const Trace::SpectralTable *table,
+                                    const Math::VectorPair3 &local,
+                                    const Math::VectorPair3 &intersect) const;
+
       void trace_ray_simple(Trace::Result &result, Trace::Ray &incident,
                             const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const;
 
       void trace_ray_intensity(Trace::Result &result, Trace::Ray &incident,
                                const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const;
 
+      /** @override */
+      void trace_packet_simple(Trace::RayPacket &input, unsigned int index,
+                               const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                               Trace::RayPacket &output) const;
+      /** @override */
+      void trace_packet_intensity(Trace::RayPacket &input, unsigned int index,
+                                  const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                  Trace::RayPacket &output) const;
+
       /** @override */
       void system_register(System &s);
 
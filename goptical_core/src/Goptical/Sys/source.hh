@@ -71,6 +71,18 @@ namespace _Goptical {
       /** Clear wavelen list */
       inline void clear_spectrum();
 
+      /** Get wavelen list */
+      inline const std::vector<Light::SpectralLine> & get_spectrum() const;
+
+      /** Set spectral sampling mode used when generating rays for
+          pattern points. Default is @ref SpectralAllLines. Other
+          modes generate a single ray per pattern point so that rays
+          count does not depend on spectrum resolution. */
+      inline void set_spectral_sampling(SpectralSampling s);
+
+      /** Get spectral sampling mode */
+      inline SpectralSampling get_spectral_sampling() const;
+
       /** Get maximal spectral line intensity */
       inline double get_max_intensity() const;
 
@@ -107,6 +119,7 @@ namespace _Goptical {
       std::vector<Light::SpectralLine>  _spectrum;
       double                            _min_intensity, _max_intensity;
       const_ref<Material::Base>     _mat;
+      SpectralSampling                  _sampling;
     };
   }
 }
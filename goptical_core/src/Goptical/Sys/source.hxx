@@ -68,6 +68,21 @@ namespace _Goptical {
       refresh_intensity_limits();
     }
 
+    const std::vector<Light::SpectralLine> & Source::get_spectrum() const
+    {
+      return _spectrum;
+    }
+
+    void Source::set_spectral_sampling(SpectralSampling s)
+    {
+      _sampling = s;
+    }
+
+    SpectralSampling Source::get_spectral_sampling() const
+    {
+      return _sampling;
+    }
+
     double Source::get_max_intensity() const
     {
       return _max_intensity;
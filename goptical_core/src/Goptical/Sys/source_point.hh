@@ -68,6 +68,16 @@ namespace _Goptical {
       /** Change current point source infinity mode */
       inline void set_mode(SourceInfinityMode mode);
 
+      /** Generate rays toward precomputed distribution pattern
+          points of target surface, as if source was located or
+          oriented as specified by @tt pos_dir in global coordinates
+          and had the given spectrum. Source state is not used. This
+          is used by @ref Trace::Tracer::trace_batch. */
+      void generate_pattern_rays(Trace::Result &result, const Surface &target,
+                                 const std::vector<Math::Vector3> &pattern,
+                                 SourceInfinityMode mode, const Math::Vector3 &pos_dir,
+                                 const std::vector<Light::SpectralLine> &spectrum) const;
+
     private:
 
       void generate_rays_simple(Trace::Result &result,
@@ -63,14 +63,23 @@ namespace _Goptical {
           radius. */
       Stop(const Math::VectorPair3 &p, double radius);
 
-      GOPTICAL_ACCESSORS(double, external_radius,
-                         "stop external radius. @see Stop");
+      GOPTICAL_GET_ACCESSOR(double, external_radius,
+                            "stop external radius. @see Stop");
+
+      /** Set stop external radius. @see Stop */
+      inline void set_external_radius(double radius);
 
       GOPTICAL_ACCESSORS(bool, intercept_reemit,
                          "intercept and reemit enabled. @see Stop");
 
+      /** @override Stop intercepts rays up to external radius */
+      Math::VectorPair3 get_bounding_box() const;
+
     private:
 
+      /** Test if ray hitting stop at given point must be reemitted */
+      inline bool reemit_test(bool sequential, const Math::VectorPair3 &intersect) const;
+
       /** @override */
       void draw_2d_e(Io::Renderer &r, const Element *ref) const;
       /** @override Only draw stop surface edges */
@@ -81,9 +90,11 @@ namespace _Goptical {
                                Trace::rays_queue_t *input) const;
 
       /** @override */
-      bool intersect(const Trace::Params &params,
-                     Math::VectorPair3 &pt,
-                     const Math::VectorPair3 &ray) const;
+      bool intercept_test(const Trace::Params &params,
+                          const Math::Vector3 &point) const;
+
+      /** @override Stop intercepts rays up to external radius */
+      double get_intersect_radius(const Trace::Params &params) const;
 
       /** @override */
       void trace_ray_simple(Trace::Result &result, Trace::Ray &incident,
@@ -93,6 +104,16 @@ namespace _Goptical {
       void trace_ray_intensity(Trace::Result &result, Trace::Ray &incident,
                                const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const;
 
+      /** @override */
+      void trace_packet_simple(Trace::RayPacket &input, unsigned int index,
+                               const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                               Trace::RayPacket &output) const;
+
+      /** @override */
+      void trace_packet_intensity(Trace::RayPacket &input, unsigned int index,
+                                  const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                  Trace::RayPacket &output) const;
+
       /** @override */
       void process_rays_simple(Trace::Result &result,
                               Trace::rays_queue_t *input) const;
@@ -31,6 +31,12 @@ namespace _Goptical {
 
   namespace Sys {
 
+    void Stop::set_external_radius(double radius)
+    {
+      _external_radius = radius;
+      update_version();
+    }
+
   }
 }
 
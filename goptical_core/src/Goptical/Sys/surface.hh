@@ -83,6 +83,20 @@ namespace _Goptical {
                              Math::VectorPair3 &pt,
                              const Math::VectorPair3 &ray) const;
 
+      /** Test if an intersection point found on surface curve is
+          intercepted by the surface. Default implementation tests
+          if point is inside surface shape unless in unobstructed
+          mode. */
+      virtual bool intercept_test(const Trace::Params &params,
+                                  const Math::Vector3 &point) const;
+
+      /** Get distance from surface axis beyond which intersection
+          points are never intercepted, used to bound curve
+          intersection search. Zero means unbounded. Default
+          implementation returns shape max radius unless in
+          unobstructed mode. */
+      virtual double get_intersect_radius(const Trace::Params &params) const;
+
       /** Get distribution pattern points projected on the surface */
       void get_pattern(const Math::Vector3::put_delegate_t &f,
                        const Trace::Distribution &d,
@@ -102,8 +116,20 @@ namespace _Goptical {
       /** Get minimal ray intensity. */
       inline double get_discard_intensity() const;
 
+      /** @override Sagitta range of curve over shape bounding box
+          is used along z axis */
       Math::VectorPair3 get_bounding_box() const;
 
+      /** Get box enclosing all points which may be returned by @ref
+          intersect, in local coordinates. Unlike @ref get_bounding_box,
+          this includes curve intersections which are not on the
+          sagitta, see @ref Curve::Base::intersect_range. Return
+          false if the curve can only estimate the box. */
+      bool get_intersect_box(Math::VectorPair3 &box) const;
+
+      /** @override Prepare curve and shape */
+      void prepare() const;
+
     protected:
 
       /** This function must be reimplemented by subclasses to handle
@@ -121,6 +147,24 @@ namespace _Goptical {
       virtual void trace_ray_polarized(Trace::Result &result, Trace::Ray &incident,
                                        const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const;
 
+      /** This function must be reimplemented by subclasses to handle
+          incoming packet rays in simple packet ray trace mode. */
+      virtual void trace_packet_simple(Trace::RayPacket &input, unsigned int index,
+                                       const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                       Trace::RayPacket &output) const;
+
+      /** This function must be reimplemented by subclasses to handle
+          incoming packet rays in intensity packet ray trace mode. */
+      virtual void trace_packet_intensity(Trace::RayPacket &input, unsigned int index,
+                                          const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                          Trace::RayPacket &output) const;
+
+      /** This function must be reimplemented by subclasses to handle
+          incoming packet rays in polarized packet ray trace mode. */
+      virtual void trace_packet_polarized(Trace::RayPacket &input, unsigned int index,
+                                          const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                          Trace::RayPacket &output) const;
+
       /** @override */
       void draw_2d_e(Io::Renderer &r, const Element *ref) const;
       /** @override */
@@ -146,6 +190,28 @@ namespace _Goptical {
       virtual void process_rays_polarized(Trace::Result &result,
                                           Trace::rays_queue_t *input) const;
 
+      template <Trace::IntensityMode m>
+      inline void trace_packet_ray(Trace::RayPacket &input, unsigned int index,
+                                   const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                   Trace::RayPacket &output) const;
+
+      template <Trace::IntensityMode m>
+      inline void process_packet_(const Trace::Params &params, Trace::RayPacket &input,
+                                  unsigned int first, unsigned int last,
+                                  Trace::RayPacket &output) const;
+
+      virtual void process_packet_simple(const Trace::Params &params, Trace::RayPacket &input,
+                                         unsigned int first, unsigned int last,
+                                         Trace::RayPacket &output) const;
+
+      virtual void process_packet_intensity(const Trace::Params &params, Trace::RayPacket &input,
+                                            unsigned int first, unsigned int last,
+                                            Trace::RayPacket &output) const;
+
+      virtual void process_packet_polarized(const Trace::Params &params, Trace::RayPacket &input,
+                                            unsigned int first, unsigned int last,
+                                            Trace::RayPacket &output) const;
+
       double                    _discard_intensity;
       const_ref<Curve::Base>   _curve;
       const_ref<Shape::Base>   _shape;
@@ -102,11 +102,59 @@ namespace _Goptical {
       /** Increase current system version */
       inline void update_version();
 
-      /** Find surface which colides with the given ray and update intersection point */
+      /** Find surface which colides with the given ray and update
+          intersection point. A bounding volume hierarchy of all
+          enabled surfaces is used to only test surfaces which may
+          be hit by the ray. */
       Surface * colide_next(const Trace::Params &params,
                             Math::VectorPair3 &intersect,
                             const Trace::Ray &ray) const;
 
+      /** Same as @ref colide_next, also get ray in local coordinates
+          of the returned surface. Rays are moved to surfaces local
+          coordinates through global coordinates so that transforms
+          between pairs of elements are not needed. */
+      Surface * colide_next(const Trace::Params &params,
+                            Math::VectorPair3 &intersect,
+                            Math::VectorPair3 &local,
+                            const Trace::Ray &ray) const;
+
+      /** @internal Rebuild surfaces bounding volume hierarchy and
+          global transforms used by @ref colide_next from current
+          curves and shapes. Called before each trace, must be called
+          before concurrent use of @ref colide_next. */
+      void colide_prepare() const;
+
+      /** @internal Fill transforms cache with transforms used when
+          tracing with given parameters: local and global transforms
+          of enabled elements, transforms between consecutive
+          sequence elements in sequential mode and between sources
+          and their target surface. Transforms between other pairs
+          of elements are not computed. Must be called before
+          concurrent use of cached transforms. */
+      void transform_cache_prepare(const Trace::Params &params) const;
+
+      /** @internal Test if all transforms computed by @ref
+          transform_cache_prepare for given parameters are available
+          in cache. Does not modify the cache. */
+      bool transform_cache_ready(const Trace::Params &params) const;
+
+      /** Compute 3d transforms used when tracing with given
+          parameters, data set interpolation tables and other lazily
+          evaluated states of the system and its elements. Only
+          local and global transforms of elements and transforms
+          between consecutive sequence elements are computed, see
+          @ref transform_cache_prepare. The returned read only view
+          can be traced concurrently by any number of @ref
+          Trace::Tracer objects using the same propagation mode and
+          sequence. The system must not be modified while the view
+          is in use. */
+      FrozenSystem freeze(const Trace::Params &params) const;
+
+      /** Freeze system for tracing with default tracer parameters,
+          see @ref get_tracer_params. */
+      FrozenSystem freeze() const;
+
       /** set environment material */
       void set_environment(const const_ref<Material::Base> &env);
 
@@ -131,8 +179,14 @@ namespace _Goptical {
       /** free the identifier associated with the given element */
       void index_put(const Element &element);
 
-      /** Get a reference to cache entry for transform between 2 elements (ids) */
-      inline Math::Transform<3> * & transform_cache_entry(unsigned int from, unsigned int to) const;
+      /** Get hash table start position for transform between 2 elements (ids) */
+      static inline unsigned int transform_cache_hash(unsigned int from, unsigned int to);
+      /** Find valid cached transform between 2 elements (ids), 0 if not available */
+      inline const Math::Transform<3> * transform_cache_lookup(unsigned int from, unsigned int to) const;
+      /** Get storage for a new transform between 2 elements (ids) */
+      Math::Transform<3> & transform_cache_insert(unsigned int from, unsigned int to) const;
+      /** Grow cache hash table and drop outdated entries */
+      void transform_cache_rehash(unsigned int newsize);
 
       /** Compute and get 3d transform between element local and global coordinates */
       const Math::Transform<3> & transform_l2g_cache_update(const Element &e) const;
@@ -141,13 +195,52 @@ namespace _Goptical {
       /** Compute and get 3d transform between two elements local coordinates */
       const Math::Transform<3> & transform_cache_update(const Element &from, const Element &to) const;
 
+      /** Compute transforms used when tracing with given parameters,
+          or test if they are all cached when @tt update is false */
+      bool transform_cache_walk(const Trace::Params &params, bool update) const;
+      /** Compute transform between two elements, 0 is global
+          coordinates, or test if it is cached when @tt update is false */
+      inline bool transform_cache_need(const Element *from, const Element *to, bool update) const;
+
       /** Flush all cached transforms associated with a given element */
       void transform_cache_flush(const Element &element);
       /** Flush all cached transforms */
       void transform_cache_flush();
 
-      /** Resize transform cache size */
-      void transform_cache_resize(unsigned int newsize);
+      /** transform cache hash table entry */
+      struct transform_cache_entry_s
+      {
+        unsigned int            _from;          // element ids, 0 is global coordinates
+        unsigned int            _to;
+        unsigned int            _from_gen;      // ids generation when computed
+        unsigned int            _to_gen;
+        Math::Transform<3>      *_transform;    // 0 for unused entry
+      };
+
+      typedef std::vector<transform_cache_entry_s> transform_cache_t;
+
+      struct bvh_item_s;
+      struct bvh_item_cmp;
+
+      /** surfaces bounding volume hierarchy node */
+      struct bvh_node_s
+      {
+        Math::VectorPair3       _box;   // global coordinates bounding box
+        unsigned int            _first; // first child node or first leaf surface
+        unsigned int            _count; // leaf surfaces count, 0 for inner nodes
+      };
+
+      /** Rebuild surfaces bounding volume hierarchy */
+      void bvh_update();
+      /** Update boxes of existing hierarchy nodes from current
+          curves and shapes, return false if a rebuild is needed */
+      bool bvh_refit();
+      /** Compute padded global bounding box of surface, return
+          false if surface must be tested linearly */
+      bool bvh_surface_box(Surface *s, Math::VectorPair3 &box);
+      /** Setup node for a range of items and build its children */
+      void bvh_build(unsigned int node, std::vector<bvh_item_s> &items,
+                     unsigned int first, unsigned int last);
 
       unsigned int              _version;
 
@@ -155,10 +248,17 @@ namespace _Goptical {
       const_ref<Surface>        _exit;
       Material::Proxy           _env_proxy;
       Trace::Params             _tracer_params;
-      unsigned int              _e_count;
       std::vector<Element *>    _index_map;
-      // FIXME use transform pool instead of new/delete
-      std::vector<Math::Transform<3> *> _transform_cache;
+      std::vector<unsigned int> _index_free;    // unused ids in index map
+      std::vector<unsigned int> _index_gen;     // ids generation, changes on flush
+      transform_cache_t         _transform_cache;       // open addressing hash table
+      unsigned int              _transform_cache_used;  // used hash table entries
+      dpp::vector_pool<Math::Transform<3> > _transform_pool;
+      std::vector<Math::Transform<3> *> _transform_free;  // unused transforms in pool
+      std::vector<bvh_node_s>   _bvh_nodes;
+      std::vector<Surface *>    _bvh_surfaces;  // surfaces referenced by leaf nodes
+      std::vector<Surface *>    _bvh_unbounded; // surfaces without finite bounding box
+      unsigned int              _bvh_version;
     };
 
   }
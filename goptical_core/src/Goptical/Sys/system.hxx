@@ -85,39 +85,65 @@ namespace _Goptical {
       return _tracer_params;
     }
 
-    Math::Transform<3> * & System::transform_cache_entry(unsigned int from, unsigned int to) const
+    unsigned int System::transform_cache_hash(unsigned int from, unsigned int to)
     {
-      return const_cast<Math::Transform<3> * &>(_transform_cache[from * _e_count + to]);
+      return from * 0x9e3779b1 ^ to * 0x85ebca77;
     }
 
-    const Math::Transform<3> & System::get_transform(const Element &from, const Element &to) const
+    const Math::Transform<3> * System::transform_cache_lookup(unsigned int from, unsigned int to) const
     {
-      Math::Transform<3> * &e = transform_cache_entry(from.id(), to.id());
+      unsigned int mask = _transform_cache.size() - 1;
+
+      for (unsigned int i = transform_cache_hash(from, to) & mask; ; i = (i + 1) & mask)
+        {
+          const transform_cache_entry_s &e = _transform_cache[i];
 
-      if (!e)
-        transform_cache_update(from, to);
+          if (!e._transform)
+            return 0;
 
-      return *e;
+          if (e._from == from && e._to == to)
+            return e._from_gen == _index_gen[from] && e._to_gen == _index_gen[to]
+              ? e._transform : 0;
+        }
     }
 
-    const Math::Transform<3> & System::get_global_transform(const Element &from) const
+    bool System::transform_cache_need(const Element *from, const Element *to, bool update) const
     {
-      Math::Transform<3> * &e = transform_cache_entry(from.id(), 0);
+      if (!update)
+        return transform_cache_lookup(from ? from->id() : 0, to ? to->id() : 0) != 0;
 
-      if (!e)
-        transform_l2g_cache_update(from);
+      if (!from)
+        get_local_transform(*to);
+      else if (!to)
+        get_global_transform(*from);
+      else
+        get_transform(*from, *to);
 
-      return *e;
+      return true;
     }
 
-    const Math::Transform<3> & System::get_local_transform(const Element &to) const
+    const Math::Transform<3> & System::get_transform(const Element &from, const Element &to) const
+    {
+      if (const Math::Transform<3> *t = transform_cache_lookup(from.id(), to.id()))
+        return *t;
+
+      return transform_cache_update(from, to);
+    }
+
+    const Math::Transform<3> & System::get_global_transform(const Element &from) const
     {
-      Math::Transform<3> * &e = transform_cache_entry(0, to.id());
+      if (const Math::Transform<3> *t = transform_cache_lookup(from.id(), 0))
+        return *t;
 
-      if (!e)
-        transform_g2l_cache_update(to);
+      return transform_l2g_cache_update(from);
+    }
+
+    const Math::Transform<3> & System::get_local_transform(const Element &to) const
+    {
+      if (const Math::Transform<3> *t = transform_cache_lookup(0, to.id()))
+        return *t;
 
-      return *e;
+      return transform_g2l_cache_update(to);
     }
 
     void System::update_version()
@@ -132,12 +158,12 @@ namespace _Goptical {
 
     unsigned int System::get_element_count() const
     {
-      return _e_count - 1;
+      return _index_map.size() - 1;
     }
 
     Element & System::get_element(unsigned int index) const
     {
-      assert(index > 0 && index <= _e_count);
+      assert(index > 0 && index < _index_map.size());
       return *_index_map[index];
     }
 
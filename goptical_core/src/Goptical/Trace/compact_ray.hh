@@ -0,0 +1,118 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+
+#ifndef GOPTICAL_TRACE_COMPACTRAY_HH_
+#define GOPTICAL_TRACE_COMPACTRAY_HH_
+
+#include "Goptical/common.hh"
+
+#include "Goptical/Math/vector.hh"
+#include "Goptical/Math/vector_pair.hh"
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    /**
+       @short Compact record of a propagated light ray
+       @header Goptical/Trace/CompactRay
+       @module {Core}
+
+       This class stores the same propagation data as @ref Ray in a
+       smaller record. It is used by @ref Result objects when the
+       @ref Params::set_compact_storage {compact storage} mode is
+       enabled.
+
+       Records are stored in a single contiguous array. Rays tree
+       links are 32 bits indexes in this array, creator and
+       interception elements are referred to by @ref Sys::Element::id
+       {element id} and materials by index in the result materials
+       table.
+     */
+    class CompactRay
+    {
+      friend class Result;
+
+    public:
+      /** Index value used when there is no such ray */
+      static const unsigned int no_index = (unsigned int)-1;
+
+      /** Get ray origin and direction in creator element coordinates */
+      inline const Math::VectorPair3 & get_ray() const;
+      /** Get ray origin in creator element coordinates */
+      inline const Math::Vector3 & get_origin() const;
+      /** Get ray direction in creator element coordinates */
+      inline const Math::Vector3 & get_direction() const;
+
+      GOPTICAL_GET_ACCESSOR(double, wavelen, "ray wavelength.");
+
+      GOPTICAL_GET_ACCESSOR(double, intensity, "ray intensity.");
+
+      GOPTICAL_GET_ACCESSOR(double, intercept_intensity, "ray intensity at interception point.");
+
+      GOPTICAL_GET_ACCESSOR(double, len, "light ray length.");
+
+      /** Get light ray interception point */
+      inline const Math::Vector3 & get_intercept_point() const;
+
+      /** Return true if ray is not intercepted */
+      inline bool is_lost() const;
+
+      /** Get id of element which generated this ray */
+      inline unsigned int get_creator_id() const;
+      /** Get id of interception element, 0 if ray is lost */
+      inline unsigned int get_intercept_element_id() const;
+      /** Get index of material ray is propagated in */
+      inline unsigned int get_material_index() const;
+
+      /** Get index of ray which generated this one, @ref no_index
+          for source rays */
+      inline unsigned int get_parent() const;
+      /** Get index of first ray generated from this one */
+      inline unsigned int get_first_child() const;
+      /** Get index of next sibling ray generated by same parent */
+      inline unsigned int get_next_child() const;
+
+    private:
+      Math::VectorPair3         _ray;
+      Math::Vector3             _point;         // ray intersection point (intersect surface local)
+      double                    _wavelen;
+      double                    _intensity;
+      double                    _intercept_intensity;
+      double                    _len;
+      unsigned int              _parent;
+      unsigned int              _child;
+      unsigned int              _next;
+      unsigned int              _creator;       // element id
+      unsigned int              _i_element;     // element id, 0 if lost
+      unsigned int              _material;      // result materials table index
+    };
+
+  }
+}
+
+#endif
+
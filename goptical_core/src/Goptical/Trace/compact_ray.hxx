@@ -0,0 +1,96 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+
+#ifndef GOPTICAL_TRACE_COMPACTRAY_HXX_
+#define GOPTICAL_TRACE_COMPACTRAY_HXX_
+
+#include "Goptical/Math/vector.hxx"
+#include "Goptical/Math/vector_pair.hxx"
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    const Math::VectorPair3 & CompactRay::get_ray() const
+    {
+      return _ray;
+    }
+
+    const Math::Vector3 & CompactRay::get_origin() const
+    {
+      return _ray.origin();
+    }
+
+    const Math::Vector3 & CompactRay::get_direction() const
+    {
+      return _ray.direction();
+    }
+
+    const Math::Vector3 & CompactRay::get_intercept_point() const
+    {
+      return _point;
+    }
+
+    bool CompactRay::is_lost() const
+    {
+      return _i_element == 0;
+    }
+
+    unsigned int CompactRay::get_creator_id() const
+    {
+      return _creator;
+    }
+
+    unsigned int CompactRay::get_intercept_element_id() const
+    {
+      return _i_element;
+    }
+
+    unsigned int CompactRay::get_material_index() const
+    {
+      return _material;
+    }
+
+    unsigned int CompactRay::get_parent() const
+    {
+      return _parent;
+    }
+
+    unsigned int CompactRay::get_first_child() const
+    {
+      return _child;
+    }
+
+    unsigned int CompactRay::get_next_child() const
+    {
+      return _next;
+    }
+
+  }
+}
+
+#endif
+
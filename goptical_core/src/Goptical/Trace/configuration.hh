@@ -0,0 +1,121 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_CONFIGURATION_HH_
+#define GOPTICAL_TRACE_CONFIGURATION_HH_
+
+#include <vector>
+
+#include "Goptical/common.hh"
+
+#include "Goptical/Trace/distribution.hh"
+#include "Goptical/Light/spectral_line.hh"
+#include "Goptical/Math/vector.hh"
+
+namespace _Goptical
+{
+
+  namespace Trace
+  {
+
+    /**
+       @short Point source configuration for batch ray tracing
+       @header Goptical/Trace/Configuration
+       @module {Core}
+
+       This class describes a single configuration of a @ref
+       Sys::SourcePoint traced by @ref Tracer::trace_batch. It
+       specifies source position or direction in system global
+       coordinates, light spectrum and rays distribution
+       pattern. The source element itself is left untouched.
+
+       Source spectrum is copied when the configuration is
+       created. Distribution from tracer parameters is used unless
+       one is set in the configuration.
+     */
+
+    class Configuration
+    {
+    public:
+      /** Creates a configuration for given point source. Source is
+          infinitely far away in direction @tt pos_dir or located at
+          position @tt pos_dir depending on mode. */
+      inline Configuration(const Sys::SourcePoint &source,
+                           Sys::SourceInfinityMode mode,
+                           const Math::Vector3 &pos_dir);
+
+      /** Get configured source */
+      inline const Sys::SourcePoint & get_source() const;
+
+      /** Set source mode to infinity with given direction vector */
+      inline void set_infinity_direction(const Math::Vector3 &dir);
+
+      /** Set source mode to positioned with given position vector */
+      inline void set_position(const Math::Vector3 &pos);
+
+      /** Get source mode */
+      inline Sys::SourceInfinityMode get_mode() const;
+
+      /** Get source position or direction vector depending on mode */
+      inline const Math::Vector3 & get_position_direction() const;
+
+      /** Add a new wavelen for ray generation */
+      inline void add_spectral_line(const Light::SpectralLine &l);
+
+      /** Clear ray wavelen list and set a single wavelen */
+      inline void single_spectral_line(const Light::SpectralLine &l);
+
+      /** Clear wavelen list */
+      inline void clear_spectrum();
+
+      /** Get wavelen list */
+      inline const std::vector<Light::SpectralLine> & get_spectrum() const;
+
+      /** Set rays distribution pattern used for this configuration */
+      inline void set_distribution(const Distribution &d);
+
+      /** Use distribution from tracer parameters (default) */
+      inline void reset_distribution();
+
+      /** Test if a distribution has been set for this configuration */
+      inline bool has_distribution() const;
+
+      /** Get configuration distribution pattern */
+      inline const Distribution & get_distribution() const;
+
+    private:
+      const Sys::SourcePoint            *_source;
+      Sys::SourceInfinityMode           _mode;
+      Math::Vector3                     _pos_dir;
+      std::vector<Light::SpectralLine>  _spectrum;
+      bool                              _has_distribution;
+      Distribution                      _distribution;
+    };
+
+  }
+}
+
+#endif
+
@@ -0,0 +1,126 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_CONFIGURATION_HXX_
+#define GOPTICAL_TRACE_CONFIGURATION_HXX_
+
+#include "Goptical/Trace/distribution.hxx"
+#include "Goptical/Light/spectral_line.hxx"
+#include "Goptical/Math/vector.hxx"
+#include "Goptical/Sys/source_point.hh"
+#include "Goptical/Sys/source.hxx"
+
+namespace _Goptical
+{
+
+  namespace Trace
+  {
+
+    Configuration::Configuration(const Sys::SourcePoint &source,
+                                 Sys::SourceInfinityMode mode,
+                                 const Math::Vector3 &pos_dir)
+      : _source(&source),
+        _mode(mode),
+        _pos_dir(pos_dir),
+        _spectrum(source.get_spectrum()),
+        _has_distribution(false),
+        _distribution()
+    {
+    }
+
+    const Sys::SourcePoint & Configuration::get_source() const
+    {
+      return *_source;
+    }
+
+    void Configuration::set_infinity_direction(const Math::Vector3 &dir)
+    {
+      _mode = Sys::SourceAtInfinity;
+      _pos_dir = dir;
+    }
+
+    void Configuration::set_position(const Math::Vector3 &pos)
+    {
+      _mode = Sys::SourceAtFiniteDistance;
+      _pos_dir = pos;
+    }
+
+    Sys::SourceInfinityMode Configuration::get_mode() const
+    {
+      return _mode;
+    }
+
+    const Math::Vector3 & Configuration::get_position_direction() const
+    {
+      return _pos_dir;
+    }
+
+    void Configuration::add_spectral_line(const Light::SpectralLine &l)
+    {
+      _spectrum.push_back(l);
+    }
+
+    void Configuration::single_spectral_line(const Light::SpectralLine &l)
+    {
+      _spectrum.clear();
+      _spectrum.push_back(l);
+    }
+
+    void Configuration::clear_spectrum()
+    {
+      _spectrum.clear();
+    }
+
+    const std::vector<Light::SpectralLine> & Configuration::get_spectrum() const
+    {
+      return _spectrum;
+    }
+
+    void Configuration::set_distribution(const Distribution &d)
+    {
+      _distribution = d;
+      _has_distribution = true;
+    }
+
+    void Configuration::reset_distribution()
+    {
+      _has_distribution = false;
+    }
+
+    bool Configuration::has_distribution() const
+    {
+      return _has_distribution;
+    }
+
+    const Distribution & Configuration::get_distribution() const
+    {
+      return _distribution;
+    }
+
+  }
+}
+
+#endif
+
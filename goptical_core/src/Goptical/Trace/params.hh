@@ -75,6 +75,18 @@ namespace _Goptical {
       GOPTICAL_ACCESSORS(PropagationMode, propagation_mode,
         "physical light propagation mode. @experimental @hidden");
 
+      GOPTICAL_ACCESSORS(unsigned int, thread_count,
+        "number of worker threads used for ray tracing, 0 means one thread per processor, default is 1");
+
+      GOPTICAL_ACCESSORS(bool, packet_mode,
+        "use @ref RayPacket {rays packets} in sequential ray tracing mode, default is false");
+
+      GOPTICAL_ACCESSORS(bool, compact_storage,
+        "store traced rays as @ref CompactRay {compact records} in result, default is false");
+
+      GOPTICAL_ACCESSORS(bool, wavelen_dedup,
+        "in non sequential mode, trace rays which only differ by wavelen once and copy resulting rays tree when propagation does not depend on wavelen, default is true");
+
       /** Set sequential ray tracing mode */
       inline void set_sequential_mode(const const_ref<Sequence> &seq);
 
@@ -84,6 +96,9 @@ namespace _Goptical {
       /** Test if in sequential ray tracing mode */
       inline bool is_sequential() const;
 
+      /** Get sequence used in sequential ray tracing mode */
+      inline const Sequence & get_sequence() const;
+
       /** Set distribution pattern for a given surface */
       inline void set_distribution(const Sys::Surface &s, const Distribution &dist);
 
@@ -105,6 +120,10 @@ namespace _Goptical {
       PropagationMode           _propagation_mode;
       bool                      _unobstructed;
       double                    _lost_ray_length;
+      unsigned int              _thread_count;
+      bool                      _packet_mode;
+      bool                      _compact_storage;
+      bool                      _wavelen_dedup;
     };
   }
 }
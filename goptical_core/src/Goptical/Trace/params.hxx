@@ -42,7 +42,11 @@ namespace _Goptical {
         _sequential_mode(false),
         _propagation_mode(RayPropagation),
         _unobstructed(false),
-        _lost_ray_length(1000)
+        _lost_ray_length(1000),
+        _thread_count(1),
+        _packet_mode(false),
+        _compact_storage(false),
+        _wavelen_dedup(true)
     {
     }
 
@@ -62,6 +66,11 @@ namespace _Goptical {
       return _sequential_mode;
     }
 
+    const Sequence & Params::get_sequence() const
+    {
+      return *_sequence;
+    }
+
     void Params::set_distribution(const Sys::Surface &s, const Distribution &dist)
     {
       _s_distribution[&s] = dist;
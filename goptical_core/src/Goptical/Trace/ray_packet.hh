@@ -0,0 +1,148 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_RAYPACKET_HH_
+#define GOPTICAL_TRACE_RAYPACKET_HH_
+
+#include <vector>
+
+#include "Goptical/common.hh"
+
+#include "Goptical/Math/vector.hh"
+#include "Goptical/Math/vector_pair.hh"
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    /**
+       @short Packet of light rays with structure of arrays layout
+       @header Goptical/Trace/RayPacket
+       @module {Core}
+
+       This class stores all rays generated by a single element
+       during a sequential ray trace when the @ref Params::set_packet_mode
+       {packet mode} is enabled. Each ray attribute is stored in its
+       own contiguous array so that elements can process the whole
+       packet with a single transform and dense memory accesses.
+
+       Rays in a packet are referenced by index. The parent of each
+       ray is the index of the incident ray in the packet processed
+       by the creator element. Interception data is recorded in the
+       packet when rays are processed by the next element.
+
+       @ref Result objects convert packets to the @ref Ray tree on
+       first access to the intercepted or generated rays lists.
+     */
+    class RayPacket
+    {
+    public:
+      /** Parent index of rays which have no parent ray */
+      static const unsigned int no_parent = (unsigned int)-1;
+
+      /** Create an empty rays packet */
+      RayPacket(const Sys::Element *creator = 0);
+
+      GOPTICAL_ACCESSORS(const Sys::Element *, creator, "element which generated rays in this packet.");
+      GOPTICAL_ACCESSORS(const Sys::Element *, intercept_element, "element which processed rays in this packet, if any.");
+      GOPTICAL_ACCESSORS(const SpectralTable *, spectral_table, "@internal material spectral properties table used to process rays, if any.");
+
+      /** Get number of rays in packet */
+      inline unsigned int size() const;
+
+      /** Remove all rays from packet, storage is kept allocated */
+      void clear();
+
+      /** Allocate storage for the given number of rays */
+      void reserve(unsigned int count);
+
+      /** Append all rays from an other packet */
+      void append(const RayPacket &p);
+
+      /** Add a new ray to packet and return its index */
+      inline unsigned int add_ray(const Math::Vector3 &origin, const Math::Vector3 &direction,
+                                  double wavelen, double intensity,
+                                  const Material::Base *material, unsigned int parent);
+
+      /** Get ray origin and direction in creator element coordinates */
+      inline Math::VectorPair3 get_ray(unsigned int i) const;
+      /** Get ray origin in creator element coordinates */
+      inline Math::Vector3 get_origin(unsigned int i) const;
+      /** Get ray direction in creator element coordinates */
+      inline Math::Vector3 get_direction(unsigned int i) const;
+      /** Get ray wavelength */
+      inline double get_wavelen(unsigned int i) const;
+      /** Get ray intensity */
+      inline double get_intensity(unsigned int i) const;
+      /** Get material ray is propagated in */
+      inline const Material::Base * get_material(unsigned int i) const;
+      /** Get index of parent ray in previous packet */
+      inline unsigned int get_parent(unsigned int i) const;
+
+      /** Set ray interception point in intercept element
+          coordinates, ray length and intensity at interception point */
+      inline void set_intercept(unsigned int i, const Math::Vector3 &point,
+                                double len, double intensity);
+      /** Return true if ray is not intercepted */
+      inline bool is_lost(unsigned int i) const;
+      /** Get ray interception point */
+      inline Math::Vector3 get_intercept_point(unsigned int i) const;
+      /** Get ray length */
+      inline double get_len(unsigned int i) const;
+      /** Get ray intensity at interception point */
+      inline double get_intercept_intensity(unsigned int i) const;
+
+      /** Get contiguous array of rays origin coordinates on given axis */
+      inline const double * get_origin_array(unsigned int axis) const;
+      /** Get contiguous array of rays direction coordinates on given axis */
+      inline const double * get_direction_array(unsigned int axis) const;
+      /** Get contiguous array of rays wavelengths */
+      inline const double * get_wavelen_array() const;
+      /** Get contiguous array of rays intensities */
+      inline const double * get_intensity_array() const;
+
+    private:
+      const Sys::Element                *_creator;
+      const Sys::Element                *_intercept_element;
+      const SpectralTable               *_spectral_table;
+
+      std::vector<double>               _origin[3];
+      std::vector<double>               _direction[3];
+      std::vector<double>               _wavelen;
+      std::vector<double>               _intensity;
+      std::vector<const Material::Base *> _material;
+      std::vector<unsigned int>         _parent;
+
+      std::vector<double>               _point[3];      // interception point
+      std::vector<double>               _len;
+      std::vector<double>               _intercept_intensity;
+      std::vector<unsigned char>        _lost;
+    };
+
+  }
+}
+
+#endif
+
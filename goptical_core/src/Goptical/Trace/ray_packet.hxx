@@ -0,0 +1,155 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_RAYPACKET_HXX_
+#define GOPTICAL_TRACE_RAYPACKET_HXX_
+
+#include <limits>
+
+#include "Goptical/Math/vector.hxx"
+#include "Goptical/Math/vector_pair.hxx"
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    unsigned int RayPacket::size() const
+    {
+      return _wavelen.size();
+    }
+
+    unsigned int RayPacket::add_ray(const Math::Vector3 &origin, const Math::Vector3 &direction,
+                                    double wavelen, double intensity,
+                                    const Material::Base *material, unsigned int parent)
+    {
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          _origin[j].push_back(origin[j]);
+          _direction[j].push_back(direction[j]);
+          _point[j].push_back(0.);
+        }
+
+      _wavelen.push_back(wavelen);
+      _intensity.push_back(intensity);
+      _material.push_back(material);
+      _parent.push_back(parent);
+      _len.push_back(std::numeric_limits<double>::max());
+      _intercept_intensity.push_back(0.);
+      _lost.push_back(true);
+
+      return _wavelen.size() - 1;
+    }
+
+    Math::VectorPair3 RayPacket::get_ray(unsigned int i) const
+    {
+      return Math::VectorPair3(get_origin(i), get_direction(i));
+    }
+
+    Math::Vector3 RayPacket::get_origin(unsigned int i) const
+    {
+      return Math::Vector3(_origin[0][i], _origin[1][i], _origin[2][i]);
+    }
+
+    Math::Vector3 RayPacket::get_direction(unsigned int i) const
+    {
+      return Math::Vector3(_direction[0][i], _direction[1][i], _direction[2][i]);
+    }
+
+    double RayPacket::get_wavelen(unsigned int i) const
+    {
+      return _wavelen[i];
+    }
+
+    double RayPacket::get_intensity(unsigned int i) const
+    {
+      return _intensity[i];
+    }
+
+    const Material::Base * RayPacket::get_material(unsigned int i) const
+    {
+      return _material[i];
+    }
+
+    unsigned int RayPacket::get_parent(unsigned int i) const
+    {
+      return _parent[i];
+    }
+
+    void RayPacket::set_intercept(unsigned int i, const Math::Vector3 &point,
+                                  double len, double intensity)
+    {
+      for (unsigned int j = 0; j < 3; j++)
+        _point[j][i] = point[j];
+
+      _len[i] = len;
+      _intercept_intensity[i] = intensity;
+      _lost[i] = false;
+    }
+
+    bool RayPacket::is_lost(unsigned int i) const
+    {
+      return _lost[i];
+    }
+
+    Math::Vector3 RayPacket::get_intercept_point(unsigned int i) const
+    {
+      return Math::Vector3(_point[0][i], _point[1][i], _point[2][i]);
+    }
+
+    double RayPacket::get_len(unsigned int i) const
+    {
+      return _len[i];
+    }
+
+    double RayPacket::get_intercept_intensity(unsigned int i) const
+    {
+      return _intercept_intensity[i];
+    }
+
+    const double * RayPacket::get_origin_array(unsigned int axis) const
+    {
+      return &_origin[axis][0];
+    }
+
+    const double * RayPacket::get_direction_array(unsigned int axis) const
+    {
+      return &_direction[axis][0];
+    }
+
+    const double * RayPacket::get_wavelen_array() const
+    {
+      return &_wavelen[0];
+    }
+
+    const double * RayPacket::get_intensity_array() const
+    {
+      return &_intensity[0];
+    }
+
+  }
+}
+
+#endif
+
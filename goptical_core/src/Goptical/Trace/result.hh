@@ -26,14 +26,14 @@
 #ifndef GOPTICAL_TRACE_RESULT_HH_
 #define GOPTICAL_TRACE_RESULT_HH_
 
-#include <set>
-#include <deque>
-
 #include "Goptical/common.hh"
 
 #include "Goptical/Sys/element.hh"
+#include "Goptical/Trace/spectral_table.hh"
 #include "Goptical/Sys/surface.hh"
 #include "Goptical/Trace/ray.hh"
+#include "Goptical/Trace/compact_ray.hh"
+#include "Goptical/Trace/ray_packet.hh"
 
 namespace _Goptical {
 
@@ -54,6 +54,16 @@ namespace _Goptical {
 
        All @ref Ray object are allocated by this class. It is able
        to remember which element intercepted and generated each ray.
+
+       When sequential ray tracing is performed in packet mode,
+       propagation data is first stored in @ref RayPacket objects. The
+       @ref Ray tree is only built on first access to rays lists.
+
+       When the @ref Params::set_compact_storage {compact storage}
+       mode is enabled, each rays tree is converted to @ref CompactRay
+       records once propagated and @ref Ray objects are released.
+       Rays lists are then only available as indexes in the compact
+       rays array.
     */
     class Result
     {
@@ -61,6 +71,8 @@ namespace _Goptical {
 
     public:
       typedef std::vector<const Sys::Source *> sources_t;
+      typedef std::vector<RayPacket *> packets_t;
+      typedef std::vector<CompactRay> compact_rays_t;
 
       /** Crate a new empty result object */
       Result();
@@ -72,6 +84,21 @@ namespace _Goptical {
       /** Get the list of rays generated by a given element */
       inline const rays_queue_t & get_generated(const Sys::Element &s) const;
 
+      /** Test if rays are stored as @ref CompactRay records */
+      inline bool is_compact() const;
+      /** Get array of compact rays records */
+      inline const Trace::Result::compact_rays_t & get_compact_rays() const;
+      /** Get indexes of compact rays striking a given surface */
+      inline const rays_index_t & get_intercepted_index(const Sys::Surface &s) const;
+      /** Get indexes of compact rays generated by a given element */
+      inline const rays_index_t & get_generated_index(const Sys::Element &e) const;
+      /** Get material of a compact ray */
+      inline const Material::Base & get_material(const CompactRay &r) const;
+
+      /** Get rays packets in sequence order when sequential ray
+          tracing was performed in packet mode */
+      inline const Trace::Result::packets_t & get_ray_packets() const;
+
       /** Get list of sources used for ray tracing */
       inline const Trace::Result::sources_t & get_source_list() const;
 
@@ -104,6 +131,10 @@ namespace _Goptical {
       /* Get raytracing mode used FIXME */
       //  inline Tracer::Mode get_mode() const;
 
+      /** @internal Get material spectral properties table of
+          current ray trace */
+      inline const SpectralTable & get_spectral_table() const;
+
       /** Allocate a new Trace::Ray object from result */
       inline Ray & new_ray();
 
@@ -118,8 +149,8 @@ namespace _Goptical {
       /** Declare ray wavelen used for tracing */
       inline void add_ray_wavelen(double wavelen);
 
-      /** Get ray wavelen in use set */
-      inline const std::set<double> & get_ray_wavelen_set() const;
+      /** Get sorted set of ray wavelen in use */
+      inline const std::vector<double> & get_ray_wavelen_set() const;
 
       /** Get reference to tracer parameters used */
       inline const Params & get_params() const;
@@ -139,12 +170,42 @@ namespace _Goptical {
       void init(const Sys::System &system);
       void init(const Sys::Element &element);
 
-      void prepare();
-
+      /** clear result data before a new trace, rays pools, lists,
+          packets and shards storage is kept for reuse */
+      void prepare(bool compact = false);
+      void reset();
+
+      /** make sure enough result shards are available for tracer
+          worker threads. Shards are reused until result is cleared */
+      void prepare_shards(unsigned int count);
+      /** reset shard for a new trace with same rays lists setup */
+      void prepare_shard(Result &shard) const;
+      /** move shard rays lists at end of this result lists */
+      void merge_shard(Result &shard);
+
+      /** allocate a new rays packet owned by this result */
+      RayPacket & new_packet(const Sys::Element &creator);
+      /** build rays tree from packets if not done yet */
+      inline void update_rays() const;
+      void packets_to_rays();
+
+      /** convert rays trees of given source rays to compact records */
+      void compact_rays(const rays_queue_t &roots, unsigned int first,
+                        unsigned int last);
+      /** convert all rays trees to compact records and release rays */
+      void compact_rays();
+      /** release rays allocated after the given count, including
+          all shards rays */
+      void release_rays(unsigned int count);
+      void compact_tree(const Ray &root);
+      unsigned int compact_ray(const Ray &r, unsigned int parent);
+      unsigned int compact_material(const Material::Base *m);
       struct element_result_s
       {
         rays_queue_t *_intercepted; // list of rays for each intercepted surfaces
         rays_queue_t *_generated; // list of rays for each generator surfaces
+        rays_index_t *_intercepted_index; // compact rays indexes lists
+        rays_index_t *_generated_index;
         bool _save_intercepted_list;
         bool _save_generated_list;
       };
@@ -154,12 +215,30 @@ namespace _Goptical {
 
       vector_pool<Ray, 256> _rays; // rays allocation pool
       std::vector<struct element_result_s> _elements;
-      std::set<double>          _wavelengths;
+      std::vector<double>       _wavelengths; // sorted
       rays_queue_t              *_generated_queue;
       Trace::Result::sources_t  _sources;
       unsigned int              _bounce_limit_count;
       const Sys::System         *_system;
       const Trace::Params       *_params;
+      std::vector<Result *>     _shards; // worker threads results, own their rays
+      Trace::Result::packets_t  _packets;
+      Trace::Result::packets_t  _packets_free; // released packets, kept for reuse
+      bool                      _packets_pending; // rays tree not built from packets yet
+      bool                      _compact;
+      Trace::Result::compact_rays_t _compact_rays;
+      std::vector<const Material::Base *> _compact_materials;
+      std::vector<const Ray *>  _compact_queue; // rays tree walk queue
+      SpectralTable             _spectral;
+      const SpectralTable       *_spectral_ptr; // shards use table of main result
+
+      // tracer working storage, kept across traces
+      rays_queue_t              _queues[2];
+      rays_queue_t              _gqueue;
+      rays_queue_t              _cqueue;
+      RayPacket                 _packet; // shard packet chunk generated rays
+      std::vector<const Sys::Source *> _source_list;
+      std::vector<const Sys::Element *> _targets;
       //  Tracer::Mode          _mode;
     };
   }
@@ -27,11 +27,13 @@
 #define GOPTICAL_TRACE_RESULT_HXX_
 
 #include <cassert>
+#include <algorithm>
 
 #include "Goptical/error.hh"
 #include "Goptical/Sys/element.hxx"
 #include "Goptical/Sys/surface.hxx"
 #include "Goptical/Trace/ray.hxx"
+#include "Goptical/Trace/compact_ray.hxx"
 
 namespace _Goptical {
 
@@ -47,8 +49,19 @@ namespace _Goptical {
       return _elements[e.id() - 1];
     }
 
+    void Result::update_rays() const
+    {
+      if (_packets_pending)
+        const_cast<Result*>(this)->packets_to_rays();
+    }
+
     const Trace::rays_queue_t & Result::get_intercepted(const Sys::Surface &s) const
     {
+      if (_compact)
+        throw Error("rays are stored as compact records in ray trace result");
+
+      update_rays();
+
       const struct element_result_s &er = get_element_result(s);
 
       if (!er._intercepted)
@@ -59,6 +72,11 @@ namespace _Goptical {
 
     const Trace::rays_queue_t & Result::get_generated(const Sys::Element &e) const
     {
+      if (_compact)
+        throw Error("rays are stored as compact records in ray trace result");
+
+      update_rays();
+
       const struct element_result_s &er = get_element_result(e);
 
       if (!er._generated)
@@ -67,6 +85,46 @@ namespace _Goptical {
       return *er._generated;
     }
 
+    bool Result::is_compact() const
+    {
+      return _compact;
+    }
+
+    const Trace::Result::compact_rays_t & Result::get_compact_rays() const
+    {
+      return _compact_rays;
+    }
+
+    const Trace::rays_index_t & Result::get_intercepted_index(const Sys::Surface &s) const
+    {
+      const struct element_result_s &er = get_element_result(s);
+
+      if (!er._intercepted_index)
+        throw Error("no such ray interception surface in compact ray trace result");
+
+      return *er._intercepted_index;
+    }
+
+    const Trace::rays_index_t & Result::get_generated_index(const Sys::Element &e) const
+    {
+      const struct element_result_s &er = get_element_result(e);
+
+      if (!er._generated_index)
+        throw Error("no such ray generator element in compact ray trace result");
+
+      return *er._generated_index;
+    }
+
+    const Material::Base & Result::get_material(const CompactRay &r) const
+    {
+      return *_compact_materials[r.get_material_index()];
+    }
+
+    const Trace::Result::packets_t & Result::get_ray_packets() const
+    {
+      return _packets;
+    }
+
     const Trace::Result::sources_t & Result::get_source_list() const
     {
       return _sources;
@@ -90,10 +148,19 @@ namespace _Goptical {
 
     void Result::add_ray_wavelen(double wavelen)
     {
-      _wavelengths.insert(wavelen);
+      std::vector<double>::iterator i =
+        std::lower_bound(_wavelengths.begin(), _wavelengths.end(), wavelen);
+
+      if (i == _wavelengths.end() || *i != wavelen)
+        _wavelengths.insert(i, wavelen);
+    }
+
+    const SpectralTable & Result::get_spectral_table() const
+    {
+      return *_spectral_ptr;
     }
 
-    const std::set<double> & Result::get_ray_wavelen_set() const
+    const std::vector<double> & Result::get_ray_wavelen_set() const
     {
       return _wavelengths;
     }
@@ -82,6 +82,9 @@ namespace _Goptical {
       /** Get a reference to an element in sequence */
       inline const Sys::Element &get_element(unsigned int index) const;
 
+      /** Get number of elements in sequence */
+      inline unsigned int get_element_count() const;
+
     private:
       void add(const Sys::Container &c);
 
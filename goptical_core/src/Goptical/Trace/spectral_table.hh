@@ -0,0 +1,149 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_SPECTRALTABLE_HH_
+#define GOPTICAL_TRACE_SPECTRALTABLE_HH_
+
+#include <vector>
+
+#include "Goptical/common.hh"
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    /**
+       @short Per trace table of material spectral properties
+       @header Goptical/Trace/SpectralTable
+       @module {Core}
+       @internal
+
+       This class stores material properties used to propagate rays
+       for all wavelens in use by a ray trace operation. It is built
+       by the @ref Tracer once sources have generated rays and is then
+       used by surfaces instead of evaluating material models for
+       each ray.
+
+       Refractive index ratio, normal transmittance and normal
+       reflectance are stored for both sides of each optical
+       surface. Internal transmittance of a 1 mm thickness is stored
+       for each material. Internal transmittance of other
+       thicknesses is computed using the Beer-Lambert law as done by
+       all materials models.
+
+       Properties which can not be computed are not stored and
+       lookups fail, so that the material model is used instead.
+
+       Refractive indexes can be evaluated at a given temperature
+       instead of current materials temperature, see @ref
+       set_temperature. Normal transmittance and reflectance are
+       always evaluated at materials temperature.
+     */
+    class SpectralTable
+    {
+    public:
+      /** Spectral properties of an optical surface interface for
+          light going in a given direction */
+      struct surface_entry_s
+      {
+        /** ratio of refractive index on incident side to refractive
+            index on the other side */
+        double _index;
+        /** transmittance at normal incidence, intensity mode only */
+        double _transmittance;
+        /** reflectance at normal incidence, intensity mode only */
+        double _reflectance;
+        bool _valid;
+      };
+
+      SpectralTable();
+
+      /** Clear table content, storage is kept for reuse */
+      void clear();
+
+      /** Evaluate refractive indexes of all materials at given
+          temperature in celcius on next update */
+      void set_temperature(double temperature);
+
+      /** Evaluate refractive indexes at materials temperature on
+          next update (default) */
+      void reset_temperature();
+
+      /** Test if refractive indexes are evaluated at a given
+          temperature */
+      inline bool has_temperature() const;
+
+      /** Build table for all optical surfaces in system and given
+          sorted wavelen set. Nothing is done if the table is
+          already up to date for this wavelen set. Transmittance and
+          reflectance are only stored in intensity mode. */
+      void update(const Sys::System &system,
+                  const std::vector<double> &wavelens, bool intensity);
+
+      /** Get spectral properties of optical surface for given
+          wavelen when light comes from the right (@tt right_to_left
+          is true) or left side. return 0 if not available. */
+      inline const surface_entry_s * get_surface_entry(const Sys::OpticalSurface &s,
+                                                       bool right_to_left,
+                                                       double wavelen) const;
+
+      /** Test if all properties in table are available and do not
+          depend on wavelen. Rays which only differ by wavelen then
+          follow the same path through optical surfaces. */
+      inline bool is_wavelen_independent() const;
+
+      /** Get material internal transmittance for 1 mm thickness at
+          given wavelen. return false if not available. */
+      inline bool get_internal_transmittance(const Material::Base *m, double wavelen,
+                                             double &transmittance) const;
+
+    private:
+      /** get index of wavelen in table or -1 */
+      inline int get_wavelen_index(double wavelen) const;
+
+      void add_material(const Material::Base *m);
+
+      std::vector<double>       _wavelens;
+      bool                      _intensity;
+      bool                      _wavelen_independent;
+      bool                      _thermal;
+      double                    _temperature;
+      // optical surfaces in system
+      std::vector<const Sys::OpticalSurface *> _surfaces;
+      // surface entries row by element id, -1 if none
+      std::vector<int>          _surface_row;
+      // [row * 2 + right_to_left][wavelen]
+      std::vector<surface_entry_s> _surface_entries;
+      // sorted materials list
+      std::vector<const Material::Base *> _materials;
+      // [material][wavelen], negative if not available
+      std::vector<double>       _transmittance;
+    };
+
+  }
+}
+
+#endif
+
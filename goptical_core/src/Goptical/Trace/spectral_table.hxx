@@ -0,0 +1,105 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_TRACE_SPECTRALTABLE_HXX_
+#define GOPTICAL_TRACE_SPECTRALTABLE_HXX_
+
+#include <algorithm>
+
+#include "Goptical/Sys/optical_surface.hh"
+#include "Goptical/Sys/element.hxx"
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    bool SpectralTable::has_temperature() const
+    {
+      return _thermal;
+    }
+
+    bool SpectralTable::is_wavelen_independent() const
+    {
+      return _wavelen_independent;
+    }
+
+    int SpectralTable::get_wavelen_index(double wavelen) const
+    {
+      std::vector<double>::const_iterator i =
+        std::lower_bound(_wavelens.begin(), _wavelens.end(), wavelen);
+
+      if (i == _wavelens.end() || *i != wavelen)
+        return -1;
+
+      return i - _wavelens.begin();
+    }
+
+    const SpectralTable::surface_entry_s *
+    SpectralTable::get_surface_entry(const Sys::OpticalSurface &s,
+                                     bool right_to_left, double wavelen) const
+    {
+      unsigned int id = s.id();
+
+      if (id >= _surface_row.size() || _surface_row[id] < 0)
+        return 0;
+
+      int w = get_wavelen_index(wavelen);
+
+      if (w < 0)
+        return 0;
+
+      const surface_entry_s &e = _surface_entries[
+        (_surface_row[id] * 2 + right_to_left) * _wavelens.size() + w];
+
+      return e._valid ? &e : 0;
+    }
+
+    bool SpectralTable::get_internal_transmittance(const Material::Base *m, double wavelen,
+                                                   double &transmittance) const
+    {
+      if (!_intensity)
+        return false;
+
+      std::vector<const Material::Base *>::const_iterator i =
+        std::lower_bound(_materials.begin(), _materials.end(), m);
+
+      if (i == _materials.end() || *i != m)
+        return false;
+
+      int w = get_wavelen_index(wavelen);
+
+      if (w < 0)
+        return false;
+
+      transmittance = _transmittance[(i - _materials.begin()) * _wavelens.size() + w];
+
+      return transmittance >= 0.0;
+    }
+
+  }
+}
+
+#endif
+
@@ -30,6 +30,7 @@
 
 #include "Goptical/Trace/result.hh"
 #include "Goptical/Trace/params.hh"
+#include "Goptical/Trace/distribution.hh"
 #include "Goptical/Sys/system.hh"
 
 namespace _Goptical {
@@ -47,6 +48,31 @@ namespace _Goptical {
        Propagation result is stored in a @ref Result object.
        Propagation parameters are stored in a @ref Params object.
 
+       Rays can be traced on multiple threads, see @ref
+       Params::set_thread_count. In non-sequential mode, rays
+       generated by sources are split between threads. In sequential
+       mode, rays entering each element of the sequence are split
+       between threads. Trace result does not depend on the number of
+       threads used.
+
+       In non-sequential mode, source rays which only differ by
+       wavelen are traced once when material properties of the
+       system do not depend on wavelen, as in mirror only systems.
+       Rays trees are then copied for other wavelens, see @ref
+       Params::set_wavelen_dedup.
+
+       Sequential ray tracing can propagate rays packets with
+       structure of arrays layout instead of @ref Ray objects, see
+       @ref Params::set_packet_mode.
+
+       Multiple tracers created from the same @ref Sys::FrozenSystem
+       can trace concurrently, see @ref Sys::System::freeze.
+
+       Multiple point source configurations can be traced in a
+       single batch, see @ref trace_batch. The system can be traced
+       at multiple temperatures in a single batch, see @ref
+       trace_temperatures.
+
        @xsee {tuto_seqtrace}
      */
     class Tracer
@@ -56,6 +82,13 @@ namespace _Goptical {
       /** Create a new Light porpagator object */
       Tracer(const const_ref<Sys::System> &system);
 
+      /** Create a new Light porpagator object for a frozen system.
+          Ray tracing does not modify the system and throws if the
+          system has been modified since freeze or if the tracer
+          propagation mode or sequence need transforms which were
+          not computed by freeze. */
+      Tracer(const Sys::FrozenSystem &system);
+
       ~Tracer();
 
       /** Set the Result object which must be used to store ray
@@ -83,15 +116,114 @@ namespace _Goptical {
       /** Launch ray tracing operation */
       void trace();
 
+      /** Trace a batch of point source configurations. System
+          setup and distribution patterns are computed once and
+          shared by all configurations, which are traced in
+          parallel depending on @ref Params::set_thread_count. Only
+          the configured source is traced in each configuration,
+          other sources are ignored.
+
+          The system is frozen before tracing, see @ref
+          Sys::System::freeze. One result per configuration is
+          available from @ref get_batch_result until next batch
+          trace. */
+      void trace_batch(const std::vector<Configuration> &configs);
+
+      /** Trace the system at multiple temperatures in celcius.
+          Refractive indexes of all materials, including the
+          environment, are evaluated at each temperature without
+          modifying material models. System setup is computed once
+          and shared, each temperature only gets its own spectral
+          table. Temperatures are traced in parallel depending on
+          @ref Params::set_thread_count.
+
+          Geometry does not change with temperature. The system is
+          frozen before tracing, see @ref Sys::System::freeze. One
+          result per temperature is available from @ref
+          get_batch_result until next batch trace. */
+      void trace_temperatures(const std::vector<double> &temperatures);
+
+      /** Get result of configuration or temperature at given index
+          in last batch trace */
+      inline Result & get_batch_result(unsigned int index) const;
+
+      /** Get number of configurations or temperatures traced by last
+          batch trace */
+      inline unsigned int get_batch_size() const;
+
     private:
 
       template <IntensityMode m> void trace_template();
       template <IntensityMode m> void trace_seq_template();
+      template <IntensityMode m> void trace_seq_packet_template();
+
+      template <IntensityMode m> class nseq_job;
+      template <IntensityMode m> class seq_job;
+      template <IntensityMode m> class packet_job;
+      class batch_job;
+
+      /** distribution pattern points shared by batch configurations */
+      struct batch_pattern_s
+      {
+        const Sys::Surface              *_target;
+        Distribution                    _dist;
+        std::vector<Math::Vector3>      _points;
+      };
+
+      /** generate rays from source, or from batch configuration if
+          any, and update spectral table of result */
+      template <IntensityMode m>
+      void generate_rays(Result &result, const Sys::Source &source,
+                         const std::vector<const Sys::Element *> &entry) const;
+
+      /** get first non source element of sequence */
+      const Sys::Element * get_sequence_entrance() const;
+
+      /** trace rays in given range and all their children in non-sequential mode */
+      template <IntensityMode m>
+      void trace_rays(Result &result, const rays_queue_t &rays,
+                      unsigned int first, unsigned int last) const;
+
+      /** test if two source rays follow the same path when
+          propagation does not depend on wavelen */
+      template <IntensityMode m>
+      static inline bool same_path(const Ray &a, const Ray &b);
+
+      /** build rays tree of a root ray from the rays tree of a ray
+          with the same path left in generated queue by @ref trace_rays */
+      template <IntensityMode m>
+      void clone_rays(Result &result, const Ray &rep, Ray &root) const;
+
+      /** split rays in given range in chunks traced on worker threads */
+      template <IntensityMode m>
+      void trace_rays_parallel(Result &result, const rays_queue_t &rays,
+                               unsigned int first, unsigned int last) const;
+
+      /** split rays list in chunks processed by element on worker threads */
+      template <IntensityMode m>
+      void process_rays_parallel(Result &result, const Sys::Element &element,
+                                 const rays_queue_t &rays) const;
+
+      /** split rays packet in chunks processed by element on worker threads */
+      template <IntensityMode m>
+      void process_packet_parallel(Result &result, const Sys::Element &element,
+                                   RayPacket &input, RayPacket &output) const;
+
+      /** get number and size of chunks used to split a rays list between threads */
+      unsigned int get_chunk_count(unsigned int ray_count, unsigned int &chunk) const;
 
       const_ref<Sys::System>    _system;
+      bool                      _frozen;
+      unsigned int              _frozen_version;
       Params                    _params;
       Result                    _result;
       Result                    *_result_ptr;
+
+      const Configuration       *_config; // batch configuration traced by this tracer
+      const batch_pattern_s     *_pattern;
+      std::vector<Tracer *>     _batch; // per configuration tracers, kept for reuse
+      std::vector<batch_pattern_s> _batch_patterns;
+      unsigned int              _batch_size;
     };
   }
 }
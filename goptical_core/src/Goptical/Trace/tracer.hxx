@@ -27,6 +27,7 @@
 #define GOPTICAL_TRACER_HXX_
 
 #include "Goptical/Trace/result.hh"
+#include "Goptical/error.hh"
 
 namespace _Goptical {
 
@@ -47,6 +48,19 @@ namespace _Goptical {
       return *(_result_ptr = &_result);
     }
 
+    Trace::Result & Tracer::get_batch_result(unsigned int index) const
+    {
+      if (index >= _batch_size)
+        throw Error("no such entry in batch trace result");
+
+      return _batch[index]->get_trace_result();
+    }
+
+    unsigned int Tracer::get_batch_size() const
+    {
+      return _batch_size;
+    }
+
     const Sys::System & Tracer::get_system() const
     {
       return *_system;
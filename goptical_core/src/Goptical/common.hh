@@ -38,6 +38,9 @@
 #include <vector>
 #include <deque>
 
+/* reference counters may be updated from concurrent tracing threads */
+#define _DPP_USE_GCC_ATOMIC
+
 #include "Goptical/vector_pool" /* mkdoc:skip */
 #include "Goptical/ref"    /* mkdoc:skip */
 #include "Goptical/delegate"       /* mkdoc:skip */
@@ -166,6 +169,22 @@ namespace Goptical {
         SourceAtInfinity,
       };
 
+    /** Specifies how source spectral lines are assigned to rays
+        generated for pattern points */
+    enum SpectralSampling
+      {
+        /** One ray is generated for each spectral line */
+        SpectralAllLines,
+        /** A single ray is generated, lines are picked in turn with
+            equal probability and ray intensity is scaled by the
+            lines count. */
+        SpectralStratified,
+        /** A single ray is generated, lines are picked with
+            probability proportional to their intensity and all rays
+            carry the whole spectrum intensity. */
+        SpectralImportance,
+      };
+
   }
 
   namespace Trace {
@@ -423,6 +442,8 @@ namespace _Goptical {
     /** @main @see __VectorPair3__ */
     typedef VectorPair<3> VectorPair3;
 
+    template <int N> struct Dual;
+
     template <int N> class Transform;
     /** @main */
     template <> class Transform<3>;
@@ -473,6 +494,7 @@ namespace _Goptical {
 
     class Container;
     class System;
+    class FrozenSystem;
     class Element;
     class Surface;
     class Image;
@@ -492,15 +514,20 @@ namespace _Goptical {
   namespace Trace {
     using namespace Goptical::Trace;
 
+    class Configuration;
     class Distribution;
     class Tracer;
     class Params;
     class Ray;
     class Result;
+    class RayPacket;
+    class CompactRay;
+    class SpectralTable;
     class Element;
     class Sequence;
 
-    typedef std::deque<Ray *> rays_queue_t;
+    typedef std::vector<Ray *> rays_queue_t;
+    typedef std::vector<unsigned int> rays_index_t;
 
   }
 
@@ -563,6 +590,8 @@ namespace _Goptical {
     class Dielectric;
     class Metal;
     class Sellmeier;
+    class Chebyshev;
+    class GlassIndex;
 
   }
 
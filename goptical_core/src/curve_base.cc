@@ -22,6 +22,9 @@
 
 */
 
+#include <limits>
+#include <algorithm>
+
 #include <Goptical/Curve/Base>
 #include <Goptical/Math/Vector>
 #include <Goptical/Math/VectorPair>
@@ -34,30 +37,89 @@ namespace _Goptical {
 
     // Default curve/ray intersection iterative method
 
-    bool Base::intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const
+    void Base::prepare() const
     {
-      Math::VectorPair3 p;
+    }
 
-      // initial intersection with z=0 plane
-      {
-        double  s = ray.direction().z();
+    bool Base::intersect_range(const Math::VectorPair2 &area,
+                               double &min, double &max) const
+    {
+      // sampled range may miss narrow features
+      sagitta_range(area, min, max);
+      return false;
+    }
 
-        if (s == 0)
-          return false;
+    /** last intersection point and normal found by current thread */
+    struct intersect_hint_s
+    {
+      const Base        *_curve;
+      const void        *_key;
+      double            _point[6];
+    };
 
-        double  a = -ray.origin().z() / s;
+    /** per thread hints table indexed by curve and key hash */
+    static const unsigned int hint_table_size = 8;
+    static __thread struct intersect_hint_s hint_table[hint_table_size];
+    static __thread const void *hint_key;
 
-        if (a < 0)
-          return false;
+    static inline struct intersect_hint_s & hint_entry(const Base *curve)
+    {
+      size_t h = ((size_t)curve >> 4) + ((size_t)hint_key >> 4) * 3;
 
-        p.origin() = ray.origin() + ray.direction() * a;
-      }
+      return hint_table[h % hint_table_size];
+    }
 
-      unsigned int n = 32;      // avoid infinite loop
+    void Base::set_intersect_hint_key(const void *key)
+    {
+      hint_key = key;
+    }
+
+    bool Base::load_intersect_hint(Math::VectorPair3 &point) const
+    {
+      if (!_intersect_hint)
+        return false;
 
+      const struct intersect_hint_s &e = hint_entry(this);
+
+      if (e._curve != this || e._key != hint_key)
+        return false;
+
+      for (unsigned int i = 0; i < 3; i++)
+        {
+          point.origin()[i] = e._point[i];
+          point.normal()[i] = e._point[i + 3];
+        }
+
+      return true;
+    }
+
+    void Base::save_intersect_hint(const Math::VectorPair3 &point) const
+    {
+      if (!_intersect_hint)
+        return;
+
+      struct intersect_hint_s &e = hint_entry(this);
+
+      e._curve = this;
+      e._key = hint_key;
+
+      for (unsigned int i = 0; i < 3; i++)
+        {
+          e._point[i] = point.origin()[i];
+          e._point[i + 3] = point.normal()[i];
+        }
+    }
+
+    /** refine intersection from starting point on ray using curve
+        tangent planes. Return 1 on convergence, 0 if iterations
+        count is exhausted and -1 if ray goes backward. */
+    static inline int intersect_iterate(const Base &c, Math::VectorPair3 &p,
+                                        const Math::VectorPair3 &ray,
+                                        unsigned int n)
+    {
       while (n--)
         {
-          double new_sag = sagitta(p.origin().project_xy());
+          double new_sag = c.sagitta(p.origin().project_xy());
           double old_sag = p.origin().z();
 
           // project previous intersection point on curve
@@ -65,25 +127,172 @@ namespace _Goptical {
 
           // stop if close enough
           if (fabs(old_sag - new_sag) < 1e-10)
-            break;
+            return 1;
 
           // get curve tangeante plane at intersection point
-          normal(p.normal(), p.origin());
+          c.normal(p.normal(), p.origin());
 
           // intersect again with new tangeante plane
           double a = p.pl_ln_intersect_scale(ray);
 
           if (a < 0)
-            return false;
+            return -1;
 
           p.origin() = ray.origin() + ray.direction() * a;
         }
 
+      return 0;
+    }
+
+    bool Base::intersect(Math::Vector3 &point, const Math::VectorPair3 &ray) const
+    {
+      Math::VectorPair3 p;
+
+      // warm start from intersection of ray with curve tangent plane
+      // at last intersection point, fall back to cold start if it
+      // does not converge quickly
+      if (load_intersect_hint(p))
+        {
+          double a = p.pl_ln_intersect_scale(ray);
+
+          if (a >= 0 && a == a)
+            {
+              p.origin() = ray.origin() + ray.direction() * a;
+
+              if (intersect_iterate(*this, p, ray, 8) > 0)
+                {
+                  point = p.origin();
+                  save_intersect_hint(p);
+                  return true;
+                }
+            }
+        }
+
+      // initial intersection with z=0 plane
+      {
+        double  s = ray.direction().z();
+
+        if (s == 0)
+          return false;
+
+        double  a = -ray.origin().z() / s;
+
+        if (a < 0)
+          return false;
+
+        p.origin() = ray.origin() + ray.direction() * a;
+        p.normal() = Math::vector3_001;
+      }
+
+      // avoid infinite loop
+      int r = intersect_iterate(*this, p, ray, 32);
+
+      if (r < 0)
+        return false;
+
       point = p.origin();
 
+      if (r > 0)
+        save_intersect_hint(p);
+
       return true;
     }
 
+    bool Base::intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                                 double) const
+    {
+      return intersect(point, ray);
+    }
+
+    void Base::intersect_batch_scalar(double * const point[3], bool *hit,
+                                      const double * const origin[3],
+                                      const double * const direction[3],
+                                      unsigned int first, unsigned int count,
+                                      double max_radius) const
+    {
+      for (unsigned int i = first; i < count; i++)
+        {
+          Math::VectorPair3 ray(Math::Vector3(origin[0][i], origin[1][i], origin[2][i]),
+                                Math::Vector3(direction[0][i], direction[1][i], direction[2][i]));
+          Math::Vector3 p;
+
+          hit[i] = max_radius > 0 ? intersect_bounded(p, ray, max_radius)
+                                  : intersect(p, ray);
+
+          if (hit[i])
+            for (unsigned int j = 0; j < 3; j++)
+              point[j][i] = p[j];
+        }
+    }
+
+    void Base::intersect_batch(double * const point[3], bool *hit,
+                               const double * const origin[3],
+                               const double * const direction[3],
+                               unsigned int count, double max_radius) const
+    {
+      intersect_batch_scalar(point, hit, origin, direction, 0, count, max_radius);
+    }
+
+    void Base::normal_batch_scalar(double * const normal[3],
+                                   const double * const point[3],
+                                   unsigned int first, unsigned int count) const
+    {
+      for (unsigned int i = first; i < count; i++)
+        {
+          Math::Vector3 n;
+
+          this->normal(n, Math::Vector3(point[0][i], point[1][i], point[2][i]));
+
+          for (unsigned int j = 0; j < 3; j++)
+            normal[j][i] = n[j];
+        }
+    }
+
+    void Base::normal_batch(double * const normal[3],
+                            const double * const point[3],
+                            unsigned int count) const
+    {
+      normal_batch_scalar(normal, point, 0, count);
+    }
+
+    void Base::sagitta_range(const Math::VectorPair2 &area,
+                             double &min, double &max) const
+    {
+      static const unsigned int n = 16;
+
+      const double dx = (area[1].x() - area[0].x()) / n;
+      const double dy = (area[1].y() - area[0].y()) / n;
+      double gmax = 0;
+
+      min = std::numeric_limits<double>::max();
+      max = -std::numeric_limits<double>::max();
+
+      for (unsigned int i = 0; i <= n; i++)
+        for (unsigned int j = 0; j <= n; j++)
+          {
+            Math::Vector2 p(area[0].x() + dx * i, area[0].y() + dy * j);
+            Math::Vector2 d;
+
+            double z = sagitta(p);
+
+            // ignore points outside curve domain
+            if (!(z == z))
+              continue;
+
+            min = std::min(min, z);
+            max = std::max(max, z);
+
+            derivative(p, d);
+            gmax = std::max(gmax, d.len());
+          }
+
+      // sagitta can not change more than this between grid points
+      double margin = gmax * sqrt(dx * dx + dy * dy);
+
+      min -= margin;
+      max += margin;
+    }
+
     // Default curve derivative use gsl numerical differentiation
 
     struct curve_gsl_params_s
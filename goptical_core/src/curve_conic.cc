@@ -31,6 +31,8 @@
 #include <Goptical/Math/VectorPair>
 #include <Goptical/Math/VectorPair>
 
+#include "simd_.hh"
+
 namespace _Goptical {
 
   namespace Curve {
@@ -105,6 +107,111 @@ namespace _Goptical {
       return true;
     }
 
+    void Conic::intersect_batch(double * const point[3], bool *hit,
+                                const double * const origin[3],
+                                const double * const direction[3],
+                                unsigned int count, double max_radius) const
+    {
+      unsigned int i = 0;
+
+#ifdef GOPTICAL_SIMD_WIDTH
+      // same computation as intersect(), on multiple rays at once
+      typedef simd_pd S;
+
+      const S::v sh = S::set1(_sh);
+      const S::v roc = S::set1(_roc);
+      const S::v two = S::set1(2.0);
+      const S::v four = S::set1(4.0);
+      const S::v zero = S::zero();
+      const bool sh_neg = _sh < 0;
+
+      for (; i + S::width <= count; i += S::width)
+        {
+          const S::v ax = S::load(origin[0] + i);
+          const S::v ay = S::load(origin[1] + i);
+          const S::v az = S::load(origin[2] + i);
+          const S::v bx = S::load(direction[0] + i);
+          const S::v by = S::load(direction[1] + i);
+          const S::v bz = S::load(direction[2] + i);
+
+          S::v a = S::add(S::add(S::mul(sh, S::mul(bz, bz)), S::mul(by, by)), S::mul(bx, bx));
+          S::v b = S::mul(S::sub(S::div(S::add(S::add(S::mul(S::mul(sh, bz), az), S::mul(by, ay)),
+                                               S::mul(bx, ax)), roc), bz), two);
+          S::v c = S::sub(S::div(S::add(S::add(S::mul(sh, S::mul(az, az)), S::mul(ay, ay)),
+                                        S::mul(ax, ax)), roc), S::mul(two, az));
+
+          S::v d = S::sub(S::mul(b, b), S::div(S::mul(S::mul(four, a), c), roc));
+          S::v s = S::neg_if(S::lt(S::mul(a, bz), zero), S::sqrt(d));
+
+          if (sh_neg)
+            s = S::neg(s);
+
+          S::v a_zero = S::eq(a, zero);
+
+          S::v t = S::select(a_zero, S::div(S::neg(c), b),
+                             S::div(S::mul(two, c), S::sub(s, b)));
+
+          // no intersection where d < 0, ignore intersection if before ray origin
+          S::v ok = S::and_(S::or_(a_zero, S::nlt(d, zero)), S::nle(t, zero));
+
+          S::store(point[0] + i, S::add(ax, S::mul(bx, t)));
+          S::store(point[1] + i, S::add(ay, S::mul(by, t)));
+          S::store(point[2] + i, S::add(az, S::mul(bz, t)));
+          S::store_mask(hit + i, ok);
+        }
+#endif
+
+      intersect_batch_scalar(point, hit, origin, direction, i, count, max_radius);
+    }
+
+    void Conic::normal_batch(double * const normal[3],
+                             const double * const point[3],
+                             unsigned int count) const
+    {
+      unsigned int i = 0;
+
+#ifdef GOPTICAL_SIMD_WIDTH
+      // same computation as Rotational::normal() with conic derivative
+      typedef simd_pd S;
+
+      const S::v sh = S::set1(_sh);
+      const S::v roc = S::set1(_roc);
+      const S::v roc2 = S::set1(Math::square(_roc));
+      const S::v roc3 = S::set1(Math::square(_roc) * _roc);
+      const S::v one = S::set1(1.0);
+      const S::v two = S::set1(2.0);
+      const S::v zero = S::zero();
+
+      for (; i + S::width <= count; i += S::width)
+        {
+          const S::v x = S::load(point[0] + i);
+          const S::v y = S::load(point[1] + i);
+
+          S::v r = S::sqrt(S::add(S::mul(x, x), S::mul(y, y)));
+
+          S::v s2 = S::mul(sh, S::mul(r, r));
+          S::v s3 = S::sqrt(S::sub(one, S::div(s2, roc2)));
+          S::v s3_1 = S::add(s3, one);
+          S::v s4 = S::add(S::div(two, S::mul(roc, s3_1)),
+                           S::div(s2, S::mul(S::mul(roc3, s3), S::mul(s3_1, s3_1))));
+          S::v p = S::mul(r, s4);
+
+          S::v nx = S::div(S::mul(x, p), r);
+          S::v ny = S::div(S::mul(y, p), r);
+          S::v len = S::sqrt(S::add(S::add(S::mul(nx, nx), S::mul(ny, ny)), one));
+
+          // normal is (0, 0, -1) on axis
+          S::v r_zero = S::eq(r, zero);
+
+          S::store(normal[0] + i, S::select(r_zero, zero, S::div(nx, len)));
+          S::store(normal[1] + i, S::select(r_zero, zero, S::div(ny, len)));
+          S::store(normal[2] + i, S::select(r_zero, S::neg(one), S::div(S::neg(one), len)));
+        }
+#endif
+
+      normal_batch_scalar(normal, point, i, count);
+    }
+
     /*
       ellipse and hyperbola equation standard forms:
 
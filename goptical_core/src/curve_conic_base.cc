@@ -23,6 +23,7 @@
 */
 
 #include <cassert>
+#include <algorithm>
 
 #include <gsl/gsl_fit.h>
 
@@ -92,6 +93,73 @@ namespace _Goptical {
 
     */
 
+    bool ConicBase::intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                                      double) const
+    {
+      return intersect(point, ray);
+    }
+
+    void ConicBase::sagitta_range(const Math::VectorPair2 &area,
+                                  double &min, double &max) const
+    {
+      double rmin, rmax;
+      radius_range(area, rmin, rmax);
+
+      // clamp to curve domain
+      if (_sh > 0)
+        {
+          double rlimit = fabs(_roc) / sqrt(_sh);
+
+          rmax = std::min(rmax, rlimit);
+          rmin = std::min(rmin, rlimit);
+        }
+
+      double z0 = sagitta(rmin);
+      double z1 = sagitta(rmax);
+
+      min = std::min(z0, z1);
+      max = std::max(z0, z1);
+    }
+
+    bool ConicBase::intersect_range(const Math::VectorPair2 &area,
+                                    double &min, double &max) const
+    {
+      sagitta_range(area, min, max);
+
+      // parabola has a single branch
+      if (_sh == 0)
+        return true;
+
+      double rmin, rmax;
+      radius_range(area, rmin, rmax);
+
+      if (_sh > 0)
+        {
+          double rlimit = fabs(_roc) / sqrt(_sh);
+
+          rmax = std::min(rmax, rlimit);
+          rmin = std::min(rmin, rlimit);
+        }
+
+      // other root of r^2 - 2 * roc * z + sh * z^2 = 0
+      double s0 = sqrt(std::max(0.0, Math::square(_roc) - _sh * Math::square(rmin)));
+      double s1 = sqrt(std::max(0.0, Math::square(_roc) - _sh * Math::square(rmax)));
+
+      if (_roc < 0)
+        {
+          s0 = -s0;
+          s1 = -s1;
+        }
+
+      double z0 = (_roc + s0) / _sh;
+      double z1 = (_roc + s1) / _sh;
+
+      min = std::min(min, std::min(z0, z1));
+      max = std::max(max, std::max(z0, z1));
+
+      return true;
+    }
+
     double ConicBase::fit_roc(const Rotational &c, double radius, unsigned int count)
     {
       double X[count], Y[count];
@@ -28,6 +28,8 @@
 #include <Goptical/Math/VectorPair>
 #include <Goptical/Math/VectorPair>
 
+#include "simd_.hh"
+
 namespace _Goptical {
 
   namespace Curve {
@@ -80,11 +82,72 @@ namespace _Goptical {
       return true;
     }
 
+    bool Flat::intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                                 double) const
+    {
+      return intersect(point, ray);
+    }
+
     void Flat::normal(Math::Vector3 &normal, const Math::Vector3 &point) const
     {
       normal = Math::Vector3(0, 0, -1);
     }
 
+    void Flat::sagitta_range(const Math::VectorPair2 &,
+                             double &min, double &max) const
+    {
+      min = max = 0;
+    }
+
+    bool Flat::intersect_range(const Math::VectorPair2 &,
+                               double &min, double &max) const
+    {
+      min = max = 0;
+      return true;
+    }
+
+    void Flat::intersect_batch(double * const point[3], bool *hit,
+                               const double * const origin[3],
+                               const double * const direction[3],
+                               unsigned int count, double max_radius) const
+    {
+      unsigned int i = 0;
+
+#ifdef GOPTICAL_SIMD_WIDTH
+      typedef simd_pd S;
+
+      const S::v zero = S::zero();
+
+      for (; i + S::width <= count; i += S::width)
+        {
+          const S::v s = S::load(direction[2] + i);
+          const S::v a = S::div(S::neg(S::load(origin[2] + i)), s);
+
+          S::v ok = S::and_(S::neq(s, zero), S::nlt(a, zero));
+
+          for (unsigned int j = 0; j < 3; j++)
+            S::store(point[j] + i, S::add(S::load(origin[j] + i),
+                                          S::mul(S::load(direction[j] + i), a)));
+
+          S::store_mask(hit + i, ok);
+        }
+#endif
+
+      intersect_batch_scalar(point, hit, origin, direction, i, count, max_radius);
+    }
+
+    void Flat::normal_batch(double * const normal[3],
+                            const double * const [3],
+                            unsigned int count) const
+    {
+      for (unsigned int i = 0; i < count; i++)
+        {
+          normal[0][i] = 0.;
+          normal[1][i] = 0.;
+          normal[2][i] = -1.;
+        }
+    }
+
     Flat flat;
 
   }
@@ -46,6 +46,9 @@ namespace _Goptical {
 
       _reading.set_interpolation(Data::Cubic);
       _sagitta.set_interpolation(Data::CubicDeriv);
+      // sagitta and derivative are evaluated at close radii during
+      // intersection iterations
+      _sagitta.set_interval_hint(true);
 
       gsl_st = gsl_odeiv_step_alloc(gsl_odeiv_step_rkf45, 1);
       gsl_sys.function = gsl_func;
@@ -173,6 +176,14 @@ namespace _Goptical {
       return _sagitta.interpolate(r, 1);
     }
 
+    void Foucault::prepare() const
+    {
+      if (!_updated)
+        const_cast<Foucault *>(this)->update();
+
+      _sagitta.prepare();
+    }
+
     void Foucault::update()
     {
       _sagitta.clear();
@@ -64,5 +64,10 @@ namespace _Goptical {
       dxdy = _data.interpolate_deriv(xy);
     }
 
+    void Grid::prepare() const
+    {
+      _data.prepare();
+    }
+
   }
 }
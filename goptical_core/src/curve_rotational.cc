@@ -22,9 +22,12 @@
 
 */
 
+#include <limits>
+#include <algorithm>
+
 #include <Goptical/Curve/Rotational>
 #include <Goptical/Math/Vector>
-#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
 
 namespace _Goptical {
 
@@ -66,6 +69,264 @@ namespace _Goptical {
       dxdy = xy * (p / r);
     }
 
+    /** get sagitta difference between ray point at t and curve */
+    static inline double ray_sag_diff(const Rotational &c, const Math::VectorPair3 &ray,
+                                      double t)
+    {
+      const Math::Vector3 p(ray.origin() + ray.direction() * t);
+
+      return p.z() - c.sagitta(sqrt(Math::square(p.x()) + Math::square(p.y())));
+    }
+
+    /** get sagitta difference between ray point at t and curve,
+        along with its derivative with respect to t and the curve
+        gradient at ray point */
+    static inline double ray_sag_diff(const Rotational &c, const Math::VectorPair3 &ray,
+                                      double t, double &df, Math::Vector2 &grad)
+    {
+      const Math::Vector3 &d = ray.direction();
+      const Math::Vector3 p(ray.origin() + d * t);
+      const double r = sqrt(Math::square(p.x()) + Math::square(p.y()));
+
+      df = d.z();
+      grad = Math::vector2_0;
+
+      if (r > 0)
+        {
+          grad = p.project_xy() * (c.derivative(r) / r);
+          df -= grad.x() * d.x() + grad.y() * d.y();
+        }
+
+      return p.z() - c.sagitta(r);
+    }
+
+    bool Rotational::intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                                       double max_radius) const
+    {
+      intersect_stats_s stats;
+
+      return intersect_bounded(point, ray, max_radius, stats);
+    }
+
+    bool Rotational::intersect_bounded(Math::Vector3 &point, const Math::VectorPair3 &ray,
+                                       double max_radius, intersect_stats_s &stats) const
+    {
+      static const unsigned int max_iterations = 64;
+      static const unsigned int scan_count = 16;
+
+      const Math::Vector3 &o = ray.origin();
+      const Math::Vector3 &d = ray.direction();
+
+      stats.iterations = 0;
+      stats.bisections = 0;
+      stats.scanned = false;
+
+      if (!(max_radius > 0) || !(max_radius < std::numeric_limits<double>::infinity()))
+        return intersect(point, ray);
+
+      const double a = Math::square(d.x()) + Math::square(d.y());
+
+      if (a == 0)
+        {
+          // ray parallel to curve axis, sagitta is constant along ray
+          const double r = sqrt(Math::square(o.x()) + Math::square(o.y()));
+          const double z = sagitta(r);
+
+          if (d.z() == 0 || r > max_radius || !(z == z) || (z - o.z()) / d.z() < 0)
+            return false;
+
+          point = Math::Vector3(o.x(), o.y(), z);
+          return true;
+        }
+
+      // ray segment inside the max_radius cylinder, in front of ray origin
+      const double b = o.x() * d.x() + o.y() * d.y();
+      const double c = Math::square(o.x()) + Math::square(o.y()) - Math::square(max_radius);
+      const double delta = Math::square(b) - a * c;
+
+      if (delta < 0)
+        return false;
+
+      const double sd = sqrt(delta);
+      double t0 = std::max((-b - sd) / a, 0.0);
+      double t1 = (-b + sd) / a;
+
+      if (t1 < t0)
+        return false;
+
+      double f0 = ray_sag_diff(*this, ray, t0);
+      double f1 = ray_sag_diff(*this, ray, t1);
+
+      // curve not defined over the whole segment
+      if (!(f0 == f0) || !(f1 == f1))
+        return intersect(point, ray);
+
+      if (f0 * f1 > 0)
+        {
+          // no sign change at segment ends, look for first sign
+          // change along the segment to catch grazing rays
+          const double step = (t1 - t0) / scan_count;
+          double ta = t0, fa = f0;
+          unsigned int i;
+
+          stats.scanned = true;
+
+          for (i = 1; i <= scan_count; i++)
+            {
+              double tb = i == scan_count ? t1 : t0 + step * i;
+              double fb = i == scan_count ? f1 : ray_sag_diff(*this, ray, tb);
+
+              if (!(fb == fb))
+                return intersect(point, ray);
+
+              if (fa * fb <= 0)
+                {
+                  t0 = ta;
+                  f0 = fa;
+                  t1 = tb;
+                  f1 = fb;
+                  break;
+                }
+
+              ta = tb;
+              fa = fb;
+            }
+
+          if (i > scan_count)
+            return false;
+        }
+
+      // bracket bounds with negative and positive differences
+      double lo = f0 < 0 ? t0 : t1;
+      double hi = f0 < 0 ? t1 : t0;
+
+      // start from last intersection point projected on ray or
+      // from curve vertex plane intersection when in bracket like
+      // generic method, bracket middle otherwise
+      double t = 0.5 * (t0 + t1);
+      Math::VectorPair3 h;
+
+      if (load_intersect_hint(h))
+        {
+          // intersect ray with tangent plane at last intersection point
+          double th = h.pl_ln_intersect_scale(ray);
+
+          if (th > t0 && th < t1)
+            t = th;
+        }
+      else if (d.z() != 0)
+        {
+          double tv = -o.z() / d.z();
+
+          if (tv > t0 && tv < t1)
+            t = tv;
+        }
+
+      double dt_old = t1 - t0;
+      double dt = dt_old;
+      Math::Vector2 grad;
+      double df, f = ray_sag_diff(*this, ray, t, df, grad);
+
+      bool converged = false;
+
+      while (stats.iterations++ < max_iterations)
+        {
+          if (!(f == f))
+            return intersect(point, ray);
+
+          if (f == 0)
+            {
+              converged = true;
+              break;
+            }
+
+          if (f < 0)
+            lo = t;
+          else
+            hi = t;
+
+          if (((t - hi) * df - f) * ((t - lo) * df - f) > 0 ||
+              fabs(2.0 * f) > fabs(dt_old * df))
+            {
+              // newton step out of bracket or not decreasing fast enough
+              stats.bisections++;
+              dt_old = dt;
+              dt = 0.5 * (hi - lo);
+              t = lo + dt;
+            }
+          else
+            {
+              dt_old = dt;
+              dt = f / df;
+              t -= dt;
+            }
+
+          if (fabs(dt) < 1e-12 * (1.0 + fabs(t)))
+            {
+              converged = true;
+              break;
+            }
+
+          f = ray_sag_diff(*this, ray, t, df, grad);
+        }
+
+      point = o + d * t;
+
+      // last gradient was evaluated close enough to be used as
+      // tangent plane for next warm start
+      if (converged)
+        save_intersect_hint(Math::VectorPair3(point, Math::Vector3(grad, -1.0)));
+
+      return true;
+    }
+
+    void Rotational::radius_range(const Math::VectorPair2 &area,
+                                  double &rmin, double &rmax)
+    {
+      // closest point of area is origin clamped to area
+      double cx = std::max(area[0].x(), std::min(area[1].x(), 0.0));
+      double cy = std::max(area[0].y(), std::min(area[1].y(), 0.0));
+
+      rmin = sqrt(Math::square(cx) + Math::square(cy));
+
+      // farthest point of area is one of its corners
+      rmax = sqrt(std::max(Math::square(area[0].x()), Math::square(area[1].x())) +
+                  std::max(Math::square(area[0].y()), Math::square(area[1].y())));
+    }
+
+    void Rotational::sagitta_range(const Math::VectorPair2 &area,
+                                   double &min, double &max) const
+    {
+      static const unsigned int n = 64;
+
+      double rmin, rmax;
+      radius_range(area, rmin, rmax);
+
+      const double step = (rmax - rmin) / n;
+      double dmax = 0;
+
+      min = std::numeric_limits<double>::max();
+      max = -std::numeric_limits<double>::max();
+
+      for (unsigned int i = 0; i <= n; i++)
+        {
+          double r = rmin + step * i;
+          double z = sagitta(r);
+
+          // ignore points outside curve domain
+          if (!(z == z))
+            continue;
+
+          min = std::min(min, z);
+          max = std::max(max, z);
+          dmax = std::max(dmax, fabs(derivative(r)));
+        }
+
+      // sagitta can not change more than this between samples
+      min -= dmax * step;
+      max += dmax * step;
+    }
+
     double Rotational::gsl_func_sagitta(double x, void *params)
     {
       Rotational *c = static_cast<Rotational *>(params);
@@ -28,6 +28,8 @@
 #include <Goptical/Math/VectorPair>
 #include <Goptical/Math/VectorPair>
 
+#include "simd_.hh"
+
 namespace _Goptical {
 
   namespace Curve {
@@ -124,6 +126,93 @@ namespace _Goptical {
         normal = -normal;
     }
 
+    void Sphere::intersect_batch(double * const point[3], bool *hit,
+                                 const double * const origin[3],
+                                 const double * const direction[3],
+                                 unsigned int count, double max_radius) const
+    {
+      unsigned int i = 0;
+
+#ifdef GOPTICAL_SIMD_WIDTH
+      // same computation as intersect(), on multiple rays at once
+      typedef simd_pd S;
+
+      const S::v roc = S::set1(_roc);
+      const S::v roc2 = S::set1(Math::square(_roc));
+      const S::v two = S::set1(2.0);
+      const S::v zero = S::zero();
+
+      for (; i + S::width <= count; i += S::width)
+        {
+          const S::v ax = S::load(origin[0] + i);
+          const S::v ay = S::load(origin[1] + i);
+          const S::v az = S::load(origin[2] + i);
+          const S::v bx = S::load(direction[0] + i);
+          const S::v by = S::load(direction[1] + i);
+          const S::v bz = S::load(direction[2] + i);
+
+          S::v d = S::sub(az, roc);
+          S::v ay_by = S::mul(ay, by);
+          S::v ax_bx = S::mul(ax, bx);
+          S::v ay_bx = S::mul(ay, bx);
+          S::v ax_by = S::mul(ax, by);
+
+          S::v s = S::add(roc2, S::mul(S::mul(S::mul(two, S::add(ax_bx, ay_by)), bz), d));
+          s = S::add(s, S::mul(S::mul(two, ax_bx), ay_by));
+          s = S::sub(s, S::mul(ay_bx, ay_bx));
+          s = S::sub(s, S::mul(ax_by, ax_by));
+          s = S::sub(s, S::mul(S::add(S::mul(bx, bx), S::mul(by, by)), S::mul(d, d)));
+          s = S::sub(s, S::mul(S::add(S::mul(ax, ax), S::mul(ay, ay)), S::mul(bz, bz)));
+
+          // no sphere/ray colision in lanes where s < 0
+          S::v ok = S::nlt(s, zero);
+
+          s = S::neg_if(S::gt(S::mul(roc, bz), zero), S::sqrt(s));
+
+          S::v t = S::sub(s, S::add(S::add(S::mul(bz, d), ax_bx), ay_by));
+
+          // do not colide if line intersection is before ray start position
+          ok = S::and_(ok, S::nle(t, zero));
+
+          S::store(point[0] + i, S::add(ax, S::mul(bx, t)));
+          S::store(point[1] + i, S::add(ay, S::mul(by, t)));
+          S::store(point[2] + i, S::add(az, S::mul(bz, t)));
+          S::store_mask(hit + i, ok);
+        }
+#endif
+
+      intersect_batch_scalar(point, hit, origin, direction, i, count, max_radius);
+    }
+
+    void Sphere::normal_batch(double * const normal[3],
+                              const double * const point[3],
+                              unsigned int count) const
+    {
+      unsigned int i = 0;
+
+#ifdef GOPTICAL_SIMD_WIDTH
+      typedef simd_pd S;
+
+      const S::v roc = S::set1(_roc);
+      const S::v sign = S::set1(_roc < 0 ? -1.0 : 1.0);
+
+      for (; i + S::width <= count; i += S::width)
+        {
+          const S::v x = S::load(point[0] + i);
+          const S::v y = S::load(point[1] + i);
+          const S::v z = S::sub(S::load(point[2] + i), roc);
+
+          S::v len = S::sqrt(S::add(S::add(S::mul(x, x), S::mul(y, y)), S::mul(z, z)));
+
+          S::store(normal[0] + i, S::mul(S::div(x, len), sign));
+          S::store(normal[1] + i, S::mul(S::div(y, len), sign));
+          S::store(normal[2] + i, S::mul(S::div(z, len), sign));
+        }
+#endif
+
+      normal_batch_scalar(normal, point, i, count);
+    }
+
   }
 
 }
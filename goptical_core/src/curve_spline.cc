@@ -32,6 +32,9 @@ namespace _Goptical {
       : _data()
     {
       _data.set_interpolation(Data::Cubic);
+      // sagitta and derivative are evaluated at close radii during
+      // intersection iterations
+      _data.set_interval_hint(true);
     }
 
     Spline::~Spline()
@@ -47,6 +50,11 @@ namespace _Goptical {
         _data.add_data(x, c.sagitta(x));
     }
 
+    void Spline::prepare() const
+    {
+      _data.prepare();
+    }
+
   }
 
 }
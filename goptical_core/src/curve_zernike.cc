@@ -22,715 +22,579 @@
 
 */
 
-#include <gsl/gsl_multifit.h>
+#include <algorithm>
 
+#include <gsl/gsl_linalg.h>
+#include <gsl/gsl_permutation.h>
+
+#include <Goptical/Error>
 #include <Goptical/Math/Vector>
 #include <Goptical/Curve/Zernike>
 #include <Goptical/Trace/Distribution>
 #include <Goptical/Shape/Disk>
 
+#include "parallel_.hh"
+
 namespace _Goptical {
 
   namespace Curve {
-
     const Trace::Distribution Zernike::default_dist(Trace::HexaPolarDist, 10);
 
-    struct zp_precalc_s
-    {
-      double x, x2;
-      double y, y2;
-      double r;
-
-      inline zp_precalc_s(double x_, double y_)
-        : x(x_),
-          x2(x_ * x_),
-          y(y_),
-          y2(y_ * y_),
-          r(x2 + y2)
-      {
-      }
-    };
-
-    typedef double (zp_t)(const struct zp_precalc_s &p);
-    typedef void (zp_d_t)(const struct zp_precalc_s &p, Math::Vector2 & dxdy);
-
-    // Zernike polynomial 0
-
-    static double zp_0(const struct zp_precalc_s &p)
-    {
-      return 1;
-    }
-
-    // Zernike polynomial 1
-
-    static double zp_1(const struct zp_precalc_s &p)
-    {
-      return p.x;
-    }
-
-    static void zp_1_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 1.0;
-      dxdy.y() = 0.0;
-    }
-
-    // Zernike polynomial 2
-
-    static double zp_2(const struct zp_precalc_s &p)
-    {
-      return p.y;
-    }
-
-    static void zp_2_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 0.0;
-      dxdy.y() = 1.0;
-    }
-
-    // Zernike polynomial 3
-
-    static double zp_3(const struct zp_precalc_s &p)
-    {
-      return -1.0 + 2.0 * p.r;
-    }
-
-    static void zp_3_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 4.0 * p.x;
-      dxdy.y() = 4.0 * p.y;
-    }
-
-    // Zernike polynomial 4
-
-    static double zp_4(const struct zp_precalc_s &p)
-    {
-      return p.x2 - p.y2;
-    }
+    // Zernike terms are Z = R(rho) * cos(m * theta) or R(rho) * sin(m
+    // * theta) with radial polynomial R of order n = m + 2 * k. The
+    // angular part multiplied by rho^m is the real or imaginary part
+    // of (x + i * y)^m and the remaining radial part is a polynomial
+    // Q_k(u) of u = rho^2 which is a shifted Jacobi polynomial:
+    //
+    //   Q_k(u) = (a_k * u + b_k) * Q_k-1(u) - c_k * Q_k-2(u)
+    //
+    // with Q_-1 = 1 and Q_-2 = 0. Terms are indexed in fringe order:
+    // terms with the same q = m + k are grouped in increasing q
+    // order, with decreasing m (cosine then sine) in a group.
+
+    static void zp_recurrence(unsigned int m, unsigned int k,
+                              double &a, double &b, double &c)
+    {
+      if (k == 0)
+        {
+          a = 0.0;
+          b = 1.0;
+          c = 0.0;
+        }
+      else if (k == 1)
+        {
+          a = m + 2.0;
+          b = - (m + 1.0);
+          c = 0.0;
+        }
+      else
+        {
+          double d = 2.0 * k * (k + m) * (2 * k + m - 2);
+          double e = 2 * k + m - 1;
+          double f = (2.0 * k + m) * (2 * k + m - 2);
 
-    static void zp_4_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 2.0 * p.x;
-      dxdy.y() = -2.0 * p.y;
+          a = 2.0 * e * f / d;
+          b = - e * (f + m * m) / d;
+          c = 2.0 * (k + m - 1) * (k - 1) * (2 * k + m) / d;
+        }
     }
 
-    // Zernike polynomial 5
-
-    static double zp_5(const struct zp_precalc_s &p)
+    static void zp_order(unsigned int n, unsigned int &m, unsigned int &k, bool &sine)
     {
-      return 2.0 * p.x * p.y;
-    }
+      unsigned int q = (unsigned int)sqrt((double)n);
 
-    static void zp_5_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 2.0 * p.y;
-      dxdy.y() = 2.0 * p.x;
-    }
+      // fix rounding of large values
+      while (q * q > n)
+        q--;
+      while ((q + 1) * (q + 1) <= n)
+        q++;
 
-    // Zernike polynomial 6
+      unsigned int r = n - q * q;
 
-    static double zp_6(const struct zp_precalc_s &p)
-    {
-      return p.x * (-2.0 + 3.0 * p.r);
+      m = q - r / 2;
+      k = q - m;
+      sine = r & 1;
     }
 
-    static void zp_6_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    static inline unsigned int zp_index(unsigned int m, unsigned int k)
     {
-      dxdy.x() = 3.0 * p.r + 6.0 * p.x2 - 2.0;
-      dxdy.y() = 6.0 * p.x * p.y;
-    }
-
-    // Zernike polynomial 7
+      unsigned int q = m + k;
 
-    static double zp_7(const struct zp_precalc_s &p)
-    {
-      return p.y * (-2.0 + 3.0 * p.r);
+      return q * q + 2 * k;
     }
 
-    static void zp_7_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    /** evaluate Q_k(u) and its derivative */
+    static void zp_radial(unsigned int m, unsigned int k, double u,
+                          double &q, double &dq)
     {
-      dxdy.x() = 6.0 * p.x * p.y;
-      dxdy.y() = 3.0 * p.r + 6.0 * p.y2 - 2.0;
-    }
+      double q1 = 1.0, q2 = 0.0, d1 = 0.0, d2 = 0.0;
 
-    // Zernike polynomial 8
-
-    static double zp_8(const struct zp_precalc_s &p)
-    {
-      return 1.0 + 6.0 * p.r * (- 1.0 + p.r);
-    }
-
-    static void zp_8_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 12.0 * (2 * p.r - 1.0);
-
-      dxdy.x() = p.x * a;
-      dxdy.y() = p.y * a;
-    }
-
-    // Zernike polynomial 9
-
-    static double zp_9(const struct zp_precalc_s &p)
-    {
-      return p.x * (p.x2 - 3.0 * p.y2);
-    }
+      for (unsigned int i = 0; i <= k; i++)
+        {
+          double a, b, c;
 
-    static void zp_9_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 3.0 * (p.x2 - p.y2);
-      dxdy.y() = -6.0 * p.x * p.y;
-    }
+          zp_recurrence(m, i, a, b, c);
 
-    // Zernike polynomial 10
+          double l = a * u + b;
 
-    static double zp_10(const struct zp_precalc_s &p)
-    {
-      return -p.y * (p.y2 - 3.0 * p.x2);
-    }
+          q = l * q1 - c * q2;
+          dq = a * q1 + l * d1 - c * d2;
 
-    static void zp_10_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 6.0 * p.x * p.y;
-      dxdy.y() = 3.0 * (p.x2 - p.y2);
+          q2 = q1;
+          q1 = q;
+          d2 = d1;
+          d1 = dq;
+        }
     }
 
-    // Zernike polynomial 11
-
-    static double zp_11(const struct zp_precalc_s &p)
+    /** evaluate (x + i * y)^m and (x + i * y)^(m-1) */
+    static void zp_angular(unsigned int m, double x, double y,
+                           double &c, double &s, double &cp, double &sp)
     {
-      return (p.y2 - p.x2) * (3.0 + (-4.0 * p.r));
-    }
+      c = 1.0;
+      s = cp = sp = 0.0;
 
-    static void zp_11_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = p.x * (16.0 * p.x2 - 6.0);
-      dxdy.y() = p.y * (-16.0 * p.y2 + 6.0);
+      for (unsigned int i = 0; i < m; i++)
+        {
+          cp = c;
+          sp = s;
+          c = cp * x - sp * y;
+          s = cp * y + sp * x;
+        }
     }
 
-    // Zernike polynomial 12
-
-    static double zp_12(const struct zp_precalc_s &p)
+    /** evaluate count zernike terms in fringe order */
+    static void zp_values(unsigned int count, double x, double y, double *v)
     {
-      return p.x * p.y * (-6.0 + 8.0 * p.r);
-    }
+      double u = x * x + y * y;
+      double c = 1.0, s = 0.0;
 
-    static void zp_12_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = p.y * (8.0 * p.y2 + 24.0 * p.x2 - 6.0);
-      dxdy.y() = p.x * (8.0 * p.x2 + 24.0 * p.y2 - 6.0);
-    }
+      for (unsigned int m = 0; zp_index(m, 0) < count; m++)
+        {
+          if (m > 0)
+            {
+              double cp = c;
+              c = cp * x - s * y;
+              s = cp * y + s * x;
+            }
 
-    // Zernike polynomial 13
+          double q1 = 1.0, q2 = 0.0;
 
-    static double zp_13(const struct zp_precalc_s &p)
-    {
-      return p.x * (3.0 - p.r * (12.0 - 10.0 * p.r));
-    }
+          for (unsigned int k = 0; ; k++)
+            {
+              unsigned int n = zp_index(m, k);
 
-    static void zp_13_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = (12.0 - 10.0 * p.r);
+              if (n >= count)
+                break;
 
-      dxdy.x() = p.x2 * (20.0 * p.r - 2.0 * a) - a * p.r + 3.0;
-      dxdy.y() = 8.0 * p.x * p.y * (5.0 * p.r - 3.0); 
-    }
+              double a, b, cc;
 
-    // Zernike polynomial 14
+              zp_recurrence(m, k, a, b, cc);
 
-    static double zp_14(const struct zp_precalc_s &p)
-    {
-      return p.y * (3.0 - p.r * (12.0 - 10.0 * p.r));
-    }
+              double q = (a * u + b) * q1 - cc * q2;
 
-    static void zp_14_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = (12.0 - 10.0 * p.r);
+              q2 = q1;
+              q1 = q;
 
-      dxdy.x() = 8.0 * p.x * p.y * (5.0 * p.r - 3.0); 
-      dxdy.y() = p.y2 * (20.0 * p.r - 2.0 * a) - a * p.r + 3.0;
+              v[n] = q * c;
+              if (m > 0 && n + 1 < count)
+                v[n + 1] = q * s;
+            }
+        }
     }
 
-    // Zernike polynomial 15
-
-    static double zp_15(const struct zp_precalc_s &p)
+    Zernike::Zernike(double radius, double unit_scale)
+      : _scale(unit_scale),
+        _threshold(1e-10),
+        _radius(radius),
+        _coeff(term_count, 0.0),
+        _enabled(term_count, false),
+        _fit_threads(1),
+        _fit_terms(0),
+        _fit_scale(0.0),
+        _fit_rank(0)
     {
-      return -1.0 + p.r * (12 - p.r * (30.0 - 20.0 * p.r));
+      update_terms();
     }
 
-    static void zp_15_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    Zernike::Zernike(double radius, double coefs[],
+                     unsigned int coefs_count, double unit_scale)
+      : _scale(unit_scale),
+        _threshold(1e-10),
+        _radius(radius),
+        _coeff(coefs_count > term_count ? coefs_count : term_count, 0.0),
+        _enabled(_coeff.size(), false),
+        _fit_threads(1),
+        _fit_terms(0),
+        _fit_scale(0.0),
+        _fit_rank(0)
     {
-      double a = 24.0 * (5.0 * p.r * (p.r - 1.0) + 1.0);
+      for (unsigned int i = 0; i < coefs_count; i++)
+        _coeff[i] = coefs[i];
 
-      dxdy.x() = a * p.x;
-      dxdy.y() = a * p.y;
+      update_threshold_state();
     }
 
-    // Zernike polynomial 16
-
-    static double zp_16(const struct zp_precalc_s &p)
+    void Zernike::set_term_count(unsigned int count)
     {
-      return p.x2*p.x2 + p.y2 * (p.y2 - 6.0 * p.x2);
-    }    
-
-    static void zp_16_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = -4.0 * p.x * (3.0 * p.y2 - p.x2);
-      dxdy.y() = 4.0 * p.y * (p.y2 - 3.0 * p.x2);
+      _coeff.resize(count, 0.0);
+      _enabled.resize(count, false);
+      update_terms();
     }
 
-    // Zernike polynomial 17
-
-    static double zp_17(const struct zp_precalc_s &p)
+    void Zernike::update_terms()
     {
-      return 4.0 * p.x * p.y * (p.x2 - p.y2);
-    }
+      unsigned int count = _coeff.size();
 
-    static void zp_17_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = -4.0 * p.y * (p.y2 - 3.0 * p.x2);
-      dxdy.y() = -4.0 * p.x * (3.0 * p.y2 - p.x2);
-    }
+      // find highest enabled radial order for each azimuthal frequency
+      std::vector<int> kmax;
 
-    // Zernike polynomial 18
+      for (unsigned int n = 0; n < count; n++)
+        {
+          if (!_enabled[n])
+            continue;
 
-    static double zp_18(const struct zp_precalc_s &p)
-    {
-      return p.x * (- 4.0 + 5.0 * p.r) * (p.x2 - 3.0 * p.y2);
-    }
+          unsigned int m, k;
+          bool sine;
 
-    static void zp_18_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = (5.0 * p.r - 4.0);
-      double b = (p.x2 - 3.0 * p.y2);
+          zp_order(n, m, k, sine);
 
-      dxdy.x() = b * (10.0 * p.x2 + a) + 2.0 * a * p.x2;
-      dxdy.y() = p.x * p.y * (10.0 * b - 6.0 * a);
-    }
+          if (kmax.size() <= m)
+            kmax.resize(m + 1, -1);
 
-    // Zernike polynomial 19
+          kmax[m] = std::max(kmax[m], (int)k);
+        }
 
-    static double zp_19(const struct zp_precalc_s &p)
-    {
-      return p.y * (- 4.0 + 5.0 * p.r) * (3.0 * p.x2 - p.y2);
-    }
+      _terms.clear();
+      _m_count.assign(kmax.size(), 0);
 
-    static void zp_19_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = (3.0 * p.x2 - p.y2);
-      double b = (5.0 * p.r - 4.0);
+      for (unsigned int m = 0; m < kmax.size(); m++)
+        {
+          for (int k = 0; k <= kmax[m]; k++)
+            {
+              unsigned int n = zp_index(m, k);
+              term_s t;
 
-      dxdy.x() = p.x * p.y * (10.0 * a + 6.0 * b);
-      dxdy.y() = p.y2 * (-2.0 * b + 10.0 * a) + a * b;
-    }
+              zp_recurrence(m, k, t.a, t.b, t.c);
+              t.cos_coeff = _enabled[n] ? _coeff[n] : 0.0;
+              t.sin_coeff = m > 0 && n + 1 < count && _enabled[n + 1]
+                ? _coeff[n + 1] : 0.0;
 
-    // Zernike polynomial 20
+              _terms.push_back(t);
+            }
 
-    static double zp_20(const struct zp_precalc_s &p)
-    {
-      return (p.x2 - p.y2) * (6.0 - p.r * (20.0 - 15.0 * p.r));
+          _m_count[m] = kmax[m] + 1;
+        }
     }
 
-    static void zp_20_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    void Zernike::eval(double x, double y, double &sag, double *dxdy) const
     {
-      double a = 20.0 - 15.0 * p.r;
-      double b = (30.0 * p.r - 2.0 * a) * (p.x2 - p.y2);
-      double c = 2.0 * (6.0 - a * p.r);
-
-      dxdy.x() = p.x * (b + c);
-      dxdy.y() = p.y * (b - c);
-    }
+      const term_s *t = _terms.empty() ? 0 : &_terms[0];
+      double u = x * x + y * y;
 
-    // Zernike polynomial 21
+      // (x + i * y)^m and (x + i * y)^(m-1)
+      double c = 1.0, s = 0.0, cp = 0.0, sp = 0.0;
+      double z = 0.0, gx = 0.0, gy = 0.0;
 
-    static double zp_21(const struct zp_precalc_s &p)
-    {
-      return p.x * p.y * (12.0 - p.r * (40.0 - 30.0 * p.r));
-    }
-
-    static void zp_21_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = (40.0 - 30.0 * p.r);
-      double b = (60.0 * p.r - 2.0 * a);
-      double c = (12.0 - a * p.r);
+      for (unsigned int m = 0; m < _m_count.size(); m++)
+        {
+          if (m > 0)
+            {
+              cp = c;
+              sp = s;
+              c = cp * x - sp * y;
+              s = cp * y + sp * x;
+            }
 
-      dxdy.x() = p.y * (p.x2 * b + c);
-      dxdy.y() = p.x * (p.y2 * b + c);
-    }
+          // weighted sums of radial polynomials and derivatives
+          double ac = 0.0, as = 0.0, dc = 0.0, ds = 0.0;
+          double q1 = 1.0, q2 = 0.0, d1 = 0.0, d2 = 0.0;
 
-    // Zernike polynomial 22
+          for (const term_s *end = t + _m_count[m]; t < end; t++)
+            {
+              double l = t->a * u + t->b;
+              double q = l * q1 - t->c * q2;
 
-    static double zp_22(const struct zp_precalc_s &p)
-    {
-      return p.x * (-4.0 + p.r * (30.0 - p.r * (60.0 - 35.0 * p.r)));
-    }
+              ac += t->cos_coeff * q;
+              as += t->sin_coeff * q;
 
-    static void zp_22_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 60.0 - 35.0 * p.r;
-      double b = 30.0 - a * p.r;
-      double c = (70.0 * p.r - 2.0 * a);
-      double e = (p.r * c + 2.0 * b);
+              if (dxdy)
+                {
+                  double d = t->a * q1 + l * d1 - t->c * d2;
 
-      dxdy.x() = p.x2      * e + b * p.r - 4.0;
-      dxdy.y() = p.x * p.y * e;
-    }
+                  dc += t->cos_coeff * d;
+                  ds += t->sin_coeff * d;
+                  d2 = d1;
+                  d1 = d;
+                }
 
-    // Zernike polynomial 23
+              q2 = q1;
+              q1 = q;
+            }
 
-    static double zp_23(const struct zp_precalc_s &p)
-    {
-      return p.y * (-4.0 + p.r * (30.0 - p.r * (60.0 - 35.0 * p.r)));
-    }
+          z += ac * c + as * s;
 
-    static void zp_23_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 60.0 - 35.0 * p.r;
-      double b = 30.0 - a * p.r;
-      double c = (70.0 * p.r - 2.0 * a);
-      double e = (p.r * c + 2.0 * b);
+          if (dxdy)
+            {
+              double g = 2.0 * (dc * c + ds * s);
 
-      dxdy.x() = p.x * p.y * e;
-      dxdy.y() = p.y2      * e + b * p.r - 4.0;
-    }
+              gx += x * g + m * (ac * cp + as * sp);
+              gy += y * g + m * (as * cp - ac * sp);
+            }
+        }
 
-    // Zernike polynomial 24
+      sag = z;
 
-    static double zp_24(const struct zp_precalc_s &p)
-    {
-      return 1.0 - p.r * (20.0 + p.r * (-90.0 - p.r * (-140.0 + 70.0 * p.r)));
+      if (dxdy)
+        {
+          dxdy[0] = gx;
+          dxdy[1] = gy;
+        }
     }
 
-    static void zp_24_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    double Zernike::sagitta(const Math::Vector2 & xy) const
     {
-      double a = 70.0 * p.r - 140.0;
-      double b = (p.r * ((140.0 * p.r + 6.0 * a) * p.r + 360.0) - 40.f); 
+      double x = xy.x() / _radius;
+      double y = xy.y() / _radius;
 
-      dxdy.x() = p.x * b;
-      dxdy.y() = p.y * b;
-    }
-
-    // Zernike polynomial 25
-
-    static double zp_25(const struct zp_precalc_s &p)
-    {
-      return p.x * (p.x2 * (p.x2 - 10.0 * p.y2) + 5.0 * p.y2*p.y2);
-    }
+      if (x * x + y * y > 1.0)
+        return 0;
 
-    static void zp_25_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() = 5.0 * Math::square(p.y2) + 2.0 * Math::square(p.x2) + 3.0 * (p.x2 - 10.0 * p.y2) * p.x2;
-      dxdy.y() = 20.0 * p.x * p.y * (p.y2 - p.x2);
-    }
+      double sag;
 
-    // Zernike polynomial 26
+      eval(x, y, sag, 0);
 
-    static double zp_26(const struct zp_precalc_s &p)
-    {
-      return p.y * (p.y2 * (p.y2 - 10.0 * p.x2) + 5.0 * p.x2*p.x2);
+      return sag * _scale;
     }
 
-    static void zp_26_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    void Zernike::derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const
     {
-      dxdy.x() = 20.0 * p.x * p.y * (p.x2 - p.y2);
-      dxdy.y() = 5.0 * Math::square(p.x2) + 2.0 * Math::square(p.y2) + 3.0 * (p.y2 - 10.0 * p.x2) * p.y2;
-    }
-
-    // Zernike polynomial 27
+      double sag;
 
-    static double zp_27(const struct zp_precalc_s &p)
-    {
-      return (-Math::square(p.x2) + p.y2 * (-p.y2 + p.x2 * 6.0)) * (5.0 - 6.0 * p.r);
+      sagitta_derivative(xy, sag, dxdy);
     }
 
-    static void zp_27_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    void Zernike::sagitta_derivative(const Math::Vector2 & xy, double &sag,
+                                     Math::Vector2 & dxdy) const
     {
-      dxdy.x() = p.x * (p.y2 * (-60.0 * p.y2 - 120.0 * p.x2 + 60.0) + p.x2 * (36.0 * p.x2 - 20.0));
-      dxdy.y() = p.y * (p.x2 * (-60.0 * p.x2 - 120.0 * p.y2 + 60.0) + p.y2 * (36.0 * p.y2 - 20.0));
-    }
+      double x = xy.x() / _radius;
+      double y = xy.y() / _radius;
 
-    // Zernike polynomial 28
+      if (x * x + y * y > 1.0)
+        {
+          sag = 0.0;
+          dxdy.set(0.0);
+          return;
+        }
 
-    static double zp_28(const struct zp_precalc_s &p)
-    {
-      return p.x * p.y * (p.x2 - p.y2) * (-20.0 + 24.0 * p.r);
-    }
+      double d[2];
 
-    static void zp_28_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      dxdy.x() =  p.y * (p.y2 * (-24.0 * p.y2 + 20.0) + p.x2 * (120.0 * p.x2 - 60.f));
-      dxdy.y() = -p.x * (p.x2 * (-24.0 * p.x2 + 20.0) + p.y2 * (120.0 * p.y2 - 60.f));
-    }
-
-    // Zernike polynomial 29
+      eval(x, y, sag, d);
 
-    static double zp_29(const struct zp_precalc_s &p)
-    {
-      return p.x * (10.0 - p.r * (30.0 - 21.0 * p.r)) * (p.x2 + p.y2 * -3.0);
+      sag *= _scale;
+      dxdy.x() = d[0] * _scale / _radius;
+      dxdy.y() = d[1] * _scale / _radius;
     }
 
-    static void zp_29_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    void Zernike::sagitta_derivative_batch(double *sag, double * const dxdy[2],
+                                           const double * const xy[2],
+                                           unsigned int count) const
     {
-      double a = 30.0 - 21.0 * p.r;
-      double b = 10.0 - a * p.r;
-      double c = (p.x2 - 3.0 * p.y2);
-      double e = (42.0 * p.r - 2.0 * a);
+      const double ir = 1.0 / _radius;
+      const double gs = _scale * ir;
 
-      dxdy.x() = c * (p.x2 * e + b) + 2 * b * p.x2;
-      dxdy.y() = p.x * p.y * (e * c - 6.0 * b);
-    }
+      for (unsigned int i = 0; i < count; i++)
+        {
+          double x = xy[0][i] * ir;
+          double y = xy[1][i] * ir;
+          double z = 0.0, d[2] = { 0.0, 0.0 };
 
-    // Zernike polynomial 30
+          if (x * x + y * y <= 1.0)
+            eval(x, y, z, d);
 
-    static double zp_30(const struct zp_precalc_s &p)
-    {
-      return -p.y * (10.0 - p.r * (30.0 - 21.0 * p.r)) * (p.y2 + p.x2 * -3.0);
+          sag[i] = z * _scale;
+          dxdy[0][i] = d[0] * gs;
+          dxdy[1][i] = d[1] * gs;
+        }
     }
 
-    static void zp_30_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    void Zernike::normal_batch(double * const normal[3],
+                               const double * const point[3],
+                               unsigned int count) const
     {
-      double a = 30.0 - 21.0 * p.r;
-      double b = 10.0 - a * p.r;
-      double c = (p.y2 - 3.0 * p.x2);
-      double e = (42.0 * p.r - 2.0 * a);
-
-      dxdy.x() = p.x * p.y * (6.0 * b - e * c);
-      dxdy.y() = -c * (p.y2 * e + b) - 2.0 * b * p.y2;
-    }
+      const double ir = 1.0 / _radius;
+      const double gs = _scale * ir;
 
-    // Zernike polynomial 31
+      for (unsigned int i = 0; i < count; i++)
+        {
+          double x = point[0][i] * ir;
+          double y = point[1][i] * ir;
+          double z, d[2] = { 0.0, 0.0 };
 
-    static double zp_31(const struct zp_precalc_s &p)
-    {
-      return (p.x2 - p.y2) * (-10.0 + p.r * (60.0 - p.r * (105.0 - 56.0 * p.r)));
-    }
+          if (x * x + y * y <= 1.0)
+            eval(x, y, z, d);
 
-    static void zp_31_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 105.0 - 56.0 * p.r;
-      double b = 60.0 - a * p.r;
-      double c = 2.0 * (p.r * (56.0 * p.r - a) + b) * (p.x2 - p.y2);
-      double e = 2.0 * (b * p.r - 10.0);
+          double nx = d[0] * gs;
+          double ny = d[1] * gs;
+          double l = 1.0 / sqrt(nx * nx + ny * ny + 1.0);
 
-      dxdy.x() = p.x * (c + e);
-      dxdy.y() = p.y * (c - e);
+          normal[0][i] = nx * l;
+          normal[1][i] = ny * l;
+          normal[2][i] = -l;
+        }
     }
 
-    // Zernike polynomial 32
-
-    static double zp_32(const struct zp_precalc_s &p)
+    bool Zernike::intersect_range(const Math::VectorPair2 &,
+                                  double &min, double &max) const
     {
-      return p.x * p.y * (-20.0 + p.r * (120.0 - p.r * (210.0 - (112.0 * p.r))));
-    }
+      double s = 0.0;
 
-    static void zp_32_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 210.0 - 112.0 * p.r;
-      double b = 120.0 - a * p.r;
-      double c = 2.0 * (p.r * (112.0 * p.r - a) + b);
-      double e = (b * p.r - 20.0);
+      for (unsigned int i = 0; i < _terms.size(); i++)
+        s += fabs(_terms[i].cos_coeff) + fabs(_terms[i].sin_coeff);
 
-      dxdy.x() = p.y * (p.x2 * c + e);
-      dxdy.y() = p.x * (p.y2 * c + e);
-    }
+      s *= fabs(_scale);
 
-    // Zernike polynomial 33
+      min = -s;
+      max = s;
 
-    static double zp_33(const struct zp_precalc_s &p)
-    {
-      return p.x * (5.0 + p.r * (-60.0 + p.r * (210.0 - p.r * (280.0 - 126.0 * p.r))));
+      return true;
     }
 
-    static void zp_33_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
+    class Zernike::fit_job : public parallel_job_t
     {
-      double a = 280.0 - 126.0 * p.r;
-      double b = 210.0 - a * p.r;
-      double c = b * p.r - 60.0;
-      double e = 2.0 * (p.r * (p.r * (126.0 * p.r - a) + b) + c);
-
-      dxdy.x() = p.x2 * e + c * p.r + 5.0;
-      dxdy.y() = p.x * p.y * e;
-    }
-
-    // Zernike polynomial 34
+    public:
+      fit_job(const Base &curve, const std::vector<Math::Vector2> &points,
+              double radius, double *y, unsigned int chunk)
+        : _curve(curve),
+          _points(points),
+          _radius(radius),
+          _y(y),
+          _chunk(chunk)
+      {
+      }
 
-    static double zp_34(const struct zp_precalc_s &p)
-    {
-      return p.y * (5.0 + p.r * (-60.0 + p.r * (210.0 - p.r * (280.0 - 126.0 * p.r))));
-    }
+    private:
+      bool valid() const
+      {
+        return true;
+      }
 
-    static void zp_34_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 280.0 - 126.0 * p.r;
-      double b = 210.0 - a * p.r;
-      double c = b * p.r - 60.0;
-      double e = 2.0 * (p.r * (p.r * (126.0 * p.r - a) + b) + c);
+      void call(unsigned int i) const
+      {
+        unsigned int first = i * _chunk;
+        unsigned int last = std::min(first + _chunk, (unsigned int)_points.size());
 
-      dxdy.x() = p.y * p.x * e;
-      dxdy.y() = p.y2 * e + c * p.r + 5.0;
-    }
+        for (unsigned int j = first; j < last; j++)
+          _y[j] = _curve.sagitta(_points[j] * _radius);
+      }
 
-    // Zernike polynomial 35
+      const Base &_curve;
+      const std::vector<Math::Vector2> &_points;
+      double _radius;
+      double *_y;
+      unsigned int _chunk;
+    };
 
-    static double zp_35(const struct zp_precalc_s &p)
+    void Zernike::update_fit(const Trace::Distribution &d)
     {
-      return -1.0 + p.r * (30.0 + p.r * (-210.0 + p.r * (560.0 - p.r * (630.0 - 252.0 * p.r))));
-    }
+      unsigned int tcount = _coeff.size();
 
-    static void zp_35_d(const struct zp_precalc_s &p, Math::Vector2 & dxdy)
-    {
-      double a = 630.0 - 252.0 * p.r;
-      double b = 560.0 - a * p.r;
-      double c = b * p.r - 210.0;
-      double e = 2.0 * (p.r * (p.r * (p.r * (252.0 * p.r - a) + b) + c) + (c * p.r + 30.0));
+      if (!_fit_points.empty() && _fit_terms == tcount && _fit_scale == _scale
+          && _fit_dist.get_pattern() == d.get_pattern()
+          && _fit_dist.get_radial_density() == d.get_radial_density()
+          && _fit_dist.get_scaling() == d.get_scaling())
+        return;
 
-      dxdy.x() = p.x * e;
-      dxdy.y() = p.y * e;
-    }
+      _fit_points.clear();
 
-    ////////////////////////////////////////////////////
+      if (tcount == 0)
+        throw Error("no zernike terms to fit");
 
-    zp_t * const zp[Zernike::term_count] =
-    {
-      &zp_0,
-      &zp_1, &zp_2, &zp_3,
-      &zp_4, &zp_5, &zp_6, &zp_7, &zp_8,
-      &zp_9, &zp_10, &zp_11, &zp_12, &zp_13, &zp_14, &zp_15,
-      &zp_16, &zp_17, &zp_18, &zp_19, &zp_20, &zp_21, &zp_22, &zp_23, &zp_24,
-      &zp_25, &zp_26, &zp_27, &zp_28, &zp_29, &zp_30, &zp_31, &zp_32, &zp_33, &zp_34, &zp_35
-    };
+      // get distributed sample points on surface
+      std::vector<Math::Vector2 > pattern;
+      delegate_push<typeof(pattern)> pattern_push(pattern);
+      Shape::Disk shape(1.0);
+      shape.get_pattern(pattern_push, d, false);
 
-    zp_d_t * const zp_d[Zernike::term_count] =
-    {
-      0,
-      &zp_1_d, &zp_2_d, &zp_3_d,
-      &zp_4_d, &zp_5_d, &zp_6_d, &zp_7_d, &zp_8_d,
-      &zp_9_d, &zp_10_d, &zp_11_d, &zp_12_d, &zp_13_d, &zp_14_d, &zp_15_d,
-      &zp_16_d, &zp_17_d, &zp_18_d, &zp_19_d, &zp_20_d, &zp_21_d, &zp_22_d, &zp_23_d, &zp_24_d,
-      &zp_25_d, &zp_26_d, &zp_27_d, &zp_28_d, &zp_29_d, &zp_30_d, &zp_31_d, &zp_32_d, &zp_33_d, &zp_34_d, &zp_35_d
-    };
+      unsigned int pcount = pattern.size();
 
-    Zernike::Zernike(double radius, double unit_scale)
-      : _scale(unit_scale),
-        _threshold(1e-10),
-        _radius(radius),
-        _enabled_count(0)
-    {
-      for (unsigned int i = 0; i < term_count; i++)
-        _coeff[i] = 0.0;
-    }
+      if (pcount < tcount)
+        throw Error("not enough sample points to fit zernike terms");
 
-    Zernike::Zernike(double radius, double coefs[],
-                     unsigned int coefs_count, double unit_scale)
-      : _scale(unit_scale),
-        _threshold(1e-10),
-        _radius(radius),
-        _enabled_count(0)
-    {
-      unsigned int i;
+      // setup least square fit matrix from sample points
+      _fit_qr.resize(pcount * tcount);
+      _fit_tau.resize(tcount);
+      _fit_perm.resize(tcount);
 
-      for (i = 0; i < coefs_count; i++)
+      for (unsigned int i = 0; i < pcount; i++)
         {
-          double c = coefs[i];
+          double *row = &_fit_qr[i * tcount];
 
-          _coeff[i] = c;
+          zp_values(tcount, pattern[i].x(), pattern[i].y(), row);
 
-          if (c >= _threshold)
-            _enabled_list[_enabled_count++] = i;
+          for (unsigned int j = 0; j < tcount; j++)
+            row[j] *= _scale;
         }
 
-      for (; i < term_count; i++)
-        _coeff[i] = 0.0;
-    }
+      std::vector<double> norm(tcount);
+      gsl_matrix_view X = gsl_matrix_view_array(&_fit_qr[0], pcount, tcount);
+      gsl_vector_view tau = gsl_vector_view_array(&_fit_tau[0], tcount);
+      gsl_vector_view nv = gsl_vector_view_array(&norm[0], tcount);
+      gsl_permutation perm = { tcount, &_fit_perm[0] };
+      int signum;
 
-    double Zernike::sagitta(const Math::Vector2 & xy) const
-    {
-      struct zp_precalc_s p(xy.x() / _radius, xy.y() / _radius);
+      gsl_linalg_QRPT_decomp(&X.matrix, &tau.vector, &perm, &signum, &nv.vector);
 
-      if (p.r > 1.0)
-        return 0;
+      // pivoting sorts R diagonal by decreasing magnitude, terms
+      // after the first negligible diagonal element depend on
+      // previous terms on sample points
+      static const double rank_tolerance = 1e-10;
+      double rmax = fabs(_fit_qr[0]);
+      unsigned int rank = 0;
 
-      double sum = 0.0;
+      while (rank < tcount &&
+             fabs(_fit_qr[rank * tcount + rank]) > rank_tolerance * rmax)
+        rank++;
 
-      for (unsigned int i = 0; i < _enabled_count; i++)
-        {
-          unsigned int n = _enabled_list[i];
-          sum += zp[n](p) * _coeff[n];
-        }
+      if (rank == 0)
+        throw Error("sample points do not determine any zernike term");
 
-      return sum * _scale;
+      _fit_dist = d;
+      _fit_terms = tcount;
+      _fit_scale = _scale;
+      _fit_rank = rank;
+      _fit_points.swap(pattern);
     }
 
-    void Zernike::derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const
+    double Zernike::fit(const Base &curve, const Trace::Distribution & d)
     {
-      struct zp_precalc_s p(xy.x() / _radius, xy.y() / _radius);
-
-      dxdy.set(0.0);
-
-      if (p.r > 1.0)
-        return;
+      static const unsigned int chunk = 256;
 
-      for (unsigned int i = 0; i < _enabled_count; i++)
-        {
-          unsigned int n = _enabled_list[i];
+      update_fit(d);
 
-          if (n > 0)
-            {
-              Math::Vector2 dtmp;
+      unsigned int pcount = _fit_points.size();
+      unsigned int tcount = _fit_terms;
+      std::vector<double> y(pcount);
 
-              zp_d[n](p, dtmp);
-              dxdy += dtmp * (_coeff[n] / _radius);
-            }
-        }
+      // sample curve, lazy state must be computed before sharing
+      // the curve between threads
+      curve.prepare();
 
-      dxdy *= _scale;
-    }
+      parallel_for((pcount + chunk - 1) / chunk, _fit_threads,
+                   fit_job(curve, _fit_points, _radius, &y[0], chunk));
 
-    double Zernike::fit(const Base &curve, const Trace::Distribution & d)
-    {
-      // get distributed sample points on surface
-      std::vector<Math::Vector2 > pattern;
-      delegate_push<typeof(pattern)> pattern_push(pattern);
-      Shape::Disk shape(1.0);
-      shape.get_pattern(pattern_push, d, false);
+      // solve least square problem with cached factorization, y
+      // becomes Q^T * y
 
-      unsigned int pcount = pattern.size();
+      gsl_matrix_const_view X = gsl_matrix_const_view_array(&_fit_qr[0], pcount, tcount);
+      gsl_vector_const_view tau = gsl_vector_const_view_array(&_fit_tau[0], tcount);
+      gsl_vector_view yv = gsl_vector_view_array(&y[0], pcount);
 
-      gsl_matrix *X = gsl_matrix_alloc(pcount, term_count);
-      gsl_vector *y = gsl_vector_alloc(pcount);
-      gsl_vector *c = gsl_vector_alloc(term_count);
-      gsl_matrix *cov = gsl_matrix_alloc(term_count, term_count);
+      gsl_linalg_QR_QTvec(&X.matrix, &tau.vector, &yv.vector);
 
-      unsigned int i = 0;
+      // back substitution on independent terms, dependent terms are
+      // set to zero
+      unsigned int rank = _fit_rank;
 
-      // setup least square fit matrix from sample points
+      for (unsigned int j = rank; j < tcount; j++)
+        _coeff[_fit_perm[j]] = 0.0;
 
-      GOPTICAL_FOREACH(pt, pattern)
+      for (unsigned int j = rank; j-- > 0; )
         {
-          struct zp_precalc_s p(pt->x(), pt->y());
+          const double *row = &_fit_qr[j * tcount];
+          double s = y[j];
 
-          gsl_vector_set(y, i, curve.sagitta(*pt * _radius));
-          
-          for (unsigned int j = 0; j < term_count; j++)
-            gsl_matrix_set(X, i, j, zp[j](p) * _scale);
+          for (unsigned int k = j + 1; k < rank; k++)
+            s -= row[k] * _coeff[_fit_perm[k]];
 
-          i++;
+          _coeff[_fit_perm[j]] = s / row[j];
         }
 
-      double chisq;
-
-      // process least square fit
-
-      gsl_multifit_linear_workspace *work = gsl_multifit_linear_alloc(pcount, term_count);
-      gsl_multifit_linear(X, y, c, cov, &chisq, work);
-      gsl_multifit_linear_free(work);
-
-      gsl_matrix_free(X);
-      gsl_vector_free(y);
-      gsl_matrix_free(cov);
+      // residual is the part of Q^T * y not reached by R
+      double chisq = 0.0;
 
-      for (unsigned int j = 0; j < term_count; j++)
-        _coeff[j] = gsl_vector_get(c, j);
-
-      gsl_vector_free(c);
+      for (unsigned int i = rank; i < pcount; i++)
+        chisq += y[i] * y[i];
 
       update_threshold_state();
 
@@ -739,67 +603,76 @@ namespace _Goptical {
 
     void Zernike::update_threshold_state()
     {
-      unsigned int n = 0, i = 0;
-
-      for (; i < term_count; i++)
-        if (fabs(_coeff[i]) >= _threshold)
-          _enabled_list[n++] = i;
+      for (unsigned int i = 0; i < _coeff.size(); i++)
+        _enabled[i] = fabs(_coeff[i]) >= _threshold;
 
-      _enabled_count = n;
+      update_terms();
     }
 
     void Zernike::set_term_state(unsigned int n, bool enabled)
     {
-      unsigned int i;
+      assert(n < _coeff.size());
 
-      assert(n < term_count);
+      if (_enabled[n] == enabled)
+        return;
 
-      if (enabled)
-        {
-          for (i = 0; i < _enabled_count; i++)
-            if (_enabled_list[i] == n)
-              return;
-          assert(i < term_count);
-          _enabled_list[i] = n;
-          _enabled_count = i + 1;
-        }
-      else
-        {
-          for (i = 0; i < _enabled_count; i++)
-            if (_enabled_list[i] == n)
-              {
-                _enabled_count--;
-                _enabled_list[i] = _enabled_list[_enabled_count];
-                return;
-              }
-        }
+      _enabled[n] = enabled;
+      update_terms();
     }
 
     bool Zernike::get_term_state(unsigned int n)
     {
-      for (unsigned int i = 0; i < _enabled_count; i++)
-        if (_enabled_list[i] == n)
-          return true;
+      return n < _enabled.size() && _enabled[n];
+    }
 
-      return false;
+    void Zernike::get_term_orders(unsigned int n, unsigned int &radial, int &azimuthal)
+    {
+      unsigned int m, k;
+      bool sine;
+
+      zp_order(n, m, k, sine);
+
+      radial = m + 2 * k;
+      azimuthal = sine ? -(int)m : (int)m;
     }
 
     double Zernike::zernike_poly(unsigned int n, const Math::Vector2 & xy)
     {
-      struct zp_precalc_s p(xy.x(), xy.y());
+      unsigned int m, k;
+      bool sine;
+
+      zp_order(n, m, k, sine);
 
-      assert(n < term_count);
+      double q, dq, c, s, cp, sp;
 
-      return zp[n](p);
+      zp_radial(m, k, xy.x() * xy.x() + xy.y() * xy.y(), q, dq);
+      zp_angular(m, xy.x(), xy.y(), c, s, cp, sp);
+
+      return q * (sine ? s : c);
     }
 
     void Zernike::zernike_poly_d(unsigned int n, const Math::Vector2 & xy, Math::Vector2 & dxdy)
     {
-      struct zp_precalc_s p(xy.x(), xy.y());
+      unsigned int m, k;
+      bool sine;
+
+      zp_order(n, m, k, sine);
 
-      assert(n < term_count);
+      double q, dq, c, s, cp, sp;
 
-      zp_d[n](p, dxdy);
+      zp_radial(m, k, xy.x() * xy.x() + xy.y() * xy.y(), q, dq);
+      zp_angular(m, xy.x(), xy.y(), c, s, cp, sp);
+
+      if (sine)
+        {
+          dxdy.x() = 2.0 * xy.x() * dq * s + m * q * sp;
+          dxdy.y() = 2.0 * xy.y() * dq * s + m * q * cp;
+        }
+      else
+        {
+          dxdy.x() = 2.0 * xy.x() * dq * c + m * q * cp;
+          dxdy.y() = 2.0 * xy.y() * dq * c - m * q * sp;
+        }
     }
 
   }
@@ -35,9 +35,17 @@ namespace _Goptical
   namespace Data
   {
 
+    // last interval found by each thread on a data set with hint enabled
+    static __thread const DiscreteSetBase *hint_set = 0;
+    static __thread unsigned int hint_interval;
+
     DiscreteSetBase::DiscreteSetBase()
       : Set1d(),
-        _data()
+        _data(),
+        _index(),
+        _index_origin(0.),
+        _index_scale(0.),
+        _hint(false)
     {
     }
 
@@ -45,10 +53,11 @@ namespace _Goptical
     {
     }
 
-    inline unsigned int DiscreteSetBase::get_interval(double x) const
+    unsigned int DiscreteSetBase::search_interval(double x, unsigned int first,
+                                                  unsigned int last) const
     {
-      int min_idx = 0;
-      int max_idx = _data.size() + 1;
+      unsigned int min_idx = first;
+      unsigned int max_idx = last + 1;
 
       while (max_idx - min_idx > 1)
         {
@@ -63,22 +72,102 @@ namespace _Goptical
       return min_idx;
     }
 
-    inline unsigned int DiscreteSetBase::get_nearest(double x) const
+    unsigned int DiscreteSetBase::get_bucket(double x) const
     {
-      int min_idx = 0;
-      int max_idx = _data.size();
+      unsigned int buckets = _index.size() - 1;
+      double b = (x - _index_origin) * _index_scale;
 
-      while (max_idx - min_idx > 1)
+      return b < buckets ? (unsigned int)b : buckets - 1;
+    }
+
+    void DiscreteSetBase::update_index() const
+    {
+      unsigned int n = _data.size();
+
+      _index.clear();
+
+      if (n < 2)
+        return;
+
+      // one bucket per data entry on average
+      unsigned int buckets = n;
+
+      _index_origin = _data.front().x;
+      _index_scale = buckets / (_data.back().x - _index_origin);
+
+      _index.resize(buckets + 1);
+
+      // store number of entries in previous buckets. Entries are
+      // assigned to buckets with the same arithmetic as lookups so
+      // that rounding can not misplace an interval
+      unsigned int j = 0;
+
+      for (unsigned int k = 0; k < buckets; k++)
         {
-          unsigned int p = (max_idx + min_idx) / 2;
+          _index[k] = j;
 
-          if (x + x >= _data[p - 1].x + _data[p].x)
-            min_idx = p;
-          else
-            max_idx = p;
+          while (j < n && get_bucket(_data[j].x) == k)
+            j++;
         }
 
-      return min_idx;
+      _index[buckets] = n;
+    }
+
+    inline unsigned int DiscreteSetBase::get_interval(double x) const
+    {
+      unsigned int n = _data.size();
+
+      if (_hint && hint_set == this)
+        {
+          unsigned int h = hint_interval;
+
+          // check last interval and next one
+          if (h <= n && (h == 0 || x >= _data[h - 1].x))
+            {
+              if (h == n || x < _data[h].x)
+                return h;
+
+              if (h + 1 == n || x < _data[h + 1].x)
+                return hint_interval = h + 1;
+            }
+        }
+
+      unsigned int i;
+
+      if (_index.empty())
+        i = search_interval(x, 0, n);
+      else if (!(x >= _data.front().x))
+        i = 0;
+      else if (x >= _data.back().x)
+        i = n;
+      else
+        {
+          unsigned int k = get_bucket(x);
+
+          i = search_interval(x, _index[k], _index[k + 1]);
+        }
+
+      if (_hint)
+        {
+          hint_set = this;
+          hint_interval = i;
+        }
+
+      return i;
+    }
+
+    inline unsigned int DiscreteSetBase::get_nearest(double x) const
+    {
+      unsigned int n = _data.size();
+      unsigned int i = get_interval(x);
+
+      if (i == 0)
+        return 0;
+
+      if (i >= n)
+        return n - 1;
+
+      return x + x >= _data[i - 1].x + _data[i].x ? i : i - 1;
     }
 
     void DiscreteSetBase::add_data(double x, double y, double d)
@@ -86,6 +175,7 @@ namespace _Goptical
       const struct entry_s e = { x, y, d };
 
       _version++;
+      _index.clear();
 
       unsigned int di = get_interval(x);
 
@@ -100,6 +190,7 @@ namespace _Goptical
     void DiscreteSetBase::clear()
     {
       _data.clear();
+      _index.clear();
       _version++;
       invalidate();
     }
@@ -37,7 +37,7 @@ namespace _Goptical {
         _d_data(),
         _poly(),
         _update(&Grid::update_linear),
-        _lookup(&Grid::update_linear),
+        _lookup(&Grid::lookup_interval),
         _resize(&Grid::resize_y),
         _origin(origin),
         _step(step)
@@ -53,12 +53,14 @@ namespace _Goptical {
 
     void Grid::set_all_y(double y)
     {
+      invalidate();
       GOPTICAL_FOREACH(i, _y_data)
         *i = y;
     }
 
     void Grid::set_all_d(const Math::Vector2 & deriv)
     {
+      invalidate();
       GOPTICAL_FOREACH(i, _d_data)
         *i = deriv;
     }
@@ -144,7 +146,15 @@ namespace _Goptical {
         }
 
       _interpolation = i;
-      _lookup = _update;
+      invalidate();
+    }
+
+    void Grid::update_tables() const
+    {
+      unsigned int x[2];
+
+      // update function computes tables and selects lookup function
+      (this->*_update)(x, get_x_value_i(0, 0));
     }
 
     // **********************************************************************
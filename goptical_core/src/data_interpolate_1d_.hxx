@@ -31,7 +31,7 @@ namespace _Goptical {
     template <class X>
     Interpolate1d<X>::Interpolate1d()
       : _update(&Interpolate1d::update_linear),
-        _interpolate(_update),
+        _interpolate(&Interpolate1d::interpolate_linear),
         _poly()
     {
     }
@@ -278,7 +278,7 @@ namespace _Goptical {
         }
 
       X::_interpolation = i;
-      _interpolate = _update;
+      invalidate();
     }
 
     template <class X>
@@ -699,10 +699,22 @@ namespace _Goptical {
       return interpolate_cubic(d, x);
     }
 
+    template <class X>
+    void Interpolate1d<X>::update_tables() const
+    {
+      if (X::get_count() == 0)
+        throw Error("data set contains no data");
+
+      // build data set lookup index, then update function computes
+      // tables and selects interpolation function
+      X::update_index();
+      (this->*_update)(0, X::get_x_value(0));
+    }
+
     template <class X>
     void Interpolate1d<X>::invalidate()
     {
-      _interpolate = _update;
+      X::invalidate_tables();
     }
 
   }
@@ -25,6 +25,8 @@
 #include <limits>
 #include <iostream>
 
+#include <sched.h>
+
 #include <Goptical/Error>
 #include <Goptical/Data/Set>
 
@@ -35,7 +37,8 @@ namespace _Goptical
   {
 
     Set::Set()
-      : _version(0)
+      : _version(0),
+        _tables_state(TablesDirty)
     {
     }
 
@@ -43,6 +46,52 @@ namespace _Goptical
     {
     }
 
+    void Set::prepare() const
+    {
+      if (is_prepared())
+        return;
+
+      for (unsigned int i = 0; i < get_dimensions(); i++)
+        if (get_count(i) == 0)
+          return;
+
+      prepare_tables();
+    }
+
+    void Set::prepare_tables() const
+    {
+      while (1)
+        {
+          if (__sync_bool_compare_and_swap(&_tables_state, TablesDirty, TablesBuilding))
+            {
+              try {
+                update_tables();
+              } catch (...) {
+                __atomic_store_n(&_tables_state, TablesDirty, __ATOMIC_RELEASE);
+                throw;
+              }
+
+              // publish tables before the ready state
+              __atomic_store_n(&_tables_state, TablesReady, __ATOMIC_RELEASE);
+              return;
+            }
+
+          int state;
+
+          // an other thread is building tables, wait for completion
+          while ((state = __atomic_load_n(&_tables_state, __ATOMIC_ACQUIRE)) == TablesBuilding)
+            sched_yield();
+
+          // retry on failure so that error is reported to this caller too
+          if (state == TablesReady)
+            return;
+        }
+    }
+
+    void Set::update_tables() const
+    {
+    }
+
     Math::range_t Set::get_y_range() const
     {
       Math::range_t r(std::numeric_limits<double>::max(),
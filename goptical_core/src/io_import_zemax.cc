@@ -55,6 +55,8 @@
 
 #include <Goptical/Math/Transform>
 
+#include "io_zemax_agf_.hh"
+
 #include <string>
 #include <fstream>
 #include <cstdio>
@@ -694,312 +696,18 @@ namespace _Goptical {
     ref<Material::Catalog> ImportZemax::import_catalog(const std::string &filename,
                                                        const std::string &catname)
     {
-      std::ifstream file(filename.c_str());
-      std::string line;
-
-      if (!file)
-        throw Error("Unable to open file");
-
-      ref<Material::Catalog> cat = GOPTICAL_REFNEW(Material::Catalog, catname);
-
-      // FIXME check already loaded catalog
-
-      ref<Material::Dielectric> mat;
-
-      while (std::getline(file, line))
-        {
-          int formula;
-
-          if (line.size() < 2)
-            continue;
-
-          const char *buf = line.c_str();
-
-#define AGF_TYPE(a, b) ((a) + ((b) << 8))
-
-          int type = AGF_TYPE(buf[0], buf[1]);
-
-          switch(type)
-            {
-
-              ////////////////////////////////////////////////////
-              // New Material line
-
-            case (AGF_TYPE('N', 'M')): {
-              char name[32];
-
-              mat.invalidate();
-
-              if (sscanf(buf, "NM %s %u", name, &formula) != 2)
-                break;
-
-              switch (formula)
-                {
-                case (1):       // Schott
-                case (10):      // Extended
-                case (12):      // Extended 2
-                  mat = GOPTICAL_REFNEW(Material::Schott);
-                  break;
-
-                case (3):       // Herzberger
-                  mat = GOPTICAL_REFNEW(Material::Herzberger);
-                  break;
-
-                case (5):       // Conrady
-                  mat = GOPTICAL_REFNEW(Material::Conrady);
-                  break;
-
-                case (7):       // Hanbook 1
-                  mat = GOPTICAL_REFNEW(Material::Handbook1);
-                  break;
-
-                case (8):       // Hanbook 2
-                  mat = GOPTICAL_REFNEW(Material::Handbook2);
-                  break;
-
-                case (4):       // Sellmeier 2
-                  mat = GOPTICAL_REFNEW(Material::SellmeierMod2);
-                  break;
-
-                case (2):       // Sellmeier 1
-                case (6):       // Sellmeier 3
-                case (9):       // Sellmeier 4
-                case (11):      // Sellmeier 5
-                  mat = GOPTICAL_REFNEW(Material::Sellmeier);
-                  break;
-                }
-
-              if (mat.valid())
-                {
-                  mat->set_measurement_medium(Material::air);
-                  cat->add_material(name, *mat);
-                }
-
-              break;
-            }
-
-              ////////////////////////////////////////////////////
-              // Coefficient Data line
-
-            case (AGF_TYPE('C', 'D')): {
-              double c0, c1, c2, c3, c4, c5, c6, c7, c8, c9;
-
-              if (!mat.valid())
-                break;
-
-              if (sscanf(buf, "CD %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf",
-                         &c0, &c1, &c2, &c3, &c4, &c5, &c6, &c7, &c8, &c9) < 3)
-                break;
-
-              switch (formula)
-                {
-                case (1): {     // Schott
-                  Material::Schott &m = static_cast<Material::Schott &>(*mat);
-
-                  m.set_terms_range(-8, 2);
-                  m.set_term(0, c0);
-                  m.set_term(2, c1);
-                  m.set_term(-2, c2);
-                  m.set_term(-4, c3);
-                  m.set_term(-6, c4);
-                  m.set_term(-8, c5);
-                  break;
-                }
-
-                case (2): {     // Sellmeier 1
-                  Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
-
-                  m.set_terms_count(3);
-                  m.set_term(0, c0, c1);
-                  m.set_term(1, c2, c3);
-                  m.set_term(2, c4, c5);
-                  m.set_contant_term(1.0);
-                  break;
-                }
-
-                case (3): {     // Herzberger
-                  Material::Herzberger &m = static_cast<Material::Herzberger &>(*mat);
-
-                  m.set_coefficients(c0, c3, c4, c5, c1, c2);
-                  break;
-                }
+      ref<Material::Catalog> cat = agf_shared_catalog(filename, catname, _cache_path);
 
-                case (4): {     // Sellmeier 2
-                  Material::SellmeierMod2 &m = static_cast<Material::SellmeierMod2 &>(*mat);
-                  m.set_coefficients(c0, c1, c2, c3, c4);
-                  break;
-                }
-
-                case (5): {     // Conrady
-                  Material::Conrady &m = static_cast<Material::Conrady &>(*mat);
-
-                  m.set_coefficients(c0, c1, c2);
-                  break;
-                }
-                case (6): {     // Sellmeier 3
-                  Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
-
-                  m.set_terms_count(4);
-                  m.set_term(0, c0, c1);
-                  m.set_term(1, c2, c3);
-                  m.set_term(2, c4, c5);
-                  m.set_term(3, c6, c7);
-                  m.set_contant_term(1.0);
-                  break;
-                }
-
-                case (7): {     // Hanbook 1
-                  Material::Handbook1 &m = static_cast<Material::Handbook1 &>(*mat);
-                  m.set_coefficients(c0, -c3, c1, c2);
-                  break;
-                }
-                case (8): {     // Hanbook 2
-                  Material::Handbook2 &m = static_cast<Material::Handbook2 &>(*mat);
-                  m.set_coefficients(c0, -c3, c1, c2);
-                  break;
-                }
-
-                case (9): {     // Sellmeier 4
-                  Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
-
-                  m.set_terms_count(2);
-                  m.set_term(0, c1, c2);
-                  m.set_term(1, c3, c4);
-                  m.set_contant_term(c0);
-                  break;
-                }
-
-                case (10): {    // Extended
-                  Material::Schott &m = static_cast<Material::Schott &>(*mat);
-
-                  m.set_terms_range(-12, 2);
-                  m.set_term(0, c0);
-                  m.set_term(2, c1);
-                  m.set_term(-2, c2);
-                  m.set_term(-4, c3);
-                  m.set_term(-6, c4);
-                  m.set_term(-8, c5);
-                  m.set_term(-10, c6);
-                  m.set_term(-12, c7);
-                  break;
-                }
-
-                case (11): {    // Sellmeier 5
-                  Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
-
-                  m.set_terms_count(5);
-                  m.set_term(0, c0, c1);
-                  m.set_term(1, c2, c3);
-                  m.set_term(2, c4, c5);
-                  m.set_term(3, c6, c7);
-                  m.set_term(4, c8, c9);
-                  m.set_contant_term(1.0);
-                  break;
-                }
-
-                case (12): {    // Extended 2
-                  Material::Schott &m = static_cast<Material::Schott &>(*mat);
-
-                  m.set_terms_range(-8, 6);
-                  m.set_term(0, c0);
-                  m.set_term(2, c1);
-                  m.set_term(-2, c2);
-                  m.set_term(-4, c3);
-                  m.set_term(-6, c4);
-                  m.set_term(-8, c5);
-                  m.set_term(4, c6);
-                  m.set_term(6, c7);
-                  break;
-                }
-
-                }
-
-              break;
-            }
-
-              ////////////////////////////////////////////////////
-              // Thermal Data line
-
-            case (AGF_TYPE('T', 'D')): {
-              double d0, d1, d2, e0, e1, ltk, reftemp;
-
-              if (!mat.valid())
-                break;
-
-              if (sscanf(buf, "TD %lf %lf %lf %lf %lf %lf %lf",
-                         &d0, &d1, &d2, &e0, &e1, &ltk, &reftemp) != 7)
-                break;
-
-              mat->set_temperature_schott(d0, d1, d2, e0, e1, ltk * 1000.);
-
-              // Zemax glasses are measured in air medium
-              ref<Material::AirKohlrausch68> air =
-                ref<Material::AirKohlrausch68>::create();
-
-              air->set_temperature(reftemp);
-              mat->set_measurement_medium(*air);
-
-              break;
-            }
-
-              ////////////////////////////////////////////////////
-              // Internal Transmition line
-
-            case (AGF_TYPE('I', 'T')): {
-              double wl, it, th;
-
-              if (!mat.valid())
-                break;
-
-              if (sscanf(buf, "IT %lf %lf %lf", &wl, &it, &th) != 3)
-                break;
-
-              mat->set_internal_transmittance(wl * 1000.0, th, it);
-              break;
-            }
-
-              ////////////////////////////////////////////////////
-              // Extra Data line
-
-            case (AGF_TYPE('E', 'D')): {
-              double tce, density;
-
-              if (!mat.valid())
-                break;
-
-              if (sscanf(buf, "ED %lf %*f %lf", &tce, &density) != 2)
-                break;
-
-              mat->set_thermal_expansion(tce * 1e-6);
-              mat->set_density(density);
-              break;
-            }
-
-              ////////////////////////////////////////////////////
-              // Limit Data line
-
-            case (AGF_TYPE('L', 'D')): {
-              double low, high;
-
-              if (!mat.valid())
-                break;
-
-              if (sscanf(buf, "LD %lf %lf", &low, &high) != 2)
-                break;
-
-              mat->set_wavelen_range(low * 1000.0, high * 1000.0);
-              break;
-            }
-
-            }
-
-        }
-
-      _cat_list.insert(cat_map_t::value_type(catname, cat));
+      _cat_list[catname] = cat;
 
       return cat;
     }
 
+    void ImportZemax::clear_shared_catalogs()
+    {
+      agf_clear_shared_catalogs();
+    }
+
     ref<Material::Catalog> ImportZemax::get_catalog(const std::string &catalogname)
     {
       cat_map_t::iterator i = _cat_list.find(catalogname);
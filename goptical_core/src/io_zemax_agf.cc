@@ -0,0 +1,785 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <Goptical/Error>
+
+#include <Goptical/Material/Dielectric>
+#include <Goptical/Material/Sellmeier>
+#include <Goptical/Material/SellmeierMod>
+#include <Goptical/Material/Conrady>
+#include <Goptical/Material/Herzberger>
+#include <Goptical/Material/Schott>
+#include <Goptical/Material/Air>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "io_zemax_agf_.hh"
+
+namespace _Goptical {
+
+  namespace Io {
+
+    /** binary cache file header */
+    struct agf_cache_header_s
+    {
+      char              magic[8];
+      uint32_t          version;
+      uint32_t          endian;
+      uint32_t          glass_size;     // sizeof(agf_glass_s)
+      uint32_t          glass_count;
+      uint32_t          it_count;
+      uint32_t          reserved;
+      uint64_t          src_size;
+      int64_t           src_mtime;
+      uint64_t          src_hash;
+    };
+
+    static const char agf_cache_magic[8] = "GOPTAGF";
+    static const uint32_t agf_cache_version = 1;
+    static const uint32_t agf_cache_endian = 0x01020304;
+
+    /** 64 bits FNV-1a hash */
+    static uint64_t agf_hash(const char *data, size_t size)
+    {
+      uint64_t h = 14695981039346656037ULL;
+
+      for (size_t i = 0; i < size; i++)
+        {
+          h ^= (unsigned char)data[i];
+          h *= 1099511628211ULL;
+        }
+
+      return h;
+    }
+
+    static bool agf_glass_less(const agf_glass_s &a, const agf_glass_s &b)
+    {
+      return strcmp(a.name, b.name) < 0;
+    }
+
+    static bool agf_glass_name_less(const agf_glass_s &a, const char *name)
+    {
+      return strcmp(a.name, name) < 0;
+    }
+
+    agf_catalog_s::agf_catalog_s()
+      : _glass_list(),
+        _it_list(),
+        _glass(0),
+        _it(0),
+        _glass_count(0),
+        _it_count(0),
+        _map(0),
+        _map_size(0)
+    {
+    }
+
+    agf_catalog_s::~agf_catalog_s()
+    {
+      unmap_cache();
+    }
+
+    void agf_catalog_s::load(const std::string &filename, const std::string &cache_path)
+    {
+      int fd = open(filename.c_str(), O_RDONLY);
+      struct stat st;
+
+      if (fd < 0)
+        throw Error("Unable to open file");
+
+      if (fstat(fd, &st))
+        {
+          close(fd);
+          throw Error("Unable to open file");
+        }
+
+      std::string cache_file;
+      int64_t mtime = 0;
+      uint64_t hash = 0;
+
+      if (!cache_path.empty())
+        {
+          // cache file name depends on AGF file path
+          std::string name(filename);
+          size_t n = name.rfind(PATH_SEPARATOR);
+
+          if (n != std::string::npos)
+            name.erase(0, n + 1);
+
+          char suffix[32];
+          sprintf(suffix, "-%016llx.gcat", (unsigned long long)
+                  agf_hash(filename.data(), filename.size()));
+
+          cache_file = cache_path + PATH_SEPARATOR + name + suffix;
+
+          if (map_cache(cache_file, st.st_size, mtime, hash) &&
+              mtime == (int64_t)st.st_mtime)
+            {
+              close(fd);
+              return;
+            }
+        }
+
+      std::vector<char> data(st.st_size);
+      size_t done = 0;
+
+      while (done < data.size())
+        {
+          ssize_t r = read(fd, &data[done], data.size() - done);
+
+          if (r <= 0)
+            {
+              close(fd);
+              unmap_cache();
+              throw Error("Unable to read file");
+            }
+
+          done += r;
+        }
+
+      close(fd);
+
+      uint64_t data_hash = agf_hash(data.empty() ? 0 : &data[0], data.size());
+
+      // file touched but contents unchanged, update cache mtime
+      if (_map && hash == data_hash)
+        {
+          write_cache(cache_file, st.st_size, st.st_mtime, data_hash);
+          return;
+        }
+
+      unmap_cache();
+      parse(data.empty() ? 0 : &data[0], data.size());
+
+      if (!cache_file.empty())
+        write_cache(cache_file, st.st_size, st.st_mtime, data_hash);
+    }
+
+    void agf_catalog_s::parse(const char *data, size_t size)
+    {
+      const char *end = data + size;
+      std::string line;
+      agf_glass_s *g = 0;
+
+      _glass_list.clear();
+      _it_list.clear();
+
+      while (data < end)
+        {
+          const char *eol = (const char *)memchr(data, '\n', end - data);
+
+          if (!eol)
+            eol = end;
+
+          line.assign(data, eol);
+          data = eol + 1;
+
+          if (line.size() < 2)
+            continue;
+
+          const char *buf = line.c_str();
+
+#define AGF_TYPE(a, b) ((a) + ((b) << 8))
+
+          int type = AGF_TYPE(buf[0], buf[1]);
+
+          switch (type)
+            {
+
+              ////////////////////////////////////////////////////
+              // New Material line
+
+            case (AGF_TYPE('N', 'M')): {
+              agf_glass_s n;
+              unsigned int formula;
+
+              g = 0;
+
+              memset(&n, 0, sizeof(n));
+
+              if (sscanf(buf, "NM %31s %u", n.name, &formula) != 2)
+                break;
+
+              // unsupported formula
+              if (formula < 1 || formula > 12)
+                break;
+
+              n.formula = formula;
+              n.it_first = _it_list.size();
+              _glass_list.push_back(n);
+              g = &_glass_list.back();
+              break;
+            }
+
+              ////////////////////////////////////////////////////
+              // Coefficient Data line
+
+            case (AGF_TYPE('C', 'D')): {
+              double c[10] = { 0 };
+
+              if (!g)
+                break;
+
+              if (sscanf(buf, "CD %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf",
+                         c + 0, c + 1, c + 2, c + 3, c + 4,
+                         c + 5, c + 6, c + 7, c + 8, c + 9) < 3)
+                break;
+
+              memcpy(g->cd, c, sizeof(c));
+              g->flags |= AGF_DATA_CD;
+              break;
+            }
+
+              ////////////////////////////////////////////////////
+              // Thermal Data line
+
+            case (AGF_TYPE('T', 'D')): {
+              double *d = g ? g->td : 0;
+
+              if (!g)
+                break;
+
+              if (sscanf(buf, "TD %lf %lf %lf %lf %lf %lf %lf",
+                         d + 0, d + 1, d + 2, d + 3, d + 4, d + 5, d + 6) != 7)
+                break;
+
+              g->flags |= AGF_DATA_TD;
+              break;
+            }
+
+              ////////////////////////////////////////////////////
+              // Internal Transmition line
+
+            case (AGF_TYPE('I', 'T')): {
+              agf_it_s it;
+
+              if (!g)
+                break;
+
+              if (sscanf(buf, "IT %lf %lf %lf", &it.wavelen,
+                         &it.transmittance, &it.thickness) != 3)
+                break;
+
+              _it_list.push_back(it);
+              g->it_count++;
+              break;
+            }
+
+              ////////////////////////////////////////////////////
+              // Extra Data line
+
+            case (AGF_TYPE('E', 'D')): {
+              double tce, density;
+
+              if (!g)
+                break;
+
+              if (sscanf(buf, "ED %lf %*f %lf", &tce, &density) != 2)
+                break;
+
+              g->ed[0] = tce;
+              g->ed[1] = density;
+              g->flags |= AGF_DATA_ED;
+              break;
+            }
+
+              ////////////////////////////////////////////////////
+              // Limit Data line
+
+            case (AGF_TYPE('L', 'D')): {
+              double low, high;
+
+              if (!g)
+                break;
+
+              if (sscanf(buf, "LD %lf %lf", &low, &high) != 2)
+                break;
+
+              g->ld[0] = low;
+              g->ld[1] = high;
+              g->flags |= AGF_DATA_LD;
+              break;
+            }
+
+            }
+
+#undef AGF_TYPE
+        }
+
+      // keep file order of glasses with the same name
+      std::stable_sort(_glass_list.begin(), _glass_list.end(), agf_glass_less);
+
+      _glass = _glass_list.empty() ? 0 : &_glass_list[0];
+      _it = _it_list.empty() ? 0 : &_it_list[0];
+      _glass_count = _glass_list.size();
+      _it_count = _it_list.size();
+    }
+
+    const agf_glass_s * agf_catalog_s::find_glass(const std::string &name) const
+    {
+      const agf_glass_s *end = _glass + _glass_count;
+      const agf_glass_s *g = std::lower_bound(_glass, end, name.c_str(),
+                                              agf_glass_name_less);
+
+      if (g == end || name != g->name)
+        return 0;
+
+      return g;
+    }
+
+    bool agf_catalog_s::map_cache(const std::string &cache_file, uint64_t size,
+                                  int64_t &mtime, uint64_t &hash)
+    {
+      int fd = open(cache_file.c_str(), O_RDONLY);
+      struct stat st;
+
+      if (fd < 0)
+        return false;
+
+      if (fstat(fd, &st) || (size_t)st.st_size < sizeof(agf_cache_header_s))
+        {
+          close(fd);
+          return false;
+        }
+
+      void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      close(fd);
+
+      if (map == MAP_FAILED)
+        return false;
+
+      _map = map;
+      _map_size = st.st_size;
+
+      const agf_cache_header_s *h = (const agf_cache_header_s *)map;
+
+      if (memcmp(h->magic, agf_cache_magic, sizeof(h->magic)) ||
+          h->version != agf_cache_version ||
+          h->endian != agf_cache_endian ||
+          h->glass_size != sizeof(agf_glass_s) ||
+          h->src_size != size ||
+          _map_size != sizeof(agf_cache_header_s)
+                     + (size_t)h->glass_count * sizeof(agf_glass_s)
+                     + (size_t)h->it_count * sizeof(agf_it_s))
+        {
+          unmap_cache();
+          return false;
+        }
+
+      const agf_glass_s *glass = (const agf_glass_s *)(h + 1);
+
+      for (unsigned int i = 0; i < h->glass_count; i++)
+        {
+          const agf_glass_s &g = glass[i];
+
+          if (g.name[sizeof(g.name) - 1] || g.formula < 1 || g.formula > 12 ||
+              g.it_first > h->it_count || g.it_count > h->it_count - g.it_first)
+            {
+              unmap_cache();
+              return false;
+            }
+        }
+
+      _glass = glass;
+      _glass_count = h->glass_count;
+      _it = (const agf_it_s *)(glass + h->glass_count);
+      _it_count = h->it_count;
+      mtime = h->src_mtime;
+      hash = h->src_hash;
+
+      return true;
+    }
+
+    void agf_catalog_s::unmap_cache()
+    {
+      if (!_map)
+        return;
+
+      munmap(_map, _map_size);
+
+      _map = 0;
+      _map_size = 0;
+      _glass = 0;
+      _it = 0;
+      _glass_count = 0;
+      _it_count = 0;
+    }
+
+    void agf_catalog_s::write_cache(const std::string &cache_file, uint64_t size,
+                                    int64_t mtime, uint64_t hash) const
+    {
+      agf_cache_header_s h;
+
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, agf_cache_magic, sizeof(h.magic));
+      h.version = agf_cache_version;
+      h.endian = agf_cache_endian;
+      h.glass_size = sizeof(agf_glass_s);
+      h.glass_count = _glass_count;
+      h.it_count = _it_count;
+      h.src_size = size;
+      h.src_mtime = mtime;
+      h.src_hash = hash;
+
+      // write to temporary file and rename so that concurrent
+      // processes never map a partial cache file
+      char suffix[32];
+      sprintf(suffix, ".%u.tmp", (unsigned int)getpid());
+      std::string tmp_file(cache_file + suffix);
+
+      FILE *f = fopen(tmp_file.c_str(), "wb");
+
+      // cache is optional, ignore errors
+      if (!f)
+        return;
+
+      bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+        fwrite(_glass, sizeof(agf_glass_s), _glass_count, f) == _glass_count &&
+        fwrite(_it, sizeof(agf_it_s), _it_count, f) == _it_count;
+
+      if (fclose(f) || !ok || rename(tmp_file.c_str(), cache_file.c_str()))
+        unlink(tmp_file.c_str());
+    }
+
+    ref<Material::Dielectric> agf_catalog_s::create_material(const agf_glass_s &g) const
+    {
+      ref<Material::Dielectric> mat;
+
+      switch (g.formula)
+        {
+        case (1):       // Schott
+        case (10):      // Extended
+        case (12):      // Extended 2
+          mat = GOPTICAL_REFNEW(Material::Schott);
+          break;
+
+        case (3):       // Herzberger
+          mat = GOPTICAL_REFNEW(Material::Herzberger);
+          break;
+
+        case (5):       // Conrady
+          mat = GOPTICAL_REFNEW(Material::Conrady);
+          break;
+
+        case (7):       // Hanbook 1
+          mat = GOPTICAL_REFNEW(Material::Handbook1);
+          break;
+
+        case (8):       // Hanbook 2
+          mat = GOPTICAL_REFNEW(Material::Handbook2);
+          break;
+
+        case (4):       // Sellmeier 2
+          mat = GOPTICAL_REFNEW(Material::SellmeierMod2);
+          break;
+
+        case (2):       // Sellmeier 1
+        case (6):       // Sellmeier 3
+        case (9):       // Sellmeier 4
+        case (11):      // Sellmeier 5
+          mat = GOPTICAL_REFNEW(Material::Sellmeier);
+          break;
+
+        default:
+          return mat;
+        }
+
+      mat->set_measurement_medium(Material::air);
+
+      if (g.flags & AGF_DATA_CD)
+        {
+          const double *c = g.cd;
+
+          switch (g.formula)
+            {
+            case (1): {     // Schott
+              Material::Schott &m = static_cast<Material::Schott &>(*mat);
+
+              m.set_terms_range(-8, 2);
+              m.set_term(0, c[0]);
+              m.set_term(2, c[1]);
+              m.set_term(-2, c[2]);
+              m.set_term(-4, c[3]);
+              m.set_term(-6, c[4]);
+              m.set_term(-8, c[5]);
+              break;
+            }
+
+            case (2): {     // Sellmeier 1
+              Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
+
+              m.set_terms_count(3);
+              m.set_term(0, c[0], c[1]);
+              m.set_term(1, c[2], c[3]);
+              m.set_term(2, c[4], c[5]);
+              m.set_contant_term(1.0);
+              break;
+            }
+
+            case (3): {     // Herzberger
+              Material::Herzberger &m = static_cast<Material::Herzberger &>(*mat);
+
+              m.set_coefficients(c[0], c[3], c[4], c[5], c[1], c[2]);
+              break;
+            }
+
+            case (4): {     // Sellmeier 2
+              Material::SellmeierMod2 &m = static_cast<Material::SellmeierMod2 &>(*mat);
+              m.set_coefficients(c[0], c[1], c[2], c[3], c[4]);
+              break;
+            }
+
+            case (5): {     // Conrady
+              Material::Conrady &m = static_cast<Material::Conrady &>(*mat);
+
+              m.set_coefficients(c[0], c[1], c[2]);
+              break;
+            }
+            case (6): {     // Sellmeier 3
+              Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
+
+              m.set_terms_count(4);
+              m.set_term(0, c[0], c[1]);
+              m.set_term(1, c[2], c[3]);
+              m.set_term(2, c[4], c[5]);
+              m.set_term(3, c[6], c[7]);
+              m.set_contant_term(1.0);
+              break;
+            }
+
+            case (7): {     // Hanbook 1
+              Material::Handbook1 &m = static_cast<Material::Handbook1 &>(*mat);
+              m.set_coefficients(c[0], -c[3], c[1], c[2]);
+              break;
+            }
+            case (8): {     // Hanbook 2
+              Material::Handbook2 &m = static_cast<Material::Handbook2 &>(*mat);
+              m.set_coefficients(c[0], -c[3], c[1], c[2]);
+              break;
+            }
+
+            case (9): {     // Sellmeier 4
+              Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
+
+              m.set_terms_count(2);
+              m.set_term(0, c[1], c[2]);
+              m.set_term(1, c[3], c[4]);
+              m.set_contant_term(c[0]);
+              break;
+            }
+
+            case (10): {    // Extended
+              Material::Schott &m = static_cast<Material::Schott &>(*mat);
+
+              m.set_terms_range(-12, 2);
+              m.set_term(0, c[0]);
+              m.set_term(2, c[1]);
+              m.set_term(-2, c[2]);
+              m.set_term(-4, c[3]);
+              m.set_term(-6, c[4]);
+              m.set_term(-8, c[5]);
+              m.set_term(-10, c[6]);
+              m.set_term(-12, c[7]);
+              break;
+            }
+
+            case (11): {    // Sellmeier 5
+              Material::Sellmeier &m = static_cast<Material::Sellmeier &>(*mat);
+
+              m.set_terms_count(5);
+              m.set_term(0, c[0], c[1]);
+              m.set_term(1, c[2], c[3]);
+              m.set_term(2, c[4], c[5]);
+              m.set_term(3, c[6], c[7]);
+              m.set_term(4, c[8], c[9]);
+              m.set_contant_term(1.0);
+              break;
+            }
+
+            case (12): {    // Extended 2
+              Material::Schott &m = static_cast<Material::Schott &>(*mat);
+
+              m.set_terms_range(-8, 6);
+              m.set_term(0, c[0]);
+              m.set_term(2, c[1]);
+              m.set_term(-2, c[2]);
+              m.set_term(-4, c[3]);
+              m.set_term(-6, c[4]);
+              m.set_term(-8, c[5]);
+              m.set_term(4, c[6]);
+              m.set_term(6, c[7]);
+              break;
+            }
+
+            }
+        }
+
+      if (g.flags & AGF_DATA_TD)
+        {
+          const double *d = g.td;
+
+          mat->set_temperature_schott(d[0], d[1], d[2], d[3], d[4], d[5] * 1000.);
+
+          // Zemax glasses are measured in air medium
+          ref<Material::AirKohlrausch68> air =
+            ref<Material::AirKohlrausch68>::create();
+
+          air->set_temperature(d[6]);
+          mat->set_measurement_medium(*air);
+        }
+
+      for (unsigned int i = 0; i < g.it_count; i++)
+        {
+          const agf_it_s &it = _it[g.it_first + i];
+
+          mat->set_internal_transmittance(it.wavelen * 1000.0, it.thickness,
+                                          it.transmittance);
+        }
+
+      if (g.flags & AGF_DATA_ED)
+        {
+          mat->set_thermal_expansion(g.ed[0] * 1e-6);
+          mat->set_density(g.ed[1]);
+        }
+
+      if (g.flags & AGF_DATA_LD)
+        mat->set_wavelen_range(g.ld[0] * 1000.0, g.ld[1] * 1000.0);
+
+      return mat;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // Lazy catalog and shared registry
+    ////////////////////////////////////////////////////////////////////////
+
+    agf_material_catalog_s::agf_material_catalog_s(const std::string &name,
+                                                   const const_ref<agf_catalog_s> &agf)
+      : Catalog(name),
+        _agf(agf)
+    {
+    }
+
+    const_ref<Material::Base> agf_material_catalog_s::create_material(const std::string &material_name) const
+    {
+      const agf_glass_s *g = _agf->find_glass(material_name);
+
+      if (!g)
+        return const_ref<Material::Base>();
+
+      return _agf->create_material(*g);
+    }
+
+    void agf_material_catalog_s::get_lazy_material_names(std::vector<std::string> &names) const
+    {
+      for (unsigned int i = 0; i < _agf->get_glass_count(); i++)
+        names.push_back(_agf->get_glass(i).name);
+    }
+
+    struct agf_registry_entry_s
+    {
+      ref<Material::Catalog>    _cat;
+      off_t                     _size;
+      time_t                    _mtime;
+    };
+
+    typedef std::map<std::pair<std::string, std::string>,
+                     agf_registry_entry_s> agf_registry_t;
+
+    static pthread_mutex_t agf_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    static agf_registry_t & agf_registry()
+    {
+      static agf_registry_t r;
+      return r;
+    }
+
+    ref<Material::Catalog> agf_shared_catalog(const std::string &filename,
+                                              const std::string &catname,
+                                              const std::string &cache_path)
+    {
+      struct stat st;
+
+      if (stat(filename.c_str(), &st))
+        throw Error("Unable to open file");
+
+      // same file may be designated by different paths
+      std::string path(filename);
+      char *rpath = realpath(filename.c_str(), 0);
+
+      if (rpath)
+        {
+          path = rpath;
+          free(rpath);
+        }
+
+      pthread_mutex_lock(&agf_registry_lock);
+
+      agf_registry_entry_s &e = agf_registry()[std::make_pair(path, catname)];
+
+      if (!e._cat.valid() || e._size != st.st_size || e._mtime != st.st_mtime)
+        {
+          try {
+            ref<agf_catalog_s> agf = GOPTICAL_REFNEW(agf_catalog_s);
+
+            agf->load(filename, cache_path);
+            e._cat = GOPTICAL_REFNEW(agf_material_catalog_s, catname, agf);
+            e._size = st.st_size;
+            e._mtime = st.st_mtime;
+          } catch (...) {
+            pthread_mutex_unlock(&agf_registry_lock);
+            throw;
+          }
+        }
+
+      ref<Material::Catalog> cat = e._cat;
+
+      pthread_mutex_unlock(&agf_registry_lock);
+
+      return cat;
+    }
+
+    void agf_clear_shared_catalogs()
+    {
+      pthread_mutex_lock(&agf_registry_lock);
+      agf_registry().clear();
+      pthread_mutex_unlock(&agf_registry_lock);
+    }
+
+  }
+
+}
+
@@ -0,0 +1,172 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_IO_ZEMAX_AGF_HH_
+#define GOPTICAL_IO_ZEMAX_AGF_HH_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "Goptical/common.hh"
+
+#include "Goptical/Material/catalog.hh"
+
+namespace _Goptical {
+
+  namespace Io {
+
+    /** @internal AGF glass data lines present in record */
+    enum agf_data_e
+      {
+        AGF_DATA_CD = 1,        //< coefficient data
+        AGF_DATA_TD = 2,        //< thermal data
+        AGF_DATA_ED = 4,        //< extra data
+        AGF_DATA_LD = 8,        //< wavelen limit data
+      };
+
+    /** @internal Flat glass record, as stored in binary catalog cache */
+    struct agf_glass_s
+    {
+      char              name[32];
+      int32_t           formula;
+      uint32_t          flags;          // agf_data_e mask
+      double            cd[10];
+      double            td[7];
+      double            ed[2];
+      double            ld[2];
+      uint32_t          it_first;       // first internal transmittance entry
+      uint32_t          it_count;
+    };
+
+    /** @internal Internal transmittance record */
+    struct agf_it_s
+    {
+      double            wavelen;        // micrometer
+      double            transmittance;
+      double            thickness;      // mm
+    };
+
+    /**
+       @internal
+       @short Zemax ascii glass catalog data
+
+       Glass records are parsed from an AGF file or taken from a
+       memory mapped binary cache file. A cache file is valid when
+       size and modification time of the AGF file match, or when
+       contents hash match. Records are sorted by glass name.
+     */
+    class agf_catalog_s : public ref_base<agf_catalog_s>
+    {
+    public:
+      agf_catalog_s();
+      ~agf_catalog_s();
+
+      /** Load AGF file. Use or write binary cache file in given
+          directory if not empty. */
+      void load(const std::string &filename, const std::string &cache_path);
+
+      /** Get number of glass records */
+      inline unsigned int get_glass_count() const;
+
+      /** Get glass record */
+      inline const agf_glass_s & get_glass(unsigned int i) const;
+
+      /** Find glass record by name, return 0 if not found */
+      const agf_glass_s * find_glass(const std::string &name) const;
+
+      /** Create material object from glass record, invalid ref if
+          glass formula is not supported */
+      ref<Material::Dielectric> create_material(const agf_glass_s &g) const;
+
+    private:
+      agf_catalog_s(const agf_catalog_s &);
+      agf_catalog_s & operator=(const agf_catalog_s &);
+
+      void parse(const char *data, size_t size);
+      bool map_cache(const std::string &cache_file, uint64_t size,
+                     int64_t &mtime, uint64_t &hash);
+      void unmap_cache();
+      void write_cache(const std::string &cache_file, uint64_t size,
+                       int64_t mtime, uint64_t hash) const;
+
+      std::vector<agf_glass_s>  _glass_list;
+      std::vector<agf_it_s>     _it_list;
+
+      const agf_glass_s *       _glass;
+      const agf_it_s *          _it;
+      unsigned int              _glass_count;
+      unsigned int              _it_count;
+
+      void *                    _map;
+      size_t                    _map_size;
+    };
+
+    /**
+       @internal
+       @short Zemax glass catalog with lazy material instantiation
+
+       Material objects are created from AGF glass records on first
+       lookup.
+     */
+    class agf_material_catalog_s : public Material::Catalog
+    {
+    public:
+      agf_material_catalog_s(const std::string &name,
+                             const const_ref<agf_catalog_s> &agf);
+
+    private:
+      const_ref<Material::Base> create_material(const std::string &material_name) const;
+      void get_lazy_material_names(std::vector<std::string> &names) const;
+
+      const_ref<agf_catalog_s> _agf;
+    };
+
+    /** @internal Get glass catalog from process wide registry. AGF
+        file is loaded on first request and when the file has been
+        modified since last load. */
+    ref<Material::Catalog> agf_shared_catalog(const std::string &filename,
+                                              const std::string &catname,
+                                              const std::string &cache_path);
+
+    /** @internal Drop all catalogs from process wide registry */
+    void agf_clear_shared_catalogs();
+
+    unsigned int agf_catalog_s::get_glass_count() const
+    {
+      return _glass_count;
+    }
+
+    const agf_glass_s & agf_catalog_s::get_glass(unsigned int i) const
+    {
+      return _glass[i];
+    }
+
+  }
+
+}
+
+#endif
+
@@ -63,13 +63,19 @@ namespace _Goptical {
 
     template <enum AirFormula m>
     double Air<m>::get_refractive_index(double wavelen) const
+    {
+      return get_thermal_refractive_index(wavelen, _temperature);
+    }
+
+    template <enum AirFormula m>
+    double Air<m>::get_thermal_refractive_index(double wavelen, double temperature) const
     {
       switch (m)
         {
         case AirBirch94Formula: {
           // Birch, Metrologia, 1994, 31, 315
 
-          // _temperature in celsius
+          // temperature in celsius
           // _pressure in pascal
 
           double s2 = Math::square(1 / (wavelen / 1000.0));
@@ -81,8 +87,8 @@ namespace _Goptical {
                );
 
           return 1.0 + (ref /*- 1.0*/)
-            * (_pressure * (1.0 + _pressure * (60.1 - 0.972 * _temperature) * 1e-10))
-            / (96095.43 * (1.0 + 0.003661 * _temperature));
+            * (_pressure * (1.0 + _pressure * (60.1 - 0.972 * temperature) * 1e-10))
+            / (96095.43 * (1.0 + 0.003661 * temperature));
         }
 
         case AirKohlrausch68Formula: {
@@ -95,7 +101,7 @@ namespace _Goptical {
                                + (25540.0 * w2) / (41.0 * w2 - 1.0)) * 1e-8;
 
           return 1.0 + ( ((nref - 1.0) * (_pressure / std_pressure))
-                         / (1.0 + (_temperature - 15.0) * 0.0034785));
+                         / (1.0 + (temperature - 15.0) * 0.0034785));
 
         }
         }
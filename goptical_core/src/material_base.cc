@@ -24,6 +24,7 @@
 
 #include <iostream>
 #include <Goptical/Material/Base>
+#include <Goptical/Error>
 #include <Goptical/Io/Rgb>
  
 namespace _Goptical {
@@ -88,12 +89,41 @@ namespace _Goptical {
       return (4.0 * n0 * n1) / Math::square(n0 + n1);
     }
 
+    double Base::get_thermal_refractive_index(double, double) const
+    {
+      throw Error("material has no refractive index temperature model");
+    }
+
+    double Base::get_thermal_normal_reflectance(const Base *from, double wavelen,
+                                                double temperature) const
+    {
+      // same as get_normal_reflectance with indexes at given temperature
+      double n0 = from->get_thermal_refractive_index(wavelen, temperature);
+      double k12 = Math::square(get_extinction_coef(wavelen));
+      double n1 = get_thermal_refractive_index(wavelen, temperature);
+
+      return (Math::square(n0 - n1) + k12) / (Math::square(n0 + n1) + k12);
+    }
+
+    double Base::get_thermal_normal_transmittance(const Base *from, double wavelen,
+                                                  double temperature) const
+    {
+      double n0 = from->get_thermal_refractive_index(wavelen, temperature);
+      double n1 = get_thermal_refractive_index(wavelen, temperature);
+
+      return (4.0 * n0 * n1) / Math::square(n0 + n1);
+    }
+
     Io::Rgb Base::get_color() const
     {
       // FIXME color depends on material properties
       return Io::Rgb(1, 1, 1, 1);
     }
 
+    void Base::prepare() const
+    {
+    }
+
     void Base::set_temperature(double temp)
     {
       _temperature = temp;
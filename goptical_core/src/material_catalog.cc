@@ -22,6 +22,8 @@
 
 */
 
+#include <algorithm>
+
 #include <Goptical/Material/Catalog>
 #include <Goptical/Material/Base>
 
@@ -33,17 +35,88 @@ namespace _Goptical {
       : _name(name),
         _list()
     {
+      pthread_mutex_init(&_lock, 0);
+    }
+
+    Catalog::~Catalog()
+    {
+      pthread_mutex_destroy(&_lock);
+    }
+
+    const_ref<Base> Catalog::get_material(const std::string &material_name)
+    {
+      pthread_mutex_lock(&_lock);
+
+      catalog_map_t::iterator i = _list.find(material_name);
+
+      if (i == _list.end())
+        {
+          const_ref<Base> m;
+
+          try {
+            m = create_material(material_name);
+          } catch (...) {
+            pthread_mutex_unlock(&_lock);
+            throw;
+          }
+
+          if (!m.valid())
+            {
+              pthread_mutex_unlock(&_lock);
+              throw Error("No such material in catalog");
+            }
+
+          i = _list.insert(catalog_map_t::value_type(material_name, m)).first;
+        }
+
+      // reference taken under lock, material may be removed concurrently
+      const_ref<Base> m = i->second;
+      pthread_mutex_unlock(&_lock);
+
+      return m;
     }
 
     void Catalog::add_material(const std::string &material_name, const const_ref<Base> &material)
     {
-      if (!_list.insert(catalog_map_t::value_type(material_name, material)).second)
+      pthread_mutex_lock(&_lock);
+      bool done = _list.insert(catalog_map_t::value_type(material_name, material)).second;
+      pthread_mutex_unlock(&_lock);
+
+      if (!done)
         throw Error("Material already present in catalog");
     }
 
     void Catalog::del_material(const std::string &material_name)
     {
+      pthread_mutex_lock(&_lock);
       _list.erase(material_name);
+      pthread_mutex_unlock(&_lock);
+    }
+
+    void Catalog::get_material_names(std::vector<std::string> &names) const
+    {
+      size_t first = names.size();
+
+      pthread_mutex_lock(&_lock);
+
+      GOPTICAL_FOREACH(i, _list)
+        names.push_back(i->first);
+
+      pthread_mutex_unlock(&_lock);
+
+      get_lazy_material_names(names);
+
+      std::sort(names.begin() + first, names.end());
+      names.erase(std::unique(names.begin() + first, names.end()), names.end());
+    }
+
+    const_ref<Base> Catalog::create_material(const std::string &) const
+    {
+      return const_ref<Base>();
+    }
+
+    void Catalog::get_lazy_material_names(std::vector<std::string> &) const
+    {
     }
 
   }
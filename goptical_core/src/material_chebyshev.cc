@@ -0,0 +1,182 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <cmath>
+
+#include <Goptical/Material/Chebyshev>
+#include <Goptical/Material/Dielectric>
+#include <Goptical/Io/Rgb>
+#include <Goptical/Error>
+
+namespace _Goptical {
+
+  namespace Material {
+
+    Chebyshev::Chebyshev(const const_ref<Dielectric> &m, double max_error)
+      : _m(m),
+        _max_error(max_error),
+        _fit_error(0.),
+        _fit_temperature(0.),
+        _low(0.),
+        _high(0.),
+        _scale(0.),
+        _segments(0),
+        _degree(0),
+        _coefs()
+    {
+      update();
+    }
+
+    void Chebyshev::update()
+    {
+      _low = _m->get_low_wavelen();
+      _high = _m->get_high_wavelen();
+      _fit_temperature = _m->get_temperature();
+
+      if (!(_high > _low))
+        {
+          _segments = 0;
+          throw Error("material has empty wavelen validity range");
+        }
+
+      for (unsigned int segments = 1; segments <= 64; segments *= 2)
+        for (unsigned int degree = 2; degree <= 16; degree++)
+          {
+            _fit_error = fit(segments, degree);
+
+            if (_fit_error <= _max_error)
+              return;
+          }
+
+      // do not use inaccurate polynomials
+      _segments = 0;
+      throw Error("unable to fit material refractive index with requested accuracy");
+    }
+
+    double Chebyshev::fit(unsigned int segments, unsigned int degree)
+    {
+      unsigned int n = degree + 1;
+      double width = (_high - _low) / segments;
+      std::vector<double> f(n);
+
+      _segments = segments;
+      _degree = degree;
+      _scale = segments / (_high - _low);
+      _coefs.resize(segments * n);
+
+      for (unsigned int s = 0; s < segments; s++)
+        {
+          double *c = &_coefs[s * n];
+
+          // sample at Chebyshev nodes of segment
+          for (unsigned int k = 0; k < n; k++)
+            {
+              double x = cos(M_PI * (k + 0.5) / n);
+              f[k] = _m->get_refractive_index(_low + width * (s + (x + 1.0) / 2.0));
+            }
+
+          for (unsigned int j = 0; j < n; j++)
+            {
+              double sum = 0.0;
+
+              for (unsigned int k = 0; k < n; k++)
+                sum += f[k] * cos(M_PI * j * (k + 0.5) / n);
+
+              c[j] = 2.0 / n * sum;
+            }
+
+          c[0] /= 2.0;
+        }
+
+      // check error on a denser grid, including range bounds
+      unsigned int count = 8 * n * segments;
+      double err = 0.0;
+
+      for (unsigned int i = 0; i <= count; i++)
+        {
+          double wl = _low + (_high - _low) * i / count;
+
+          err = std::max(err, fabs(eval(wl) - _m->get_refractive_index(wl)));
+        }
+
+      return err;
+    }
+
+    bool Chebyshev::is_opaque() const
+    {
+      return _m->is_opaque();
+    }
+
+    bool Chebyshev::is_reflecting() const
+    {
+      return _m->is_reflecting();
+    }
+
+    double Chebyshev::get_internal_transmittance(double wavelen, double thickness) const
+    {
+      return _m->get_internal_transmittance(wavelen, thickness);
+    }
+
+    double Chebyshev::get_refractive_index(double wavelen) const
+    {
+      if (!_segments || wavelen < _low || wavelen > _high ||
+          _m->get_temperature() != _fit_temperature)
+        return _m->get_refractive_index(wavelen);
+
+      return eval(wavelen);
+    }
+
+    double Chebyshev::get_thermal_refractive_index(double wavelen, double temperature) const
+    {
+      if (!_segments || wavelen < _low || wavelen > _high ||
+          temperature != _fit_temperature)
+        return _m->get_thermal_refractive_index(wavelen, temperature);
+
+      return eval(wavelen);
+    }
+
+    double Chebyshev::get_extinction_coef(double wavelen) const
+    {
+      return _m->get_extinction_coef(wavelen);
+    }
+
+    double Chebyshev::get_temperature() const
+    {
+      return _m->get_temperature();
+    }
+
+    Io::Rgb Chebyshev::get_color() const
+    {
+      return _m->get_color();
+    }
+
+    void Chebyshev::prepare() const
+    {
+      _m->prepare();
+    }
+
+  }
+}
+
@@ -41,6 +41,12 @@ namespace _Goptical {
       _transmittance.set_interpolation(Data::Cubic);
     }
 
+    void Dielectric::prepare() const
+    {
+      _transmittance.prepare();
+      _measurement_medium->prepare();
+    }
+
     bool Dielectric::is_opaque() const
     {
       return false;
@@ -74,11 +80,11 @@ namespace _Goptical {
       }
     }
 
-    double Dielectric::get_schott_temp(double wavelen, double n) const
+    double Dielectric::get_schott_temp(double wavelen, double n, double temperature) const
     {
       // SCHOTT TIE-19: Temperature Coefficient of the Refractive Index
 
-      double dt = _temperature - _measurement_medium->get_temperature();
+      double dt = temperature - _measurement_medium->get_temperature();
       double wl = wavelen / 1000.;
       double wl_tk = _temp_wl_tk;
 
@@ -87,6 +93,11 @@ namespace _Goptical {
     }
 
     double Dielectric::get_refractive_index(double wavelen) const
+    {
+      return get_thermal_refractive_index(wavelen, _temperature);
+    }
+
+    double Dielectric::get_thermal_refractive_index(double wavelen, double temperature) const
     {
       double a = _measurement_medium->get_refractive_index(wavelen);
       double m = get_measurement_index(wavelen);
@@ -98,11 +109,11 @@ namespace _Goptical {
       switch(_temp_model)
         {
         case ThermalSchott:
-          n = n + get_schott_temp(wavelen, m);
+          n = n + get_schott_temp(wavelen, m, temperature);
           break;
 
         case ThermalDnDt: {
-          double dt = _temperature - _measurement_medium->get_temperature();
+          double dt = temperature - _measurement_medium->get_temperature();
           n = n + dt * _temp_d0;
           break;
         }
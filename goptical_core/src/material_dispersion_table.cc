@@ -42,6 +42,12 @@ namespace _Goptical {
       return _refractive_index.interpolate(wavelen);
     }
 
+    void DispersionTable::prepare() const
+    {
+      Dielectric::prepare();
+      _refractive_index.prepare();
+    }
+
   }
 
 }
@@ -0,0 +1,364 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <Goptical/Material/GlassIndex>
+#include <Goptical/Material/Catalog>
+#include <Goptical/Material/Dielectric>
+#include <Goptical/Light/SpectralLine>
+#include <Goptical/Error>
+
+namespace _Goptical {
+
+  namespace Material {
+
+    /** k nearest search state, max heap of best candidates */
+    struct GlassIndex::nearest_s
+    {
+      double                    _attr[attribute_count];
+      unsigned int              _k;
+      std::vector<std::pair<double, unsigned int> > _heap;
+    };
+
+    struct GlassIndex::axis_less_s
+    {
+      axis_less_s(unsigned int axis)
+        : _axis(axis)
+      {
+      }
+
+      bool operator()(const node_s &a, const node_s &b) const
+      {
+        return a._attr[_axis] < b._attr[_axis];
+      }
+
+      unsigned int _axis;
+    };
+
+    GlassIndex::GlassIndex()
+      : _entries(),
+        _nodes(),
+        _dirty(false)
+    {
+      _weight[Nd] = 100.;
+      _weight[Vd] = 1.;
+      _weight[DPgF] = 100.;
+      _weight[Cost] = 0.;
+    }
+
+    GlassIndex::GlassIndex(Catalog &catalog, double cost)
+      : _entries(),
+        _nodes(),
+        _dirty(false)
+    {
+      _weight[Nd] = 100.;
+      _weight[Vd] = 1.;
+      _weight[DPgF] = 100.;
+      _weight[Cost] = 0.;
+
+      add_catalog(catalog, cost);
+    }
+
+    void GlassIndex::add_catalog(Catalog &catalog, double cost)
+    {
+      std::vector<std::string> names;
+
+      catalog.get_material_names(names);
+
+      GOPTICAL_FOREACH(n, names)
+        {
+          const_ref<Base> m = catalog.get_material(*n);
+          const Dielectric *d = dynamic_cast<const Dielectric*>(&*m);
+
+          if (!d)
+            continue;
+
+          add_material(*n, *d, cost);
+          _entries.back().catalog = catalog.get_name();
+        }
+    }
+
+    void GlassIndex::add_material(const std::string &name,
+                                  const const_ref<Dielectric> &material,
+                                  double cost)
+    {
+      double nd = material->get_measurement_index(Light::SpectralLine::d);
+      double vd = material->get_abbe_vd();
+      double pgf = material->get_partial_dispersion(Light::SpectralLine::g,
+                                                    Light::SpectralLine::F);
+
+      add_entry("", name, material, nd, vd, pgf - (0.6438 - 0.001682 * vd), cost);
+    }
+
+    void GlassIndex::add_entry(const std::string &catalog, const std::string &name,
+                               const const_ref<Dielectric> &material,
+                               double nd, double vd, double dpgf, double cost)
+    {
+      Entry e;
+
+      e.catalog = catalog;
+      e.name = name;
+      e.material = material;
+      e.attr[Nd] = nd;
+      e.attr[Vd] = vd;
+      e.attr[DPgF] = dpgf;
+      e.attr[Cost] = cost;
+
+      _entries.push_back(e);
+      _dirty = true;
+    }
+
+    void GlassIndex::clear()
+    {
+      _entries.clear();
+      _nodes.clear();
+      _dirty = false;
+    }
+
+    void GlassIndex::set_cost(unsigned int index, double cost)
+    {
+      _entries.at(index).attr[Cost] = cost;
+      _dirty = true;
+    }
+
+    void GlassIndex::set_weight(enum Attribute a, double weight)
+    {
+      if (weight < 0.)
+        throw Error("glass index attribute weight must not be negative");
+
+      _weight[a] = weight;
+      _dirty = true;
+    }
+
+    double GlassIndex::get_distance(unsigned int index,
+                                    const double attr[attribute_count]) const
+    {
+      const Entry &e = _entries[index];
+      double d2 = 0.;
+
+      for (unsigned int i = 0; i < attribute_count; i++)
+        d2 += Math::square(_weight[i] * (e.attr[i] - attr[i]));
+
+      return sqrt(d2);
+    }
+
+    void GlassIndex::build()
+    {
+      _nodes.resize(_entries.size());
+
+      for (unsigned int i = 0; i < _entries.size(); i++)
+        {
+          node_s &n = _nodes[i];
+
+          n._entry = i;
+          n._axis = 0;
+          for (unsigned int j = 0; j < attribute_count; j++)
+            n._attr[j] = _entries[i].attr[j];
+        }
+
+      build_tree(0, _nodes.size());
+      _dirty = false;
+    }
+
+    void GlassIndex::build_tree(unsigned int first, unsigned int last)
+    {
+      if (last - first < 2)
+        return;
+
+      double min[attribute_count], max[attribute_count];
+
+      for (unsigned int j = 0; j < attribute_count; j++)
+        min[j] = max[j] = _nodes[first]._attr[j];
+
+      for (unsigned int i = first + 1; i < last; i++)
+        for (unsigned int j = 0; j < attribute_count; j++)
+          {
+            min[j] = std::min(min[j], _nodes[i]._attr[j]);
+            max[j] = std::max(max[j], _nodes[i]._attr[j]);
+          }
+
+      // split along axis of largest weighted spread, fallback to raw
+      // spread when all weighted attributes are equal
+      unsigned int axis = 0, raw_axis = 0;
+      double spread = 0., raw_spread = 0.;
+
+      for (unsigned int j = 0; j < attribute_count; j++)
+        {
+          double s = max[j] - min[j];
+
+          if (s * _weight[j] > spread)
+            {
+              spread = s * _weight[j];
+              axis = j;
+            }
+
+          if (s > raw_spread)
+            {
+              raw_spread = s;
+              raw_axis = j;
+            }
+        }
+
+      if (spread == 0.)
+        axis = raw_axis;
+
+      unsigned int mid = (first + last) / 2;
+
+      std::nth_element(_nodes.begin() + first, _nodes.begin() + mid,
+                       _nodes.begin() + last, axis_less_s(axis));
+
+      _nodes[mid]._axis = axis;
+
+      build_tree(first, mid);
+      build_tree(mid + 1, last);
+    }
+
+    void GlassIndex::search_nearest(nearest_s &s, unsigned int first, unsigned int last) const
+    {
+      if (first >= last)
+        return;
+
+      unsigned int mid = (first + last) / 2;
+      const node_s &n = _nodes[mid];
+      double d2 = 0.;
+
+      for (unsigned int j = 0; j < attribute_count; j++)
+        d2 += Math::square(_weight[j] * (n._attr[j] - s._attr[j]));
+
+      if (s._heap.size() < s._k)
+        {
+          s._heap.push_back(std::make_pair(d2, n._entry));
+          std::push_heap(s._heap.begin(), s._heap.end());
+        }
+      else if (std::make_pair(d2, n._entry) < s._heap.front())
+        {
+          std::pop_heap(s._heap.begin(), s._heap.end());
+          s._heap.back() = std::make_pair(d2, n._entry);
+          std::push_heap(s._heap.begin(), s._heap.end());
+        }
+
+      if (last - first < 2)
+        return;
+
+      double diff = _weight[n._axis] * (s._attr[n._axis] - n._attr[n._axis]);
+
+      if (diff < 0.)
+        {
+          search_nearest(s, first, mid);
+          if (s._heap.size() < s._k || diff * diff <= s._heap.front().first)
+            search_nearest(s, mid + 1, last);
+        }
+      else
+        {
+          search_nearest(s, mid + 1, last);
+          if (s._heap.size() < s._k || diff * diff <= s._heap.front().first)
+            search_nearest(s, first, mid);
+        }
+    }
+
+    void GlassIndex::find_nearest(std::vector<unsigned int> &result, unsigned int k,
+                                  const double attr[attribute_count]) const
+    {
+      update();
+
+      if (!k)
+        return;
+
+      nearest_s s;
+
+      for (unsigned int j = 0; j < attribute_count; j++)
+        s._attr[j] = attr[j];
+      s._k = k;
+      s._heap.reserve(k + 1);
+
+      search_nearest(s, 0, _nodes.size());
+
+      std::sort_heap(s._heap.begin(), s._heap.end());
+
+      for (unsigned int i = 0; i < s._heap.size(); i++)
+        result.push_back(s._heap[i].second);
+    }
+
+    void GlassIndex::find_nearest(std::vector<unsigned int> &result, unsigned int k,
+                                  double nd, double vd, double dpgf) const
+    {
+      double attr[attribute_count];
+
+      attr[Nd] = nd;
+      attr[Vd] = vd;
+      attr[DPgF] = dpgf;
+      attr[Cost] = 0.;
+
+      find_nearest(result, k, attr);
+    }
+
+    void GlassIndex::search_range(std::vector<unsigned int> &result,
+                                  const double low[attribute_count],
+                                  const double high[attribute_count],
+                                  unsigned int first, unsigned int last) const
+    {
+      if (first >= last)
+        return;
+
+      unsigned int mid = (first + last) / 2;
+      const node_s &n = _nodes[mid];
+      unsigned int j;
+
+      for (j = 0; j < attribute_count; j++)
+        if (n._attr[j] < low[j] || n._attr[j] > high[j])
+          break;
+
+      if (j == attribute_count)
+        result.push_back(n._entry);
+
+      double a = n._attr[n._axis];
+
+      if (low[n._axis] <= a)
+        search_range(result, low, high, first, mid);
+
+      if (a <= high[n._axis])
+        search_range(result, low, high, mid + 1, last);
+    }
+
+    void GlassIndex::find_range(std::vector<unsigned int> &result,
+                                const double low[attribute_count],
+                                const double high[attribute_count]) const
+    {
+      update();
+
+      size_t first = result.size();
+
+      search_range(result, low, high, 0, _nodes.size());
+
+      std::sort(result.begin() + first, result.end());
+    }
+
+  }
+
+}
+
@@ -64,6 +64,12 @@ namespace _Goptical {
       return _extinction.interpolate(wavelen);
     }
 
+    void Metal::prepare() const
+    {
+      _extinction.prepare();
+      _refractive_index.prepare();
+    }
+
   }
 
 }
@@ -53,6 +53,11 @@ namespace _Goptical {
       return 1.0;
     }
 
+    double Mirror::get_thermal_refractive_index(double, double) const
+    {
+      return 1.0;
+    }
+
     double Mirror::get_extinction_coef(double wavelen) const
     {
       return 9999.0;
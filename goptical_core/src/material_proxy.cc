@@ -54,6 +54,11 @@ namespace _Goptical {
       return _m->get_refractive_index(wavelen);
     }
 
+    double Proxy::get_thermal_refractive_index(double wavelen, double temperature) const
+    {
+      return _m->get_thermal_refractive_index(wavelen, temperature);
+    }
+
     double Proxy::get_extinction_coef(double wavelen) const
     {
       return _m->get_extinction_coef(wavelen);
@@ -69,6 +74,18 @@ namespace _Goptical {
       return _m->get_normal_transmittance(from, wavelen);
     }
 
+    double Proxy::get_thermal_normal_reflectance(const Base *from, double wavelen,
+                                                 double temperature) const
+    {
+      return _m->get_thermal_normal_reflectance(from, wavelen, temperature);
+    }
+
+    double Proxy::get_thermal_normal_transmittance(const Base *from, double wavelen,
+                                                   double temperature) const
+    {
+      return _m->get_thermal_normal_transmittance(from, wavelen, temperature);
+    }
+
     double Proxy::get_temperature() const
     {
       return _m->get_temperature();
@@ -79,6 +96,11 @@ namespace _Goptical {
       return _m->get_color();
     }
 
+    void Proxy::prepare() const
+    {
+      _m->prepare();
+    }
+
   }
 }
 
@@ -58,6 +58,11 @@ namespace _Goptical {
       return 1.0;    
     }
 
+    double Vacuum::get_thermal_refractive_index(double, double) const
+    {
+      return 1.0;
+    }
+
     Vacuum vacuum;
   }
 
@@ -0,0 +1,197 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <Goptical/Error>
+
+#include "parallel_.hh"
+
+namespace _Goptical {
+
+  /** jobs of a parallel_for call */
+  struct parallel_ctx_s
+  {
+    const parallel_job_t *job;
+    unsigned int        count;
+    unsigned int        next;           // next job index to dispatch
+    unsigned int        helpers;        // max pool threads working on jobs
+    unsigned int        active;         // pool threads working on jobs
+    bool                failed;
+    std::string         error;
+    pthread_cond_t      done;           // signaled when active drops to 0
+    parallel_ctx_s      *next_ctx;      // list of calls with jobs to dispatch
+  };
+
+  /** process wide worker threads, kept between parallel_for calls */
+  struct parallel_pool_s
+  {
+    pthread_mutex_t     lock;
+    pthread_cond_t      work;           // signaled when a call is added
+    parallel_ctx_s      *ctx_list;
+    unsigned int        threads;
+  };
+
+  static parallel_pool_s pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0
+  };
+
+  /** run jobs until all dispatched, called with pool lock held */
+  static void parallel_run(parallel_ctx_s &ctx)
+  {
+    while (!ctx.failed && ctx.next < ctx.count)
+      {
+        unsigned int i = ctx.next++;
+        bool failed = false;
+        std::string error;
+
+        pthread_mutex_unlock(&pool.lock);
+
+        try {
+          (*ctx.job)(i);
+        } catch (const std::exception &e) {
+          failed = true;
+          error = e.what();
+        } catch (...) {
+          failed = true;
+          error = "unknown exception thrown by parallel job";
+        }
+
+        pthread_mutex_lock(&pool.lock);
+
+        if (failed && !ctx.failed)
+          {
+            ctx.failed = true;
+            ctx.error = error;
+          }
+      }
+  }
+
+  static void * parallel_worker(void *)
+  {
+    pthread_mutex_lock(&pool.lock);
+
+    while (1)
+      {
+        parallel_ctx_s *ctx = pool.ctx_list;
+
+        // find a call which still has jobs and accepts more threads
+        while (ctx && (ctx->failed || ctx->next >= ctx->count ||
+                       ctx->active >= ctx->helpers))
+          ctx = ctx->next_ctx;
+
+        if (!ctx)
+          {
+            pthread_cond_wait(&pool.work, &pool.lock);
+            continue;
+          }
+
+        ctx->active++;
+        parallel_run(*ctx);
+
+        if (!--ctx->active)
+          pthread_cond_signal(&ctx->done);
+      }
+
+    return 0;
+  }
+
+  unsigned int parallel_cpu_count()
+  {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return n > 0 ? n : 1;
+  }
+
+  void parallel_for(unsigned int count, unsigned int thread_count,
+                    const parallel_job_t &job)
+  {
+    if (thread_count == 0)
+      thread_count = parallel_cpu_count();
+
+    if (thread_count > count)
+      thread_count = count;
+
+    if (thread_count <= 1)
+      {
+        for (unsigned int i = 0; i < count; i++)
+          job(i);
+        return;
+      }
+
+    // calling thread is used as first worker, context lives on stack
+    // so that no heap allocation occurs once the pool is large enough
+    struct parallel_ctx_s ctx;
+
+    ctx.job = &job;
+    ctx.count = count;
+    ctx.next = 0;
+    ctx.helpers = thread_count - 1;
+    ctx.active = 0;
+    ctx.failed = false;
+    pthread_cond_init(&ctx.done, 0);
+
+    pthread_mutex_lock(&pool.lock);
+
+    // grow pool, jobs are still run by the calling thread if no
+    // more thread can be created
+    while (pool.threads < thread_count - 1)
+      {
+        pthread_t t;
+
+        if (pthread_create(&t, 0, parallel_worker, 0))
+          break;
+
+        pthread_detach(t);
+        pool.threads++;
+      }
+
+    ctx.next_ctx = pool.ctx_list;
+    pool.ctx_list = &ctx;
+    pthread_cond_broadcast(&pool.work);
+
+    parallel_run(ctx);
+
+    // all jobs dispatched, stop other threads from joining
+    for (parallel_ctx_s **i = &pool.ctx_list; ; i = &(*i)->next_ctx)
+      if (*i == &ctx)
+        {
+          *i = ctx.next_ctx;
+          break;
+        }
+
+    while (ctx.active)
+      pthread_cond_wait(&ctx.done, &pool.lock);
+
+    pthread_mutex_unlock(&pool.lock);
+
+    pthread_cond_destroy(&ctx.done);
+
+    if (ctx.failed)
+      throw Error(ctx.error);
+  }
+
+}
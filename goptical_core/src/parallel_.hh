@@ -0,0 +1,55 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_PARALLEL_HH_
+#define GOPTICAL_PARALLEL_HH_
+
+#include "Goptical/common.hh"
+
+namespace _Goptical {
+
+  /** @internal Job delegate type, called with job index */
+  typedef delegate<void (unsigned int)> parallel_job_t;
+
+  /** @internal Get number of available processors */
+  unsigned int parallel_cpu_count();
+
+  /** @internal Run jobs with index in [0, count) on up to
+      @tt thread_count worker threads. Jobs are dispatched in
+      increasing index order. A @tt thread_count of 0 uses one thread
+      per available processor and a value of 1 runs all jobs in the
+      calling thread. The calling thread runs jobs along with
+      threads of a process wide pool which are created on first use
+      and kept for later calls. Calls may be nested or made
+      concurrently from different threads. An @ref Error is thrown
+      once all running jobs terminated if any job has thrown an
+      exception of any type, remaining jobs are not run. */
+  void parallel_for(unsigned int count, unsigned int thread_count,
+                    const parallel_job_t &job);
+
+}
+
+#endif
+
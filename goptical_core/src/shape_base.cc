@@ -210,6 +210,10 @@ namespace _Goptical {
       return 0.;
     }
 
+    void Base::prepare() const
+    {
+    }
+
   }
 
 }
@@ -141,6 +141,15 @@ namespace _Goptical {
       const_cast<Composer*>(this)->update();
     }
 
+    void Composer::prepare() const
+    {
+      if (_update)
+        update();
+
+      GOPTICAL_FOREACH(i, _list)
+        i->_shape->prepare();
+    }
+
     double Composer::max_radius() const
     {
       if (_update)
@@ -151,6 +151,12 @@ namespace _Goptical {
         }
     }
 
+    void Polygon::prepare() const
+    {
+      if (!_updated)
+        const_cast<Polygon*>(this)->update();
+    }
+
     double Polygon::max_radius() const
     {
       if (!_updated)
@@ -0,0 +1,136 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#ifndef GOPTICAL_SIMD_HH_
+#define GOPTICAL_SIMD_HH_
+
+/* Packed double precision operations used by batch kernels. The
+   widest instruction set enabled at compile time is used, AVX when
+   built with -mavx or -march=native, SSE2 on x86_64 by default. No
+   vector type is defined on other targets and kernels only use their
+   scalar code path. */
+
+#if defined(__AVX__)
+# include <immintrin.h>
+# define GOPTICAL_SIMD_WIDTH 4
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+# define GOPTICAL_SIMD_WIDTH 2
+#endif
+
+#ifdef GOPTICAL_SIMD_WIDTH
+
+namespace _Goptical {
+
+  /** @internal Packed double precision values. Comparison
+      operations return lane masks usable with @ref select. */
+  struct simd_pd
+  {
+    static const unsigned int width = GOPTICAL_SIMD_WIDTH;
+
+#if defined(__AVX__)
+    typedef __m256d v;
+
+    static inline v load(const double *p) { return _mm256_loadu_pd(p); }
+    static inline void store(double *p, v a) { _mm256_storeu_pd(p, a); }
+    static inline v set1(double x) { return _mm256_set1_pd(x); }
+    static inline v zero() { return _mm256_setzero_pd(); }
+
+    static inline v add(v a, v b) { return _mm256_add_pd(a, b); }
+    static inline v sub(v a, v b) { return _mm256_sub_pd(a, b); }
+    static inline v mul(v a, v b) { return _mm256_mul_pd(a, b); }
+    static inline v div(v a, v b) { return _mm256_div_pd(a, b); }
+    static inline v sqrt(v a) { return _mm256_sqrt_pd(a); }
+    static inline v max(v a, v b) { return _mm256_max_pd(a, b); }
+
+    static inline v lt(v a, v b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    static inline v gt(v a, v b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static inline v eq(v a, v b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static inline v neq(v a, v b) { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+    static inline v nlt(v a, v b) { return _mm256_cmp_pd(a, b, _CMP_NLT_UQ); }
+    static inline v nle(v a, v b) { return _mm256_cmp_pd(a, b, _CMP_NLE_UQ); }
+
+    static inline v and_(v a, v b) { return _mm256_and_pd(a, b); }
+    static inline v or_(v a, v b) { return _mm256_or_pd(a, b); }
+    static inline v xor_(v a, v b) { return _mm256_xor_pd(a, b); }
+    static inline v select(v mask, v a, v b) { return _mm256_blendv_pd(b, a, mask); }
+    static inline int movemask(v mask) { return _mm256_movemask_pd(mask); }
+#else
+    typedef __m128d v;
+
+    static inline v load(const double *p) { return _mm_loadu_pd(p); }
+    static inline void store(double *p, v a) { _mm_storeu_pd(p, a); }
+    static inline v set1(double x) { return _mm_set1_pd(x); }
+    static inline v zero() { return _mm_setzero_pd(); }
+
+    static inline v add(v a, v b) { return _mm_add_pd(a, b); }
+    static inline v sub(v a, v b) { return _mm_sub_pd(a, b); }
+    static inline v mul(v a, v b) { return _mm_mul_pd(a, b); }
+    static inline v div(v a, v b) { return _mm_div_pd(a, b); }
+    static inline v sqrt(v a) { return _mm_sqrt_pd(a); }
+    static inline v max(v a, v b) { return _mm_max_pd(a, b); }
+
+    static inline v lt(v a, v b) { return _mm_cmplt_pd(a, b); }
+    static inline v gt(v a, v b) { return _mm_cmpgt_pd(a, b); }
+    static inline v eq(v a, v b) { return _mm_cmpeq_pd(a, b); }
+    static inline v neq(v a, v b) { return _mm_cmpneq_pd(a, b); }
+    static inline v nlt(v a, v b) { return _mm_cmpnlt_pd(a, b); }
+    static inline v nle(v a, v b) { return _mm_cmpnle_pd(a, b); }
+
+    static inline v and_(v a, v b) { return _mm_and_pd(a, b); }
+    static inline v or_(v a, v b) { return _mm_or_pd(a, b); }
+    static inline v xor_(v a, v b) { return _mm_xor_pd(a, b); }
+    static inline v select(v mask, v a, v b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+    static inline int movemask(v mask) { return _mm_movemask_pd(mask); }
+#endif
+
+    /** negate values */
+    static inline v neg(v a)
+    {
+      return xor_(a, set1(-0.0));
+    }
+
+    /** negate values in lanes where mask is set */
+    static inline v neg_if(v mask, v a)
+    {
+      return xor_(a, and_(mask, set1(-0.0)));
+    }
+
+    /** store mask lanes as booleans */
+    static inline void store_mask(bool *p, v mask)
+    {
+      int m = movemask(mask);
+
+      for (unsigned int i = 0; i < width; i++)
+        p[i] = (m >> i) & 1;
+    }
+  };
+
+}
+
+#endif
+
+#endif
+
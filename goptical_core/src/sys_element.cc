@@ -214,6 +214,27 @@ namespace _Goptical {
       throw Error("this element is not designed to process incoming light rays in polarized ray trace mode");
     }
 
+    void Element::process_packet_simple(const Trace::Params &, Trace::RayPacket &,
+                                        unsigned int, unsigned int,
+                                        Trace::RayPacket &) const
+    {
+      throw Error("this element is not designed to process rays packets in simple ray trace mode");
+    }
+
+    void Element::process_packet_intensity(const Trace::Params &, Trace::RayPacket &,
+                                           unsigned int, unsigned int,
+                                           Trace::RayPacket &) const
+    {
+      throw Error("this element is not designed to process rays packets in intensity ray trace mode");
+    }
+
+    void Element::process_packet_polarized(const Trace::Params &, Trace::RayPacket &,
+                                           unsigned int, unsigned int,
+                                           Trace::RayPacket &) const
+    {
+      throw Error("this element is not designed to process rays packets in polarized ray trace mode");
+    }
+
     void Element::system_register(System &s)
     {
       assert(!_system);
@@ -247,6 +268,10 @@ namespace _Goptical {
         _system->update_version();
     }
 
+    void Element::prepare() const
+    {
+    }
+
     void Element::draw_2d_e(Io::Renderer &r, const Element *ref) const
     {
     }
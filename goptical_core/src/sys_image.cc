@@ -58,6 +58,24 @@ namespace _Goptical {
     {
     }
 
+    void Image::trace_packet_simple(Trace::RayPacket &, unsigned int,
+                                    const Math::VectorPair3 &, const Math::VectorPair3 &,
+                                    Trace::RayPacket &) const
+    {
+    }
+
+    void Image::trace_packet_intensity(Trace::RayPacket &, unsigned int,
+                                       const Math::VectorPair3 &, const Math::VectorPair3 &,
+                                       Trace::RayPacket &) const
+    {
+    }
+
+    void Image::trace_packet_polarized(Trace::RayPacket &, unsigned int,
+                                       const Math::VectorPair3 &, const Math::VectorPair3 &,
+                                       Trace::RayPacket &) const
+    {
+    }
+
   }
 
 }
@@ -32,10 +32,14 @@
 #include <Goptical/Trace/Ray>
 #include <Goptical/Trace/Distribution>
 #include <Goptical/Trace/Result>
+#include <Goptical/Trace/RayPacket>
+#include <Goptical/Trace/SpectralTable>
 
 #include <Goptical/Io/Rgb>
 #include <Goptical/Io/Renderer>
 
+#include <Goptical/Error>
+
 namespace _Goptical {
 
   namespace Sys {
@@ -83,6 +87,15 @@ namespace _Goptical {
       return r.get_style_color(Io::StyleSurface);
     }
 
+    void OpticalSurface::prepare() const
+    {
+      Surface::prepare();
+
+      for (unsigned int i = 0; i < 2; i++)
+        if (_mat[i].valid())
+          _mat[i]->prepare();
+    }
+
     bool OpticalSurface::refract(const Math::VectorPair3 &ray, Math::Vector3 &dir,
                                  const Math::Vector3 &normal, double refract_index) const
     {
@@ -116,10 +129,66 @@ namespace _Goptical {
       dir = ray.direction() - normal * (2.0 * cosi);
     }
 
-    void OpticalSurface::trace_ray_simple(Trace::Result &result,
-                                          Trace::Ray &incident,
-                                          const Math::VectorPair3 &local,
-                                          const Math::VectorPair3 &intersect) const
+    /** @internal Store rays generated by a surface as new rays in
+        trace result */
+    struct optical_ray_output_s
+    {
+      inline optical_ray_output_s(Trace::Result &result, Trace::Ray &incident,
+                                  const Element *creator)
+        : _result(result),
+          _incident(incident),
+          _creator(creator)
+      {
+      }
+
+      inline void add_ray(const Math::Vector3 &origin, const Math::Vector3 &direction,
+                          double wavelen, double intensity,
+                          const Material::Base *material)
+      {
+        Trace::Ray &r = _result.new_ray();
+
+        r.set_wavelen(wavelen);
+        r.set_intensity(intensity);
+        r.set_material(material);
+        r.origin() = origin;
+        r.direction() = direction;
+        r.set_creator(_creator);
+        _incident.add_generated(&r);
+      }
+
+      Trace::Result &_result;
+      Trace::Ray &_incident;
+      const Element *_creator;
+    };
+
+    /** @internal Store rays generated by a surface in output rays
+        packet */
+    struct optical_packet_output_s
+    {
+      inline optical_packet_output_s(Trace::RayPacket &output, unsigned int parent)
+        : _output(output),
+          _parent(parent)
+      {
+      }
+
+      inline void add_ray(const Math::Vector3 &origin, const Math::Vector3 &direction,
+                          double wavelen, double intensity,
+                          const Material::Base *material)
+      {
+        _output.add_ray(origin, direction, wavelen, intensity, material, _parent);
+      }
+
+      Trace::RayPacket &_output;
+      unsigned int _parent;
+    };
+
+    template <Trace::IntensityMode m, class Output>
+    inline void OpticalSurface::trace_interaction(Output &output,
+                                                  const Material::Base *material,
+                                                  double wl, double intensity,
+                                                  const Trace::SpectralTable *table,
+                                                  const Math::VectorPair3 &local,
+                                                  const Math::VectorPair3 &intersect) const
     {
       Math::Vector3     direction;      // refracted ray direction
 
@@ -129,130 +198,111 @@ namespace _Goptical {
       const Material::Base *next_mat = _mat[!right_to_left].ptr();
 
       // check ray didn't "escaped" from its material
-      if (prev_mat != incident.get_material())
+      if (prev_mat != material)
         return;
 
-      double wl = incident.get_wavelen();
-      double index = prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
+      const Trace::SpectralTable::surface_entry_s *e =
+        table ? table->get_surface_entry(*this, right_to_left, wl) : 0;
+
+      // falling back to material models would ignore table temperature
+      if (!e && table && table->has_temperature())
+        throw Error("material properties not available at trace temperature");
+      double index = e ? e->_index
+        : prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
 
       if (!refract(local, direction, intersect.normal(), index))
         {
-          Trace::Ray &r = result.new_ray();
           // total internal reflection
-
-          r.set_wavelen(wl);
-          r.set_intensity(incident.get_intensity());
-          r.set_material(prev_mat);
-          r.origin() = intersect.origin();
-          reflect(local, r.direction(), intersect.normal());
-          r.set_creator(this);
-          incident.add_generated(&r);
-
+          reflect(local, direction, intersect.normal());
+          output.add_ray(intersect.origin(), direction, wl, intensity, prev_mat);
           return;
         }
 
-      // transmit
-      if (!next_mat->is_opaque())
+      switch (m)
         {
-          Trace::Ray &r = result.new_ray();
-
-          r.set_wavelen(wl);
-          r.set_intensity(incident.get_intensity());
-          r.set_material(next_mat);
-          r.origin() = intersect.origin();
-          r.direction() = direction;
-          r.set_creator(this);
-          incident.add_generated(&r);
-        }
+        case Trace::SimpleTrace:
+          // transmit
+          if (!next_mat->is_opaque())
+            output.add_ray(intersect.origin(), direction, wl, intensity, next_mat);
 
-      // reflect
-      if (next_mat->is_reflecting())
-        {
-          Trace::Ray &r = result.new_ray();
-
-          r.set_wavelen(wl);
-          r.set_intensity(incident.get_intensity());
-          r.set_material(prev_mat);
-          r.origin() = intersect.origin();
-          reflect(local, r.direction(), intersect.normal());
-          r.set_creator(this);
-          incident.add_generated(&r);
+          // reflect
+          if (next_mat->is_reflecting())
+            {
+              reflect(local, direction, intersect.normal());
+              output.add_ray(intersect.origin(), direction, wl, intensity, prev_mat);
+            }
+          break;
+
+        default: {
+          // transmit
+          if (!next_mat->is_opaque())
+            {
+              double tintensity = intensity * (e ? e->_transmittance
+                                               : next_mat->get_normal_transmittance(prev_mat, wl));
+
+              if (tintensity >= get_discard_intensity())
+                output.add_ray(intersect.origin(), direction, wl, tintensity, next_mat);
+            }
+
+          // reflect
+          double rintensity = intensity * (e ? e->_reflectance
+                                           : next_mat->get_normal_reflectance(prev_mat, wl));
+
+          if (rintensity >= get_discard_intensity())
+            {
+              reflect(local, direction, intersect.normal());
+              output.add_ray(intersect.origin(), direction, wl, rintensity, prev_mat);
+            }
+        }
         }
     }
 
+    void OpticalSurface::trace_ray_simple(Trace::Result &result,
+                                          Trace::Ray &incident,
+                                          const Math::VectorPair3 &local,
+                                          const Math::VectorPair3 &intersect) const
+    {
+      optical_ray_output_s out(result, incident, this);
+
+      trace_interaction<Trace::SimpleTrace>(out, incident.get_material(), incident.get_wavelen(),
+                                            incident.get_intensity(), &result.get_spectral_table(),
+                                            local, intersect);
+    }
+
     void OpticalSurface::trace_ray_intensity(Trace::Result &result,
                                              Trace::Ray &incident,
                                              const Math::VectorPair3 &local,
                                              const Math::VectorPair3 &intersect) const
     {
-      Math::Vector3     direction;
-
-      bool right_to_left = intersect.normal().z() > 0;
-
-      const Material::Base *prev_mat = _mat[right_to_left].ptr();
-      const Material::Base *next_mat = _mat[!right_to_left].ptr();
-
-      // check ray didn't "escaped" from its material
-      if (prev_mat != incident.get_material())
-        return;
+      optical_ray_output_s out(result, incident, this);
 
-      double wl = incident.get_wavelen();
-      double index = prev_mat->get_refractive_index(wl) / next_mat->get_refractive_index(wl);
-      double intensity = incident.get_intercept_intensity();
-
-      if (!refract(local, direction, intersect.normal(), index))
-        {
-          // total internal reflection
-          Trace::Ray &r = result.new_ray();
-
-          r.set_wavelen(wl);
-          r.set_intensity(intensity);
-          r.set_material(prev_mat);
-          r.origin() = intersect.origin();
-          reflect(local, r.direction(), intersect.normal());
-          r.set_creator(this);
-          incident.add_generated(&r);
-
-          return;
-        }
+      trace_interaction<Trace::IntensityTrace>(out, incident.get_material(), incident.get_wavelen(),
+                                               incident.get_intercept_intensity(),
+                                               &result.get_spectral_table(), local, intersect);
+    }
 
-      // transmit
-      if (!next_mat->is_opaque())
-        {
-          double tintensity = intensity * next_mat->get_normal_transmittance(prev_mat, wl);
+    void OpticalSurface::trace_packet_simple(Trace::RayPacket &input, unsigned int index,
+                                             const Math::VectorPair3 &local,
+                                             const Math::VectorPair3 &intersect,
+                                             Trace::RayPacket &output) const
+    {
+      optical_packet_output_s out(output, index);
 
-          if (tintensity >= get_discard_intensity())
-            {
-              Trace::Ray &r = result.new_ray();
-
-              r.set_wavelen(wl);
-              r.set_intensity(tintensity);
-              r.set_material(next_mat);
-              r.origin() = intersect.origin();
-              r.direction() = direction;
-              r.set_creator(this);
-              incident.add_generated(&r);
-            }
-        }
+      trace_interaction<Trace::SimpleTrace>(out, input.get_material(index), input.get_wavelen(index),
+                                            input.get_intensity(index), input.get_spectral_table(),
+                                            local, intersect);
+    }
 
-      // reflect
-      {
-        double rintensity = intensity * next_mat->get_normal_reflectance(prev_mat, wl);
-
-        if (rintensity >= get_discard_intensity())
-          {
-            Trace::Ray &r = result.new_ray();
-
-            r.set_wavelen(wl);
-            r.set_intensity(rintensity);
-            r.set_material(prev_mat);
-            r.origin() = intersect.origin();
-            reflect(local, r.direction(), intersect.normal());
-            r.set_creator(this);
-            incident.add_generated(&r);
-          }
-      }
+    void OpticalSurface::trace_packet_intensity(Trace::RayPacket &input, unsigned int index,
+                                                const Math::VectorPair3 &local,
+                                                const Math::VectorPair3 &intersect,
+                                                Trace::RayPacket &output) const
+    {
+      optical_packet_output_s out(output, index);
 
+      trace_interaction<Trace::IntensityTrace>(out, input.get_material(index), input.get_wavelen(index),
+                                               input.get_intercept_intensity(index),
+                                               input.get_spectral_table(), local, intersect);
     }
 
     void OpticalSurface::set_material(unsigned index, const const_ref<Material::Base> &m)
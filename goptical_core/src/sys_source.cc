@@ -32,7 +32,8 @@ namespace _Goptical {
     Source::Source(const Math::VectorPair3 &position)
       : Element(position),
         _spectrum(),
-        _mat()
+        _mat(),
+        _sampling(SpectralAllLines)
     {
       _max_intensity = _min_intensity = 1.0;
       _spectrum.push_back(Light::SpectralLine(550.0, 1.0));
@@ -25,6 +25,7 @@
 #define DPP_DELEGATE_ARGC 5
 
 #include <limits>
+#include <algorithm>
 
 #include <Goptical/Math/Vector>
 
@@ -49,6 +50,129 @@ namespace _Goptical {
     {
     }
 
+    /** generate rays toward pattern points of a target surface */
+    template <SourceInfinityMode mode>
+    struct source_point_rays_s
+    {
+      inline void add(const Math::Vector3 &i) const
+      {
+        Math::Vector3 r = _t->transform(i);  // pattern point on target surface
+        Math::Vector3 direction;
+        Math::Vector3 position;
+
+        switch (mode)
+          {
+          case (SourceAtFiniteDistance):
+            position = _pos_dir.origin();
+            direction = (r - position).normalized();
+            break;
+
+          case (SourceAtInfinity):
+            direction = _pos_dir.normal();
+            position = _pos_dir.pl_ln_intersect(Math::VectorPair3(r, direction));
+            break;
+          }
+
+        if (_sampling == SpectralAllLines)
+          {
+            GOPTICAL_FOREACH(l, *_spectrum)
+              new_ray(position, direction, l->get_wavelen(), l->get_intensity());
+            return;
+          }
+
+        if (_spectrum->empty())
+          return;
+
+        // golden ratio additive sequence keeps samples stratified
+        // whatever the pattern points count and order
+        _u += 0.61803398874989484820;
+        if (_u >= 1.0)
+          _u -= 1.0;
+
+        unsigned int l = std::upper_bound(_cdf.begin(), _cdf.end() - 1, _u) - _cdf.begin();
+
+        new_ray(position, direction, (*_spectrum)[l].get_wavelen(), _intensity[l]);
+      }
+
+      inline void new_ray(const Math::Vector3 &position, const Math::Vector3 &direction,
+                          double wavelen, double intensity) const
+      {
+        Trace::Ray &r = _result->new_ray();
+
+        // generated rays use source coordinates
+        r.direction() = direction;
+        r.origin() = position;
+
+        r.set_creator(_source);
+        r.set_intensity(intensity); // FIXME depends on distance from source and pattern density
+        r.set_wavelen(wavelen);
+        r.set_material(_mat);
+      }
+
+      /** setup spectral lines probabilities and sampled rays
+          intensities so that expected energy is conserved */
+      void init_spectrum(SpectralSampling sampling,
+                         const std::vector<Light::SpectralLine> &spectrum)
+      {
+        _sampling = sampling;
+        _spectrum = &spectrum;
+        _u = 0.5;
+
+        if (sampling == SpectralAllLines || spectrum.empty())
+          return;
+
+        unsigned int count = spectrum.size();
+        double total = 0;
+
+        GOPTICAL_FOREACH(l, spectrum)
+          total += l->get_intensity();
+
+        if (total <= 0)
+          sampling = SpectralStratified;
+
+        _cdf.resize(count);
+        _intensity.resize(count);
+
+        double sum = 0;
+
+        for (unsigned int i = 0; i < count; i++)
+          {
+            double w = spectrum[i].get_intensity();
+
+            switch (sampling)
+              {
+              case SpectralImportance:
+                sum += w / total;
+                _intensity[i] = total;
+                break;
+              default:
+                sum += 1.0 / count;
+                _intensity[i] = w * count;
+                break;
+              }
+
+            _cdf[i] = sum;
+          }
+
+        _cdf[count - 1] = 1.0;
+      }
+
+      const Source *_source;
+      // source position or plane where rays start if at infinity,
+      // in source coordinates
+      Math::VectorPair3 _pos_dir;
+      // transform from target to source coordinates
+      const Math::Transform<3> *_t;
+      const Material::Base *_mat;
+      const std::vector<Light::SpectralLine> *_spectrum;
+      Trace::Result *_result;
+      SpectralSampling _sampling;
+      // cumulative lines probabilities and rays intensities
+      std::vector<double> _cdf;
+      std::vector<double> _intensity;
+      mutable double _u;
+    };
+
     template <SourceInfinityMode mode>
     void SourcePoint::get_lightrays_(Trace::Result &result,
                                      const Element &target) const
@@ -62,63 +186,79 @@ namespace _Goptical {
 
       const Trace::Distribution &d = result.get_params().get_distribution(*starget);
 
-      DPP_DELEGATE5_OBJ(de, void, (const Math::Vector3 &i),
+      source_point_rays_s<mode> gen;
 
-                        // _0
-                        const SourcePoint *, this,
+      gen._source = this;
+      // ray aiming at target surface origin in source coordinates
+      gen._pos_dir = mode == SourceAtInfinity
+        ? Math::VectorPair3(starget->get_position(*this) -
+                            Math::vector3_001 * rlen, Math::vector3_001)
+        : Math::VectorPair3(Math::vector3_0, Math::vector3_001);
+      gen._t = &starget->get_transform_to(*this);
+      gen._mat = _mat.valid() ? _mat.ptr() : &get_system()->get_environment_proxy();
+      gen._result = &result;
+      gen.init_spectrum(_sampling, _spectrum);
 
-                        // _1 ray aiming at target surface origin in source coordinates
-                        const Math::VectorPair3 &,
-                        Math::VectorPair3(starget->get_position(*this) -
-                                            Math::vector3_001 * rlen, Math::vector3_001),
+      DPP_DELEGATE1_OBJ(de, void, (const Math::Vector3 &i),
 
-                        // _2 transform from target to source coordinates
-                        const Math::Transform<3> &,
-                        starget->get_transform_to(*this),
+                        const source_point_rays_s<mode> &, gen,
 
-                        // _3
-                        const Material::Base *,
-                        _mat.valid() ? _mat.ptr() : &get_system()->get_environment_proxy(),
+      {
+        _0.add(i);
+      });
 
-                        // _4
-                        Trace::Result &, result,
+      starget->get_pattern(de, d, result.get_params().get_unobstructed());
+    }
 
-      {
-        Math::Vector3 r = _2.transform(i);  // pattern point on target surface
-        Math::Vector3 direction;
-        Math::Vector3 position;
+    void SourcePoint::generate_pattern_rays(Trace::Result &result, const Surface &target,
+                                            const std::vector<Math::Vector3> &pattern,
+                                            SourceInfinityMode mode, const Math::Vector3 &pos_dir,
+                                            const std::vector<Light::SpectralLine> &spectrum) const
+    {
+      GOPTICAL_FOREACH(l, spectrum)
+        result.add_ray_wavelen(l->get_wavelen());
 
-        switch (mode)
-          {
-          case (SourceAtFiniteDistance):
-            position = Math::vector3_0;
-            direction = r.normalized();
-            break;
+      double rlen = result.get_params().get_lost_ray_length();
+      const Math::Transform<3> &t = get_local_transform();
 
-          case (SourceAtInfinity):
-            direction = Math::vector3_001;
-            position = _1.pl_ln_intersect(Math::VectorPair3(r, direction));
-            break;
-          }
+      const Material::Base *mat
+        = _mat.valid() ? _mat.ptr() : &get_system()->get_environment_proxy();
 
-        GOPTICAL_FOREACH(l, _0->_spectrum)
-          {
-            Trace::Ray &r = _4.new_ray();
+      switch (mode)
+        {
+        case SourceAtFiniteDistance: {
+          source_point_rays_s<SourceAtFiniteDistance> gen;
+
+          gen._source = this;
+          gen._pos_dir = Math::VectorPair3(t.transform(pos_dir), Math::vector3_001);
+          gen._t = &target.get_transform_to(*this);
+          gen._mat = mat;
+          gen._result = &result;
+          gen.init_spectrum(_sampling, spectrum);
+
+          GOPTICAL_FOREACH(i, pattern)
+            gen.add(*i);
+          return;
+        }
 
-            // generated rays use source coordinates
-            r.direction() = direction;
-            r.origin() = position;
+        case SourceAtInfinity: {
+          source_point_rays_s<SourceAtInfinity> gen;
+          Math::Vector3 dir = t.transform_linear(pos_dir).normalized();
 
-            r.set_creator(_0);
-            r.set_intensity(l->get_intensity()); // FIXME depends on distance from source and pattern density
-            r.set_wavelen(l->get_wavelen());
-            r.set_material(_3);
-          }
-      });
+          gen._source = this;
+          gen._pos_dir = Math::VectorPair3(target.get_position(*this) - dir * rlen, dir);
+          gen._t = &target.get_transform_to(*this);
+          gen._mat = mat;
+          gen._result = &result;
+          gen.init_spectrum(_sampling, spectrum);
 
-      starget->get_pattern(de, d, result.get_params().get_unobstructed());
+          GOPTICAL_FOREACH(i, pattern)
+            gen.add(*i);
+          return;
+        }
+        }
     }
-        
+
     void SourcePoint::generate_rays_simple(Trace::Result &result,
                                            const targets_t &entry) const
     {
@@ -27,6 +27,7 @@
 #include <Goptical/Trace/Result>
 #include <Goptical/Trace/Params>
 #include <Goptical/Trace/Ray>
+#include <Goptical/Trace/RayPacket>
 
 #include <Goptical/Math/Vector>
 #include <Goptical/Math/VectorPair>
@@ -56,38 +57,35 @@ namespace _Goptical {
       _external_radius = r * 2.0;
     }
 
-    bool Stop::intersect(const Trace::Params &params,
-                         Math::VectorPair3 &intersect,
-                         const Math::VectorPair3 &ray) const
+    bool Stop::intercept_test(const Trace::Params &params,
+                              const Math::Vector3 &point) const
     {
-      if (!get_curve().intersect(intersect.origin(), ray))
-        return false;
-
-      Math::Vector2 v(intersect.origin().project_xy());
+      Math::Vector2 v(point.project_xy());
 
       if (v.len() > _external_radius)
         return false;
 
       bool ir = _intercept_reemit || params.is_sequential();
 
-      if (!ir && get_shape().inside(v))
-        return false;
-
-      get_curve().normal(intersect.normal(), intersect.origin());
-      if (ray.direction().z() < 0)
-        intersect.normal() = -intersect.normal();
+      return ir || !get_shape().inside(v);
+    }
 
-      return true;
+    double Stop::get_intersect_radius(const Trace::Params &) const
+    {
+      return _external_radius;
     }
 
-    inline void Stop::trace_ray_simple(Trace::Result &result, Trace::Ray &incident,
-                                       const Math::VectorPair3 &local, const Math::VectorPair3 &intersect) const
+    inline bool Stop::reemit_test(bool sequential, const Math::VectorPair3 &intersect) const
     {
-      Math::Vector2 v = intersect.origin().project_xy();
+      bool ir = _intercept_reemit || sequential;
 
-      bool ir = _intercept_reemit || result.get_params().is_sequential();
+      return ir && get_shape().inside(intersect.origin().project_xy());
+    }
 
-      if (ir && get_shape().inside(v))
+    inline void Stop::trace_ray_simple(Trace::Result &result, Trace::Ray &incident,
+                                       const Math::VectorPair3 &, const Math::VectorPair3 &intersect) const
+    {
+      if (reemit_test(result.get_params().is_sequential(), intersect))
         {
           // reemit incident ray
           Trace::Ray &r = result.new_ray();
@@ -109,6 +107,24 @@ namespace _Goptical {
       trace_ray_simple(result, incident, local, intersect);
     }
 
+    void Stop::trace_packet_simple(Trace::RayPacket &input, unsigned int index,
+                                   const Math::VectorPair3 &, const Math::VectorPair3 &intersect,
+                                   Trace::RayPacket &output) const
+    {
+      // rays packets are only traced in sequential mode
+      if (reemit_test(true, intersect))
+        output.add_ray(intersect.origin(), input.get_direction(index),
+                       input.get_wavelen(index), input.get_intensity(index),
+                       input.get_material(index), index);
+    }
+
+    void Stop::trace_packet_intensity(Trace::RayPacket &input, unsigned int index,
+                                      const Math::VectorPair3 &local, const Math::VectorPair3 &intersect,
+                                      Trace::RayPacket &output) const
+    {
+      trace_packet_simple(input, index, local, intersect, output);
+    }
+
     template <Trace::IntensityMode m>
     inline void Stop::process_rays_(Trace::Result &result,
                                     Trace::rays_queue_t *input) const
@@ -121,7 +137,9 @@ namespace _Goptical {
           const Math::Transform<3> &t = ray.get_creator()->get_transform_to(*this);
           Math::VectorPair3 local(t.transform_line(ray));
 
-          if (get_curve().intersect(intersect.origin(), local))
+          Curve::Base::set_intersect_hint_key(this);
+
+          if (get_curve().intersect_bounded(intersect.origin(), local, _external_radius))
             {
               if (intersect.origin().project_xy().len() < _external_radius)
                 {
@@ -156,6 +174,18 @@ namespace _Goptical {
       process_rays_<Trace::PolarizedTrace>(result, input);
     }
 
+    Math::VectorPair3 Stop::get_bounding_box() const
+    {
+      Math::VectorPair2 sb(Math::Vector2(-_external_radius),
+                           Math::Vector2(_external_radius));
+      double z0, z1;
+
+      get_curve().sagitta_range(sb, z0, z1);
+
+      return Math::VectorPair3(Math::Vector3(sb[0], z0),
+                               Math::Vector3(sb[1], z1));
+    }
+
     void Stop::draw_3d_e(Io::Renderer &r, const Element *ref) const
     {
       r.group_begin();
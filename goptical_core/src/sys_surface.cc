@@ -23,6 +23,8 @@
 */
 
 
+#include <algorithm>
+
 #include <Goptical/Sys/Surface>
 #include <Goptical/Sys/Element>
 #include <Goptical/Material/Base>
@@ -40,6 +42,8 @@
 #include <Goptical/Trace/Distribution>
 #include <Goptical/Trace/Ray>
 #include <Goptical/Trace/Result>
+#include <Goptical/Trace/RayPacket>
+#include <Goptical/Trace/SpectralTable>
 #include <Goptical/Trace/Params>
 
 #include <Goptical/Io/Renderer>
@@ -99,11 +103,15 @@ namespace _Goptical {
 
     bool Surface::intersect(const Trace::Params &params, Math::VectorPair3 &pt, const Math::VectorPair3 &ray) const
     {
-      if (!_curve->intersect(pt.origin(), ray))
+      const double r = get_intersect_radius(params);
+
+      Curve::Base::set_intersect_hint_key(this);
+
+      if (!(r > 0 ? _curve->intersect_bounded(pt.origin(), ray, r)
+                  : _curve->intersect(pt.origin(), ray)))
         return false;
 
-      if (!params.get_unobstructed() &&
-          !_shape->inside(pt.origin().project_xy()))
+      if (!intercept_test(params, pt.origin()))
         return false;
 
       _curve->normal(pt.normal(), pt.origin());
@@ -113,6 +121,16 @@ namespace _Goptical {
       return true;
     }
 
+    bool Surface::intercept_test(const Trace::Params &params, const Math::Vector3 &point) const
+    {
+      return params.get_unobstructed() || _shape->inside(point.project_xy());
+    }
+
+    double Surface::get_intersect_radius(const Trace::Params &params) const
+    {
+      return params.get_unobstructed() ? 0.0 : _shape->max_radius();
+    }
+
     template <Trace::IntensityMode m>
     void Surface::trace_ray(Trace::Result &result, Trace::Ray &incident,
                             const Math::VectorPair3 &local, const Math::VectorPair3 &pt) const
@@ -128,9 +146,14 @@ namespace _Goptical {
       else
         {
           // apply absorbtion from current material
+          const Material::Base *mat = incident.get_material();
+          double wl = incident.get_wavelen();
+          double t;
+
           double i_intensity = incident.get_intensity() *
-            incident.get_material()->get_internal_transmittance(
-                          incident.get_wavelen(), incident.get_len());
+            (result.get_spectral_table().get_internal_transmittance(mat, wl, t)
+             ? pow(t, incident.get_len())
+             : mat->get_internal_transmittance(wl, incident.get_len()));
 
           incident.set_intercept_intensity(i_intensity);
 
@@ -194,6 +217,159 @@ namespace _Goptical {
       process_rays_<Trace::PolarizedTrace>(result, input);
     }
 
+    void Surface::trace_packet_simple(Trace::RayPacket &, unsigned int,
+                                      const Math::VectorPair3 &, const Math::VectorPair3 &,
+                                      Trace::RayPacket &) const
+    {
+      throw Error("simple packet ray trace not handled by this surface class");
+    }
+
+    void Surface::trace_packet_intensity(Trace::RayPacket &, unsigned int,
+                                         const Math::VectorPair3 &, const Math::VectorPair3 &,
+                                         Trace::RayPacket &) const
+    {
+      throw Error("intensity packet ray trace not handled by this surface class");
+    }
+
+    void Surface::trace_packet_polarized(Trace::RayPacket &, unsigned int,
+                                         const Math::VectorPair3 &, const Math::VectorPair3 &,
+                                         Trace::RayPacket &) const
+    {
+      throw Error("polarized packet ray trace not handled by this surface class");
+    }
+
+    template <Trace::IntensityMode m>
+    inline void Surface::trace_packet_ray(Trace::RayPacket &input, unsigned int index,
+                                          const Math::VectorPair3 &local, const Math::VectorPair3 &pt,
+                                          Trace::RayPacket &output) const
+    {
+      double len = (pt.origin() - local.origin()).len();
+
+      if (m == Trace::SimpleTrace)
+        {
+          input.set_intercept(index, pt.origin(), len, 1.0);
+          return trace_packet_simple(input, index, local, pt, output);
+        }
+      else
+        {
+          // apply absorbtion from current material
+          const Material::Base *mat = input.get_material(index);
+          const Trace::SpectralTable *table = input.get_spectral_table();
+          double wl = input.get_wavelen(index);
+          double t;
+
+          double i_intensity = input.get_intensity(index) *
+            (table && table->get_internal_transmittance(mat, wl, t)
+             ? pow(t, len)
+             : mat->get_internal_transmittance(wl, len));
+
+          input.set_intercept(index, pt.origin(), len, i_intensity);
+
+          if (i_intensity < _discard_intensity)
+            return;
+
+          if (m == Trace::IntensityTrace)
+            return trace_packet_intensity(input, index, local, pt, output);
+          else if (m == Trace::PolarizedTrace)
+            return trace_packet_polarized(input, index, local, pt, output);
+          else
+            abort();
+        }
+    }
+
+    template <Trace::IntensityMode m>
+    inline void Surface::process_packet_(const Trace::Params &params, Trace::RayPacket &input,
+                                         unsigned int first, unsigned int last,
+                                         Trace::RayPacket &output) const
+    {
+      static const unsigned int batch_size = 64;
+
+      double o[3][batch_size], d[3][batch_size], p[3][batch_size], n[3][batch_size];
+      double * const origin[3] = { o[0], o[1], o[2] };
+      double * const direction[3] = { d[0], d[1], d[2] };
+      double * const point[3] = { p[0], p[1], p[2] };
+      double * const normal[3] = { n[0], n[1], n[2] };
+      unsigned int index[batch_size];
+      bool hit[batch_size];
+
+      // all rays in packet share the same creator element
+      const Math::Transform<3> &t = input.get_creator()->get_transform_to(*this);
+
+      const double r = get_intersect_radius(params);
+
+      for (unsigned int b = first; b < last; b += batch_size)
+        {
+          unsigned int count = std::min(batch_size, last - b);
+
+          // get rays in surface local coordinates
+          for (unsigned int i = 0; i < count; i++)
+            {
+              Math::VectorPair3 local(t.transform_line(input.get_ray(b + i)));
+
+              for (unsigned int j = 0; j < 3; j++)
+                {
+                  o[j][i] = local.origin()[j];
+                  d[j][i] = local.direction()[j];
+                }
+            }
+
+          Curve::Base::set_intersect_hint_key(this);
+          _curve->intersect_batch(point, hit, origin, direction, count, r);
+
+          // keep intercepted rays, pack intersection points
+          unsigned int hit_count = 0;
+
+          for (unsigned int i = 0; i < count; i++)
+            {
+              if (!hit[i] || !intercept_test(params, Math::Vector3(p[0][i], p[1][i], p[2][i])))
+                continue;
+
+              for (unsigned int j = 0; j < 3; j++)
+                p[j][hit_count] = p[j][i];
+
+              index[hit_count++] = i;
+            }
+
+          _curve->normal_batch(normal, point, hit_count);
+
+          for (unsigned int k = 0; k < hit_count; k++)
+            {
+              unsigned int i = index[k];
+
+              Math::VectorPair3 local(Math::Vector3(o[0][i], o[1][i], o[2][i]),
+                                      Math::Vector3(d[0][i], d[1][i], d[2][i]));
+              Math::VectorPair3 pt(Math::Vector3(p[0][k], p[1][k], p[2][k]),
+                                   Math::Vector3(n[0][k], n[1][k], n[2][k]));
+
+              if (local.direction().z() < 0)
+                pt.normal() = -pt.normal();
+
+              trace_packet_ray<m>(input, b + i, local, pt, output);
+            }
+        }
+    }
+
+    void Surface::process_packet_simple(const Trace::Params &params, Trace::RayPacket &input,
+                                        unsigned int first, unsigned int last,
+                                        Trace::RayPacket &output) const
+    {
+      process_packet_<Trace::SimpleTrace>(params, input, first, last, output);
+    }
+
+    void Surface::process_packet_intensity(const Trace::Params &params, Trace::RayPacket &input,
+                                           unsigned int first, unsigned int last,
+                                           Trace::RayPacket &output) const
+    {
+      process_packet_<Trace::IntensityTrace>(params, input, first, last, output);
+    }
+
+    void Surface::process_packet_polarized(const Trace::Params &params, Trace::RayPacket &input,
+                                           unsigned int first, unsigned int last,
+                                           Trace::RayPacket &output) const
+    {
+      process_packet_<Trace::PolarizedTrace>(params, input, first, last, output);
+    }
+
     Io::Rgb Surface::get_color(const Io::Renderer &r) const
     {
       return r.get_style_color(Io::StyleSurface);
@@ -202,16 +378,32 @@ namespace _Goptical {
     Math::VectorPair3 Surface::get_bounding_box() const
     {
       Math::VectorPair2 sb = _shape->get_bounding_box();
+      double z0, z1;
+
+      _curve->sagitta_range(sb, z0, z1);
+
+      return Math::VectorPair3(Math::Vector3(sb[0], z0),
+                               Math::Vector3(sb[1], z1));
+    }
+
+    void Surface::prepare() const
+    {
+      _curve->prepare();
+      _shape->prepare();
+    }
+
+    bool Surface::get_intersect_box(Math::VectorPair3 &box) const
+    {
+      Math::VectorPair3 b = get_bounding_box();
+      Math::VectorPair2 sb(b[0].project_xy(), b[1].project_xy());
+      double z0, z1;
 
-      // FIXME we assume curve is symetric here
-      double z = 0;
-      double ms = _curve->sagitta(Math::Vector2(_shape->max_radius()));
+      bool exact = _curve->intersect_range(sb, z0, z1);
 
-      if (z > ms)
-        std::swap(z, ms);
+      box = Math::VectorPair3(Math::Vector3(sb[0], z0),
+                              Math::Vector3(sb[1], z1));
 
-      return Math::VectorPair3(Math::Vector3(sb[0].x(), sb[0].y(), z),
-                                 Math::Vector3(sb[1].x(), sb[1].y(), ms));
+      return exact;
     }
 
     void Surface::draw_3d_e(Io::Renderer &r, const Element *ref) const
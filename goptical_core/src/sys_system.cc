@@ -24,6 +24,7 @@
 
 
 #include <Goptical/Sys/System>
+#include <Goptical/Sys/FrozenSystem>
 #include <Goptical/Sys/Group>
 #include <Goptical/Sys/Container>
 
@@ -37,6 +38,11 @@
 #include <Goptical/Material/Air>
 #include <Goptical/Material/Proxy>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <cmath>
+
 namespace _Goptical {
 
   namespace Sys {
@@ -45,13 +51,22 @@ namespace _Goptical {
       : _version(0),
         _env_proxy(Material::air),
         _tracer_params(),
-        _e_count(0),
         _index_map(),
-        _transform_cache()
+        _index_free(),
+        _index_gen(),
+        _transform_cache(),
+        _transform_cache_used(0),
+        _transform_pool(),
+        _transform_free(),
+        _bvh_nodes(),
+        _bvh_surfaces(),
+        _bvh_unbounded(),
+        _bvh_version(-1)
     {
-      transform_cache_resize(1);
       // index 0 is reserved for global coordinates transformations
-      _index_map[0] = (Element*)1;
+      _index_map.push_back((Element*)1);
+      _index_gen.push_back(0);
+      transform_cache_flush();
     }
 
     System::~System()
@@ -88,132 +103,168 @@ namespace _Goptical {
 
     const Math::Transform<3> & System::transform_l2g_cache_update(const Element &element) const
     {
-      Math::Transform<3> * & e = transform_cache_entry(element.id(), 0);
+      Math::Transform<3> t(element._transform);
+      const Element *i1 = &element;
 
-      if (!e)
+      while (const Element *i2 = dynamic_cast<Group *>(i1->_container))
         {
-          Math::Transform<3> t(element._transform);
-          const Element *i1 = &element;
-
-          while (const Element *i2 = dynamic_cast<Group *>(i1->_container))
-            {
-              t.compose(i2->_transform);
+          t.compose(i2->_transform);
 
-              i1 = i2;
-            }
-
-          assert(!e);
-          e = new Math::Transform<3>(t);
+          i1 = i2;
         }
 
-      return *e;
+      Math::Transform<3> &e = transform_cache_insert(element.id(), 0);
+      e = t;
+
+      return e;
     }
 
     const Math::Transform<3> & System::transform_g2l_cache_update(const Element &element) const
     {
-      Math::Transform<3> * & e = transform_cache_entry(0, element.id());
+      const Math::Transform<3> &t = get_global_transform(element);
+      Math::Transform<3> &e = transform_cache_insert(0, element.id());
 
-      if (!e)
-        e = new Math::Transform<3>(transform_l2g_cache_update(element).inverse());
+      e = t.inverse();
 
-      return *e;
+      return e;
     }
 
     const Math::Transform<3> & System::transform_cache_update(const Element &from, const Element &to) const
     {
       assert(&from != &to);
 
-      Math::Transform<3> * & e = transform_cache_entry(from.id(), to.id());
+      const Math::Transform<3> &t1 = get_global_transform(from);
+      const Math::Transform<3> &t2 = get_global_transform(to);
+      Math::Transform<3> &e = transform_cache_insert(from.id(), to.id());
 
-      if (!e)
-        {
-          const Math::Transform<3> &t1 = transform_l2g_cache_update(from);
-          const Math::Transform<3> &t2 = transform_l2g_cache_update(to);
+      e = t1;
+      e.compose(t2.inverse());
 
-          if (!e)
-            {
-              e = new Math::Transform<3>(t1);
-              e->compose(t2.inverse());
-            }
-        }
-
-      return *e;
+      return e;
     }
 
-    void System::transform_cache_flush(const Element &element)
+    Math::Transform<3> & System::transform_cache_insert(unsigned int from, unsigned int to) const
     {
-      for (unsigned int x = 0; x < _e_count; x++)
+      System *self = const_cast<System *>(this);
+
+      // keep hash table load factor below 1/2
+      if ((_transform_cache_used + 1) * 2 > _transform_cache.size())
+        self->transform_cache_rehash(_transform_cache.size() * 2);
+
+      unsigned int mask = _transform_cache.size() - 1;
+      unsigned int i = transform_cache_hash(from, to) & mask;
+
+      while (_transform_cache[i]._transform &&
+             (_transform_cache[i]._from != from || _transform_cache[i]._to != to))
+        i = (i + 1) & mask;
+
+      transform_cache_entry_s &e = self->_transform_cache[i];
+
+      if (!e._transform)
         {
-          if (Math::Transform<3> * & t = transform_cache_entry(element.id(), x))
+          // use storage of an outdated transform if available
+          if (_transform_free.empty())
             {
-              delete t;
-              t = 0;
+              e._transform = &self->_transform_pool.create();
             }
-
-          if (Math::Transform<3> * & t = transform_cache_entry(x, element.id()))
+          else
             {
-              delete t;
-              t = 0;
+              e._transform = _transform_free.back();
+              self->_transform_free.pop_back();
             }
+
+          e._from = from;
+          e._to = to;
+          self->_transform_cache_used++;
         }
-    }
 
-    void System::transform_cache_flush()
-    {
-      for (unsigned int x = 0; x < _e_count; x++)
-        for (unsigned int y = 0; y < _e_count; y++)
-          if (Math::Transform<3> * & t = transform_cache_entry(x, y))
-            {
-              delete t;
-              t = 0;
-            }
+      e._from_gen = _index_gen[from];
+      e._to_gen = _index_gen[to];
+
+      return *e._transform;
     }
 
-    void System::transform_cache_resize(unsigned int newsize)
+    void System::transform_cache_rehash(unsigned int newsize)
     {
-      unsigned int oldsize = _e_count;
+      transform_cache_t old;
+      unsigned int used = 0;
+
+      old.swap(_transform_cache);
 
-      if (oldsize < newsize)
+      // outdated entries are dropped, do not grow if enough were found
+      for (unsigned int i = 0; i < old.size(); i++)
         {
-          _index_map.resize(newsize, 0);
-          _transform_cache.resize(newsize * newsize, 0);
+          const transform_cache_entry_s &e = old[i];
 
-          for (int y = oldsize - 1; y > 0; y--)
-            {
-              // move data
-              for (int x = oldsize - 1; x >= 0; x--)
-                {
-                  _transform_cache[y * newsize + x] =
-                    _transform_cache[y * oldsize + x];
+          if (e._transform && e._from_gen == _index_gen[e._from] &&
+              e._to_gen == _index_gen[e._to])
+            used++;
+        }
 
-                  _transform_cache[y * oldsize + x] = 0;
-                }
-            }
+      while (newsize > 16 && (used + 1) * 4 <= newsize)
+        newsize /= 2;
 
-          _e_count = newsize;
-        }
-      else
+      transform_cache_entry_s empty = { 0, 0, 0, 0, 0 };
+      _transform_cache.assign(newsize, empty);
+      _transform_cache_used = used;
+
+      for (unsigned int i = 0; i < old.size(); i++)
         {
-          // FIXME handle cache downsize
+          const transform_cache_entry_s &e = old[i];
+
+          if (!e._transform)
+            continue;
+
+          if (e._from_gen != _index_gen[e._from] ||
+              e._to_gen != _index_gen[e._to])
+            {
+              _transform_free.push_back(e._transform);
+              continue;
+            }
+
+          unsigned int mask = newsize - 1;
+          unsigned int j = transform_cache_hash(e._from, e._to) & mask;
+
+          while (_transform_cache[j]._transform)
+            j = (j + 1) & mask;
+
+          _transform_cache[j] = e;
         }
+    }
+
+    void System::transform_cache_flush(const Element &element)
+    {
+      // cached transforms involving this id become outdated
+      _index_gen[element.id()]++;
+    }
+
+    void System::transform_cache_flush()
+    {
+      transform_cache_entry_s empty = { 0, 0, 0, 0, 0 };
 
+      _transform_cache.assign(16, empty);
+      _transform_cache_used = 0;
+      _transform_free.clear();
+      _transform_pool.clear();
     }
 
     unsigned int System::index_get(Element &element)
     {
-      std::vector<Element*>::iterator i;
       unsigned int index;
 
-      i = std::find(_index_map.begin(), _index_map.end(), (Element*)0);
-
-      if (i == _index_map.end())
+      if (_index_free.empty())
         {
-          index = _e_count;
-          transform_cache_resize(index + 1);
+          index = _index_map.size();
+          _index_map.push_back(0);
+          _index_gen.push_back(0);
         }
       else
         {
-          index = _index_map.begin() - i;
+          // reuse lowest free id
+          std::pop_heap(_index_free.begin(), _index_free.end(),
+                        std::greater<unsigned int>());
+          index = _index_free.back();
+          _index_free.pop_back();
         }
 
       _index_map[index] = &element;
@@ -225,16 +276,24 @@ namespace _Goptical {
     {
       transform_cache_flush(element);
       _index_map[element.id()] = 0;
+      _index_free.push_back(element.id());
+      std::push_heap(_index_free.begin(), _index_free.end(),
+                     std::greater<unsigned int>());
     }
 
     void System::transform_cache_dump(std::ostream &o) const
     {
-      o << "System transform cache size is " << _e_count << "x" << _e_count << std::endl;
+      o << "System transform cache size is " << _transform_cache.size() << std::endl;
 
-      for (unsigned int from = 0; from < _e_count; from++)
-        for (unsigned int to = 0; to < _e_count; to++)
-          if (const Math::Transform<3> *t = _transform_cache[from * _e_count + to])
-            o << "from " << from << " to " << to << ":" << std::endl << *t << std::endl;
+      for (unsigned int i = 0; i < _transform_cache.size(); i++)
+        {
+          const transform_cache_entry_s &e = _transform_cache[i];
+
+          if (e._transform && e._from_gen == _index_gen[e._from] &&
+              e._to_gen == _index_gen[e._to])
+            o << "from " << e._from << " to " << e._to << ":" << std::endl
+              << *e._transform << std::endl;
+        }
     }
 
     const Surface & System::get_entrance_pupil() const
@@ -255,50 +314,466 @@ namespace _Goptical {
       return *res;
     }
 
-    /** FIXME write an optimized version of this function which uses
-        some kind of data structure (bsp tree?) */
+    struct System::bvh_item_s
+    {
+      Math::VectorPair3 _box;
+      Math::Vector3     _center;
+      Surface           *_surface;
+    };
+
+    /** compare surfaces bounding box centers along an axis */
+    struct System::bvh_item_cmp
+    {
+      bvh_item_cmp(unsigned int axis)
+        : _axis(axis)
+      {
+      }
+
+      bool operator()(const bvh_item_s &a, const bvh_item_s &b) const
+      {
+        return a._center[_axis] < b._center[_axis];
+      }
+
+      unsigned int _axis;
+    };
+
+    void System::bvh_build(unsigned int node, std::vector<bvh_item_s> &items,
+                           unsigned int first, unsigned int last)
+    {
+      Math::VectorPair3 box(items[first]._box);
+      Math::VectorPair3 cbox(items[first]._center, items[first]._center);
+
+      for (unsigned int i = first + 1; i < last; i++)
+        for (unsigned int k = 0; k < 3; k++)
+          {
+            box[0][k] = std::min(box[0][k], items[i]._box[0][k]);
+            box[1][k] = std::max(box[1][k], items[i]._box[1][k]);
+            cbox[0][k] = std::min(cbox[0][k], items[i]._center[k]);
+            cbox[1][k] = std::max(cbox[1][k], items[i]._center[k]);
+          }
+
+      _bvh_nodes[node]._box = box;
+
+      if (last - first <= 4)
+        {
+          // leaf node
+          _bvh_nodes[node]._first = _bvh_surfaces.size();
+          _bvh_nodes[node]._count = last - first;
+
+          for (unsigned int i = first; i < last; i++)
+            _bvh_surfaces.push_back(items[i]._surface);
+
+          return;
+        }
+
+      // split on median along largest centers extent axis
+      Math::Vector3 size(cbox[1] - cbox[0]);
+      unsigned int axis = 0;
+
+      for (unsigned int k = 1; k < 3; k++)
+        if (size[k] > size[axis])
+          axis = k;
+
+      unsigned int middle = (first + last) / 2;
+
+      std::nth_element(items.begin() + first, items.begin() + middle,
+                       items.begin() + last, bvh_item_cmp(axis));
+
+      unsigned int child = _bvh_nodes.size();
+      _bvh_nodes.resize(child + 2);
+
+      _bvh_nodes[node]._first = child;
+      _bvh_nodes[node]._count = 0;
+
+      bvh_build(child, items, first, middle);
+      bvh_build(child + 1, items, middle, last);
+    }
+
+    /** relative safety margin added to bounding boxes, covers
+        rounding errors of global transforms and curve intersection */
+    static const double bvh_margin = 1e-6;
+
+    bool System::bvh_surface_box(Surface *s, Math::VectorPair3 &box)
+    {
+      // global bounding box from local bounding box corners
+      Math::VectorPair3 lbox;
+      // curves which can only estimate their range are tested linearly
+      bool exact = s->get_intersect_box(lbox);
+      const Math::Transform<3> &t = get_global_transform(*s);
+      // shapes without bounds like Shape::Infinite report an empty box
+      bool finite = lbox[0].x() < lbox[1].x() || lbox[0].y() < lbox[1].y();
+
+      for (unsigned int c = 0; c < 8; c++)
+        {
+          Math::Vector3 p(t.transform(Math::Vector3(lbox[c & 1].x(),
+                                                    lbox[(c >> 1) & 1].y(),
+                                                    lbox[c >> 2].z())));
+
+          for (unsigned int k = 0; k < 3; k++)
+            {
+              if (!(fabs(p[k]) < std::numeric_limits<double>::max()))
+                finite = false;
+
+              if (c == 0 || p[k] < box[0][k])
+                box[0][k] = p[k];
+              if (c == 0 || p[k] > box[1][k])
+                box[1][k] = p[k];
+            }
+        }
+
+      if (!finite || !exact)
+        return false;
+
+      for (unsigned int k = 0; k < 3; k++)
+        {
+          double pad = bvh_margin * (1.0 + std::max(fabs(box[0][k]), fabs(box[1][k])));
+
+          box[0][k] -= pad;
+          box[1][k] += pad;
+        }
+
+      return true;
+    }
+
+    void System::bvh_update()
+    {
+      std::vector<bvh_item_s> items;
+
+      _bvh_nodes.clear();
+      _bvh_surfaces.clear();
+      _bvh_unbounded.clear();
+
+      for (unsigned int i = 1; i < _index_map.size(); i++)
+        {
+          Element *j = _index_map[i];
+
+          if (!j || !j->is_enabled())
+            continue;
+
+          // global transforms used by colide_next
+          get_global_transform(*j);
+
+          Surface *s = dynamic_cast<Surface*>(j);
+
+          if (!s)
+            continue;
+
+          bvh_item_s item;
+
+          if (!bvh_surface_box(s, item._box))
+            {
+              _bvh_unbounded.push_back(s);
+              continue;
+            }
+
+          item._center = (item._box[0] + item._box[1]) / 2.0;
+          item._surface = s;
+          items.push_back(item);
+        }
+
+      if (!items.empty())
+        {
+          _bvh_nodes.resize(1);
+          bvh_build(0, items, 0, items.size());
+        }
+
+      _bvh_version = _version;
+    }
+
+    bool System::bvh_refit()
+    {
+      // children nodes are always stored after their parent
+      for (unsigned int i = _bvh_nodes.size(); i-- > 0; )
+        {
+          bvh_node_s &n = _bvh_nodes[i];
+          Math::VectorPair3 box;
+
+          if (n._count)
+            {
+              for (unsigned int j = 0; j < n._count; j++)
+                {
+                  if (!bvh_surface_box(_bvh_surfaces[n._first + j], box))
+                    return false;
+
+                  if (j == 0)
+                    n._box = box;
+                  else
+                    for (unsigned int k = 0; k < 3; k++)
+                      {
+                        n._box[0][k] = std::min(n._box[0][k], box[0][k]);
+                        n._box[1][k] = std::max(n._box[1][k], box[1][k]);
+                      }
+                }
+            }
+          else
+            {
+              const Math::VectorPair3 &a = _bvh_nodes[n._first]._box;
+              const Math::VectorPair3 &b = _bvh_nodes[n._first + 1]._box;
+
+              for (unsigned int k = 0; k < 3; k++)
+                {
+                  n._box[0][k] = std::min(a[0][k], b[0][k]);
+                  n._box[1][k] = std::max(a[1][k], b[1][k]);
+                }
+            }
+        }
+
+      return true;
+    }
+
+    FrozenSystem System::freeze() const
+    {
+      return freeze(_tracer_params);
+    }
+
+    FrozenSystem System::freeze(const Trace::Params &params) const
+    {
+      _env_proxy.prepare();
+
+      for (unsigned int i = 1; i < _index_map.size(); i++)
+        if (const Element *e = _index_map[i])
+          e->prepare();
+
+      transform_cache_prepare(params);
+
+      colide_prepare();
+
+      return FrozenSystem(*this);
+    }
+
+    void System::transform_cache_prepare(const Trace::Params &params) const
+    {
+      transform_cache_walk(params, true);
+    }
+
+    bool System::transform_cache_ready(const Trace::Params &params) const
+    {
+      return transform_cache_walk(params, false);
+    }
+
+    bool System::transform_cache_walk(const Trace::Params &params, bool update) const
+    {
+      // rays are moved between elements through global coordinates
+      for (unsigned int i = 1; i < _index_map.size(); i++)
+        {
+          const Element *e = _index_map[i];
+
+          if (e && e->is_enabled() &&
+              !(transform_cache_need(e, 0, update) &&
+                transform_cache_need(0, e, update)))
+            return false;
+        }
+
+      const Element *target = 0;
+
+      if (params.is_sequential())
+        {
+          const Trace::Sequence &seq = params.get_sequence();
+
+          for (unsigned int i = 0; i < seq.get_element_count(); i++)
+            {
+              const Element &e = seq.get_element(i);
+
+              if (dynamic_cast<const Source *>(&e))
+                continue;
+
+              // sources aim at first non source element
+              if (!target)
+                target = &e;
+
+              if (!e.is_enabled())
+                continue;
+
+              // rays come from previous enabled element, or from any
+              // source right before it as other sources are ignored
+              // in batch configurations
+              for (unsigned int j = i; j-- > 0; )
+                {
+                  const Element &p = seq.get_element(j);
+
+                  if (!p.is_enabled() || &p == &e)
+                    continue;
+
+                  if (!transform_cache_need(&p, &e, update))
+                    return false;
+
+                  if (!dynamic_cast<const Source *>(&p))
+                    break;
+                }
+            }
+        }
+      else
+        {
+          // sources aim at entrance pupil
+          target = _entrance.valid() ? _entrance.ptr() : find<OpticalSurface>();
+
+          if (!target)
+            target = find<Surface>();
+        }
+
+      if (!target)
+        return true;
+
+      for (unsigned int i = 1; i < _index_map.size(); i++)
+        {
+          const Source *s = dynamic_cast<const Source *>(_index_map[i]);
+
+          if (s && s->is_enabled() && s != target &&
+              !transform_cache_need(target, s, update))
+            return false;
+        }
+
+      return true;
+    }
+
+    void System::colide_prepare() const
+    {
+      System *self = const_cast<System*>(this);
+
+      // curves and shapes may change without a system version update,
+      // refit boxes of the existing hierarchy in this case
+      if (_bvh_version != _version || !self->bvh_refit())
+        self->bvh_update();
+    }
+
+    /** test global ray against surface and keep closest intersection */
+    static inline void colide_test(const Trace::Params &params, const Element *origin,
+                                   const Math::VectorPair3 &gray, Surface *s,
+                                   Surface * &e, double &min_dist,
+                                   Math::VectorPair3 &intersect,
+                                   Math::VectorPair3 &local)
+    {
+      if (s == origin)
+        return;
+
+      Math::VectorPair3 slocal(s->get_local_transform().transform_line(gray));
+      Math::VectorPair3 inter;
+
+      if (s->intersect(params, inter, slocal))
+        {
+          double        dist = (inter.origin() - slocal.origin()).len();
+
+          // keep element order on equal distance, like a linear search would
+          if (min_dist > dist || (e && min_dist == dist && s->id() < e->id()))
+            {
+              min_dist = dist;
+              intersect = inter;
+              local = slocal;
+              e = s;
+            }
+        }
+    }
+
+    Surface *System::colide_next(const Trace::Params &params,
+                                 Math::VectorPair3 &intersect,
+                                 const Trace::Ray &ray) const
+    {
+      Math::VectorPair3 local;
+
+      return colide_next(params, intersect, local, ray);
+    }
+
     Surface *System::colide_next(const Trace::Params &params,
                                  Math::VectorPair3 &intersect,
+                                 Math::VectorPair3 &local,
                                  const Trace::Ray &ray) const
     {
       const Element *origin = ray.get_creator();
 
-      // test all elements and keep closest intersection
+      if (_bvh_version != _version)
+        const_cast<System*>(this)->bvh_update();
 
-      Surface *s, *e = 0;
-      Math::VectorPair3 inter;
+      // candidate surfaces local rays are computed from global ray so
+      // that only per element transforms are needed
+      Math::VectorPair3 gray(get_global_transform(*origin).transform_line(ray));
+
+      // test all candidate surfaces and keep closest intersection
+
+      Surface *e = 0;
       double    min_dist = std::numeric_limits<double>::max();
 
-      for (unsigned int i = 1; i <= get_element_count(); i++)
+      if (params.get_unobstructed())
         {
-          Element *j = &get_element(i);
+          // surface shapes are ignored, bounding boxes can not be used
+          for (unsigned int i = 1; i < _index_map.size(); i++)
+            {
+              Surface *s = dynamic_cast<Surface*>(_index_map[i]);
 
-          if (j == origin || !j->is_enabled())
-            continue;
+              if (s && s->is_enabled())
+                colide_test(params, origin, gray, s, e, min_dist, intersect, local);
+            }
+
+          return e;
+        }
+
+      for (unsigned int i = 0; i < _bvh_unbounded.size(); i++)
+        colide_test(params, origin, gray, _bvh_unbounded[i], e, min_dist, intersect, local);
+
+      if (_bvh_nodes.empty())
+        return e;
+
+      // traverse hierarchy in global coordinates
+      double inv[3];
+
+      for (unsigned int k = 0; k < 3; k++)
+        inv[k] = gray.direction()[k] != 0.0 ? 1.0 / gray.direction()[k] : 0.0;
+
+      unsigned int stack[64];
+      unsigned int sp = 0;
+
+      stack[sp++] = 0;
 
-          if ((s = dynamic_cast<Surface*>(j)))
+      while (sp)
+        {
+          const bvh_node_s &n = _bvh_nodes[stack[--sp]];
+          double tnear = 0.0;
+          double tfar = std::numeric_limits<double>::max();
+          bool miss = false;
+
+          // ray/box slab test
+          for (unsigned int k = 0; k < 3 && !miss; k++)
             {
-              const Math::Transform<3> &t = origin->get_transform_to(*s);
-              Math::VectorPair3 local(t.transform_line(ray));
+              double o = gray.origin()[k];
 
-              if (s->intersect(params, inter, local))
+              if (inv[k] == 0.0)
                 {
-                  double        dist = (inter.origin() - local.origin()).len();
-
-                  if (min_dist > dist)
-                    {
-                      min_dist = dist;
-                      intersect = inter;
-                      e = s;
-                    }
+                  miss = o < n._box[0][k] || o > n._box[1][k];
                 }
+              else
+                {
+                  double t0 = (n._box[0][k] - o) * inv[k];
+                  double t1 = (n._box[1][k] - o) * inv[k];
+
+                  if (t0 > t1)
+                    std::swap(t0, t1);
+
+                  tnear = std::max(tnear, t0);
+                  tfar = std::min(tfar, t1);
+                  miss = tnear > tfar;
+                }
+            }
+
+          // box beyond current closest intersection, with some margin
+          // for distance computed in local coordinates
+          if (miss || tnear * gray.direction().len() > min_dist * (1.0 + 1e-9) + 1e-9)
+            continue;
+
+          if (n._count)
+            {
+              for (unsigned int i = n._first; i < n._first + n._count; i++)
+                colide_test(params, origin, gray, _bvh_surfaces[i], e, min_dist, intersect, local);
+            }
+          else
+            {
+              assert(sp + 2 <= 64);
+              stack[sp++] = n._first + 1;
+              stack[sp++] = n._first;
             }
         }
 
       return e;
     }
 
-
   }
 
 }
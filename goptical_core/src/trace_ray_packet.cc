@@ -0,0 +1,102 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <Goptical/Trace/RayPacket>
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    RayPacket::RayPacket(const Sys::Element *creator)
+      : _creator(creator),
+        _intercept_element(0),
+        _spectral_table(0)
+    {
+    }
+
+    void RayPacket::clear()
+    {
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          _origin[j].clear();
+          _direction[j].clear();
+          _point[j].clear();
+        }
+
+      _wavelen.clear();
+      _intensity.clear();
+      _material.clear();
+      _parent.clear();
+      _len.clear();
+      _intercept_intensity.clear();
+      _lost.clear();
+    }
+
+    void RayPacket::reserve(unsigned int count)
+    {
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          _origin[j].reserve(count);
+          _direction[j].reserve(count);
+          _point[j].reserve(count);
+        }
+
+      _wavelen.reserve(count);
+      _intensity.reserve(count);
+      _material.reserve(count);
+      _parent.reserve(count);
+      _len.reserve(count);
+      _intercept_intensity.reserve(count);
+      _lost.reserve(count);
+    }
+
+    template <typename X>
+    static inline void append_array(std::vector<X> &to, const std::vector<X> &from)
+    {
+      to.insert(to.end(), from.begin(), from.end());
+    }
+
+    void RayPacket::append(const RayPacket &p)
+    {
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          append_array(_origin[j], p._origin[j]);
+          append_array(_direction[j], p._direction[j]);
+          append_array(_point[j], p._point[j]);
+        }
+
+      append_array(_wavelen, p._wavelen);
+      append_array(_intensity, p._intensity);
+      append_array(_material, p._material);
+      append_array(_parent, p._parent);
+      append_array(_len, p._len);
+      append_array(_intercept_intensity, p._intercept_intensity);
+      append_array(_lost, p._lost);
+    }
+
+  }
+
+}
+
@@ -23,11 +23,15 @@
 */
 
 
+#include <algorithm>
+
 #include <Goptical/Sys/System>
 #include <Goptical/Sys/Element>
 
 #include <Goptical/Trace/Ray>
 #include <Goptical/Trace/Result>
+#include <Goptical/Trace/RayPacket>
+#include <Goptical/Trace/CompactRay>
 
 #include <Goptical/Math/Vector>
 #include <Goptical/Math/VectorPair>
@@ -45,7 +49,21 @@ namespace _Goptical {
         _generated_queue(0),
         _sources(),
         _bounce_limit_count(0),
-        _system(0)
+        _system(0),
+        _shards(),
+        _packets(),
+        _packets_free(),
+        _packets_pending(false),
+        _compact(false),
+        _compact_rays(),
+        _compact_materials(),
+        _compact_queue(),
+        _spectral(),
+        _spectral_ptr(&_spectral),
+        _gqueue(),
+        _cqueue(),
+        _source_list(),
+        _targets()
     {
     }
 
@@ -78,32 +96,342 @@ namespace _Goptical {
               delete i->_generated;
               i->_generated = 0;
             }
+
+          delete i->_intercepted_index;
+          i->_intercepted_index = 0;
+
+          delete i->_generated_index;
+          i->_generated_index = 0;
         }
 
+      GOPTICAL_FOREACH(i, _shards)
+        delete *i;
+      _shards.clear();
+
+      GOPTICAL_FOREACH(i, _packets)
+        delete *i;
+      _packets.clear();
+
+      GOPTICAL_FOREACH(i, _packets_free)
+        delete *i;
+      _packets_free.clear();
+
+      reset();
+      _compact = false;
+    }
+
+    void Result::reset()
+    {
+      // keep packets in creation order for reuse by next trace
+      _packets_free.insert(_packets_free.end(), _packets.rbegin(), _packets.rend());
+      _packets.clear();
+      _packets_pending = false;
+
       _rays.clear();
       _sources.clear();
       _wavelengths.clear();
 
+      _compact_rays.clear();
+      _compact_materials.clear();
+
+      _spectral.clear();
+
       _bounce_limit_count = 0;
     }
 
-    void Result::prepare()
+    template <typename L>
+    static inline void prepare_list(L * &list, bool enabled)
     {
-      clear();
+      if (!enabled)
+        {
+          delete list;
+          list = 0;
+        }
+      else if (list)
+        list->clear();
+      else
+        list = new L;
+    }
+
+    void Result::prepare(bool compact)
+    {
+      reset();
+
+      _compact = compact;
 
       GOPTICAL_FOREACH(i, _elements)
         {
-          if (i->_save_intercepted_list)
-            i->_intercepted = new rays_queue_t;
+          prepare_list(i->_intercepted, i->_save_intercepted_list && !compact);
+          prepare_list(i->_generated, i->_save_generated_list && !compact);
+          prepare_list(i->_intercepted_index, i->_save_intercepted_list && compact);
+          prepare_list(i->_generated_index, i->_save_generated_list && compact);
+        }
+
+      GOPTICAL_FOREACH(i, _shards)
+        prepare_shard(**i);
+    }
+
+    void Result::prepare_shard(Result &shard) const
+    {
+      const struct element_result_s er = element_result_s();
+
+      shard._system = _system;
+      shard._params = _params;
+      shard._spectral_ptr = _spectral_ptr;
+      shard._elements.resize(_elements.size(), er);
+
+      for (unsigned int i = 0; i < _elements.size(); i++)
+        {
+          element_result_s &ser = shard._elements[i];
+
+          // rays lists are built when compacting rays trees
+          ser._save_intercepted_list = _elements[i]._save_intercepted_list && !_compact;
+          ser._save_generated_list = _elements[i]._save_generated_list && !_compact;
+        }
+
+      shard.prepare();
+    }
+
+    void Result::prepare_shards(unsigned int count)
+    {
+      while (_shards.size() < count)
+        {
+          Result *r = new Result();
+
+          prepare_shard(*r);
+          _shards.push_back(r);
+        }
+    }
+
+    void Result::merge_shard(Result &shard)
+    {
+      for (unsigned int i = 0; i < _elements.size(); i++)
+        {
+          element_result_s &er = _elements[i];
+          element_result_s &ser = shard._elements[i];
+
+          if (ser._intercepted)
+            {
+              if (er._intercepted)
+                er._intercepted->insert(er._intercepted->end(),
+                                        ser._intercepted->begin(), ser._intercepted->end());
+              ser._intercepted->clear();
+            }
+
+          if (ser._generated)
+            {
+              if (er._generated)
+                er._generated->insert(er._generated->end(),
+                                      ser._generated->begin(), ser._generated->end());
+              ser._generated->clear();
+            }
+        }
+
+      _bounce_limit_count += shard._bounce_limit_count;
+      shard._bounce_limit_count = 0;
+    }
+
+    RayPacket & Result::new_packet(const Sys::Element &creator)
+    {
+      RayPacket *p;
+
+      if (_packets_free.empty())
+        {
+          p = new RayPacket(&creator);
+          // room to recycle all packets on next trace
+          _packets_free.reserve(_packets.size() + 1);
+        }
+      else
+        {
+          p = _packets_free.back();
+          _packets_free.pop_back();
+
+          p->clear();
+          p->set_creator(&creator);
+          p->set_intercept_element(0);
+        }
+
+      p->set_spectral_table(_spectral_ptr);
+
+      _packets.push_back(p);
+      _packets_pending = true;
+
+      return *p;
+    }
+
+    void Result::packets_to_rays()
+    {
+      // rays of previous packet, indexed as in packet
+      std::vector<Ray *> prev, cur;
+
+      GOPTICAL_FOREACH(p, _packets)
+        {
+          const RayPacket &packet = **p;
+          const Sys::Element &creator = *packet.get_creator();
+          const Sys::Element *ie = packet.get_intercept_element();
+
+          rays_queue_t *generated = get_element_result(creator)._generated;
+          rays_queue_t *intercepted = ie ? get_element_result(*ie)._intercepted : 0;
+
+          cur.resize(packet.size());
+
+          for (unsigned int i = 0; i < packet.size(); i++)
+            {
+              Ray &r = _rays.create();
+
+              r.origin() = packet.get_origin(i);
+              r.direction() = packet.get_direction(i);
+              r.set_wavelen(packet.get_wavelen(i));
+              r.set_intensity(packet.get_intensity(i));
+              r.set_material(packet.get_material(i));
+              r.set_creator(&creator);
+
+              unsigned int parent = packet.get_parent(i);
+
+              if (parent != RayPacket::no_parent)
+                prev[parent]->add_generated(&r);
+
+              if (!packet.is_lost(i))
+                {
+                  r.set_len(packet.get_len(i));
+                  r.set_intercept_intensity(packet.get_intercept_intensity(i));
+                  r.set_intercept(*ie, packet.get_intercept_point(i));
+
+                  if (intercepted)
+                    intercepted->push_back(&r);
+                }
+
+              if (generated)
+                generated->push_back(&r);
+
+              cur[i] = &r;
+            }
+
+          prev.swap(cur);
+        }
+
+      _packets_pending = false;
+    }
+
+    void Result::compact_rays(const rays_queue_t &roots, unsigned int first,
+                              unsigned int last)
+    {
+      for (unsigned int i = first; i < last; i++)
+        compact_tree(*roots[i]);
+    }
+
+    void Result::compact_rays()
+    {
+      if (_packets_pending)
+        packets_to_rays();
+
+      GOPTICAL_FOREACH(r, _rays)
+        if (!r->get_parent())
+          compact_tree(*r);
+
+      release_rays(0);
+
+      _rays.shrink();
+      GOPTICAL_FOREACH(s, _shards)
+        (*s)->_rays.shrink();
+    }
+
+    void Result::release_rays(unsigned int count)
+    {
+      while (_rays.size() > count)
+        _rays.pop_back();
+
+      GOPTICAL_FOREACH(s, _shards)
+        (*s)->_rays.clear();
+    }
+
+    void Result::compact_tree(const Ray &root)
+    {
+      // breadth first walk, records are allocated in queue order
+      _compact_queue.clear();
+      _compact_queue.push_back(&root);
+
+      unsigned int index = compact_ray(root, CompactRay::no_index);
+
+      for (unsigned int i = 0; i < _compact_queue.size(); i++, index++)
+        {
+          unsigned int prev = CompactRay::no_index;
 
-          if (i->_save_generated_list)
-            i->_generated = new rays_queue_t;
+          for (const Ray *r = _compact_queue[i]->get_first_child(); r; r = r->get_next_child())
+            {
+              unsigned int j = compact_ray(*r, index);
+
+              if (prev == CompactRay::no_index)
+                _compact_rays[index]._child = j;
+              else
+                _compact_rays[prev]._next = j;
+
+              prev = j;
+              _compact_queue.push_back(r);
+            }
+        }
+    }
+
+    unsigned int Result::compact_ray(const Ray &r, unsigned int parent)
+    {
+      unsigned int index = _compact_rays.size();
+
+      if (index == CompactRay::no_index)
+        throw Error("too many rays in compact ray trace result");
+
+      _compact_rays.push_back(CompactRay());
+
+      CompactRay &c = _compact_rays.back();
+      const Sys::Element &creator = *r.get_creator();
+
+      c._ray = r;
+      c._wavelen = r.get_wavelen();
+      c._intensity = r.get_intensity();
+      c._len = r.get_len();
+      c._parent = parent;
+      c._child = c._next = CompactRay::no_index;
+      c._creator = creator.id();
+      c._material = compact_material(r.get_material());
+
+      if (rays_index_t *generated = get_element_result(creator)._generated_index)
+        generated->push_back(index);
+
+      if (r.is_lost())
+        {
+          c._point = Math::vector3_0;
+          c._intercept_intensity = 0;
+          c._i_element = 0;
         }
+      else
+        {
+          const Sys::Element &ie = r.get_intercept_element();
+
+          c._point = r.get_intercept_point();
+          c._intercept_intensity = r.get_intercept_intensity();
+          c._i_element = ie.id();
+
+          if (rays_index_t *intercepted = get_element_result(ie)._intercepted_index)
+            intercepted->push_back(index);
+        }
+
+      return index;
+    }
+
+    unsigned int Result::compact_material(const Material::Base *m)
+    {
+      // only a few materials are used, last added is the most likely
+      for (unsigned int i = _compact_materials.size(); i-- > 0; )
+        if (_compact_materials[i] == m)
+          return i;
+
+      _compact_materials.push_back(m);
+
+      return _compact_materials.size() - 1;
     }
 
     void Result::init(const Sys::System &system)
     {
-      static const struct element_result_s er = { 0 };
+      const struct element_result_s er = element_result_s();
 
       if (!_system)
         _system = &system;
@@ -146,8 +474,42 @@ namespace _Goptical {
     }
 
 
+    static inline void window_extend(Math::VectorPair3 &window, const Math::Vector3 &ip)
+    {
+      if (window[0].x() > ip.x())
+        window[0].x() = ip.x();
+      else if (window[1].x() < ip.x())
+        window[1].x() = ip.x();
+
+      if (window[0].y() > ip.y())
+        window[0].y() = ip.y();
+      else if (window[1].y() < ip.y())
+        window[1].y() = ip.y();
+
+      if (window[0].z() > ip.z())
+        window[0].z() = ip.z();
+      else if (window[1].z() < ip.z())
+        window[1].z() = ip.z();
+    }
+
     Math::VectorPair3 Result::get_intercepted_window(const Sys::Surface &s) const
     {
+      if (_compact)
+        {
+          const rays_index_t & intercepts = get_intercepted_index(s);
+
+          if (intercepts.empty())
+            throw Error("no ray intercepts found on the surface");
+
+          const Math::Vector3 &first = _compact_rays[intercepts.front()].get_intercept_point();
+          Math::VectorPair3 window(first, first);
+
+          GOPTICAL_FOREACH(i, intercepts)
+            window_extend(window, _compact_rays[*i].get_intercept_point());
+
+          return window;
+        }
+
       const rays_queue_t & intercepts = get_intercepted(s);
 
       if (intercepts.empty())
@@ -157,24 +519,7 @@ namespace _Goptical {
       Math::VectorPair3 window(first, first);
 
       GOPTICAL_FOREACH(i, intercepts)
-        {
-          const Math::Vector3 &ip = (*i)->get_intercept_point();
-
-          if (window[0].x() > ip.x())
-            window[0].x() = ip.x();
-          else if (window[1].x() < ip.x())
-            window[1].x() = ip.x();
-
-          if (window[0].y() > ip.y())
-            window[0].y() = ip.y();
-          else if (window[1].y() < ip.y())
-            window[1].y() = ip.y();
-
-          if (window[0].z() > ip.z())
-            window[0].z() = ip.z();
-          else if (window[1].z() < ip.z())
-            window[1].z() = ip.z();
-        }
+        window_extend(window, (*i)->get_intercept_point());
 
       return window;
     }
@@ -188,17 +533,34 @@ namespace _Goptical {
 
     Math::Vector3 Result::get_intercepted_centroid(const Sys::Surface &s) const
     {
-      const rays_queue_t & intercepts = get_intercepted(s);
       unsigned int      count = 0;
       Math::Vector3     center(0, 0, 0);
 
-      if (intercepts.empty())
-        throw Error("no ray intercepts found on the surface");
-      
-      GOPTICAL_FOREACH(i, intercepts)
+      if (_compact)
+        {
+          const rays_index_t & intercepts = get_intercepted_index(s);
+
+          if (intercepts.empty())
+            throw Error("no ray intercepts found on the surface");
+
+          GOPTICAL_FOREACH(i, intercepts)
+            {
+              center += _compact_rays[*i].get_intercept_point();
+              count++;
+            }
+        }
+      else
         {
-          center += (*i)->get_intercept_point();
-          count++;
+          const rays_queue_t & intercepts = get_intercepted(s);
+
+          if (intercepts.empty())
+            throw Error("no ray intercepts found on the surface");
+
+          GOPTICAL_FOREACH(i, intercepts)
+            {
+              center += (*i)->get_intercept_point();
+              count++;
+            }
         }
 
       center /= count;
@@ -210,6 +572,16 @@ namespace _Goptical {
     {
       double res = 0;
 
+      if (_compact)
+        {
+          GOPTICAL_FOREACH(r, _compact_rays)
+            res = std::max(res, r->get_intensity());
+
+          return res;
+        }
+
+      update_rays();
+
       GOPTICAL_FOREACH(r, _rays)
         {
           double i = r->get_intensity();
@@ -218,6 +590,9 @@ namespace _Goptical {
             res = i;
         }
 
+      GOPTICAL_FOREACH(s, _shards)
+        res = std::max(res, (*s)->get_max_ray_intensity());
+
       return res;
     }
 
@@ -0,0 +1,198 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <algorithm>
+
+#include <Goptical/Trace/SpectralTable>
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/OpticalSurface>
+#include <Goptical/Material/Base>
+
+namespace _Goptical {
+
+  namespace Trace {
+
+    SpectralTable::SpectralTable()
+      : _wavelens(),
+        _intensity(false),
+        _wavelen_independent(false),
+        _thermal(false),
+        _temperature(0.),
+        _surfaces(),
+        _surface_row(),
+        _surface_entries(),
+        _materials(),
+        _transmittance()
+    {
+    }
+
+    void SpectralTable::clear()
+    {
+      _wavelens.clear();
+      _wavelen_independent = false;
+      _surfaces.clear();
+      _surface_row.clear();
+      _surface_entries.clear();
+      _materials.clear();
+      _transmittance.clear();
+    }
+
+    void SpectralTable::set_temperature(double temperature)
+    {
+      if (_thermal && _temperature == temperature)
+        return;
+
+      clear();
+      _thermal = true;
+      _temperature = temperature;
+    }
+
+    void SpectralTable::reset_temperature()
+    {
+      if (!_thermal)
+        return;
+
+      clear();
+      _thermal = false;
+    }
+
+    void SpectralTable::add_material(const Material::Base *m)
+    {
+      std::vector<const Material::Base *>::iterator i =
+        std::lower_bound(_materials.begin(), _materials.end(), m);
+
+      if (i == _materials.end() || *i != m)
+        _materials.insert(i, m);
+    }
+
+    void SpectralTable::update(const Sys::System &system,
+                               const std::vector<double> &wavelens, bool intensity)
+    {
+      if (!_wavelens.empty() && _wavelens == wavelens && _intensity == intensity)
+        return;
+
+      clear();
+
+      _wavelens = wavelens;
+      _intensity = intensity;
+
+      unsigned int wcount = _wavelens.size();
+
+      delegate_push<typeof(_surfaces), const Sys::OpticalSurface &> d(_surfaces);
+      system.get_elements<Sys::OpticalSurface>(d);
+
+      _surface_row.resize(system.get_element_count() + 1, -1);
+      _surface_entries.resize(_surfaces.size() * 2 * wcount);
+
+      add_material(&system.get_environment_proxy());
+
+      _wavelen_independent = true;
+
+      for (unsigned int row = 0; row < _surfaces.size(); row++)
+        {
+          const Sys::OpticalSurface &s = *_surfaces[row];
+
+          _surface_row[s.id()] = row;
+
+          for (unsigned int right_to_left = 0; right_to_left < 2; right_to_left++)
+            {
+              // same as OpticalSurface::trace_ray_* material selection
+              const Material::Base *prev_mat = &s.get_material(right_to_left);
+              const Material::Base *next_mat = &s.get_material(!right_to_left);
+
+              // no ray propagates in opaque materials. In simple mode,
+              // rays reflected on a mirror take the same path whether
+              // total internal reflection occurs or not.
+              bool unused = prev_mat->is_opaque() || !s.is_enabled();
+              bool mirror = !intensity && next_mat->is_opaque() && next_mat->is_reflecting();
+
+              if (intensity && s.is_enabled())
+                add_material(prev_mat);
+
+              for (unsigned int w = 0; w < wcount; w++)
+                {
+                  surface_entry_s &e = _surface_entries[(row * 2 + right_to_left) * wcount + w];
+                  double wl = _wavelens[w];
+
+                  // keep material models errors for ray trace time
+                  try {
+                    e._index = _thermal
+                      ? prev_mat->get_thermal_refractive_index(wl, _temperature) /
+                        next_mat->get_thermal_refractive_index(wl, _temperature)
+                      : prev_mat->get_refractive_index(wl) /
+                        next_mat->get_refractive_index(wl);
+
+                    if (intensity && _thermal)
+                      {
+                        e._transmittance = next_mat->get_thermal_normal_transmittance(prev_mat, wl, _temperature);
+                        e._reflectance = next_mat->get_thermal_normal_reflectance(prev_mat, wl, _temperature);
+                      }
+                    else if (intensity)
+                      {
+                        e._transmittance = next_mat->get_normal_transmittance(prev_mat, wl);
+                        e._reflectance = next_mat->get_normal_reflectance(prev_mat, wl);
+                      }
+
+                    e._valid = true;
+                  } catch (...) {
+                    e._valid = false;
+                  }
+
+                  const surface_entry_s &f = _surface_entries[(row * 2 + right_to_left) * wcount];
+
+                  if (unused)
+                    continue;
+
+                  if (!e._valid || (!mirror && e._index != f._index) ||
+                      (intensity && (e._transmittance != f._transmittance ||
+                                     e._reflectance != f._reflectance)))
+                    _wavelen_independent = false;
+                }
+            }
+        }
+
+      if (!intensity)
+        return;
+
+      _transmittance.resize(_materials.size() * wcount);
+
+      for (unsigned int i = 0; i < _materials.size(); i++)
+        for (unsigned int w = 0; w < wcount; w++)
+          {
+            double &t = _transmittance[i * wcount + w];
+
+            try {
+              t = _materials[i]->get_internal_transmittance(_wavelens[w], 1.0);
+            } catch (...) {
+              t = -1.0;
+            }
+
+            if (t < 0.0 || t != _transmittance[i * wcount])
+              _wavelen_independent = false;
+          }
+    }
+
+  }
+}
@@ -23,19 +23,25 @@
 */
 
 
-#include <deque>
+#include <algorithm>
 
 #include <Goptical/Trace/Tracer>
 #include <Goptical/Trace/Result>
 #include <Goptical/Trace/Ray>
-#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/RayPacket>
 #include <Goptical/Sys/System>
+#include <Goptical/Sys/FrozenSystem>
 #include <Goptical/Sys/Source>
+#include <Goptical/Sys/SourcePoint>
 #include <Goptical/Error>
 #include <Goptical/Sys/Surface>
 #include <Goptical/Math/VectorPair>
 #include <Goptical/Trace/Distribution>
 #include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Configuration>
+#include <Goptical/Trace/SpectralTable>
+
+#include "parallel_.hh"
 
 namespace _Goptical {
 
@@ -43,14 +49,63 @@ namespace _Goptical {
 
     Tracer::Tracer(const const_ref<Sys::System> &system)
       : _system(system),
+        _frozen(false),
+        _frozen_version(0),
         _params(system->get_tracer_params()),
         _result(),
-        _result_ptr(&_result)
+        _result_ptr(&_result),
+        _config(0),
+        _pattern(0),
+        _batch(),
+        _batch_patterns(),
+        _batch_size(0)
     {
     }
 
+    Tracer::Tracer(const Sys::FrozenSystem &system)
+      : _system(system.get_system()),
+        _frozen(true),
+        _frozen_version(system.get_system().get_version()),
+        _params(system.get_system().get_tracer_params()),
+        _result(),
+        _result_ptr(&_result),
+        _config(0),
+        _pattern(0),
+        _batch(),
+        _batch_patterns(),
+        _batch_size(0)
+    {
+      system.check();
+    }
+
     Tracer::~Tracer()
     {
+      GOPTICAL_FOREACH(i, _batch)
+        delete *i;
+    }
+
+    template <IntensityMode m>
+    void Tracer::generate_rays(Result &result, const Sys::Source &source,
+                               const Sys::Source::targets_t &entry) const
+    {
+      if (!_config)
+        source.generate_rays<m>(result, entry);
+      else if (_pattern->_target)
+        _config->get_source().generate_pattern_rays(result, *_pattern->_target,
+                                                    _pattern->_points, _config->get_mode(),
+                                                    _config->get_position_direction(),
+                                                    _config->get_spectrum());
+
+      // material models must not be used at other temperature or
+      // when sharing rays paths between wavelens, make sure table
+      // covers wavelens of rays from all sources
+      if (result._spectral.has_temperature() ||
+          (_params._wavelen_dedup && !_params._sequential_mode))
+        GOPTICAL_FOREACH(r, *result._generated_queue)
+          result.add_ray_wavelen((*r)->get_wavelen());
+
+      // material properties for all wavelens in use
+      result._spectral.update(*_system, result._wavelengths, m != SimpleTrace);
     }
 
     template <IntensityMode m> void Tracer::trace_seq_template()
@@ -59,24 +114,18 @@ namespace _Goptical {
 
       result.init(*_system);
 
-      // stack of rays to propagate
-      rays_queue_t tmp[2];
+      // frozen system transforms are already computed
+      if (_params._thread_count != 1 && !_frozen)
+        _system->transform_cache_prepare(_params);
+
+      // stack of rays to propagate, storage is kept in result for reuse
+      rays_queue_t *tmp = result._queues;
 
       unsigned int swaped = 0;
       rays_queue_t *generated;
       rays_queue_t *source_rays = &tmp[1];
       const std::vector<const_ref<Sys::Element> > &seq = _params._sequence->_list;
-      const Sys::Element *entrance = 0;
-
-      // find entry element (first non source)
-      for (unsigned int i = 0; i < seq.size(); i++)
-        {
-          if (!dynamic_cast<const Sys::Source *>(seq[i].ptr()))
-            {
-              entrance = seq[i].ptr();
-              break;
-            }
-        }
+      const Sys::Element *entrance = get_sequence_entrance();
 
       for (unsigned int i = 0; i < seq.size(); i++)
         {
@@ -88,6 +137,11 @@ namespace _Goptical {
           if (!element->is_enabled())
             continue;
 
+          // other sources are ignored in batch configurations
+          if (_config && element != &_config->get_source() &&
+              dynamic_cast<const Sys::Source *>(element))
+            continue;
+
           Result::element_result_s &er = result.get_element_result(*element);
 
           generated = er._generated ? er._generated : &tmp[swaped];
@@ -97,10 +151,15 @@ namespace _Goptical {
           if (const Sys::Source *source = dynamic_cast<const Sys::Source *>(element))
             {
               result._sources.push_back(source);
-              Sys::Source::targets_t elist;
+              Sys::Source::targets_t &elist = result._targets;
+              elist.clear();
               if (entrance)
                 elist.push_back(entrance);
-              source->generate_rays<m>(result, elist);
+              generate_rays<m>(result, *source, elist);
+            }
+          else if (_params._thread_count != 1 && source_rays->size() > 1)
+            {
+              process_rays_parallel<m>(result, *element, *source_rays);
             }
           else
             {
@@ -114,6 +173,431 @@ namespace _Goptical {
         }
 
       result._generated_queue = 0;
+
+      if (result._compact)
+        result.compact_rays();
+    }
+
+    const Sys::Element * Tracer::get_sequence_entrance() const
+    {
+      const std::vector<const_ref<Sys::Element> > &seq = _params._sequence->_list;
+
+      for (unsigned int i = 0; i < seq.size(); i++)
+        if (!dynamic_cast<const Sys::Source *>(seq[i].ptr()))
+          return seq[i].ptr();
+
+      return 0;
+    }
+
+    template <IntensityMode m> void Tracer::trace_seq_packet_template()
+    {
+      Result &result = *_result_ptr;
+
+      result.init(*_system);
+
+      // frozen system transforms are already computed
+      if (_params._thread_count != 1 && !_frozen)
+        _system->transform_cache_prepare(_params);
+
+      rays_queue_t &source_rays = result._queues[0];
+      RayPacket *input = 0;
+      const std::vector<const_ref<Sys::Element> > &seq = _params._sequence->_list;
+      const Sys::Element *entrance = get_sequence_entrance();
+
+      for (unsigned int i = 0; i < seq.size(); i++)
+        {
+          const Sys::Element *element = seq[i].ptr();
+
+          if (_system != element->get_system())
+            throw Error("Sequence contains element which is not part of the System");
+
+          if (!element->is_enabled())
+            continue;
+
+          // other sources are ignored in batch configurations
+          if (_config && element != &_config->get_source() &&
+              dynamic_cast<const Sys::Source *>(element))
+            continue;
+
+          if (const Sys::Source *source = dynamic_cast<const Sys::Source *>(element))
+            {
+              result._sources.push_back(source);
+              Sys::Source::targets_t &elist = result._targets;
+              elist.clear();
+              if (entrance)
+                elist.push_back(entrance);
+
+              source_rays.clear();
+              result._generated_queue = &source_rays;
+              generate_rays<m>(result, *source, elist);
+              result._generated_queue = 0;
+
+              RayPacket &output = result.new_packet(*source);
+              output.reserve(source_rays.size());
+
+              GOPTICAL_FOREACH(r, source_rays)
+                output.add_ray((*r)->origin(), (*r)->direction(),
+                               (*r)->get_wavelen(), (*r)->get_intensity(),
+                               (*r)->get_material(), RayPacket::no_parent);
+
+              // source rays objects are not needed anymore, the
+              // rays tree is rebuilt from packets on demand
+              source_rays.clear();
+              result._rays.clear();
+
+              input = &output;
+            }
+          else if (input)
+            {
+              RayPacket &output = result.new_packet(*element);
+
+              input->set_intercept_element(element);
+
+              if (_params._thread_count != 1 && input->size() > 1)
+                process_packet_parallel<m>(result, *element, *input, output);
+              else
+                element->process_packet<m>(_params, *input, 0, input->size(), output);
+
+              input = &output;
+            }
+
+          GOPTICAL_DEBUG(" " << (input ? input->size() : 0) << " rays generated by " << *element);
+        }
+
+      if (result._compact)
+        result.compact_rays();
+    }
+
+    template <IntensityMode m>
+    inline bool Tracer::same_path(const Ray &a, const Ray &b)
+    {
+      return a.origin() == b.origin() &&
+        a.direction() == b.direction() &&
+        a.get_creator() == b.get_creator() &&
+        a.get_material() == b.get_material() &&
+        // intensity changes which rays are discarded
+        (m == SimpleTrace || a.get_intensity() == b.get_intensity());
+    }
+
+    template <IntensityMode m>
+    void Tracer::clone_rays(Result &result, const Ray &rep, Ray &root) const
+    {
+      rays_queue_t &gqueue = result._gqueue;
+      rays_queue_t &cqueue = result._cqueue;
+      double wl = root.get_wavelen();
+      unsigned int next = 0;
+
+      cqueue.clear();
+      result._generated_queue = &cqueue;
+
+      // walk rays tree of representative ray in tracing order, its
+      // rays are in generated queue and children of a given ray are
+      // contiguous in generation order
+      for (int i = -1; i < (int)gqueue.size(); i++)
+        {
+          const Ray &r = i < 0 ? rep : *gqueue[i];
+          Ray &c = i < 0 ? root : *cqueue[i];
+
+          if (i >= 0)
+            result.add_generated(*c.get_creator(), c);
+
+          c.set_len(r.get_len());
+
+          if (!r.is_lost())
+            {
+              c.set_intercept(r.get_intercept_element(), r.get_intercept_point());
+              c.set_intercept_intensity(r.get_intercept_intensity());
+              result.add_intercepted(static_cast<const Sys::Surface &>(r.get_intercept_element()), c);
+            }
+
+          for (const Ray *j = r.get_first_child(); j; j = j->get_next_child())
+            {
+              const Ray &g = *gqueue[next++];
+              Ray &n = result.new_ray(g);
+
+              n.set_wavelen(wl);
+              // intensity is not modified in simple mode
+              if (m == SimpleTrace)
+                n.set_intensity(root.get_intensity());
+              n.set_creator(g.get_creator());
+              n.set_material(g.get_material());
+              c.add_generated(&n);
+            }
+        }
+
+      result._generated_queue = &gqueue;
+    }
+
+    template <IntensityMode m>
+    void Tracer::trace_rays(Result &result, const rays_queue_t &rays,
+                            unsigned int first, unsigned int last) const
+    {
+      rays_queue_t &gqueue = result._gqueue;
+      result._generated_queue = &gqueue;
+
+      // rays which only differ by wavelen follow the same path when
+      // material properties do not depend on wavelen
+      bool dedup = _params._wavelen_dedup &&
+        result.get_spectral_table().is_wavelen_independent();
+      const Ray *rep = 0;
+      unsigned int rep_bounce = 0;
+
+      for (unsigned int i = first; i < last; i++)
+        {
+          Ray *ray = rays[i];
+
+          // sources generate rays for all wavelens in a row, copy
+          // rays tree of previous ray instead of tracing again
+          if (rep && same_path<m>(*rep, *ray))
+            {
+              clone_rays<m>(result, *rep, *ray);
+              result._bounce_limit_count += rep_bounce;
+              continue;
+            }
+
+          unsigned int bounce = _params._max_bounce;
+          unsigned int bounce_count = result._bounce_limit_count;
+          unsigned int next = 0;
+
+          gqueue.clear();
+
+          if (dedup)
+            rep = ray;
+
+          // trace relfected/refracted ray further
+          while (1)
+            {
+              // check bounce limit
+              if (!bounce--)
+                result._bounce_limit_count++;
+              else
+                {
+                  Math::VectorPair3 intersect; // intersection point and normal (intersect surface local)
+                  Math::VectorPair3 local;     // incident ray (intersect surface local)
+
+                  // find ray / surface interction
+                  if (Sys::Surface *s = _system->colide_next(_params, intersect, local, *ray))
+                    {
+                      result.add_intercepted(*s, *ray);
+
+                      s->trace_ray<m>(result, *ray, local, intersect);
+                    }
+                }
+
+              // pick next ray to trace further through the system
+              if (next == gqueue.size())
+                break;
+
+              ray = gqueue[next++];
+
+              result.add_generated(*ray->get_creator(), *ray);
+            }
+
+          rep_bounce = result._bounce_limit_count - bounce_count;
+        }
+
+      result._generated_queue = 0;
+    }
+
+    template <IntensityMode m>
+    class Tracer::nseq_job : public parallel_job_t
+    {
+    public:
+      nseq_job(const Tracer &tracer, Result &result, const rays_queue_t &rays,
+               unsigned int first, unsigned int last, unsigned int chunk)
+        : _tracer(tracer),
+          _result(result),
+          _rays(rays),
+          _first(first),
+          _last(last),
+          _chunk(chunk)
+      {
+      }
+
+    private:
+      bool valid() const
+      {
+        return true;
+      }
+
+      void call(unsigned int i) const
+      {
+        unsigned int first = _first + i * _chunk;
+        unsigned int last = std::min(first + _chunk, _last);
+
+        _tracer.trace_rays<m>(*_result._shards[i], _rays, first, last);
+      }
+
+      const Tracer &_tracer;
+      Result &_result;
+      const rays_queue_t &_rays;
+      unsigned int _first;
+      unsigned int _last;
+      unsigned int _chunk;
+    };
+
+    template <IntensityMode m>
+    void Tracer::trace_rays_parallel(Result &result, const rays_queue_t &rays,
+                                     unsigned int first, unsigned int last) const
+    {
+      unsigned int chunk;
+      unsigned int count = get_chunk_count(last - first, chunk);
+
+      result.prepare_shards(count);
+
+      parallel_for(count, _params._thread_count,
+                   nseq_job<m>(*this, result, rays, first, last, chunk));
+
+      for (unsigned int i = 0; i < count; i++)
+        result.merge_shard(*result._shards[i]);
+    }
+
+    template <IntensityMode m>
+    class Tracer::seq_job : public parallel_job_t
+    {
+    public:
+      seq_job(const Sys::Element &element, Result &result)
+        : _element(element),
+          _result(result)
+      {
+      }
+
+    private:
+      bool valid() const
+      {
+        return true;
+      }
+
+      void call(unsigned int i) const
+      {
+        Result &shard = *_result._shards[i];
+
+        shard._generated_queue = &shard._queues[1];
+        _element.process_rays<m>(shard, &shard._queues[0]);
+        shard._generated_queue = 0;
+      }
+
+      const Sys::Element &_element;
+      Result &_result;
+    };
+
+    template <IntensityMode m>
+    void Tracer::process_rays_parallel(Result &result, const Sys::Element &element,
+                                       const rays_queue_t &rays) const
+    {
+      unsigned int chunk;
+      unsigned int count = get_chunk_count(rays.size(), chunk);
+
+      result.prepare_shards(count);
+
+      // shards working queues hold chunk input and generated rays
+      for (unsigned int i = 0; i < count; i++)
+        {
+          Result &shard = *result._shards[i];
+          rays_queue_t::const_iterator first = rays.begin() + i * chunk;
+
+          shard._queues[0].assign(first, first + std::min(chunk, (unsigned int)(rays.end() - first)));
+          shard._queues[1].clear();
+        }
+
+      parallel_for(count, _params._thread_count,
+                   seq_job<m>(element, result));
+
+      // keep rays generation order of serial processing
+      for (unsigned int i = 0; i < count; i++)
+        {
+          Result &shard = *result._shards[i];
+
+          result._generated_queue->insert(result._generated_queue->end(),
+                                          shard._queues[1].begin(), shard._queues[1].end());
+          result.merge_shard(shard);
+        }
+    }
+
+    template <IntensityMode m>
+    class Tracer::packet_job : public parallel_job_t
+    {
+    public:
+      packet_job(const Sys::Element &element, const Params &params,
+                 Result &result, RayPacket &input, unsigned int chunk)
+        : _element(element),
+          _params(params),
+          _result(result),
+          _input(input),
+          _chunk(chunk)
+      {
+      }
+
+    private:
+      bool valid() const
+      {
+        return true;
+      }
+
+      void call(unsigned int i) const
+      {
+        unsigned int first = i * _chunk;
+        unsigned int last = std::min(first + _chunk, _input.size());
+
+        _element.process_packet<m>(_params, _input, first, last,
+                                   _result._shards[i]->_packet);
+      }
+
+      const Sys::Element &_element;
+      const Params &_params;
+      Result &_result;
+      RayPacket &_input;
+      unsigned int _chunk;
+    };
+
+    template <IntensityMode m>
+    void Tracer::process_packet_parallel(Result &result, const Sys::Element &element,
+                                         RayPacket &input, RayPacket &output) const
+    {
+      unsigned int chunk;
+      unsigned int count = get_chunk_count(input.size(), chunk);
+
+      result.prepare_shards(count);
+
+      // interception data is written in place in input packet at
+      // distinct indexes, generated rays go to per chunk shard packets
+      for (unsigned int i = 0; i < count; i++)
+        {
+          RayPacket &p = result._shards[i]->_packet;
+
+          p.clear();
+          p.set_creator(&element);
+          p.set_intercept_element(0);
+          p.set_spectral_table(output.get_spectral_table());
+        }
+
+      parallel_for(count, _params._thread_count,
+                   packet_job<m>(element, _params, result, input, chunk));
+
+      // keep rays generation order of serial processing
+      for (unsigned int i = 0; i < count; i++)
+        output.append(result._shards[i]->_packet);
+    }
+
+    unsigned int Tracer::get_chunk_count(unsigned int ray_count, unsigned int &chunk) const
+    {
+      static const unsigned int min_chunk = 256;
+      unsigned int threads = _params._thread_count;
+
+      if (threads == 0)
+        threads = parallel_cpu_count();
+
+      // use more chunks than threads for load balancing, rays lists
+      // of chunks are merged in order so that result does not depend
+      // on chunks and threads count.
+      unsigned int count = std::min((ray_count + min_chunk - 1) / min_chunk, threads * 4);
+
+      if (count < 1)
+        count = 1;
+
+      chunk = (ray_count + count - 1) / count;
+
+      return (ray_count + chunk - 1) / chunk;
     }
 
     template <IntensityMode m> void Tracer::trace_template()
@@ -125,15 +609,24 @@ namespace _Goptical {
       if (_params._propagation_mode != RayPropagation)
         throw Error("Diffractive propagation not supported in non sequential mode");
 
-      // stack of rays to propagate
+      // frozen system hierarchy is built by freeze
+      if (!_frozen)
+        _system->colide_prepare();
+
+      // frozen system transforms are already computed
+      if (_params._thread_count != 1 && !_frozen)
+        _system->transform_cache_prepare(_params);
+
+      // stack of rays to propagate, storage is kept in result for reuse
 
-      rays_queue_t source_rays;
+      rays_queue_t &source_rays = result._queues[0];
 
-      Sys::Source::targets_t entry;
+      Sys::Source::targets_t &entry = result._targets;
+      entry.clear();
       entry.push_back(&_system->get_entrance_pupil());
 
-      // FIXME avoid container use here
-      std::vector<const Sys::Source *> slist;
+      std::vector<const Sys::Source *> &slist = result._source_list;
+      slist.clear();
       delegate_push<typeof(slist), const Sys::Source &> d(slist);
       _system->get_elements<Sys::Source>(d);
 
@@ -147,12 +640,16 @@ namespace _Goptical {
           if (!source.is_enabled())
             continue;
 
+          // other sources are ignored in batch configurations
+          if (_config && &source != &_config->get_source())
+            continue;
+
           result._sources.push_back(&source);
 
           // get rays from source
           source_rays.clear();
           result._generated_queue = &source_rays;
-          source.generate_rays<m>(result, entry);
+          generate_rays<m>(result, source, entry);
 
           // copy to source generated rays
           {
@@ -166,66 +663,205 @@ namespace _Goptical {
 
           // trace each ray generated by source through the system
 
-          rays_queue_t gqueue;
-          result._generated_queue = &gqueue;
-
-          GOPTICAL_FOREACH(r, source_rays)
+          if (result._compact)
             {
-              Ray *ray = *r;
-              unsigned int bounce = _params._max_bounce;
+              // convert rays trees to compact records in batches so
+              // that only a few ray objects are allocated at once
+              static const unsigned int batch = 16384;
+              unsigned int count = result._rays.size();
 
-              // trace relfected/refracted ray further
-              while (1)
+              for (unsigned int first = 0; first < source_rays.size(); first += batch)
                 {
-                  // check bounce limit
-                  if (!bounce--)
-                    result._bounce_limit_count++;
+                  unsigned int last = std::min(first + batch, (unsigned int)source_rays.size());
+
+                  if (_params._thread_count != 1 && last - first > 1)
+                    trace_rays_parallel<m>(result, source_rays, first, last);
                   else
-                    {
-                      Math::VectorPair3 intersect; // intersection point and normal (intersect surface local)
+                    trace_rays<m>(result, source_rays, first, last);
 
-                      // find ray / surface interction
-                      if (Sys::Surface *s = _system->colide_next(_params, intersect, *ray))
-                        {
-                          result.add_intercepted(*s, *ray);
+                  result.compact_rays(source_rays, first, last);
+                  result.release_rays(count);
+                }
 
-                          // transform incident ray to surface local
-                          const Math::Transform<3> &t = ray->get_creator()->get_transform_to(*s);
-                          Math::VectorPair3 local(t.transform_line(*ray));
+              result.release_rays(0);
+            }
+          else if (_params._thread_count != 1 && source_rays.size() > 1)
+            trace_rays_parallel<m>(result, source_rays, 0, source_rays.size());
+          else
+            trace_rays<m>(result, source_rays, 0, source_rays.size());
+        }
 
-                          s->trace_ray<m>(result, *ray, local, intersect);
-                        }
-                    }
+      result._generated_queue = 0;
+
+      if (result._compact)
+        result.compact_rays();
+    }
+
+    class Tracer::batch_job : public parallel_job_t
+    {
+    public:
+      batch_job(const std::vector<Tracer *> &tracers)
+        : _tracers(tracers)
+      {
+      }
+
+    private:
+      bool valid() const
+      {
+        return true;
+      }
+
+      void call(unsigned int i) const
+      {
+        _tracers[i]->trace();
+      }
+
+      const std::vector<Tracer *> &_tracers;
+    };
+
+    static inline bool same_distribution(const Distribution &a, const Distribution &b)
+    {
+      return a.get_pattern() == b.get_pattern() &&
+        a.get_radial_density() == b.get_radial_density() &&
+        a.get_scaling() == b.get_scaling();
+    }
 
-                  // pick next ray to trace further through the system
-                  if (gqueue.empty())
-                    break;
-                  
-                  ray = gqueue.front();
-                  gqueue.pop_front();
+    void Tracer::trace_batch(const std::vector<Configuration> &configs)
+    {
+      _batch_size = 0;
+
+      // compute lazy system states once, configurations are then
+      // traced concurrently without modifying the system
+      if (!_frozen)
+        _system->freeze(_params);
+      else if (_system->get_version() != _frozen_version)
+        throw Error("system has been modified since freeze");
+
+      // pattern target surface is the same for all configurations
+      const Sys::Element *entry = _params._sequential_mode
+        ? get_sequence_entrance() : &_system->get_entrance_pupil();
+      const Sys::Surface *target = dynamic_cast<const Sys::Surface *>(entry);
+
+      // compute distribution patterns points once
+      std::vector<unsigned int> pattern_index(configs.size());
+
+      _batch_patterns.clear();
+
+      for (unsigned int i = 0; i < configs.size(); i++)
+        {
+          const Configuration &c = configs[i];
+
+          if (_system != c.get_source().get_system())
+            throw Error("can not trace with Source which is not part of the System");
+
+          const Distribution &d = c.has_distribution() || !target
+            ? c.get_distribution() : _params.get_distribution(*target);
+
+          unsigned int j;
+
+          for (j = 0; j < _batch_patterns.size(); j++)
+            if (same_distribution(_batch_patterns[j]._dist, d))
+              break;
 
-                  result.add_generated(*ray->get_creator(), *ray);
+          if (j == _batch_patterns.size())
+            {
+              _batch_patterns.push_back(batch_pattern_s());
+
+              batch_pattern_s &p = _batch_patterns.back();
+              p._target = target;
+              p._dist = d;
+
+              if (target)
+                {
+                  delegate_push<typeof(p._points), const Math::Vector3 &> de(p._points);
+                  target->get_pattern(de, d, _params._unobstructed);
                 }
             }
+
+          pattern_index[i] = j;
         }
 
-      result._generated_queue = 0;
+      // setup one single threaded tracer per configuration
+      while (_batch.size() < configs.size())
+        _batch.push_back(new Tracer(_system));
+
+      for (unsigned int i = 0; i < configs.size(); i++)
+        {
+          Tracer &t = *_batch[i];
+
+          t._frozen = true;
+          t._frozen_version = _system->get_version();
+          t._params = _params;
+          t._params._thread_count = 1;
+          t._config = &configs[i];
+          t._pattern = &_batch_patterns[pattern_index[i]];
+          t._result._spectral.reset_temperature();
+        }
+
+      parallel_for(configs.size(), _params._thread_count, batch_job(_batch));
+
+      for (unsigned int i = 0; i < configs.size(); i++)
+        _batch[i]->_config = 0;
+
+      _batch_size = configs.size();
+    }
+
+    void Tracer::trace_temperatures(const std::vector<double> &temperatures)
+    {
+      _batch_size = 0;
+
+      // compute lazy system states once, temperatures are then
+      // traced concurrently without modifying the system
+      if (!_frozen)
+        _system->freeze(_params);
+      else if (_system->get_version() != _frozen_version)
+        throw Error("system has been modified since freeze");
+
+      // setup one single threaded tracer per temperature
+      while (_batch.size() < temperatures.size())
+        _batch.push_back(new Tracer(_system));
+
+      for (unsigned int i = 0; i < temperatures.size(); i++)
+        {
+          Tracer &t = *_batch[i];
+
+          t._frozen = true;
+          t._frozen_version = _system->get_version();
+          t._params = _params;
+          t._params._thread_count = 1;
+          t._config = 0;
+          t._pattern = 0;
+          t._result._spectral.set_temperature(temperatures[i]);
+        }
+
+      parallel_for(temperatures.size(), _params._thread_count, batch_job(_batch));
+
+      _batch_size = temperatures.size();
     }
 
     void Tracer::trace()
     {
       Result    &result = *_result_ptr;
 
-      // clear previous results
-      result.prepare();
+      if (_frozen && _system->get_version() != _frozen_version)
+        throw Error("system has been modified since freeze");
+
+      // transforms must not be computed concurrently
+      if (_frozen && !_system->transform_cache_ready(_params))
+        throw Error("system has been frozen for other tracer parameters");
 
       result._params = &_params;
 
+      // clear previous results
+      result.prepare(_params._compact_storage);
+
       switch (_params._intensity_mode)
         {
         case SimpleTrace:
           if (!_params._sequential_mode)
             trace_template<SimpleTrace>();
+          else if (_params._packet_mode)
+            trace_seq_packet_template<SimpleTrace>();
           else
             trace_seq_template<SimpleTrace>();
           break;
@@ -233,13 +869,17 @@ namespace _Goptical {
         case IntensityTrace:
           if (!_params._sequential_mode)
             trace_template<IntensityTrace>();
+          else if (_params._packet_mode)
+            trace_seq_packet_template<IntensityTrace>();
           else
             trace_seq_template<IntensityTrace>();
           break;
 
         case PolarizedTrace:
           if (!_params._sequential_mode)
-            trace_template<PolarizedTrace>();       
+            trace_template<PolarizedTrace>();
+          else if (_params._packet_mode)
+            trace_seq_packet_template<PolarizedTrace>();
           else
             trace_seq_template<PolarizedTrace>();
           break;
@@ -0,0 +1,216 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <Goptical/Error>
+#include <Goptical/Math/Vector>
+#include <Goptical/Material/Abbe>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/Surface>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Configuration>
+#include <Goptical/Trace/Distribution>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+
+#include <Goptical/Light/SpectralLine>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+/* trace configuration with a dedicated source element */
+static void trace_reference(Sys::System &sys, Sys::SourcePoint &batch_source,
+                            const Sys::Surface &image, bool sequential,
+                            const Trace::Configuration &c,
+                            unsigned int &count, Math::Vector3 &centroid)
+{
+  Sys::SourcePoint source(c.get_mode(), c.get_position_direction());
+
+  source.clear_spectrum();
+  GOPTICAL_FOREACH(l, c.get_spectrum())
+    source.add_spectral_line(*l);
+
+  sys.add(source);
+  batch_source.set_enable_state(false);
+
+  Trace::Tracer tracer(sys);
+  Trace::Result &result = tracer.get_trace_result();
+
+  if (sequential)
+    tracer.get_params().set_sequential_mode(ref<Trace::Sequence>::create(sys));
+  if (c.has_distribution())
+    tracer.get_params().set_default_distribution(c.get_distribution());
+
+  result.set_intercepted_save_state(image);
+  tracer.trace();
+
+  count = result.get_intercepted(image).size();
+  centroid = count ? result.get_intercepted_centroid(image) : Math::vector3_0;
+
+  batch_source.set_enable_state(true);
+  sys.remove(source);
+}
+
+int main()
+{
+  Sys::System   sys;
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  lens.add_surface(1/0.031186861,  14.934638, 4.627804137,
+                   ref<Material::AbbeVd>::create(1.607170, 59.5002));
+  lens.add_surface(0,              14.934638, 5.417429465);
+  lens.add_surface(1/-0.014065441, 12.766446, 3.728230979,
+                   ref<Material::AbbeVd>::create(1.575960, 41.2999));
+  lens.add_surface(1/0.034678487,  11.918098, 4.417903733);
+  lens.add_stop   (                12.066273, 2.288913925);
+  lens.add_surface(0,              12.372318, 1.499288597,
+                   ref<Material::AbbeVd>::create(1.526480, 51.4000));
+  lens.add_surface(1/0.035104369,  14.642815, 7.996205852,
+                   ref<Material::AbbeVd>::create(1.623770, 56.8998));
+  lens.add_surface(1/-0.021187519, 14.642815, 85.243965130);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 125.596), 15);
+  sys.add(image);
+
+  Sys::SourcePoint source(Sys::SourceAtInfinity, Math::vector3_001);
+  sys.add(source);
+
+  sys.get_tracer_params().set_default_distribution(
+    Trace::Distribution(Trace::HexaPolarDist, 8));
+
+  // field angles and spectra
+  std::vector<Trace::Configuration> configs;
+
+  for (unsigned int i = 0; i < 4; i++)
+    {
+      double a = i * 1.5 / 180.0 * M_PI;
+      Trace::Configuration c(source, Sys::SourceAtInfinity,
+                             Math::Vector3(0, sin(a), cos(a)));
+
+      c.single_spectral_line(Light::SpectralLine::e);
+      configs.push_back(c);
+
+      c.clear_spectrum();
+      c.add_spectral_line(Light::SpectralLine::C);
+      c.add_spectral_line(Light::SpectralLine::F);
+      configs.push_back(c);
+    }
+
+  {
+    Trace::Configuration c(source, Sys::SourceAtFiniteDistance,
+                           Math::Vector3(0, 27.5, -1000));
+
+    c.set_distribution(Trace::Distribution(Trace::HexaPolarDist, 4));
+    configs.push_back(c);
+  }
+
+  for (unsigned int seq = 0; seq < 2; seq++)
+    {
+      std::vector<unsigned int> ref_count(configs.size());
+      std::vector<Math::Vector3> ref_centroid(configs.size());
+
+      for (unsigned int i = 0; i < configs.size(); i++)
+        trace_reference(sys, source, image, seq, configs[i],
+                        ref_count[i], ref_centroid[i]);
+
+      static const unsigned int threads[] = { 1, 3, 0 };
+
+      for (unsigned int j = 0; j < sizeof(threads) / sizeof(threads[0]); j++)
+        {
+          Trace::Tracer tracer(sys);
+
+          if (seq)
+            tracer.get_params().set_sequential_mode(ref<Trace::Sequence>::create(sys));
+          tracer.get_params().set_thread_count(threads[j]);
+
+          // trace twice to check per configuration results are reused
+          for (unsigned int k = 0; k < 2; k++)
+            {
+              tracer.trace_batch(configs);
+
+              if (tracer.get_batch_size() != configs.size())
+                FAIL("bad batch size");
+
+              for (unsigned int i = 0; i < configs.size(); i++)
+                {
+                  Trace::Result &result = tracer.get_batch_result(i);
+
+                  result.set_intercepted_save_state(image);
+                }
+
+              // save states are used on next batch trace
+              if (k == 0)
+                continue;
+
+              for (unsigned int i = 0; i < configs.size(); i++)
+                {
+                  const Trace::Result &result = tracer.get_batch_result(i);
+                  unsigned int count = result.get_intercepted(image).size();
+
+                  if (!ref_count[i])
+                    FAIL("config " << i << ": no ray hit the image plane");
+
+                  if (count != ref_count[i])
+                    FAIL("config " << i << ", sequential " << seq << ", threads " << threads[j]
+                         << ": " << count << " rays on image, expecting " << ref_count[i]);
+
+                  Math::Vector3 d = result.get_intercepted_centroid(image) - ref_centroid[i];
+
+                  if (d.len() > 1e-6)
+                    FAIL("config " << i << ", sequential " << seq << ", threads " << threads[j]
+                         << ": centroid differs by " << d.len());
+
+                  if (result.get_ray_wavelen_set().size() != configs[i].get_spectrum().size())
+                    FAIL("config " << i << ": bad wavelen set");
+                }
+            }
+
+          try {
+            tracer.get_batch_result(configs.size());
+            FAIL("out of range batch result");
+          } catch (const Error &e) {
+          }
+        }
+    }
+
+  return 0;
+}
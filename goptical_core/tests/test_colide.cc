@@ -0,0 +1,232 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <limits>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+#include <Goptical/Material/Air>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Element>
+#include <Goptical/Sys/Surface>
+#include <Goptical/Sys/Group>
+#include <Goptical/Sys/OpticalSurface>
+#include <Goptical/Sys/Stop>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/SourcePoint>
+
+#include <Goptical/Curve/Sphere>
+#include <Goptical/Curve/Flat>
+#include <Goptical/Curve/Conic>
+#include <Goptical/Curve/Polynomial>
+#include <Goptical/Shape/Infinite>
+
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Params>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+/* linear search reference implementation */
+static Sys::Surface * colide_linear(const Sys::System &sys,
+                                    const Trace::Params &params,
+                                    Math::VectorPair3 &intersect,
+                                    Math::VectorPair3 &ilocal,
+                                    const Trace::Ray &ray)
+{
+  const Sys::Element *origin = ray.get_creator();
+  Sys::Surface *e = 0;
+  double min_dist = std::numeric_limits<double>::max();
+  Math::VectorPair3 gray(origin->get_global_transform().transform_line(ray));
+
+  for (unsigned int i = 1; i <= sys.get_element_count(); i++)
+    {
+      Sys::Surface *s = dynamic_cast<Sys::Surface*>(&sys.get_element(i));
+      Math::VectorPair3 inter;
+
+      if (!s || s == origin || !s->is_enabled())
+        continue;
+
+      Math::VectorPair3 local(s->get_local_transform().transform_line(gray));
+
+      if (s->intersect(params, inter, local))
+        {
+          double dist = (inter.origin() - local.origin()).len();
+
+          if (min_dist > dist)
+            {
+              min_dist = dist;
+              intersect = inter;
+              ilocal = local;
+              e = s;
+            }
+        }
+    }
+
+  return e;
+}
+
+static Math::Vector3 rand_vector(double scale)
+{
+  return Math::Vector3(drand48() - .5, drand48() - .5, drand48() - .5) * scale;
+}
+
+static unsigned int compare(const Sys::System &sys, const Sys::Element &origin,
+                            const Trace::Params &params)
+{
+  unsigned int hits = 0;
+
+  for (unsigned int i = 0; i < 20000; i++)
+    {
+      Trace::Ray ray;
+
+      ray.origin() = rand_vector(100);
+      ray.direction() = rand_vector(1);
+      // some rays along axes
+      if (i % 31 == 0)
+        ray.direction() = Math::Vector3(0, 0, 1);
+      ray.direction().normalize();
+      ray.set_creator(&origin);
+
+      Math::VectorPair3 i1, i2, l1, l2;
+      Sys::Surface *s1 = sys.colide_next(params, i1, l1, ray);
+      Sys::Surface *s2 = colide_linear(sys, params, i2, l2, ray);
+
+      if (s1 != s2)
+        FAIL("ray " << i << " hits " << (s1 ? s1->id() : 0)
+             << ", expecting " << (s2 ? s2->id() : 0));
+
+      if (s1 && !(i1.origin() == i2.origin()))
+        FAIL("ray " << i << " intersection point differs");
+
+      if (s1 && !(l1.origin() == l2.origin() && l1.direction() == l2.direction()))
+        FAIL("ray " << i << " local ray differs");
+
+      hits += s1 != 0;
+    }
+
+  return hits;
+}
+
+int main()
+{
+  Sys::System sys;
+  Sys::SourcePoint source(Sys::SourceAtFiniteDistance, Math::Vector3(0, 0, 0));
+  Sys::Group group(Math::VectorPair3(10, 20, 30));
+  const_ref<Material::Base> glass = ref<Material::AbbeVd>::create(1.5168, 64.17);
+  std::vector<ref<Sys::Element> > list;
+
+  sys.add(source);
+  sys.add(group);
+
+  srand48(12);
+
+  for (unsigned int i = 0; i < 150; i++)
+    {
+      Math::VectorPair3 p(rand_vector(200), Math::Vector3(0, 0, 1));
+      ref<Sys::Element> e;
+
+      switch (i % 3)
+        {
+        case 0:
+          e = ref<Sys::OpticalSurface>::create(p, drand48() * 100 - 50, 2 + drand48() * 10,
+                                               Material::air, glass);
+          break;
+        case 1:
+          e = ref<Sys::Stop>::create(p, 1 + drand48() * 5);
+          break;
+        case 2:
+          e = ref<Sys::Image>::create(p, 1 + drand48() * 5);
+          break;
+        }
+
+      e->rotate(drand48() * 360, drand48() * 360, drand48() * 360);
+
+      if (i % 4)
+        sys.add(e);
+      else
+        group.add(e);
+
+      list.push_back(e);
+    }
+
+  // surface without finite bounding box
+  Sys::OpticalSurface plane(Math::VectorPair3(0, 0, 80), Curve::flat,
+                            Shape::infinite, Material::air, glass);
+  sys.add(plane);
+
+  Trace::Params params;
+
+  if (!compare(sys, source, params))
+    FAIL("no ray hit a surface");
+
+  // system changes must be taken into account
+  for (unsigned int i = 0; i < list.size(); i += 7)
+    list[i]->set_enable_state(false);
+
+  list[1]->set_local_position(Math::Vector3(1, 2, 3));
+  plane.set_enable_state(false);
+
+  compare(sys, source, params);
+
+  // rays created by a surface
+  compare(sys, *list[2], params);
+
+  // curves changed in place without a system version update
+  ref<Curve::Conic> conic = ref<Curve::Conic>::create(5, -1);
+  Sys::OpticalSurface cs(Math::VectorPair3(0, 0, 0), conic, 20,
+                         Material::air, glass);
+  sys.add(cs);
+
+  // curve which can only estimate its range
+  ref<Curve::Polynomial> poly = ref<Curve::Polynomial>::create(2, 4, 0.01, 0.0, 1e-5);
+  Sys::OpticalSurface ps(Math::VectorPair3(0, 0, -50), poly, 30,
+                         Material::air, glass);
+  sys.add(ps);
+
+  sys.colide_prepare();
+  compare(sys, source, params);
+
+  conic->set_roc(-5);
+  poly->set(2, 4, -0.01, 0.0, -1e-5);
+
+  sys.colide_prepare();
+  compare(sys, source, params);
+
+  params.set_unobstructed(true);
+  compare(sys, source, params);
+
+  return 0;
+}
@@ -34,6 +34,7 @@
 #include <Goptical/Sys/Element>
 
 #include <stdlib.h>
+#include <vector>
 
 using namespace Goptical;
 
@@ -157,5 +158,54 @@ int main()
             fail(__LINE__ << ":" << p << " " << r);
         }
     }
+
+  // test large system with element removal and id reuse
+
+  Sys::System   big;
+  std::vector<ref<Sys::Element> > list;
+
+  for (int i = 0; i < 2000; i++)
+    {
+      list.push_back(ref<Sys::Surface>::create(Math::Vector3(i, 0, 0),
+                                               Curve::flat, Shape::infinite));
+      big.add(list[i]);
+    }
+
+  for (int j = 0; j < 3; j++)
+    {
+      for (int i = 0; i < 5000; i++)
+        {
+          int a = lrand48() % list.size();
+          int b = lrand48() % list.size();
+
+          if (a == b || !list[a]->get_system() || !list[b]->get_system())
+            continue;
+
+          Math::Vector3 p = list[a]->get_position(*list[b]);
+
+          if (!COMPARE_VECTOR3(p, Math::Vector3(a - b, 0, 0)))
+            fail(__LINE__ << ":" << a << " " << b << " " << p);
+        }
+
+      unsigned int lowest = list[j + 1]->id();
+
+      for (unsigned int i = j + 1; i < list.size(); i += 3)
+        {
+          big.remove(*list[i]);
+          list[i]->set_local_position(Math::Vector3(-1, 0, 0));
+        }
+
+      for (unsigned int i = j + 1; i < list.size(); i += 3)
+        {
+          list[i]->set_local_position(Math::Vector3(i, 0, 0));
+          big.add(list[i]);
+        }
+
+      if (list[j + 1]->id() != lowest)
+        fail(__LINE__);
+
+      if (big.get_element_count() != list.size())
+        fail(__LINE__);
+    }
 }
 
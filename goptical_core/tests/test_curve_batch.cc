@@ -0,0 +1,136 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+
+#include <Goptical/Curve/Base>
+#include <Goptical/Curve/Sphere>
+#include <Goptical/Curve/Conic>
+#include <Goptical/Curve/Flat>
+#include <Goptical/Curve/Parabola>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+#define COUNT 1001      // not a multiple of vector width
+
+#define COMPARE_VAL(a, b) (fabs((a)-(b)) <= 1e-10 * (1.0 + fabs(a)))
+
+static double orig[3][COUNT], dir[3][COUNT];
+
+static void init_rays()
+{
+  for (unsigned int i = 0; i < COUNT; i++)
+    {
+      Math::Vector3 o(drand48() * 40 - 20, drand48() * 40 - 20, drand48() * 20 - 15);
+      Math::Vector3 d(drand48() - .5, drand48() - .5, drand48() - .2);
+
+      // some rays parallel to z = 0 plane
+      if (i % 97 == 0)
+        d.z() = 0;
+
+      d.normalize();
+
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          orig[j][i] = o[j];
+          dir[j][i] = d[j];
+        }
+    }
+}
+
+static void test_curve(const char *name, const Curve::Base &c)
+{
+  double p[3][COUNT], n[3][COUNT];
+  double * const point[3] = { p[0], p[1], p[2] };
+  double * const normal[3] = { n[0], n[1], n[2] };
+  const double * const origin[3] = { orig[0], orig[1], orig[2] };
+  const double * const direction[3] = { dir[0], dir[1], dir[2] };
+  bool hit[COUNT];
+  unsigned int hit_count = 0;
+
+  c.intersect_batch(point, hit, origin, direction, COUNT, 0);
+  c.normal_batch(normal, point, COUNT);
+
+  for (unsigned int i = 0; i < COUNT; i++)
+    {
+      Math::VectorPair3 ray(Math::Vector3(orig[0][i], orig[1][i], orig[2][i]),
+                            Math::Vector3(dir[0][i], dir[1][i], dir[2][i]));
+      Math::Vector3 pt, nm;
+
+      if (c.intersect(pt, ray) != hit[i])
+        fail(name << ": ray " << i << " hit state differs");
+
+      if (!hit[i])
+        continue;
+
+      hit_count++;
+      c.normal(nm, pt);
+
+      for (unsigned int j = 0; j < 3; j++)
+        {
+          if (!COMPARE_VAL(pt[j], p[j][i]))
+            fail(name << ": ray " << i << " intersection point differs " << pt[j] << " " << p[j][i]);
+
+          if (!COMPARE_VAL(nm[j], n[j][i]))
+            fail(name << ": ray " << i << " normal differs " << nm[j] << " " << n[j][i]);
+        }
+    }
+
+  if (!hit_count)
+    fail(name << ": no ray hit the curve");
+}
+
+int main()
+{
+  srand48(42);
+  init_rays();
+
+  Curve::Sphere sphere(30), sphere_neg(-25);
+  Curve::Conic ellipse(30, -0.5), oblate(-40, 0.8);
+  Curve::Conic parabola(35, -1), hyperbola(-30, -2.5);
+  Curve::Parabola parabola2(50);
+
+  test_curve("sphere", sphere);
+  test_curve("sphere neg", sphere_neg);
+  test_curve("conic ellipse", ellipse);
+  test_curve("conic oblate", oblate);
+  test_curve("conic parabola", parabola);
+  test_curve("conic hyperbola", hyperbola);
+  test_curve("flat", Curve::flat);
+  test_curve("parabola", parabola2);
+
+  return 0;
+}
+
@@ -0,0 +1,205 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Math/Dual>
+
+#include <Goptical/Curve/Base>
+#include <Goptical/Curve/Rotational>
+#include <Goptical/Curve/RotationalDual>
+#include <Goptical/Curve/BaseDual>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+#define COMPARE_VAL(a, b) (fabs((a)-(b)) <= 1e-12 * (1.0 + fabs(a)))
+
+/* catenary with closed form derivative */
+class Catenary : public Curve::Rotational
+{
+public:
+  Catenary(double a)
+    : _a(a)
+  {
+  }
+
+  double sagitta(double r) const
+  {
+    return _a * cosh(r / _a) - _a;
+  }
+
+  double derivative(double r) const
+  {
+    return sinh(r / _a);
+  }
+
+private:
+  double _a;
+};
+
+/* same catenary differentiated by dual numbers */
+class CatenaryDual : public Curve::RotationalDual<CatenaryDual>
+{
+public:
+  CatenaryDual(double a)
+    : _a(a)
+  {
+  }
+
+  template <typename T> T sagitta_t(const T &r) const
+  {
+    return _a * cosh(r / _a) - _a;
+  }
+
+private:
+  double _a;
+};
+
+/* biconic like curve with closed form gradient */
+class Saddle : public Curve::Base
+{
+public:
+  double sagitta(const Math::Vector2 & xy) const
+  {
+    return 0.01 * xy.x() * xy.x() - 0.005 * xy.y() * xy.y()
+      + 0.1 * sin(0.2 * xy.x()) * exp(-0.01 * xy.y());
+  }
+
+  void derivative(const Math::Vector2 & xy, Math::Vector2 & dxdy) const
+  {
+    dxdy.x() = 0.02 * xy.x() + 0.02 * cos(0.2 * xy.x()) * exp(-0.01 * xy.y());
+    dxdy.y() = -0.01 * xy.y() - 0.001 * sin(0.2 * xy.x()) * exp(-0.01 * xy.y());
+  }
+};
+
+/* same curve differentiated by dual numbers */
+class SaddleDual : public Curve::BaseDual<SaddleDual>
+{
+public:
+  template <typename T> T sagitta_t(const T &x, const T &y) const
+  {
+    return 0.01 * x * x - 0.005 * y * y
+      + 0.1 * sin(0.2 * x) * exp(-0.01 * y);
+  }
+};
+
+template <typename T> static T func(const T &x)
+{
+  return sqrt(x * x + 1.0) / (2.0 + sin(x)) - 3.0 / x
+    + pow(x, 1.5) * log(x) + atan(x) * tanh(x) - Math::square(cos(x))
+    + asin(x / 10.0) + acos(x / 20.0) + tan(x / 4.0) + fabs(x - 10.0);
+}
+
+static void test_dual()
+{
+  for (double x = 0.25; x < 5.0; x += 0.25)
+    {
+      Math::Dual<1> d = func(Math::Dual<1>(x, 0));
+
+      if (!COMPARE_VAL(d.value(), func(x)))
+        fail("dual value mismatch at " << x);
+
+      // central difference, error is O(h^2)
+      const double h = 1e-5;
+      double df = (func(x + h) - func(x - h)) / (2.0 * h);
+
+      if (fabs(d.deriv() - df) > 1e-6 * (1.0 + fabs(df)))
+        fail("dual derivative mismatch at " << x << " " << d << " " << df);
+    }
+
+  Math::Dual<2> x(3.0, 0), y(-2.0, 1);
+  Math::Dual<2> z = x * y - y / x + 1.0 / (x - y);
+
+  if (!COMPARE_VAL(z.deriv(0), -2.0 + (-2.0 / 9.0) - 1.0 / 25.0) ||
+      !COMPARE_VAL(z.deriv(1), 3.0 - 1.0 / 3.0 + 1.0 / 25.0))
+    fail("dual partial derivatives mismatch " << z);
+}
+
+static void test_curves(const Curve::Base &ref, const Curve::Base &c)
+{
+  srand48(42);
+
+  for (unsigned int i = 0; i < 1000; i++)
+    {
+      Math::Vector2 xy(drand48() * 60 - 30, drand48() * 60 - 30);
+      Math::Vector2 d1, d2;
+
+      if (!COMPARE_VAL(ref.sagitta(xy), c.sagitta(xy)))
+        fail("sagitta mismatch at " << xy);
+
+      ref.derivative(xy, d1);
+      c.derivative(xy, d2);
+
+      if (!COMPARE_VAL(d1.x(), d2.x()) || !COMPARE_VAL(d1.y(), d2.y()))
+        fail("derivative mismatch at " << xy << " " << d1 << " " << d2);
+
+      Math::Vector3 o(drand48() * 40 - 20, drand48() * 40 - 20, -10);
+      Math::Vector3 dir(drand48() * .4 - .2, drand48() * .4 - .2, 1);
+      Math::Vector3 p1, p2, n1, n2;
+
+      dir.normalize();
+
+      bool h1 = ref.intersect(p1, Math::VectorPair3(o, dir));
+      bool h2 = c.intersect(p2, Math::VectorPair3(o, dir));
+
+      if (h1 != h2)
+        fail("intersection hit mismatch");
+
+      if (!h1)
+        continue;
+
+      ref.normal(n1, p1);
+      c.normal(n2, p2);
+
+      if ((p1 - p2).len() > 1e-9 || (n1 - n2).len() > 1e-9)
+        fail("intersection mismatch " << p1 << " " << p2 << " " << n1 << " " << n2);
+    }
+}
+
+int main()
+{
+  test_dual();
+
+  test_curves(Catenary(-300), CatenaryDual(-300));
+  test_curves(Catenary(150), CatenaryDual(150));
+
+  const CatenaryDual c(150);
+
+  if (c.derivative(0.0) != 0.0 || !COMPARE_VAL(c.derivative(20.0), sinh(20.0 / 150)))
+    fail("rotational derivative mismatch");
+
+  test_curves(Saddle(), SaddleDual());
+
+  return 0;
+}
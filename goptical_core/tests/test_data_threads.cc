@@ -0,0 +1,197 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <math.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <iostream>
+
+#include <Goptical/Data/Set>
+#include <Goptical/Data/DiscreteSet>
+#include <Goptical/Data/Grid>
+#include <Goptical/Math/Vector>
+#include <Goptical/Error>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+static const unsigned int THREADS = 8;
+static const unsigned int STEPS = 2000;
+
+/* set shared by query threads, along with reference set prepared
+   before threads start */
+static const Data::Set *shared;
+static const Data::Set *reference;
+static int start_flag;
+
+static void fill(Data::DiscreteSet &d)
+{
+  for (unsigned int i = 0; i < 200; i++)
+    {
+      double x = i * 0.05 + 0.01 * sin(i);
+      d.add_data(x, sin(x) * exp(-x / 5.0), cos(x));
+    }
+}
+
+static void fill(Data::Grid &g)
+{
+  for (unsigned int i = 0; i < g.get_count(0); i++)
+    for (unsigned int j = 0; j < g.get_count(1); j++)
+      {
+        Math::Vector2 v(g.get_x_value_i(i, j));
+
+        g.get_y_value(i, j) = sin(v.x()) * cos(v.y());
+
+        if (g.get_interpolation() == Data::BicubicDeriv)
+          g.get_d_value(i, j) = Math::Vector2(cos(v.x()) * cos(v.y()),
+                                              -sin(v.x()) * sin(v.y()));
+      }
+}
+
+static void * query(void *arg)
+{
+  unsigned int dim = shared->get_dimensions();
+  long errors = 0;
+
+  // start all threads on the unprepared set at the same time
+  while (!__atomic_load_n(&start_flag, __ATOMIC_ACQUIRE))
+    ;
+
+  for (unsigned int i = 0; i < STEPS; i++)
+    {
+      double x[2];
+
+      x[0] = 9.5 * (i + (long)arg * 0.1) / STEPS;
+      x[1] = 3.0 - x[0] / 3.0;
+
+      for (unsigned int d = 0; d < dim; d++)
+        if (shared->interpolate(x, 1, d) != reference->interpolate(x, 1, d))
+          errors++;
+
+      if (shared->interpolate(x) != reference->interpolate(x))
+        errors++;
+    }
+
+  return (void*)errors;
+}
+
+static void test_threads(const Data::Set &s, const Data::Set &ref)
+{
+  pthread_t t[THREADS];
+  long errors = 0;
+
+  ref.prepare();
+  shared = &s;
+  reference = &ref;
+  start_flag = 0;
+
+  for (unsigned long i = 0; i < THREADS; i++)
+    if (pthread_create(&t[i], 0, query, (void*)i))
+      fail("pthread_create failed");
+
+  __atomic_store_n(&start_flag, 1, __ATOMIC_RELEASE);
+
+  for (unsigned int i = 0; i < THREADS; i++)
+    {
+      void *r;
+      pthread_join(t[i], &r);
+      errors += (long)r;
+    }
+
+  if (errors)
+    fail("concurrent interpolation mismatch " << errors);
+}
+
+int main()
+{
+  static const Data::Interpolation i1d[] = {
+    Data::Nearest, Data::Linear, Data::Quadratic, Data::CubicSimple,
+    Data::CubicDeriv, Data::Cubic2Deriv, Data::CubicDerivInit,
+    Data::Cubic2DerivInit, Data::Cubic, Data::Cubic2
+  };
+
+  for (unsigned int i = 0; i < sizeof(i1d) / sizeof(i1d[0]); i++)
+    {
+      Data::DiscreteSet s, ref;
+
+      s.set_interpolation(i1d[i]);
+      ref.set_interpolation(i1d[i]);
+      fill(s);
+      fill(ref);
+      test_threads(s, ref);
+
+      // tables must be rebuilt on data change
+      s.add_data(10.5, 1.0, 0.0);
+      ref.add_data(10.5, 1.0, 0.0);
+      test_threads(s, ref);
+    }
+
+  static const Data::Interpolation i2d[] = {
+    Data::Nearest, Data::Linear, Data::Bicubic,
+    Data::BicubicDiff, Data::BicubicDeriv
+  };
+
+  for (unsigned int i = 0; i < sizeof(i2d) / sizeof(i2d[0]); i++)
+    {
+      Data::Grid g(24, 16, Math::Vector2(-0.5, -1.0), Math::Vector2(0.5, 0.4));
+      Data::Grid ref(24, 16, Math::Vector2(-0.5, -1.0), Math::Vector2(0.5, 0.4));
+
+      g.set_interpolation(i2d[i]);
+      ref.set_interpolation(i2d[i]);
+      fill(g);
+      fill(ref);
+      test_threads(g, ref);
+    }
+
+  // preparing an empty set does nothing, interpolation reports
+  // error on each call
+  Data::DiscreteSet e;
+
+  e.set_interpolation(Data::Linear);
+  e.prepare();
+
+  for (unsigned int i = 0; i < 2; i++)
+    {
+      try {
+        e.interpolate(0.0);
+        fail("no error reported on empty data set");
+      } catch (const Error &) {
+      }
+    }
+
+  e.add_data(0.0, 1.0);
+  e.add_data(1.0, 2.0);
+  e.add_data(2.0, 3.0);
+
+  if (fabs(e.interpolate(0.5) - 1.5) > 1e-12)
+    fail("bad interpolation after error");
+
+  return 0;
+}
@@ -27,6 +27,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <Goptical/Data/DiscreteSet>
 
@@ -97,6 +98,72 @@ static void test(const char *name, Data::Interpolation i)
 
 #define DO_TEST(i) test(#i, Data::i)
 
+/* check interval lookup against brute force search on clustered data */
+static void test_lookup(bool hint)
+{
+  Data::DiscreteSet n, l;
+  std::vector<double> xs;
+
+  n.set_interpolation(Data::Nearest);
+  l.set_interpolation(Data::Linear);
+  n.set_interval_hint(hint);
+  l.set_interval_hint(hint);
+
+  for (int i = 0; i < 200; i++)
+    {
+      // dense cluster near origin and sparse tail
+      double x = i < 150 ? i * 1e-3 : 0.15 + (i - 149) * (i - 149) * 0.5;
+
+      n.add_data(x, i);
+      l.add_data(x, i);
+      xs.push_back(x);
+    }
+
+  for (int k = 0; k < 3000; k++)
+    {
+      double x;
+
+      switch (k / 1000)
+        {
+        case 0:                 // increasing
+          x = -1.0 + k * 1e-2;
+          break;
+        case 1:                 // decreasing
+          x = 0.3 - (k - 1000) * 3e-4;
+          break;
+        default:                // random
+          x = drand48() * 1300.0 - 10.0;
+          if (k & 1)
+            x = xs[k % xs.size()];
+          break;
+        }
+
+      // brute force nearest and interval
+      unsigned int near = 0, itv = 0;
+
+      for (unsigned int i = 0; i < xs.size(); i++)
+        {
+          if (fabs(x - xs[i]) < fabs(x - xs[near]))
+            near = i;
+          if (x >= xs[i])
+            itv = i + 1;
+        }
+
+      unsigned int got = (unsigned int)n.interpolate(x);
+
+      // ties between two values may be resolved either way
+      if (fabs(fabs(x - xs[near]) - fabs(x - xs[got])) > 1e-12)
+        fail("bad nearest value at " << x << ": " << n.interpolate(x) << " expected " << near);
+
+      unsigned int i1 = itv == 0 ? 0 : itv >= xs.size() ? xs.size() - 2 : itv - 1;
+      double slope = (i1 + 1.0 - i1) / (xs[i1 + 1] - xs[i1]);
+
+      if (fabs(l.interpolate(x, 1) - slope) > 1e-9 * fabs(slope))
+        fail("bad linear interval at " << x << ": slope " << l.interpolate(x, 1)
+             << " expected " << slope);
+    }
+}
+
 int main()
 {
   srcdir = getenv("srcdir");
@@ -142,6 +209,18 @@ int main()
   DO_TEST(CubicDeriv);
   DO_TEST(Cubic2Deriv);
 
+  // same results with per thread interval hint
+  d.set_interval_hint(true);
+
+  DO_TEST(Nearest);
+  DO_TEST(Linear);
+  DO_TEST(Quadratic);
+  DO_TEST(Cubic);
+  DO_TEST(CubicDeriv);
+
+  test_lookup(false);
+  test_lookup(true);
+
 #ifdef TEST_WRITE
   std::cerr << "test data written" << std::endl;
   return 2;
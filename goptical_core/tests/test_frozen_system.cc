@@ -0,0 +1,286 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
+#include <Goptical/Error>
+#include <Goptical/Math/Vector>
+#include <Goptical/Material/DispersionTable>
+#include <Goptical/Material/Abbe>
+
+#include <Goptical/Curve/Spline>
+#include <Goptical/Curve/Sphere>
+#include <Goptical/Shape/Disk>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/FrozenSystem>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/Surface>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Distribution>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+
+#include <Goptical/Light/SpectralLine>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+#define THREADS 4
+
+/* system with lazily evaluated curve and material data */
+struct lens_system_s
+{
+  lens_system_s()
+    : lens(Math::Vector3(0, 0, 0)),
+      image(Math::Vector3(0, 0, 70), 15),
+      source(Sys::SourceAtInfinity, Math::Vector3(0, 0.05, 1))
+  {
+    ref<Material::DispersionTable> glass = ref<Material::DispersionTable>::create();
+
+    glass->set_refractive_index(400, 1.5308);
+    glass->set_refractive_index(500, 1.5214);
+    glass->set_refractive_index(600, 1.5163);
+    glass->set_refractive_index(700, 1.5131);
+
+    ref<Curve::Spline> curve = ref<Curve::Spline>::create();
+    curve->get_data().set_interpolation(Data::Cubic);
+    curve->fit(Curve::Sphere(60), 12, 20);
+
+    lens.add_surface(curve, ref<Shape::Disk>::create(12), 6, glass);
+    lens.add_surface(-80, 12, 60);
+
+    sys.add(lens);
+    sys.add(image);
+    sys.add(source);
+
+    source.clear_spectrum();
+    source.add_spectral_line(Light::SpectralLine::C);
+    source.add_spectral_line(Light::SpectralLine::F);
+
+    sys.get_tracer_params().set_default_distribution(
+      Trace::Distribution(Trace::HexaPolarDist, 12));
+  }
+
+  Sys::System           sys;
+  Sys::Lens             lens;
+  Sys::Image            image;
+  Sys::SourcePoint      source;
+};
+
+typedef std::vector<Math::Vector3> points_t;
+
+static void trace(Trace::Tracer &tracer, const Sys::Surface &image, points_t &points)
+{
+  Trace::Result &result = tracer.get_trace_result();
+
+  result.set_intercepted_save_state(image);
+  tracer.trace();
+
+  const Trace::rays_queue_t &rays = result.get_intercepted(image);
+
+  points.clear();
+  for (unsigned int i = 0; i < rays.size(); i++)
+    points.push_back(rays[i]->get_intercept_point());
+}
+
+struct job_s
+{
+  const Sys::FrozenSystem       *frozen;
+  const Sys::Surface            *image;
+  const points_t                *ref;
+  unsigned int                  threads;
+  bool                          ok;
+};
+
+static void * job_func(void *arg)
+{
+  job_s &job = *(job_s *)arg;
+  Trace::Tracer tracer(*job.frozen);
+  points_t points;
+
+  tracer.get_params().set_thread_count(job.threads);
+  job.ok = true;
+
+  for (unsigned int k = 0; k < 4; k++)
+    {
+      trace(tracer, *job.image, points);
+
+      if (points.size() != job.ref->size())
+        job.ok = false;
+      else
+        for (unsigned int i = 0; i < points.size(); i++)
+          if (!(points[i] == (*job.ref)[i]))
+            job.ok = false;
+    }
+
+  return 0;
+}
+
+/* count valid entries of system transforms cache */
+static unsigned int cache_entries(const Sys::System &sys)
+{
+  std::ostringstream o;
+  std::string line;
+  unsigned int count = 0;
+
+  sys.transform_cache_dump(o);
+
+  std::istringstream i(o.str());
+
+  while (std::getline(i, line))
+    count += line.compare(0, 5, "from ") == 0;
+
+  return count;
+}
+
+/* freeze must not compute transforms between all elements pairs */
+static void test_sparse_cache()
+{
+  static const unsigned int count = 200;
+
+  Sys::System sys;
+  Sys::Lens lens(Math::Vector3(0, 0, 0));
+
+  for (unsigned int i = 0; i < count / 2; i++)
+    lens.add_surface(i % 2 ? -50 : 50, 10, 2,
+                     ref<Material::AbbeVd>::create(1.5168, 64.17));
+
+  sys.add(lens);
+
+  Sys::Image image(Math::Vector3(0, 0, 300), 15);
+  sys.add(image);
+
+  Sys::SourcePoint source(Sys::SourceAtInfinity, Math::Vector3(0, 0, 1));
+  sys.add(source);
+
+  // lens, surfaces, image and source
+  unsigned int n = sys.get_element_count();
+
+  Sys::FrozenSystem frozen = sys.freeze();
+
+  if (cache_entries(sys) > 2 * n + 4)
+    FAIL("non sequential freeze cached " << cache_entries(sys) << " transforms for "
+         << n << " elements");
+
+  // sequence transforms are not available
+  Trace::Sequence seq(sys);
+  Trace::Tracer tracer(frozen);
+  tracer.get_params().set_sequential_mode(seq);
+
+  try {
+    tracer.trace();
+    FAIL("frozen system traced with other propagation mode");
+  } catch (const Error &e) {
+  }
+
+  sys.freeze(tracer.get_params());
+  tracer.trace();
+
+  if (cache_entries(sys) > 3 * n + 4)
+    FAIL("sequential freeze cached " << cache_entries(sys) << " transforms for "
+         << n << " elements");
+}
+
+int main()
+{
+  test_sparse_cache();
+
+  lens_system_s ref_sys;
+  lens_system_s s;
+  Trace::Sequence ref_seq(ref_sys.sys);
+  Trace::Sequence seq(s.sys);
+
+  for (unsigned int mode = 0; mode < 2; mode++)
+    {
+      if (mode)
+        {
+          ref_sys.sys.get_tracer_params().set_sequential_mode(ref_seq);
+          s.sys.get_tracer_params().set_sequential_mode(seq);
+        }
+
+      points_t ref;
+      Trace::Tracer ref_tracer(ref_sys.sys);
+      trace(ref_tracer, ref_sys.image, ref);
+
+      if (ref.empty())
+        FAIL("no ray hit the image plane");
+
+      Sys::FrozenSystem frozen = s.sys.freeze();
+
+      if (!frozen.is_valid())
+        FAIL("frozen system not valid");
+
+      pthread_t threads[THREADS];
+      job_s jobs[THREADS];
+
+      for (unsigned int i = 0; i < THREADS; i++)
+        {
+          job_s j = { &frozen, &s.image, &ref, i % 2 + 1, false };
+          jobs[i] = j;
+
+          if (pthread_create(&threads[i], 0, job_func, &jobs[i]))
+            FAIL("unable to create thread");
+        }
+
+      for (unsigned int i = 0; i < THREADS; i++)
+        {
+          pthread_join(threads[i], 0);
+
+          if (!jobs[i].ok)
+            FAIL("mode " << mode << ": frozen trace " << i << " differs");
+        }
+
+      // frozen system can not be traced once modified
+      Trace::Tracer tracer(frozen);
+      s.image.set_local_position(Math::Vector3(0, 0, 70));
+
+      if (frozen.is_valid())
+        FAIL("frozen system still valid");
+
+      try {
+        tracer.trace();
+        FAIL("modified frozen system traced");
+      } catch (const Error &e) {
+      }
+    }
+
+  return 0;
+}
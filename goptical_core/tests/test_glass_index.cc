@@ -0,0 +1,165 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include <Goptical/Error>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+#include <Goptical/Material/Catalog>
+#include <Goptical/Material/GlassIndex>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static double rnd(double a, double b)
+{
+  return a + (b - a) * (double)rand() / RAND_MAX;
+}
+
+int main()
+{
+  srand(1);
+
+  ref<Material::Catalog> cat = GOPTICAL_REFNEW(Material::Catalog, "random");
+
+  for (unsigned int i = 0; i < 500; i++)
+    {
+      char name[16];
+      sprintf(name, "G%03u", i);
+
+      ref<Material::AbbeVd> m =
+        ref<Material::AbbeVd>::create(rnd(1.45, 1.95), rnd(20., 90.), rnd(-0.01, 0.03));
+
+      cat->add_material(name, m);
+    }
+
+  Material::GlassIndex index(*cat);
+
+  if (index.get_entry_count() != 500)
+    FAIL("bad entry count " << index.get_entry_count());
+
+  // entries hold catalog name, set random costs
+  for (unsigned int i = 0; i < index.get_entry_count(); i++)
+    {
+      const Material::GlassIndex::Entry &e = index.get_entry(i);
+
+      if (e.catalog != "random")
+        FAIL("bad catalog name");
+
+      index.set_cost(i, rnd(1., 10.));
+    }
+
+  index.set_weight(Material::GlassIndex::Cost, 0.1);
+
+  for (unsigned int q = 0; q < 200; q++)
+    {
+      double attr[4] = { rnd(1.4, 2.0), rnd(15., 95.), rnd(-0.02, 0.04), rnd(0., 10.) };
+      unsigned int k = 1 + q % 12;
+
+      // k nearest against linear scan
+      std::vector<unsigned int> r;
+      index.find_nearest(r, k, attr);
+
+      std::vector<std::pair<double, unsigned int> > scan;
+      for (unsigned int i = 0; i < index.get_entry_count(); i++)
+        scan.push_back(std::make_pair(index.get_distance(i, attr), i));
+      std::sort(scan.begin(), scan.end());
+
+      if (r.size() != k)
+        FAIL("bad nearest result count");
+
+      for (unsigned int i = 0; i < k; i++)
+        if (r[i] != scan[i].second)
+          FAIL("nearest " << i << " mismatch, query " << q);
+
+      // range against linear scan
+      double low[4], high[4];
+      for (unsigned int j = 0; j < 4; j++)
+        {
+          double w = (j == 0 ? 0.1 : j == 1 ? 15. : j == 2 ? 0.01 : 4.);
+          low[j] = attr[j] - w;
+          high[j] = attr[j] + w;
+        }
+
+      std::vector<unsigned int> rr, sr;
+      index.find_range(rr, low, high);
+
+      for (unsigned int i = 0; i < index.get_entry_count(); i++)
+        {
+          const Material::GlassIndex::Entry &e = index.get_entry(i);
+          unsigned int j;
+
+          for (j = 0; j < 4; j++)
+            if (e.attr[j] < low[j] || e.attr[j] > high[j])
+              break;
+
+          if (j == 4)
+            sr.push_back(i);
+        }
+
+      if (rr != sr)
+        FAIL("range mismatch, query " << q);
+    }
+
+  // known glass attributes
+  {
+    Material::GlassIndex idx;
+
+    idx.add_material("BAF3", ref<Material::AbbeVd>::create(1.582670, 46.47, 0.0021));
+
+    const Material::GlassIndex::Entry &e = idx.get_entry(0);
+
+    if (fabs(e.attr[Material::GlassIndex::Nd] - 1.582670) > 1e-4 ||
+        fabs(e.attr[Material::GlassIndex::Vd] - 46.47) > 0.05 ||
+        fabs(e.attr[Material::GlassIndex::DPgF] - 0.0021) > 2e-3)
+      FAIL("bad glass attributes " << e.attr[0] << " " << e.attr[1] << " " << e.attr[2]);
+
+    std::vector<unsigned int> r;
+    idx.find_nearest(r, 3, 1.6, 40.);
+
+    if (r.size() != 1 || r[0] != 0)
+      FAIL("bad nearest result for single entry index");
+  }
+
+  try {
+    index.set_weight(Material::GlassIndex::Nd, -1.);
+    FAIL("negative weight accepted");
+  } catch (const Error &e) {
+  }
+
+  return 0;
+}
+
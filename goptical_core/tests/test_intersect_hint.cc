@@ -0,0 +1,272 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+
+#include <Goptical/Curve/Base>
+#include <Goptical/Curve/Rotational>
+#include <Goptical/Curve/Zernike>
+#include <Goptical/Curve/Polynomial>
+#include <Goptical/Shape/Base>
+#include <Goptical/Shape/Disk>
+
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+#include <Goptical/Material/Air>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Distribution>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+/* zernike curve which counts sagitta evaluations */
+class ZernikeCount : public Curve::Zernike
+{
+public:
+  ZernikeCount(double radius)
+    : Curve::Zernike(radius),
+      _count(0)
+  {
+  }
+
+  double sagitta(const Math::Vector2 & xy) const
+  {
+    _count++;
+    return Curve::Zernike::sagitta(xy);
+  }
+
+  mutable unsigned int _count;
+};
+
+/* polynomial curve which counts sagitta evaluations */
+class PolynomialCount : public Curve::Polynomial
+{
+public:
+  PolynomialCount()
+    : _count(0)
+  {
+  }
+
+  using Curve::Polynomial::sagitta;
+
+  double sagitta(double r) const
+  {
+    _count++;
+    return Curve::Polynomial::sagitta(r);
+  }
+
+  mutable unsigned int _count;
+};
+
+static const double radius = 30;
+static const unsigned int grid = 40;
+
+/* get ray of a collimated oblique beam in raster order, or in
+   random order */
+static Math::VectorPair3 get_ray(unsigned int i, bool random)
+{
+  unsigned int n = random ? lrand48() % (grid * grid) : i;
+  double x = ((double)(n % grid) / (grid - 1) - .5) * 2 * radius * .7;
+  double y = ((double)(n / grid) / (grid - 1) - .5) * 2 * radius * .7;
+
+  Math::Vector3 d(.1, -.05, 1);
+  d.normalize();
+
+  return Math::VectorPair3(Math::Vector3(x, y, -20), d);
+}
+
+template <class C>
+static void test_curve(C &c, const char *name, bool bounded)
+{
+  for (unsigned int order = 0; order < 2; order++)
+    {
+      Math::Vector3 cold[grid * grid];
+      Math::VectorPair3 rays[grid * grid];
+      unsigned int cold_count, hint_count;
+
+      srand48(order);
+
+      for (unsigned int i = 0; i < grid * grid; i++)
+        rays[i] = get_ray(i, order);
+
+      c.set_intersect_hint(false);
+      c._count = 0;
+
+      for (unsigned int i = 0; i < grid * grid; i++)
+        if (!(bounded ? c.intersect_bounded(cold[i], rays[i], 2 * radius)
+                      : c.intersect(cold[i], rays[i])))
+          fail(name << " cold start intersection missed");
+
+      cold_count = c._count;
+      c.set_intersect_hint(true);
+      c._count = 0;
+
+      for (unsigned int i = 0; i < grid * grid; i++)
+        {
+          Math::Vector3 p;
+
+          if (!(bounded ? c.intersect_bounded(p, rays[i], 2 * radius)
+                        : c.intersect(p, rays[i])))
+            fail(name << " warm start intersection missed");
+
+          if ((p - cold[i]).len() > 1e-8)
+            fail(name << " warm start intersection mismatch " << p << " " << cold[i]);
+        }
+
+      hint_count = c._count;
+
+      // neighbouring rays must save evaluations
+      if (!order && hint_count > cold_count * 9 / 10)
+        fail(name << " warm start does not save enough evaluations");
+    }
+}
+
+/* trace system on given threads count, get image intercept points */
+static void trace(Sys::System &sys, const Sys::Image &image, Trace::Sequence *seq,
+                  unsigned int threads, std::vector<Math::Vector3> &points)
+{
+  Trace::Tracer tracer(sys);
+  Trace::Result &result = tracer.get_trace_result();
+
+  if (seq)
+    tracer.get_params().set_sequential_mode(*seq);
+  tracer.get_params().set_thread_count(threads);
+  result.set_intercepted_save_state(image);
+  tracer.trace();
+
+  const Trace::rays_queue_t &rays = result.get_intercepted(image);
+
+  points.clear();
+  for (unsigned int i = 0; i < rays.size(); i++)
+    points.push_back(rays[i]->get_intercept_point());
+}
+
+/* check results do not depend on threads count when hint is
+   disabled, curve is shared by two surfaces */
+static void test_threads(const ref<Curve::Zernike> &z)
+{
+  Sys::System sys;
+  const_ref<Material::Base> glass = ref<Material::AbbeVd>::create(1.5168, 64.17);
+
+  const_ref<Shape::Base> disk = ref<Shape::Disk>::create(radius);
+  Sys::Lens lens(Math::Vector3(0, 0, 0));
+  Sys::Image image(Math::Vector3(0, 0, 60), 60);
+  Sys::SourcePoint source(Sys::SourceAtInfinity, Math::Vector3(0, .05, 1));
+
+  lens.add_surface(z, disk, 10, glass);
+  lens.add_surface(z, disk, 50);
+
+  sys.add(lens);
+  sys.add(image);
+  sys.add(source);
+
+  sys.get_tracer_params().set_default_distribution(
+    Trace::Distribution(Trace::HexaPolarDist, 20));
+
+  Trace::Sequence seq(sys);
+  static const unsigned int threads[] = { 2, 3, 0 };
+
+  for (unsigned int hint = 0; hint < 2; hint++)
+    {
+      z->set_intersect_hint(hint);
+
+      for (unsigned int sequential = 0; sequential < 2; sequential++)
+        {
+          std::vector<Math::Vector3> ref_points, points;
+
+          trace(sys, image, sequential ? &seq : 0, 1, ref_points);
+
+          if (ref_points.size() < 1000)
+            fail("not enough rays on image");
+
+          for (unsigned int j = 0; j < sizeof(threads) / sizeof(threads[0]); j++)
+            {
+              trace(sys, image, sequential ? &seq : 0, threads[j], points);
+
+              if (points.size() != ref_points.size())
+                fail("rays count depends on threads count");
+
+              for (unsigned int i = 0; i < points.size(); i++)
+                {
+                  double d = (points[i] - ref_points[i]).len();
+
+                  // warm start only changes points within convergence tolerance
+                  if (hint ? d > 1e-8 : d != 0)
+                    fail("ray " << i << " depends on threads count, hint " << hint
+                         << ", " << threads[j] << " threads");
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+  ZernikeCount z(radius);
+
+  z.set_coefficient(4, 2.0);
+  z.set_coefficient(5, .5);
+  z.set_coefficient(8, .3);
+  z.set_coefficient(12, .2);
+
+  test_curve(z, "zernike", false);
+
+  PolynomialCount p;
+
+  p.set_even(2, 8, 1.0 / 60, 3e-6, -2e-9, 1e-12);
+
+  test_curve(p, "polynomial", true);
+
+  ref<Curve::Zernike> zs = ref<Curve::Zernike>::create(radius);
+
+  zs->set_coefficient(4, .02);
+  zs->set_coefficient(5, .005);
+  zs->set_coefficient(8, .003);
+  zs->set_coefficient(12, .002);
+
+  test_threads(zs);
+
+  return 0;
+}
@@ -31,6 +31,8 @@
 #include <Goptical/Material/Abbe>
 #include <Goptical/Material/Mil>
 #include <Goptical/Material/Conrady>
+#include <Goptical/Material/Dielectric>
+#include <Goptical/Material/Chebyshev>
 
 using namespace Goptical;
 
@@ -165,6 +167,52 @@ int main()
     COMPARE( cn.Base::get_refractive_index(800., airm), 1.4680404 , 2e-7);
   }
 
+  // test Chebyshev approximant
+  {
+    // BAF3
+    ref<Material::Sellmeier> sellm =
+      ref<Material::Sellmeier>::create(1.32064267E+000, 8.87798715E-003, 1.33572683E-001,
+                                       4.20290346E-002, 8.85521821E-001, 1.11729167E+002);
+    sellm->set_temperature_schott(1.4100E-006, 1.7300E-008, -1.5100E-011,
+                                  5.7600E-007, 4.6800E-010, 2.6700E-001);
+    sellm->set_wavelen_range(365., 1014.);
+
+    ref<Material::AbbeVd> abbe = ref<Material::AbbeVd>::create(1.582670, 46.47, .0001);
+    ref<Material::Conrady> cn =
+      ref<Material::Conrady>::create(1.45217000E+000, 1.25800000E-002, 6.65900000E-005);
+
+    const_ref<Material::Dielectric> mats[3] = { sellm, abbe, cn };
+
+    for (unsigned int i = 0; i < 3; i++)
+      {
+        const Material::Dielectric &m = *mats[i];
+        Material::Chebyshev cheb(mats[i], 1e-8);
+
+        if (cheb.get_fit_error() > 1e-8)
+          FAIL(__LINE__ << " bad fit error " << cheb.get_fit_error());
+
+        for (double wl = m.get_low_wavelen(); wl <= m.get_high_wavelen(); wl += 0.37)
+          COMPARE( cheb.get_refractive_index(wl), m.get_refractive_index(wl), 1e-8);
+
+        COMPARE( cheb.get_refractive_index(m.get_high_wavelen()),
+                 m.get_refractive_index(m.get_high_wavelen()), 1e-8);
+
+        // original model used outside of fitted range
+        COMPARE( cheb.get_refractive_index(m.get_high_wavelen() + 200.),
+                 m.get_refractive_index(m.get_high_wavelen() + 200.), 1e-15);
+      }
+
+    Material::Chebyshev cheb(sellm, 1e-8);
+
+    // original model used when temperature changes
+    sellm->set_temperature(100.);
+    COMPARE( cheb.get_refractive_index(400.), sellm->get_refractive_index(400.), 1e-15);
+
+    cheb.update();
+    COMPARE( cheb.get_refractive_index(400.), sellm->get_refractive_index(400.), 1e-8);
+    COMPARE( cheb.get_temperature(), 100., 1e-15);
+  }
+
   return 0;
 }
 
@@ -0,0 +1,159 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+
+#include <iostream>
+#include <cstdlib>
+#include <set>
+
+#include <pthread.h>
+
+#include <Goptical/Error>
+
+#include "parallel_.hh"
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* record threads running jobs and sum jobs indexes */
+class record_job : public _Goptical::parallel_job_t
+{
+public:
+  record_job(std::set<pthread_t> &threads, unsigned int &sum, unsigned int nested)
+    : _threads(threads),
+      _sum(sum),
+      _nested(nested)
+  {
+  }
+
+private:
+  bool valid() const
+  {
+    return true;
+  }
+
+  void call(unsigned int i) const
+  {
+    pthread_mutex_lock(&lock);
+    _threads.insert(pthread_self());
+    _sum += i;
+    pthread_mutex_unlock(&lock);
+
+    if (_nested)
+      {
+        unsigned int sum = 0;
+        std::set<pthread_t> threads;
+
+        _Goptical::parallel_for(_nested, 2, record_job(threads, sum, 0));
+
+        if (sum != _nested * (_nested - 1) / 2)
+          FAIL("nested jobs sum " << sum);
+      }
+  }
+
+  std::set<pthread_t> &_threads;
+  unsigned int &_sum;
+  unsigned int _nested;
+};
+
+/* throw an exception which does not derive from std::exception */
+class throw_job : public _Goptical::parallel_job_t
+{
+private:
+  bool valid() const
+  {
+    return true;
+  }
+
+  void call(unsigned int i) const
+  {
+    if (i == 5)
+      throw 42;
+  }
+};
+
+static void * concurrent_func(void *)
+{
+  for (unsigned int k = 0; k < 50; k++)
+    {
+      unsigned int sum = 0;
+      std::set<pthread_t> threads;
+
+      _Goptical::parallel_for(100, 3, record_job(threads, sum, 0));
+
+      if (sum != 100 * 99 / 2)
+        FAIL("concurrent jobs sum " << sum);
+    }
+
+  return 0;
+}
+
+int main()
+{
+  std::set<pthread_t> threads;
+
+  // worker threads are kept between calls
+  for (unsigned int k = 0; k < 100; k++)
+    {
+      unsigned int sum = 0;
+
+      _Goptical::parallel_for(64, 4, record_job(threads, sum, 0));
+
+      if (sum != 64 * 63 / 2)
+        FAIL("jobs sum " << sum);
+    }
+
+  if (threads.size() > 4)
+    FAIL(threads.size() << " threads used by successive calls");
+
+  // any exception type is reported as an Error
+  try {
+    _Goptical::parallel_for(64, 4, throw_job());
+    FAIL("exception not reported");
+  } catch (const Error &e) {
+  }
+
+  // nested calls
+  unsigned int sum = 0;
+  _Goptical::parallel_for(16, 4, record_job(threads, sum, 8));
+
+  // concurrent calls
+  pthread_t t[4];
+
+  for (unsigned int i = 0; i < 4; i++)
+    if (pthread_create(&t[i], 0, concurrent_func, 0))
+      FAIL("unable to create thread");
+
+  for (unsigned int i = 0; i < 4; i++)
+    pthread_join(t[i], 0);
+
+  return 0;
+}
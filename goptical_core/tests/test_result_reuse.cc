@@ -0,0 +1,227 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <new>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/Surface>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Distribution>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+
+#include <Goptical/Light/SpectralLine>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+/* count heap allocations performed through operator new, worker
+   threads may allocate concurrently. All replacements use malloc and
+   free and are never inlined so that the compiler does not pair an
+   inlined free with a new expression. */
+static unsigned long alloc_count = 0;
+
+static __attribute__((noinline)) void * counted_malloc(std::size_t size)
+{
+  __sync_fetch_and_add(&alloc_count, 1);
+
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void * operator new(std::size_t size)
+{
+  return counted_malloc(size);
+}
+
+__attribute__((noinline)) void * operator new[](std::size_t size)
+{
+  return counted_malloc(size);
+}
+
+__attribute__((noinline)) void operator delete(void *p)
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p)
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, std::size_t)
+{
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void *p, std::size_t)
+{
+  std::free(p);
+}
+
+struct trace_config_s
+{
+  bool sequential;
+  bool packet;
+  Trace::IntensityMode intensity;
+  unsigned int threads;
+};
+
+static std::ostream & operator<<(std::ostream &o, const trace_config_s &c)
+{
+  return o << (c.sequential ? "sequential" : "non sequential")
+           << (c.packet ? ", packet mode" : "")
+           << ", intensity mode " << c.intensity
+           << ", " << c.threads << " threads";
+}
+
+static const_ref<Material::Base> glass(double nd, double vd)
+{
+  ref<Material::AbbeVd> m = ref<Material::AbbeVd>::create(nd, vd);
+
+  // intensity trace needs internal transmittance data
+  for (unsigned int i = 0; i < 4; i++)
+    m->set_internal_transmittance(400 + i * 100, 10, 0.99);
+
+  return m;
+}
+
+int main()
+{
+  Sys::System   sys;
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  lens.add_surface(1/0.031186861,  14.934638, 4.627804137,
+                   glass(1.607170, 59.5002));
+  lens.add_surface(0,              14.934638, 5.417429465);
+  lens.add_surface(1/-0.014065441, 12.766446, 3.728230979,
+                   glass(1.575960, 41.2999));
+  lens.add_surface(1/0.034678487,  11.918098, 4.417903733);
+  lens.add_stop   (                12.066273, 2.288913925);
+  lens.add_surface(0,              12.372318, 1.499288597,
+                   glass(1.526480, 51.4000));
+  lens.add_surface(1/0.035104369,  14.642815, 7.996205852,
+                   glass(1.623770, 56.8998));
+  lens.add_surface(1/-0.021187519, 14.642815, 85.243965130);
+
+  // keep ghost rays trees small in non sequential intensity mode
+  for (unsigned int i = 0; i < 7; i++)
+    lens.get_surface(i).set_discard_intensity(0.01);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 125.596), 5);
+  sys.add(image);
+
+  Sys::SourcePoint source(Sys::SourceAtFiniteDistance,
+                          Math::Vector3(0, 27.5, -1000));
+  sys.add(source);
+
+  source.clear_spectrum();
+  source.add_spectral_line(Light::SpectralLine::C);
+  source.add_spectral_line(Light::SpectralLine::e);
+  source.add_spectral_line(Light::SpectralLine::F);
+
+  sys.get_tracer_params().set_default_distribution(
+    Trace::Distribution(Trace::HexaPolarDist, 10));
+
+  Trace::Sequence seq(sys);
+
+  static const trace_config_s configs[] = {
+    { false, false, Trace::SimpleTrace, 1 },
+    { false, false, Trace::IntensityTrace, 1 },
+    { true, false, Trace::SimpleTrace, 1 },
+    { true, false, Trace::IntensityTrace, 1 },
+    { true, true, Trace::SimpleTrace, 1 },
+    { true, true, Trace::IntensityTrace, 1 },
+    { false, false, Trace::SimpleTrace, 3 },
+    { false, false, Trace::IntensityTrace, 3 },
+    { true, false, Trace::SimpleTrace, 3 },
+    { true, false, Trace::IntensityTrace, 3 },
+    { true, true, Trace::SimpleTrace, 3 },
+    { true, true, Trace::IntensityTrace, 3 },
+  };
+
+  for (unsigned int j = 0; j < sizeof(configs) / sizeof(configs[0]); j++)
+    {
+      const trace_config_s &c = configs[j];
+
+      Trace::Tracer tracer(sys);
+      Trace::Params &params = tracer.get_params();
+      Trace::Result &result = tracer.get_trace_result();
+
+      if (c.sequential)
+        params.set_sequential_mode(seq);
+      params.set_packet_mode(c.packet);
+      params.set_intensity_mode(c.intensity);
+      params.set_thread_count(c.threads);
+
+      result.set_intercepted_save_state(image);
+      result.set_generated_save_state(lens.get_surface(6));
+
+      // first trace allocates rays pools, lists and packets
+      tracer.trace();
+
+      unsigned int count = result.get_intercepted(image).size();
+
+      if (!count)
+        FAIL(c << ": no ray hit the image plane");
+
+      for (unsigned int k = 0; k < 3; k++)
+        {
+          unsigned long n = alloc_count;
+
+          tracer.trace();
+
+          n = alloc_count - n;
+
+          if (n)
+            FAIL(c << ": " << n << " heap allocations on trace " << k + 2);
+
+          if (result.get_intercepted(image).size() != count)
+            FAIL(c << ": rays count differs on trace " << k + 2);
+        }
+    }
+
+  return 0;
+}
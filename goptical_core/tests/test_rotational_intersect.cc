@@ -0,0 +1,233 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+
+#include <Goptical/Curve/Rotational>
+#include <Goptical/Curve/RotationalDual>
+#include <Goptical/Curve/Polynomial>
+#include <Goptical/Curve/Sphere>
+
+#include <Goptical/Sys/Stop>
+#include <Goptical/Trace/Params>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+/* sphere without closed form intersection */
+class SphereSag : public Curve::RotationalDual<SphereSag>
+{
+public:
+  SphereSag(double roc)
+    : _roc(roc)
+  {
+  }
+
+  template <typename T> T sagitta_t(const T &r) const
+  {
+    return _roc - (_roc > 0 ? 1.0 : -1.0) * sqrt(_roc * _roc - r * r);
+  }
+
+private:
+  double _roc;
+};
+
+/* check point is on ray and on curve */
+static void check_point(const Curve::Rotational &c, const Math::VectorPair3 &ray,
+                        const Math::Vector3 &p)
+{
+  Math::Vector3 v(p - ray.origin());
+  double t = v * ray.direction();
+
+  if ((v - ray.direction() * t).len() > 1e-9 || t < -1e-12)
+    fail("intersection point not on ray " << p);
+
+  if (fabs(p.z() - c.sagitta(p.project_xy())) > 1e-9)
+    fail("intersection point not on curve " << p);
+}
+
+static void random_ray(Math::VectorPair3 &ray, double r)
+{
+  ray.origin() = Math::Vector3(drand48() * 2 * r - r, drand48() * 2 * r - r, -50);
+  ray.direction() = Math::Vector3(drand48() * .6 - .3, drand48() * .6 - .3, 1);
+  ray.direction().normalize();
+}
+
+static void test_sphere()
+{
+  const double roc = 40, radius = 25;
+  Curve::Sphere ref(roc);
+  SphereSag c(roc);
+
+  srand48(1);
+
+  for (unsigned int i = 0; i < 10000; i++)
+    {
+      Math::VectorPair3 ray;
+      Math::Vector3 p1, p2;
+      Curve::Rotational::intersect_stats_s stats;
+
+      random_ray(ray, radius);
+
+      bool h1 = ref.intersect(p1, ray) && p1.project_xy().len() < radius;
+      bool h2 = c.intersect_bounded(p2, ray, radius, stats);
+
+      if (h2)
+        check_point(c, ray, p2);
+
+      if (h1 && (!h2 || (p1 - p2).len() > 1e-9))
+        fail("sphere intersection mismatch " << p1 << " " << p2);
+
+      if (stats.iterations > 10)
+        fail("too many iterations " << stats.iterations);
+    }
+}
+
+static void test_asphere()
+{
+  const double radius = 30;
+  Curve::Polynomial c;
+  unsigned int count = 0, iterations = 0;
+
+  c.set_even(2, 12, 1.0 / 80, 2e-6, -3e-9, 1e-12, 4e-16, -2e-19);
+
+  srand48(2);
+
+  for (unsigned int i = 0; i < 10000; i++)
+    {
+      Math::VectorPair3 ray;
+      Math::Vector3 p1, p2;
+      Curve::Rotational::intersect_stats_s stats;
+
+      random_ray(ray, radius);
+
+      bool h1 = c.intersect(p1, ray);
+      bool h2 = c.intersect_bounded(p2, ray, radius, stats);
+
+      if (!h2)
+        continue;
+
+      check_point(c, ray, p2);
+
+      // solutions found by generic method inside radius must agree
+      if (h1 && p1.project_xy().len() < radius && (p1 - p2).len() > 1e-8)
+        fail("asphere intersection mismatch " << p1 << " " << p2);
+
+      count++;
+      iterations += stats.iterations;
+    }
+
+  if (count < 5000)
+    fail("asphere intersections missed " << count);
+
+  if (iterations > count * 6)
+    fail("asphere average iterations too high " << (double)iterations / count);
+}
+
+static void test_grazing()
+{
+  Curve::Polynomial c;
+  Math::Vector3 p;
+  Curve::Rotational::intersect_stats_s stats;
+
+  c.set_even(2, 2, 0.01);
+
+  // ray parallel to vertex plane crosses the curve twice
+  Math::VectorPair3 ray(Math::Vector3(-25, 0, 3.5), Math::Vector3(1, 0, 0));
+
+  if (!c.intersect_bounded(p, ray, 20, stats) || !stats.scanned)
+    fail("grazing ray missed");
+
+  check_point(c, ray, p);
+
+  if (fabs(p.x() + sqrt(350.0)) > 1e-9)
+    fail("grazing ray first intersection not found " << p);
+
+  // ray out of curve range
+  ray.origin().z() = 5.0;
+
+  if (c.intersect_bounded(p, ray, 20, stats))
+    fail("false intersection");
+
+  // ray along curve axis
+  ray = Math::VectorPair3(Math::Vector3(3, 4, -10), Math::Vector3(0, 0, 1));
+
+  if (!c.intersect_bounded(p, ray, 20, stats) || fabs(p.z() - 0.25) > 1e-12)
+    fail("axial ray intersection");
+
+  // ray outside radius
+  if (c.intersect_bounded(p, ray, 4, stats))
+    fail("intersection outside radius");
+}
+
+static void test_stop()
+{
+  ref<Curve::Polynomial> c = ref<Curve::Polynomial>::create();
+  c->set_even(2, 2, 0.01);
+
+  // external radius defaults to twice the aperture radius
+  Sys::Stop stop(Math::VectorPair3(0, 0, 0), 10);
+  stop.set_curve(c);
+
+  Trace::Params params;
+  Math::VectorPair3 pt;
+
+  // non sequential stop blocks rays between aperture and external radius
+  Math::VectorPair3 ray(Math::Vector3(15, 0, -10), Math::Vector3(0, 0, 1));
+
+  if (!stop.intersect(params, pt, ray) || fabs(pt.origin().z() - 2.25) > 1e-12)
+    fail("stop intersection outside aperture missed");
+
+  // rays inside aperture are not intercepted
+  ray.origin().x() = 5;
+
+  if (stop.intersect(params, pt, ray))
+    fail("stop intersection inside aperture");
+
+  // rays beyond external radius are not intercepted
+  ray.origin().x() = 25;
+
+  if (stop.intersect(params, pt, ray))
+    fail("stop intersection beyond external radius");
+}
+
+int main()
+{
+  test_sphere();
+  test_asphere();
+  test_grazing();
+  test_stop();
+
+  return 0;
+}
@@ -0,0 +1,218 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+#include <Goptical/Trace/Distribution>
+
+#include <Goptical/Light/SpectralLine>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static const unsigned int line_count = 60;
+
+struct rays_stats_s
+{
+  unsigned int count;
+  unsigned int image_count;
+  double intensity;
+  double wavelen;               // intensity weighted mean wavelen
+  std::vector<unsigned int> line_hits;
+};
+
+static rays_stats_s trace(Trace::Tracer &tracer, const Sys::SourcePoint &source,
+                          const Sys::Image &image)
+{
+  Trace::Result &result = tracer.get_trace_result();
+  const std::vector<Light::SpectralLine> &spectrum = source.get_spectrum();
+
+  result.set_generated_save_state(source);
+  result.set_intercepted_save_state(image);
+  tracer.trace();
+
+  const Trace::rays_queue_t &rays = result.get_generated(source);
+  rays_stats_s s;
+
+  s.count = rays.size();
+  s.image_count = result.get_intercepted(image).size();
+  s.intensity = s.wavelen = 0;
+  s.line_hits.resize(spectrum.size(), 0);
+
+  GOPTICAL_FOREACH(r, rays)
+    {
+      s.intensity += (*r)->get_intensity();
+      s.wavelen += (*r)->get_intensity() * (*r)->get_wavelen();
+
+      for (unsigned int i = 0; i < spectrum.size(); i++)
+        if (spectrum[i].get_wavelen() == (*r)->get_wavelen())
+          s.line_hits[i]++;
+    }
+
+  s.wavelen /= s.intensity;
+
+  return s;
+}
+
+static const_ref<Material::Base> glass(double nd, double vd)
+{
+  ref<Material::AbbeVd> m = ref<Material::AbbeVd>::create(nd, vd);
+
+  for (unsigned int i = 0; i < 4; i++)
+    m->set_internal_transmittance(400 + i * 100, 10, 0.9 + i * 0.02);
+
+  return m;
+}
+
+int main()
+{
+  Sys::System   sys;
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  lens.add_surface(1/0.031186861,  14.934638, 4.627804137,
+                   glass(1.607170, 59.5002));
+  lens.add_surface(0,              14.934638, 5.417429465);
+  lens.add_stop   (                12.066273, 2.288913925);
+  lens.add_surface(0,              12.372318, 1.499288597,
+                   glass(1.526480, 51.4000));
+  lens.add_surface(1/-0.021187519, 14.642815, 85.243965130);
+
+  // keep ghost rays trees small in non sequential intensity mode
+  for (unsigned int i = 0; i < 4; i++)
+    lens.get_surface(i).set_discard_intensity(0.01);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 125.596), 25);
+  sys.add(image);
+
+  Sys::SourcePoint source(Sys::SourceAtInfinity, Math::Vector3(0, 0.05, 1));
+  source.clear_spectrum();
+
+  // measured like spectrum, last line has no energy
+  for (unsigned int i = 0; i < line_count; i++)
+    source.add_spectral_line(Light::SpectralLine(420. + i * 5.,
+      i + 1 < line_count ? 1.5 + std::sin(i * 0.3) : 0.));
+  sys.add(source);
+
+  const std::vector<Light::SpectralLine> &spectrum = source.get_spectrum();
+  double total = 0;
+  GOPTICAL_FOREACH(l, spectrum)
+    total += l->get_intensity();
+
+  ref<Trace::Sequence> seq = ref<Trace::Sequence>::create(sys);
+
+  for (unsigned int j = 0; j < 2; j++)
+    {
+      Trace::Tracer tracer(sys);
+      Trace::Params &params = tracer.get_params();
+
+      if (j)
+        params.set_sequential_mode(seq);
+      params.set_intensity_mode(Trace::IntensityTrace);
+      params.get_default_distribution().set_radial_density(10);
+
+      source.set_spectral_sampling(Sys::SpectralAllLines);
+      rays_stats_s all = trace(tracer, source, image);
+
+      if (all.count % line_count)
+        FAIL(j << ": rays count is not a multiple of lines count");
+
+      unsigned int points = all.count / line_count;
+
+      static const Sys::SpectralSampling modes[] = {
+        Sys::SpectralStratified, Sys::SpectralImportance
+      };
+
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          source.set_spectral_sampling(modes[k]);
+
+          if (source.get_spectral_sampling() != modes[k])
+            FAIL(j << ": sampling mode not kept");
+
+          rays_stats_s s = trace(tracer, source, image);
+
+          if (s.count != points)
+            FAIL(j << "," << k << ": " << s.count << " rays generated, expecting " << points);
+
+          if (s.image_count == 0)
+            FAIL(j << "," << k << ": no ray hit the image plane");
+
+          // energy is conserved, exactly for importance sampling
+          double tol = modes[k] == Sys::SpectralImportance ? 1e-9 : 0.02;
+
+          if (std::fabs(s.intensity / all.intensity - 1.) > tol)
+            FAIL(j << "," << k << ": energy not conserved " << s.intensity
+                 << " " << all.intensity);
+
+          if (std::fabs(s.wavelen - all.wavelen) > 2.)
+            FAIL(j << "," << k << ": mean wavelen " << s.wavelen << " expecting " << all.wavelen);
+
+          for (unsigned int i = 0; i < line_count; i++)
+            {
+              // expected hits count for this line
+              double p = modes[k] == Sys::SpectralImportance
+                ? spectrum[i].get_intensity() / total : 1. / line_count;
+
+              if (std::fabs(s.line_hits[i] - p * points) > 1.5)
+                FAIL(j << "," << k << ": line " << i << " sampled " << s.line_hits[i]
+                     << " times, expecting " << p * points);
+            }
+        }
+
+      // rays without spectral sampling are left unchanged
+      source.set_spectral_sampling(Sys::SpectralAllLines);
+      rays_stats_s again = trace(tracer, source, image);
+
+      if (again.count != all.count || again.intensity != all.intensity)
+        FAIL(j << ": all lines mode changed");
+    }
+
+  return 0;
+}
@@ -0,0 +1,262 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/Source>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/OpticalSurface>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+#include <Goptical/Trace/SpectralTable>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static const double wavelens[] = { 486.1327, 587.5618, 656.2725 };
+
+/* source with a grid of parallel rays, spectral table is not built
+   for rays wavelens when they are not declared to result */
+class GridSource : public Sys::Source
+{
+public:
+  GridSource(const Math::Vector3 &pos, bool declare)
+    : Sys::Source(Math::VectorPair3(pos, Math::vector3_001)),
+      _declare(declare)
+  {
+  }
+
+private:
+  void generate_rays_simple(Trace::Result &result, const targets_t &) const
+  {
+    for (unsigned int w = 0; w < 3; w++)
+      {
+        if (_declare)
+          result.add_ray_wavelen(wavelens[w]);
+
+        for (int x = -5; x <= 5; x++)
+          for (int y = -5; y <= 5; y++)
+            {
+              Trace::Ray &r = result.new_ray();
+
+              r.origin() = Math::Vector3(x * 2.5, y * 2.5, 0);
+              r.direction() = Math::vector3_001;
+              r.set_creator(this);
+              r.set_intensity(1.0);
+              r.set_wavelen(wavelens[w]);
+              r.set_material(&get_system()->get_environment_proxy());
+            }
+      }
+  }
+
+  void generate_rays_intensity(Trace::Result &result, const targets_t &entry) const
+  {
+    generate_rays_simple(result, entry);
+  }
+
+  bool _declare;
+};
+
+static const_ref<Material::Base> glass(double nd, double vd)
+{
+  ref<Material::AbbeVd> m = ref<Material::AbbeVd>::create(nd, vd);
+
+  for (unsigned int i = 0; i < 4; i++)
+    m->set_internal_transmittance(400 + i * 100, 10, 0.9 + i * 0.02);
+
+  return m;
+}
+
+struct trace_config_s
+{
+  bool sequential;
+  bool packet;
+  Trace::IntensityMode intensity;
+};
+
+static std::ostream & operator<<(std::ostream &o, const trace_config_s &c)
+{
+  return o << (c.sequential ? "sequential" : "non sequential")
+           << (c.packet ? ", packet mode" : "")
+           << ", intensity mode " << c.intensity;
+}
+
+int main()
+{
+  Sys::System   sys;
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  lens.add_surface(1/0.031186861,  14.934638, 4.627804137,
+                   glass(1.607170, 59.5002));
+  lens.add_surface(0,              14.934638, 5.417429465);
+  lens.add_surface(1/-0.014065441, 12.766446, 3.728230979,
+                   glass(1.575960, 41.2999));
+  lens.add_surface(1/0.034678487,  11.918098, 4.417903733);
+  lens.add_stop   (                12.066273, 2.288913925);
+  lens.add_surface(0,              12.372318, 1.499288597,
+                   glass(1.526480, 51.4000));
+  lens.add_surface(1/0.035104369,  14.642815, 7.996205852,
+                   glass(1.623770, 56.8998));
+  lens.add_surface(1/-0.021187519, 14.642815, 85.243965130);
+
+  // keep ghost rays trees small in non sequential intensity mode
+  for (unsigned int i = 0; i < 7; i++)
+    lens.get_surface(i).set_discard_intensity(0.01);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 125.596), 15);
+  sys.add(image);
+
+  GridSource    ref_source(Math::Vector3(0, 0, -20), false);
+  GridSource    source(Math::Vector3(0, 0, -20), true);
+  sys.add(ref_source);
+  sys.add(source);
+
+  ref<Trace::Sequence> seq = ref<Trace::Sequence>::create(sys);
+
+  static const trace_config_s configs[] = {
+    { false, false, Trace::SimpleTrace },
+    { false, false, Trace::IntensityTrace },
+    { true, false, Trace::SimpleTrace },
+    { true, false, Trace::IntensityTrace },
+    { true, true, Trace::SimpleTrace },
+    { true, true, Trace::IntensityTrace },
+  };
+
+  for (unsigned int j = 0; j < sizeof(configs) / sizeof(configs[0]); j++)
+    {
+      const trace_config_s &c = configs[j];
+
+      Trace::Tracer ref_tracer(sys);
+      Trace::Tracer tracer(sys);
+
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          Trace::Params &params = k ? tracer.get_params() : ref_tracer.get_params();
+
+          if (c.sequential)
+            params.set_sequential_mode(seq);
+          params.set_packet_mode(c.packet);
+          params.set_intensity_mode(c.intensity);
+        }
+
+      Trace::Result &ref_result = ref_tracer.get_trace_result();
+      Trace::Result &result = tracer.get_trace_result();
+
+      ref_result.set_intercepted_save_state(image);
+      result.set_intercepted_save_state(image);
+
+      // rays of reference source are traced using material models
+      source.set_enable_state(false);
+      ref_tracer.trace();
+      source.set_enable_state(true);
+
+      ref_source.set_enable_state(false);
+      tracer.trace();
+      ref_source.set_enable_state(true);
+
+      const Trace::rays_queue_t &ref_rays = ref_result.get_intercepted(image);
+      const Trace::rays_queue_t &rays = result.get_intercepted(image);
+
+      if (ref_rays.empty())
+        FAIL(c << ": no ray hit the image plane");
+
+      if (rays.size() != ref_rays.size())
+        FAIL(c << ": " << rays.size() << " rays on image, expecting " << ref_rays.size());
+
+      for (unsigned int i = 0; i < rays.size(); i++)
+        {
+          const Trace::Ray &a = *ref_rays[i];
+          const Trace::Ray &b = *rays[i];
+
+          if (!(a.get_intercept_point() == b.get_intercept_point()) ||
+              a.get_intercept_intensity() != b.get_intercept_intensity() ||
+              a.get_wavelen() != b.get_wavelen())
+            FAIL(c << ": ray " << i << " differs");
+        }
+
+      // check table content against material models
+      const Trace::SpectralTable &table = result.get_spectral_table();
+
+      for (unsigned int i = 0; i < 7; i++)
+        {
+          const Sys::OpticalSurface &s = lens.get_surface(i);
+
+          for (unsigned int w = 0; w < 3; w++)
+            for (unsigned int rl = 0; rl < 2; rl++)
+              {
+                const Trace::SpectralTable::surface_entry_s *e =
+                  table.get_surface_entry(s, rl, wavelens[w]);
+
+                if (!e)
+                  FAIL(c << ": missing surface entry");
+
+                const Material::Base &prev = s.get_material(rl);
+                const Material::Base &next = s.get_material(!rl);
+
+                if (e->_index != prev.get_refractive_index(wavelens[w]) /
+                    next.get_refractive_index(wavelens[w]))
+                  FAIL(c << ": bad surface entry index");
+
+                double t;
+
+                if (c.intensity != Trace::IntensityTrace)
+                  continue;
+
+                if (e->_reflectance != next.get_normal_reflectance(&prev, wavelens[w]) ||
+                    e->_transmittance != next.get_normal_transmittance(&prev, wavelens[w]))
+                  FAIL(c << ": bad surface entry coefficients");
+
+                if (!table.get_internal_transmittance(&prev, wavelens[w], t) ||
+                    t != prev.get_internal_transmittance(wavelens[w], 1.0))
+                  FAIL(c << ": bad internal transmittance");
+              }
+
+          if (table.get_surface_entry(s, 0, 500.0))
+            FAIL(c << ": unexpected entry for wavelen not in use");
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,289 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Sellmeier>
+#include <Goptical/Material/Air>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/Source>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/OpticalSurface>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+
+#include <Goptical/Light/SpectralLine>
+
+#include <Goptical/Error>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+/* source with a grid of parallel rays which does not declare its
+   wavelen to result */
+class GridSource : public Sys::Source
+{
+public:
+  GridSource(const Math::Vector3 &pos)
+    : Sys::Source(Math::VectorPair3(pos, Math::vector3_001))
+  {
+  }
+
+private:
+  void generate_rays_simple(Trace::Result &result, const targets_t &) const
+  {
+    for (int x = -4; x <= 4; x++)
+      for (int y = -4; y <= 4; y++)
+        {
+          Trace::Ray &r = result.new_ray();
+
+          r.origin() = Math::Vector3(x * 2.5, y * 2.5, 0);
+          r.direction() = Math::vector3_001;
+          r.set_creator(this);
+          r.set_intensity(1.0);
+          r.set_wavelen(520.0);
+          r.set_material(&get_system()->get_environment_proxy());
+        }
+  }
+
+  void generate_rays_intensity(Trace::Result &result, const targets_t &entry) const
+  {
+    generate_rays_simple(result, entry);
+  }
+};
+
+/* BAF3 with Schott thermal coefficients */
+static ref<Material::Sellmeier> glass(double scale)
+{
+  ref<Material::Sellmeier> m =
+    ref<Material::Sellmeier>::create(1.32064267E+000 * scale, 8.87798715E-003,
+                                     1.33572683E-001, 4.20290346E-002,
+                                     8.85521821E-001, 1.11729167E+002);
+
+  m->set_temperature_schott(1.4100E-006, 1.7300E-008, -1.5100E-011,
+                            5.7600E-007, 4.6800E-010, 2.6700E-001);
+
+  for (unsigned int i = 0; i < 4; i++)
+    m->set_internal_transmittance(400 + i * 100, 10, 0.9 + i * 0.02);
+
+  return m;
+}
+
+/* material without refractive index temperature model */
+class FixedIndex : public Material::Base
+{
+public:
+  bool is_opaque() const
+  {
+    return false;
+  }
+
+  bool is_reflecting() const
+  {
+    return false;
+  }
+
+  double get_refractive_index(double) const
+  {
+    return 1.5;
+  }
+};
+
+struct trace_config_s
+{
+  bool sequential;
+  bool packet;
+  Trace::IntensityMode intensity;
+};
+
+static const trace_config_s configs[] = {
+  { false, false, Trace::SimpleTrace },
+  { true, false, Trace::SimpleTrace },
+  { true, true, Trace::SimpleTrace },
+  { true, false, Trace::IntensityTrace },
+};
+
+static const double temperatures[] = { -40., -10., 20., 45., 80. };
+static const unsigned int tcount = sizeof(temperatures) / sizeof(temperatures[0]);
+
+int main()
+{
+  Sys::System   sys;
+
+  ref<Material::AirBirch94> air = ref<Material::AirBirch94>::create();
+  sys.set_environment(air);
+
+  std::vector<ref<Material::Sellmeier> > glasses;
+  for (unsigned int i = 0; i < 4; i++)
+    glasses.push_back(glass(1.0 + i * 0.05));
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  lens.add_surface(1/0.031186861,  14.934638, 4.627804137, glasses[0]);
+  lens.add_surface(0,              14.934638, 5.417429465);
+  lens.add_surface(1/-0.014065441, 12.766446, 3.728230979, glasses[1]);
+  lens.add_surface(1/0.034678487,  11.918098, 4.417903733);
+  lens.add_stop   (                12.066273, 2.288913925);
+  lens.add_surface(0,              12.372318, 1.499288597, glasses[2]);
+  lens.add_surface(1/0.035104369,  14.642815, 7.996205852, glasses[3]);
+  lens.add_surface(1/-0.021187519, 14.642815, 85.243965130);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 125.596), 15);
+  sys.add(image);
+
+  Sys::SourcePoint source(Sys::SourceAtInfinity, Math::Vector3(0, 0.03, 1));
+  source.clear_spectrum();
+  source.add_spectral_line(Light::SpectralLine::d);
+  source.add_spectral_line(Light::SpectralLine::F);
+  sys.add(source);
+
+  GridSource    grid(Math::Vector3(0, 0, -20));
+  sys.add(grid);
+
+  ref<Trace::Sequence> seq = ref<Trace::Sequence>::create(sys);
+
+  for (unsigned int j = 0; j < sizeof(configs) / sizeof(configs[0]); j++)
+    {
+      const trace_config_s &c = configs[j];
+
+      Trace::Tracer ref_tracer(sys);
+      Trace::Tracer tracer(sys);
+
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          Trace::Params &params = k ? tracer.get_params() : ref_tracer.get_params();
+
+          if (c.sequential)
+            params.set_sequential_mode(seq);
+          params.set_packet_mode(c.packet);
+          params.set_intensity_mode(c.intensity);
+          params.get_default_distribution().set_radial_density(4);
+        }
+
+      tracer.get_params().set_thread_count(j % 2 ? 0 : 1);
+
+      // reference traces with all materials set to each temperature
+      std::vector<std::vector<Math::Vector3> > ref_points(tcount);
+      std::vector<std::vector<double> > ref_intensities(tcount);
+
+      for (unsigned int t = 0; t < tcount; t++)
+        {
+          air->set_temperature(temperatures[t]);
+          for (unsigned int i = 0; i < glasses.size(); i++)
+            glasses[i]->set_temperature(temperatures[t]);
+
+          Trace::Result &result = ref_tracer.get_trace_result();
+          result.set_intercepted_save_state(image);
+          ref_tracer.trace();
+
+          const Trace::rays_queue_t &rays = result.get_intercepted(image);
+
+          if (rays.empty())
+            FAIL(j << ": no ray hit the image plane");
+
+          GOPTICAL_FOREACH(r, rays)
+            {
+              ref_points[t].push_back((*r)->get_intercept_point());
+              ref_intensities[t].push_back((*r)->get_intensity());
+            }
+        }
+
+      air->set_temperature(20.);
+      for (unsigned int i = 0; i < glasses.size(); i++)
+        glasses[i]->set_temperature(20.);
+
+      // first sweep creates batch tracers, second one reuses them
+      for (unsigned int pass = 0; pass < 2; pass++)
+        {
+          tracer.trace_temperatures(std::vector<double>(temperatures, temperatures + tcount));
+
+          if (tracer.get_batch_size() != tcount)
+            FAIL(j << ": bad batch size");
+
+          for (unsigned int t = 0; t < tcount; t++)
+            {
+              Trace::Result &result = tracer.get_batch_result(t);
+
+              if (!pass)
+                {
+                  result.set_intercepted_save_state(image);
+                  continue;
+                }
+
+              const Trace::rays_queue_t &rays = result.get_intercepted(image);
+
+              if (rays.size() != ref_points[t].size())
+                FAIL(j << ": " << rays.size() << " rays on image at "
+                     << temperatures[t] << ", expecting " << ref_points[t].size());
+
+              for (unsigned int i = 0; i < rays.size(); i++)
+                if (!(rays[i]->get_intercept_point() == ref_points[t][i]) ||
+                    rays[i]->get_intensity() != ref_intensities[t][i])
+                  FAIL(j << ": ray " << i << " differs at " << temperatures[t]);
+            }
+        }
+
+      // temperature must have an effect on this design
+      if (ref_points[0][1] == ref_points[tcount - 1][1])
+        FAIL(j << ": temperature has no effect");
+
+      // materials are left untouched
+      if (glasses[0]->get_temperature() != 20. || air->get_temperature() != 20.)
+        FAIL(j << ": material temperature modified");
+    }
+
+  // material without temperature model can not be swept
+  lens.get_surface(2).set_material(1, ref<FixedIndex>::create());
+
+  try {
+    Trace::Tracer tracer(sys);
+
+    tracer.get_params().set_sequential_mode(seq);
+    tracer.trace_temperatures(std::vector<double>(temperatures, temperatures + tcount));
+    FAIL("material without temperature model traced");
+  } catch (const Error &e) {
+  }
+
+  return 0;
+}
+
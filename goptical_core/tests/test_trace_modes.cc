@@ -0,0 +1,246 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Abbe>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/SourceRays>
+#include <Goptical/Sys/Image>
+#include <Goptical/Sys/Surface>
+
+#include <Goptical/Curve/Polynomial>
+#include <Goptical/Shape/Disk>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Distribution>
+#include <Goptical/Trace/Sequence>
+#include <Goptical/Trace/Params>
+
+#include <Goptical/Light/SpectralLine>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static unsigned int ray_depth(const Trace::Ray *r)
+{
+  unsigned int d = 0;
+
+  for (; r; r = r->get_parent())
+    d++;
+
+  return d;
+}
+
+struct trace_config_s
+{
+  unsigned int threads;
+  bool packet;
+};
+
+static std::ostream & operator<<(std::ostream &o, const trace_config_s &c)
+{
+  return o << c.threads << " threads" << (c.packet ? ", packet mode" : "");
+}
+
+static void compare_queues(const Trace::rays_queue_t &a,
+                           const Trace::rays_queue_t &b,
+                           const trace_config_s &c)
+{
+  if (a.size() != b.size())
+    FAIL(c << ": " << b.size() << " rays found, expecting " << a.size());
+
+  for (unsigned int i = 0; i < a.size(); i++)
+    {
+      const Trace::Ray &ra = *a[i];
+      const Trace::Ray &rb = *b[i];
+
+      // intercept point is not defined for lost rays
+      if ((!ra.is_lost() && !(ra.get_intercept_point() == rb.get_intercept_point())) ||
+          ra.get_wavelen() != rb.get_wavelen() ||
+          ra.get_intensity() != rb.get_intensity() ||
+          ra.get_creator() != rb.get_creator() ||
+          ra.get_material() != rb.get_material() ||
+          ra.is_lost() != rb.is_lost() ||
+          ray_depth(&ra) != ray_depth(&rb))
+        FAIL(c << ": ray " << i << " differs");
+    }
+}
+
+static void trace_compare(Sys::System &sys, const Sys::Surface &image,
+                          const Sys::Surface &last)
+{
+  Trace::Tracer ref_tracer(sys);
+  Trace::Result &ref_result = ref_tracer.get_trace_result();
+
+  ref_result.set_intercepted_save_state(image);
+  ref_result.set_generated_save_state(last);
+  ref_tracer.trace();
+
+  if (ref_result.get_intercepted(image).empty())
+    FAIL("no ray hit the image plane");
+
+  static const trace_config_s configs[] = {
+    { 2, false }, { 3, false }, { 8, false }, { 0, false },
+    { 1, true }, { 3, true }, { 0, true },
+  };
+
+  for (unsigned int j = 0; j < sizeof(configs) / sizeof(configs[0]); j++)
+    {
+      const trace_config_s &c = configs[j];
+
+      // packet mode only affects sequential ray tracing
+      if (c.packet && !sys.get_tracer_params().is_sequential())
+        continue;
+
+      Trace::Tracer tracer(sys);
+      Trace::Result &result = tracer.get_trace_result();
+
+      tracer.get_params().set_thread_count(c.threads);
+      tracer.get_params().set_packet_mode(c.packet);
+
+      result.set_intercepted_save_state(image);
+      result.set_generated_save_state(last);
+
+      // trace twice to check shards and packets are properly released
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          tracer.trace();
+
+          compare_queues(ref_result.get_intercepted(image),
+                         result.get_intercepted(image), c);
+          compare_queues(ref_result.get_generated(last),
+                         result.get_generated(last), c);
+
+          if (ref_result.get_max_ray_intensity() != result.get_max_ray_intensity())
+            FAIL(c << ": max ray intensity differs");
+        }
+    }
+}
+
+/* steep aspheric surfaces, rays hit at grazing angles near the edge */
+static void test_steep()
+{
+  Sys::System   sys;
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  ref<Curve::Polynomial> front = ref<Curve::Polynomial>::create();
+  front->set_even(2, 4, 1.0 / 16, 2e-4);
+
+  ref<Curve::Polynomial> back = ref<Curve::Polynomial>::create();
+  back->set_even(2, 4, -1.0 / 30, -1e-4);
+
+  lens.add_surface(front, ref<Shape::Disk>::create(12), 10,
+                   ref<Material::AbbeVd>::create(1.516800, 64.1673));
+  lens.add_surface(back, ref<Shape::Disk>::create(12), 40);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 50), 40);
+  sys.add(image);
+
+  Sys::SourceRays source(Math::Vector3(0, 0, -20));
+  sys.add(source);
+
+  // tilted parallel beam filling the aperture, edge rays are grazing
+  Math::Vector3 dir(0, .35, 1);
+  dir.normalize();
+
+  for (int x = -12; x <= 12; x++)
+    for (int y = -12; y <= 12; y++)
+      source.add_rays(Math::VectorPair3(Math::Vector3(x, y - 7, 0), dir), &source);
+
+  Trace::Sequence seq(sys);
+  sys.get_tracer_params().set_sequential_mode(seq);
+
+  trace_compare(sys, image, lens.get_surface(1));
+}
+
+int main()
+{
+  test_steep();
+
+  Sys::System   sys;
+
+  Sys::Lens     lens(Math::Vector3(0, 0, 0));
+
+  lens.add_surface(1/0.031186861,  14.934638, 4.627804137,
+                   ref<Material::AbbeVd>::create(1.607170, 59.5002));
+  lens.add_surface(0,              14.934638, 5.417429465);
+  lens.add_surface(1/-0.014065441, 12.766446, 3.728230979,
+                   ref<Material::AbbeVd>::create(1.575960, 41.2999));
+  lens.add_surface(1/0.034678487,  11.918098, 4.417903733);
+  lens.add_stop   (                12.066273, 2.288913925);
+  lens.add_surface(0,              12.372318, 1.499288597,
+                   ref<Material::AbbeVd>::create(1.526480, 51.4000));
+  lens.add_surface(1/0.035104369,  14.642815, 7.996205852,
+                   ref<Material::AbbeVd>::create(1.623770, 56.8998));
+  lens.add_surface(1/-0.021187519, 14.642815, 85.243965130);
+
+  sys.add(lens);
+
+  Sys::Image    image(Math::Vector3(0, 0, 125.596), 5);
+  sys.add(image);
+
+  Sys::SourcePoint source(Sys::SourceAtFiniteDistance,
+                          Math::Vector3(0, 27.5, -1000));
+  sys.add(source);
+
+  source.clear_spectrum();
+  source.add_spectral_line(Light::SpectralLine::C);
+  source.add_spectral_line(Light::SpectralLine::e);
+  source.add_spectral_line(Light::SpectralLine::F);
+
+  sys.get_tracer_params().set_default_distribution(
+    Trace::Distribution(Trace::HexaPolarDist, 10));
+
+  Trace::Sequence seq(sys);
+
+  for (unsigned int mode = 0; mode < 2; mode++)
+    {
+      if (mode)
+        sys.get_tracer_params().set_sequential_mode(seq);
+      else
+        sys.get_tracer_params().set_nonsequential_mode();
+
+      trace_compare(sys, image, lens.get_surface(6));
+    }
+
+  return 0;
+}
+
@@ -0,0 +1,216 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Abbe>
+#include <Goptical/Material/Air>
+#include <Goptical/Material/Vacuum>
+
+#include <Goptical/Curve/Conic>
+#include <Goptical/Shape/Ring>
+
+#include <Goptical/Sys/System>
+#include <Goptical/Sys/Mirror>
+#include <Goptical/Sys/Lens>
+#include <Goptical/Sys/Stop>
+#include <Goptical/Sys/SourcePoint>
+#include <Goptical/Sys/Image>
+
+#include <Goptical/Trace/Tracer>
+#include <Goptical/Trace/Result>
+#include <Goptical/Trace/Ray>
+#include <Goptical/Trace/Params>
+#include <Goptical/Trace/SpectralTable>
+
+#include <Goptical/Light/SpectralLine>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static void compare_rays(const std::string &name, const Trace::rays_queue_t &a,
+                         const Trace::rays_queue_t &b)
+{
+  if (a.size() != b.size())
+    FAIL(name << ": " << a.size() << " rays, expecting " << b.size());
+
+  for (unsigned int i = 0; i < a.size(); i++)
+    {
+      const Trace::Ray &ra = *a[i];
+      const Trace::Ray &rb = *b[i];
+
+      if (!(ra.origin() == rb.origin()) || !(ra.direction() == rb.direction()) ||
+          ra.get_wavelen() != rb.get_wavelen() ||
+          ra.get_intensity() != rb.get_intensity() ||
+          ra.get_material() != rb.get_material() ||
+          ra.get_creator() != rb.get_creator() ||
+          ra.is_lost() != rb.is_lost() ||
+          ra.get_len() != rb.get_len())
+        FAIL(name << ": ray " << i << " differs");
+
+      if (!ra.is_lost() &&
+          (!(ra.get_intercept_point() == rb.get_intercept_point()) ||
+           &ra.get_intercept_element() != &rb.get_intercept_element() ||
+           ra.get_intercept_intensity() != rb.get_intercept_intensity()))
+        FAIL(name << ": ray " << i << " interception differs");
+
+      if ((ra.get_parent() == 0) != (rb.get_parent() == 0) ||
+          (ra.get_parent() && ra.get_parent()->get_wavelen() != ra.get_wavelen()))
+        FAIL(name << ": ray " << i << " parent differs");
+
+      unsigned int ca = 0, cb = 0;
+      for (const Trace::Ray *r = ra.get_first_child(); r; r = r->get_next_child())
+        ca++;
+      for (const Trace::Ray *r = rb.get_first_child(); r; r = r->get_next_child())
+        cb++;
+
+      if (ca != cb)
+        FAIL(name << ": ray " << i << " children count differs");
+    }
+}
+
+int main()
+{
+  Sys::System   sys;
+
+  // cassegrain telescope
+  Sys::Mirror   primary(Math::Vector3(0, 0, 800),
+                        ref<Curve::Conic>::create(-1600, -1.0869),
+                        ref<Shape::Ring>::create(300, 85));
+  sys.add(primary);
+
+  Sys::Mirror   secondary(Math::VectorPair3(0, 0, 225, 0, 0, -1), 675, -5.0434, 100);
+  sys.add(secondary);
+
+  Sys::Image    image(Math::VectorPair3(0, 0, 900), 15);
+  sys.add(image);
+
+  Sys::Stop     stop(Math::vector3_0, 300);
+  sys.add(stop);
+  sys.set_entrance_pupil(stop);
+
+  // glass window in front of telescope, disabled by default
+  Sys::Lens     window(Math::Vector3(0, 0, -50));
+  ref<Material::AbbeVd> glass = ref<Material::AbbeVd>::create(1.5168, 64.17);
+  for (unsigned int i = 0; i < 4; i++)
+    glass->set_internal_transmittance(400 + i * 100, 10, 0.9 + i * 0.02);
+  window.add_surface(0, 310, 10, glass);
+  window.add_surface(0, 310, 0);
+  sys.add(window);
+
+  // keep ghost rays trees small in intensity mode
+  for (unsigned int i = 0; i < 2; i++)
+    window.get_surface(i).set_discard_intensity(0.01);
+
+  Sys::SourcePoint source(Sys::SourceAtInfinity, Math::Vector3(0, 0.002, 1));
+  source.clear_spectrum();
+  source.add_spectral_line(Light::SpectralLine(486.1327, 0.6));
+  source.add_spectral_line(Light::SpectralLine(587.5618, 1.0));
+  source.add_spectral_line(Light::SpectralLine(656.2725, 0.8));
+  sys.add(source);
+
+  for (unsigned int j = 0; j < 12; j++)
+    {
+      bool intensity = j & 1;
+      bool vacuum = j & 2;
+      unsigned int setup = j / 4;   // mirrors, window, equal lines intensity
+
+      sys.set_environment(vacuum ? const_ref<Material::Base>(Material::vacuum)
+                                 : const_ref<Material::Base>(Material::air));
+      for (unsigned int i = 0; i < 2; i++)
+        window.get_surface(i).set_enable_state(setup == 1);
+
+      // rays with different intensities are not deduplicated in intensity mode
+      for (unsigned int i = 0; i < 3; i++)
+        source.set_spectral_line(Light::SpectralLine(source.get_spectrum()[i].get_wavelen(),
+                                                     setup == 2 ? 1.0 : 0.6 + i * 0.2), i);
+
+      Trace::Tracer tracer(sys);
+      Trace::Tracer ref_tracer(sys);
+
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          Trace::Params &params = k ? ref_tracer.get_params() : tracer.get_params();
+
+          params.set_intensity_mode(intensity ? Trace::IntensityTrace : Trace::SimpleTrace);
+          params.get_default_distribution().set_radial_density(8);
+        }
+
+      ref_tracer.get_params().set_wavelen_dedup(false);
+      tracer.get_params().set_thread_count(j % 3 ? 1 : 0);
+
+      Trace::Result &result = tracer.get_trace_result();
+      Trace::Result &ref_result = ref_tracer.get_trace_result();
+
+      for (unsigned int k = 0; k < 2; k++)
+        {
+          Trace::Result &r = k ? ref_result : result;
+
+          r.set_generated_save_state(source);
+          r.set_generated_save_state(primary);
+          r.set_intercepted_save_state(primary);
+          r.set_intercepted_save_state(secondary);
+          r.set_intercepted_save_state(image);
+        }
+
+      tracer.trace();
+      ref_tracer.trace();
+
+      // mirrors do not depend on wavelen, even in dispersive air
+      // when intensity is not computed
+      bool independent = setup != 1 && (!intensity || vacuum);
+
+      if (independent && !result.get_spectral_table().is_wavelen_independent())
+        FAIL(j << ": system not detected as wavelen independent");
+
+      if (setup == 1 && result.get_spectral_table().is_wavelen_independent())
+        FAIL(j << ": refractive system detected as wavelen independent");
+
+      if (result.get_intercepted(image).empty())
+        FAIL(j << ": no ray hit the image plane");
+
+      compare_rays("source generated", result.get_generated(source),
+                   ref_result.get_generated(source));
+      compare_rays("primary generated", result.get_generated(primary),
+                   ref_result.get_generated(primary));
+      compare_rays("primary intercepted", result.get_intercepted(primary),
+                   ref_result.get_intercepted(primary));
+      compare_rays("secondary intercepted", result.get_intercepted(secondary),
+                   ref_result.get_intercepted(secondary));
+      compare_rays("image intercepted", result.get_intercepted(image),
+                   ref_result.get_intercepted(image));
+    }
+
+  return 0;
+}
@@ -0,0 +1,271 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <utime.h>
+#include <pthread.h>
+
+#include <Goptical/Error>
+#include <Goptical/Math/Vector>
+#include <Goptical/Math/VectorPair>
+#include <Goptical/Material/Base>
+#include <Goptical/Material/Catalog>
+#include <Goptical/Io/ImportZemax>
+
+using namespace Goptical;
+
+#define FAIL(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  std::exit(1);                                 \
+}
+
+static const char *agf_file = "test_zemax_catalog.agf";
+static const char *cache_dir = "test_zemax_catalog_cache";
+
+static const char *agf_text =
+  "CC test catalog\n"
+  "NM N-BK7 2 517642 1.5168 64.17 0 0\n"
+  "ED 7.1 8.3 2.51 0 0\n"
+  "CD 1.03961212 0.00600069867 0.231792344 0.0200179144 1.01046945 103.560653 0 0 0 0\n"
+  "TD 1.86e-6 1.31e-8 -1.37e-11 4.34e-7 6.27e-10 0.17 20\n"
+  "LD 0.3 2.5\n"
+  "IT 0.35 0.923 25\n"
+  "IT 0.40 0.992 25\n"
+  "IT 0.50 0.998 25\n"
+  "IT 0.70 0.998 25\n"
+  "NM F2 1 620364 1.62004 36.37 0 0\n"
+  "CD 2.5590001 -0.0087470999 0.021818898 0.0012938111 -6.4575103e-05 4.6733659e-06 0 0 0 0\n"
+  "LD 0.32 2.5\n"
+  "IT 0.38 0.91 25\n"
+  "IT 0.40 0.96 25\n"
+  "IT 0.50 0.995 25\n"
+  "IT 0.60 0.999 25\n"
+  "NM UNKNOWN 42 500500 1.5 50 0 0\n"
+  "CD 1 2 3 4 5 6 7 8 9 10\n";
+
+static void write_agf(const char *text, time_t mtime)
+{
+  FILE *f = fopen(agf_file, "wb");
+
+  if (!f || fputs(text, f) < 0 || fclose(f))
+    FAIL("unable to write " << agf_file);
+
+  struct utimbuf t;
+  t.actime = t.modtime = mtime;
+  utime(agf_file, &t);
+}
+
+static ref<Material::Catalog> import(bool cache)
+{
+  Io::ImportZemax imp;
+
+  // force file load
+  Io::ImportZemax::clear_shared_catalogs();
+
+  if (cache)
+    imp.set_catalog_cache_path(cache_dir);
+
+  return imp.import_catalog(agf_file, "test");
+}
+
+static bool same(Material::Catalog &a, Material::Catalog &b, const char *name)
+{
+  const Material::Base &ma = *a.get_material(name);
+  const Material::Base &mb = *b.get_material(name);
+
+  for (double wl = 400.; wl <= 700.; wl += 25.)
+    if (ma.get_refractive_index(wl) != mb.get_refractive_index(wl))
+      return false;
+
+  return ma.get_internal_transmittance(450., 10.) == mb.get_internal_transmittance(450., 10.)
+    && ma.get_temperature() == mb.get_temperature();
+}
+
+static const char *lookup_names[] = { "N-BK7", "F2" };
+
+static void * lookup_thread(void *param)
+{
+  Material::Catalog *cat = (Material::Catalog *)param;
+  const Material::Base **res = new const Material::Base *[1000];
+
+  for (unsigned int i = 0; i < 1000; i++)
+    res[i] = &*cat->get_material(lookup_names[i % 2]);
+
+  return res;
+}
+
+int main()
+{
+  time_t t0 = 1000000000;
+
+  // start with empty cache
+  if (system((std::string("rm -rf ") + cache_dir).c_str()))
+    FAIL("unable to remove cache directory");
+
+  mkdir(cache_dir, 0755);
+  write_agf(agf_text, t0);
+
+  ref<Material::Catalog> ref_cat = import(false);
+
+  try {
+    ref_cat->get_material("UNKNOWN");
+    FAIL("material with unsupported formula imported");
+  } catch (const Error &e) {
+  }
+
+  // first import writes cache, second import maps it
+  for (unsigned int i = 0; i < 2; i++)
+    {
+      ref<Material::Catalog> cat = import(true);
+
+      if (!same(*cat, *ref_cat, "N-BK7") || !same(*cat, *ref_cat, "F2"))
+        FAIL("cached catalog differs from ascii catalog, pass " << i);
+    }
+
+  // modify file with unchanged size and mtime, cache is still used
+  std::string text(agf_text);
+  text.replace(text.find("CD 1.03961212"), 13, "CD 1.13961212");
+  write_agf(text.c_str(), t0);
+
+  ref<Material::Catalog> mod_cat = import(false);
+
+  if (same(*mod_cat, *ref_cat, "N-BK7"))
+    FAIL("modified catalog not different");
+
+  if (!same(*import(true), *ref_cat, "N-BK7"))
+    FAIL("cache not used for unchanged mtime");
+
+  // mtime changed, contents hash differs and cache is rebuilt
+  write_agf(text.c_str(), t0 + 10);
+
+  if (!same(*import(true), *mod_cat, "N-BK7"))
+    FAIL("cache not rebuilt for changed file");
+
+  if (!same(*import(true), *mod_cat, "N-BK7") || !same(*import(true), *ref_cat, "F2"))
+    FAIL("rebuilt cache differs");
+
+  // corrupted cache file is ignored
+  write_agf(agf_text, t0 + 20);
+  import(true);
+
+  std::string cmd = std::string("for f in ") + cache_dir + "/*.gcat; do "
+    "dd if=/dev/zero of=$f bs=1 count=64 seek=64 conv=notrunc 2>/dev/null; done";
+
+  if (system(cmd.c_str()))
+    FAIL("unable to corrupt cache file");
+
+  if (!same(*import(true), *ref_cat, "N-BK7") || !same(*import(true), *ref_cat, "F2"))
+    FAIL("corrupted cache used");
+
+  // shared catalog registry
+  {
+    write_agf(agf_text, t0 + 30);
+    Io::ImportZemax::clear_shared_catalogs();
+
+    Io::ImportZemax imp1, imp2;
+    ref<Material::Catalog> cat1 = imp1.import_catalog(agf_file, "test");
+    ref<Material::Catalog> cat2 = imp2.import_catalog(agf_file, "test");
+
+    if (&*cat1 != &*cat2 || &*imp2.get_catalog("test") != &*cat1)
+      FAIL("catalog not shared between importers");
+
+    // concurrent first lookups create a single material object
+    pthread_t t[4];
+
+    for (unsigned int i = 0; i < 4; i++)
+      pthread_create(t + i, 0, lookup_thread, &*cat1);
+
+    const Material::Base *first[2] = { 0, 0 };
+
+    for (unsigned int i = 0; i < 4; i++)
+      {
+        void *r;
+        pthread_join(t[i], &r);
+        const Material::Base **res = (const Material::Base **)r;
+
+        for (unsigned int j = 0; j < 1000; j++)
+          {
+            const Material::Base *&f = first[j % 2];
+
+            if (!f)
+              f = res[j];
+            else if (f != res[j])
+              FAIL("material instantiated more than once");
+          }
+
+        delete[] res;
+      }
+
+    if (!same(*cat2, *ref_cat, "N-BK7") || !same(*cat2, *ref_cat, "F2"))
+      FAIL("shared catalog differs from ascii catalog");
+
+    std::vector<std::string> names;
+    cat2->get_material_names(names);
+
+    if (names.size() != 2 || names[0] != "F2" || names[1] != "N-BK7")
+      FAIL("bad catalog material names");
+
+    try {
+      cat1->get_material("N-SF11");
+      FAIL("material not in catalog found");
+    } catch (const Error &e) {
+    }
+
+    // modified file is loaded again
+    write_agf(agf_text, t0 + 40);
+
+    ref<Material::Catalog> cat3 = imp1.import_catalog(agf_file, "test");
+
+    if (&*cat3 == &*cat1)
+      FAIL("modified catalog file not loaded again");
+
+    if (imp1.get_catalog("test")->get_material("F2") != cat3->get_material("F2"))
+      FAIL("importer catalog not updated");
+  }
+
+  // material stays valid when removed from catalog
+  {
+    const_ref<Material::Base> m = ref_cat->get_material("F2");
+    double n = m->get_refractive_index(550.);
+
+    ref_cat->del_material("F2");
+    ref_cat = ref<Material::Catalog>();
+
+    if (m->get_refractive_index(550.) != n)
+      FAIL("removed material changed");
+  }
+
+  return 0;
+}
+
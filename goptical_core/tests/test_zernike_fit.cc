@@ -0,0 +1,181 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Curve/Base>
+#include <Goptical/Curve/Zernike>
+#include <Goptical/Curve/Sphere>
+#include <Goptical/Trace/Distribution>
+#include <Goptical/Error>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+static const double radius = 15.0;
+
+/* fit known zernike surface, coefficients must be recovered */
+static void test_recover()
+{
+  static const unsigned int count = 66;
+  double coefs[count];
+
+  for (unsigned int j = 0; j < count; j++)
+    coefs[j] = 1e-3 * sin(j * 2.1 + 0.3);
+
+  Curve::Zernike ref(radius, coefs, count);
+  Curve::Zernike z(radius);
+
+  z.set_term_count(count);
+
+  double rms = z.fit(ref, Trace::Distribution(Trace::HexaPolarDist, 20));
+
+  if (rms > 1e-12)
+    fail("bad rms for exact fit " << rms);
+
+  for (unsigned int j = 0; j < count; j++)
+    if (fabs(z.get_coefficient(j) - coefs[j]) > 1e-11)
+      fail("coefficient " << j << " not recovered: " << z.get_coefficient(j) << " " << coefs[j]);
+}
+
+/* fit with distributions which can not tell all terms apart,
+   dependent terms must be dropped instead of producing nan */
+static void test_degenerate()
+{
+  static const Trace::Pattern patterns[] = { Trace::MeridionalDist, Trace::CrossDist };
+  double coefs[Curve::Zernike::term_count];
+
+  for (unsigned int j = 0; j < Curve::Zernike::term_count; j++)
+    coefs[j] = 1e-3 * cos(j * 1.7 + 0.2);
+
+  Curve::Zernike ref(radius, coefs, Curve::Zernike::term_count);
+
+  for (unsigned int i = 0; i < 2; i++)
+    {
+      Curve::Zernike z(radius);
+
+      double rms = z.fit(ref, Trace::Distribution(patterns[i], 100));
+
+      for (unsigned int j = 0; j < z.get_term_count(); j++)
+        if (!(fabs(z.get_coefficient(j)) < 1.0))
+          fail("pattern " << i << ": bad coefficient " << j << " " << z.get_coefficient(j));
+
+      // sampled lines are fitted exactly
+      if (!(rms < 1e-12))
+        fail("pattern " << i << ": bad rms " << rms);
+
+      for (double r = -radius; r <= radius; r += radius / 7)
+        if (fabs(z.sagitta(Math::Vector2(0, r)) - ref.sagitta(Math::Vector2(0, r))) > 1e-10
+            || (i && fabs(z.sagitta(Math::Vector2(r, 0)) - ref.sagitta(Math::Vector2(r, 0))) > 1e-10))
+          fail("pattern " << i << ": sagitta mismatch at " << r);
+    }
+}
+
+static void check_same(const Curve::Zernike &a, const Curve::Zernike &b, double tol, const char *what)
+{
+  if (a.get_term_count() != b.get_term_count())
+    fail(what << ": term count mismatch");
+
+  for (unsigned int j = 0; j < a.get_term_count(); j++)
+    if (fabs(a.get_coefficient(j) - b.get_coefficient(j)) > tol)
+      fail(what << ": coefficient " << j << " mismatch " << a.get_coefficient(j)
+           << " " << b.get_coefficient(j));
+}
+
+int main()
+{
+  test_recover();
+  test_degenerate();
+
+  Trace::Distribution dist(Trace::HexaPolarDist, 30);
+  Curve::Sphere s1(120.0), s2(-200.0);
+
+  // reused factorization gives same result as a fresh fit
+  Curve::Zernike z(radius), fresh1(radius), fresh2(radius);
+
+  double r1 = z.fit(s1, dist);
+  double r2 = z.fit(s2, dist);
+
+  if (!(r1 > 0 && r1 < 1e-4) || !(r2 > 0 && r2 < 1e-4))
+    fail("unexpected sphere fit rms " << r1 << " " << r2);
+
+  if (fabs(fresh2.fit(s2, dist) - r2) > 1e-15)
+    fail("rms mismatch with reused factorization");
+  check_same(z, fresh2, 1e-15, "reused factorization");
+
+  // sag at center and edge matches fitted sphere
+  if (fabs(z.sagitta(Math::Vector2(0, 0)) - s2.sagitta(0.0)) > 1e-4
+      || fabs(z.sagitta(Math::Vector2(0, radius * 0.9)) - s2.sagitta(radius * 0.9)) > 1e-4)
+    fail("fitted zernike does not follow sphere");
+
+  // parallel sampling gives bitwise identical coefficients
+  Curve::Zernike zp(radius);
+
+  zp.set_fit_thread_count(4);
+  if (zp.fit(s2, dist) != r2)
+    fail("rms mismatch with parallel sampling");
+  check_same(z, zp, 0.0, "parallel sampling");
+
+  // changes of scale, terms count and distribution invalidate the factorization
+  z.set_coefficients_scale(0.5);
+  z.fit(s2, dist);
+
+  for (unsigned int j = 0; j < z.get_term_count(); j++)
+    if (fabs(z.get_coefficient(j) - 2.0 * fresh2.get_coefficient(j)) > 1e-12)
+      fail("scale change not handled for coefficient " << j);
+
+  z.set_coefficients_scale(1.0);
+  z.set_term_count(45);
+  fresh1.set_term_count(45);
+  z.fit(s1, dist);
+  fresh1.fit(s1, dist);
+  check_same(z, fresh1, 1e-15, "term count change");
+
+  Trace::Distribution dist2(Trace::SquareDist, 25);
+  Curve::Zernike fresh3(radius);
+
+  fresh3.set_term_count(45);
+  z.fit(s1, dist2);
+  fresh3.fit(s1, dist2);
+  check_same(z, fresh3, 1e-15, "distribution change");
+
+  // too few sample points for terms count
+  try {
+    Curve::Zernike zs(radius);
+    zs.set_term_count(231);
+    zs.fit(s1, Trace::Distribution(Trace::HexaPolarDist, 3));
+    fail("missing error for underdetermined fit");
+  } catch (const Error &e) {
+  }
+
+  return 0;
+}
@@ -0,0 +1,241 @@
+/*
+
+      This file is part of the Goptical Core library.
+  
+      The Goptical library is free software; you can redistribute it
+      and/or modify it under the terms of the GNU General Public
+      License as published by the Free Software Foundation; either
+      version 3 of the License, or (at your option) any later version.
+  
+      The Goptical library is distributed in the hope that it will be
+      useful, but WITHOUT ANY WARRANTY; without even the implied
+      warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+      See the GNU General Public License for more details.
+  
+      You should have received a copy of the GNU General Public
+      License along with the Goptical library; if not, write to the
+      Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+      Boston, MA 02111-1307 USA
+  
+      Copyright (C) 2010-2011 Free Software Foundation, Inc
+      Author: Alexandre Becoulet
+
+*/
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include <Goptical/Math/Vector>
+#include <Goptical/Curve/Base>
+#include <Goptical/Curve/Zernike>
+
+using namespace Goptical;
+
+#define fail(x)                                 \
+{                                               \
+  std::cerr << x << std::endl;                  \
+  exit(1);                                      \
+}
+
+static const unsigned int count = 231;
+
+/* radial polynomial from explicit factorial sum */
+static long double radial(unsigned int n, unsigned int m, long double rho)
+{
+  long double r = 0;
+
+  for (unsigned int s = 0; s <= (n - m) / 2; s++)
+    {
+      long double c = s % 2 ? -1 : 1;
+
+      for (unsigned int i = 2; i <= n - s; i++)
+        c *= i;
+      for (unsigned int i = 2; i <= s; i++)
+        c /= i;
+      for (unsigned int i = 2; i <= (n + m) / 2 - s; i++)
+        c /= i;
+      for (unsigned int i = 2; i <= (n - m) / 2 - s; i++)
+        c /= i;
+
+      r += c * powl(rho, n - 2 * s);
+    }
+
+  return r;
+}
+
+static Math::Vector2 sample(unsigned int i)
+{
+  double r = 0.999 * sqrt((i % 17) / 16.0);
+  double t = i * 2.399963;
+
+  return Math::Vector2(r * cos(t), r * sin(t));
+}
+
+static void test_terms()
+{
+  unsigned int n;
+  int m;
+
+  Curve::Zernike::get_term_orders(3, n, m);
+  if (n != 2 || m != 0)
+    fail("bad orders for defocus term");
+
+  Curve::Zernike::get_term_orders(10, n, m);
+  if (n != 3 || m != -3)
+    fail("bad orders for trefoil term");
+
+  for (unsigned int j = 0; j < count; j++)
+    {
+      Curve::Zernike::get_term_orders(j, n, m);
+
+      for (unsigned int i = 0; i < 40; i++)
+        {
+          Math::Vector2 p(sample(i));
+          double rho = p.len(), t = atan2(p.y(), p.x());
+          unsigned int am = abs(m);
+          double ref = radial(n, am, rho) * (m < 0 ? sin(am * t) : cos(am * t));
+          double z = Curve::Zernike::zernike_poly(j, p);
+
+          if (fabs(z - ref) > 1e-7)
+            fail("term " << j << " mismatch at " << p << ": " << z << " " << ref);
+
+          // fringe order terms reach 1 at circle edge
+          if (m == 0 && fabs(Curve::Zernike::zernike_poly(j, Math::Vector2(0, 1)) - 1.0) > 1e-9)
+            fail("term " << j << " not normalized");
+
+          Math::Vector2 d, dn;
+          const double h = 1e-6;
+
+          Curve::Zernike::zernike_poly_d(j, p, d);
+          dn.x() = (Curve::Zernike::zernike_poly(j, p + Math::Vector2(h, 0))
+                    - Curve::Zernike::zernike_poly(j, p - Math::Vector2(h, 0))) / (2 * h);
+          dn.y() = (Curve::Zernike::zernike_poly(j, p + Math::Vector2(0, h))
+                    - Curve::Zernike::zernike_poly(j, p - Math::Vector2(0, h))) / (2 * h);
+
+          if ((d - dn).len() > 1e-4 * (1.0 + dn.len()))
+            fail("term " << j << " derivative mismatch at " << p << ": " << d << " " << dn);
+        }
+    }
+
+  // closed forms of a few low order terms
+  Math::Vector2 p(0.3, -0.6);
+  double r = 0.45;
+
+  if (fabs(Curve::Zernike::zernike_poly(8, p) - (1.0 + 6.0 * r * (r - 1.0))) > 1e-14
+      || fabs(Curve::Zernike::zernike_poly(12, p) - p.x() * p.y() * (8.0 * r - 6.0)) > 1e-14
+      || fabs(Curve::Zernike::zernike_poly(24, p) - (1.0 - r * (20.0 - r * (90.0 - r * (140.0 - 70.0 * r))))) > 1e-14)
+    fail("closed form mismatch");
+}
+
+static void test_curve()
+{
+  double coefs[count];
+
+  for (unsigned int j = 0; j < count; j++)
+    coefs[j] = 1e-3 * cos(j * 1.7) / (1 + j / 10);
+
+  const double radius = 20.0, scale = 0.5;
+  Curve::Zernike z(radius, coefs, count, scale);
+
+  if (z.get_term_count() != count || !z.get_term_state(count - 1))
+    fail("term count not extended");
+
+  z.set_term_state(17, false);
+  z.set_coefficient(40, 0.0);
+
+  for (unsigned int i = 0; i < 50; i++)
+    {
+      Math::Vector2 p(sample(i) * radius);
+      double ref = 0;
+
+      for (unsigned int j = 0; j < count; j++)
+        if (j != 17 && j != 40)
+          ref += coefs[j] * Curve::Zernike::zernike_poly(j, p / radius);
+
+      ref *= scale;
+
+      double sag;
+      Math::Vector2 d, dn;
+      const double h = 1e-5;
+
+      z.sagitta_derivative(p, sag, d);
+
+      if (fabs(sag - ref) > 1e-12 || fabs(z.sagitta(p) - sag) > 1e-15)
+        fail("sagitta mismatch at " << p << ": " << sag << " " << ref);
+
+      dn.x() = (z.sagitta(p + Math::Vector2(h, 0)) - z.sagitta(p - Math::Vector2(h, 0))) / (2 * h);
+      dn.y() = (z.sagitta(p + Math::Vector2(0, h)) - z.sagitta(p - Math::Vector2(0, h))) / (2 * h);
+
+      if ((d - dn).len() > 1e-7)
+        fail("gradient mismatch at " << p << ": " << d << " " << dn);
+
+      Math::Vector2 d2;
+      z.derivative(p, d2);
+
+      if ((d2 - d).len() > 1e-15)
+        fail("derivative mismatch at " << p);
+    }
+
+  // batch forms match scalar evaluation, including outside circle
+  static const unsigned int bcount = 60;
+  double x[bcount], y[bcount], zz[3][bcount], s[bcount], g[2][bcount];
+
+  for (unsigned int i = 0; i < bcount; i++)
+    {
+      Math::Vector2 p(sample(i) * (radius * 1.1));
+      x[i] = p.x();
+      y[i] = p.y();
+      zz[2][i] = 0;
+    }
+
+  const double * const xy[2] = { x, y };
+  double * const dxdy[2] = { g[0], g[1] };
+  const double * const pt[3] = { x, y, zz[2] };
+  double * const nm[3] = { zz[0], zz[1], s };
+
+  z.sagitta_derivative_batch(s, dxdy, xy, bcount);
+
+  for (unsigned int i = 0; i < bcount; i++)
+    {
+      Math::Vector2 p(x[i], y[i]), d;
+
+      z.derivative(p, d);
+
+      if (fabs(s[i] - z.sagitta(p)) > 1e-15 || fabs(g[0][i] - d.x()) > 1e-15
+          || fabs(g[1][i] - d.y()) > 1e-15)
+        fail("batch sagitta/gradient mismatch at " << p);
+    }
+
+  z.normal_batch(nm, pt, bcount);
+
+  for (unsigned int i = 0; i < bcount; i++)
+    {
+      Math::Vector3 n;
+
+      z.normal(n, Math::Vector3(x[i], y[i], 0));
+
+      if ((n - Math::Vector3(nm[0][i], nm[1][i], nm[2][i])).len() > 1e-14)
+        fail("batch normal mismatch at " << x[i] << " " << y[i]);
+    }
+
+  // default term count and disabled terms
+  Curve::Zernike z2(radius);
+
+  if (z2.get_term_count() != Curve::Zernike::term_count || z2.sagitta(Math::Vector2(1, 2)) != 0.0)
+    fail("bad default zernike curve");
+
+  z2.set_term_count(100);
+  z2.set_coefficient(99, 1.0);
+
+  if (fabs(z2.sagitta(Math::Vector2(0, 0)) - Curve::Zernike::zernike_poly(99, Math::Vector2(0, 0))) > 1e-12)
+    fail("extended term mismatch");
+}
+
+int main()
+{
+  test_terms();
+  test_curve();
+
+  return 0;
+}